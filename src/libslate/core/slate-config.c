@@ -24,7 +24,11 @@ struct _SlateConfig
 {
   GObject parent_instance;
 
+  /* Sealed. Only the main thread replaces it, under @document_lock, so
+   * that other threads can take a reference without racing the unref of
+   * the document it replaces. */
   HclDocument *document;
+  GMutex document_lock;
   gboolean loaded;
 };
 
@@ -36,6 +40,7 @@ slate_config_finalize (GObject *object)
   SlateConfig *self = SLATE_CONFIG (object);
 
   g_clear_object (&self->document);
+  g_mutex_clear (&self->document_lock);
 
   G_OBJECT_CLASS (slate_config_parent_class)->finalize (object);
 }
@@ -52,6 +57,7 @@ static void
 slate_config_init (SlateConfig *self)
 {
   self->document = NULL;
+  g_mutex_init (&self->document_lock);
   self->loaded = FALSE;
 }
 
@@ -68,13 +74,68 @@ slate_config_new (void)
   return g_object_new (SLATE_TYPE_CONFIG, NULL);
 }
 
+/* Where the parsed form of @filename is cached, keyed by its absolute path */
+static char *
+slate_config_get_cache_path (const char *filename)
+{
+  g_autofree char *absolute = g_canonicalize_filename (filename, NULL);
+  g_autofree char *key = g_compute_checksum_for_string (G_CHECKSUM_SHA256, absolute, -1);
+  g_autofree char *basename = g_strconcat (key, ".hclc", NULL);
+
+  return g_build_filename (g_get_user_cache_dir (), "slate", "config", basename, NULL);
+}
+
+/*
+ * Loads @filename from the document cache if it is current, and parses
+ * it and refreshes the cache otherwise. The cache records the file as
+ * it was parsed, so saving it again during the parse is noticed on the
+ * next load. Failing to write the cache is not an error; the next load
+ * simply parses again.
+ */
+static HclDocument *
+slate_config_load_cached_file (const char  *filename,
+                               GError     **error)
+{
+  g_autofree char *cache_path = slate_config_get_cache_path (filename);
+
+  return hcl_document_parse_cached (cache_path, filename, error);
+}
+
+/*
+ * Makes @document, which may be %NULL, the loaded configuration, taking
+ * the reference. It is sealed first, so that snapshots of it can be read
+ * from any thread. The document it replaces lives on in the snapshots
+ * still held.
+ */
+static gboolean
+slate_config_set_document (SlateConfig *config,
+                           HclDocument *document)
+{
+  HclDocument *old;
+
+  if (document != NULL)
+    hcl_document_seal (document);
+
+  g_mutex_lock (&config->document_lock);
+  old = config->document;
+  config->document = document;
+  g_mutex_unlock (&config->document_lock);
+
+  g_clear_object (&old);
+
+  config->loaded = document != NULL;
+  return config->loaded;
+}
+
 /**
  * slate_config_load_file:
  * @config: a #SlateConfig
  * @filename: path to the HCL configuration file
  * @error: return location for a #GError, or %NULL
  *
- * Loads configuration from an HCL file.
+ * Loads configuration from an HCL file. The parsed file is cached in the
+ * user cache directory, and later loads of the unchanged file read the
+ * cache instead of parsing it again.
  *
  * Returns: %TRUE on success, %FALSE on error
  */
@@ -86,17 +147,8 @@ slate_config_load_file (SlateConfig  *config,
   g_return_val_if_fail (SLATE_IS_CONFIG (config), FALSE);
   g_return_val_if_fail (filename != NULL, FALSE);
 
-  g_clear_object (&config->document);
-
-  config->document = hcl_parse_file (filename, error);
-  if (config->document == NULL)
-    {
-      config->loaded = FALSE;
-      return FALSE;
-    }
-
-  config->loaded = TRUE;
-  return TRUE;
+  return slate_config_set_document (config,
+                                    slate_config_load_cached_file (filename, error));
 }
 
 /**
@@ -117,24 +169,97 @@ slate_config_load_string (SlateConfig  *config,
   g_return_val_if_fail (SLATE_IS_CONFIG (config), FALSE);
   g_return_val_if_fail (hcl_string != NULL, FALSE);
 
-  g_clear_object (&config->document);
+  return slate_config_set_document (config,
+                                    hcl_parse_string (hcl_string, error));
+}
+
+/**
+ * slate_config_load_files:
+ * @config: a #SlateConfig
+ * @filenames: (array zero-terminated=1): %NULL-terminated array of paths
+ *   to HCL configuration files
+ * @error: return location for a #GError, or %NULL
+ *
+ * Loads configuration split across several HCL files. The files are
+ * parsed in parallel and merged in the order given, so attributes in
+ * later files override those in earlier ones.
+ *
+ * Returns: %TRUE on success, %FALSE on error
+ */
+gboolean
+slate_config_load_files (SlateConfig        *config,
+                         const char * const *filenames,
+                         GError            **error)
+{
+  g_return_val_if_fail (SLATE_IS_CONFIG (config), FALSE);
+  g_return_val_if_fail (filenames != NULL, FALSE);
+
+  return slate_config_set_document (config,
+                                    hcl_parse_files (filenames, error));
+}
+
+static gint
+compare_filenames (gconstpointer a,
+                   gconstpointer b)
+{
+  return g_strcmp0 (*(const char * const *) a, *(const char * const *) b);
+}
+
+/**
+ * slate_config_load_directory:
+ * @config: a #SlateConfig
+ * @directory: path to a directory of HCL configuration files
+ * @error: return location for a #GError, or %NULL
+ *
+ * Loads every `.hcl` file directly inside @directory with
+ * slate_config_load_files(), in alphabetical order of file name.
+ *
+ * Returns: %TRUE on success, %FALSE on error
+ */
+gboolean
+slate_config_load_directory (SlateConfig  *config,
+                             const char   *directory,
+                             GError      **error)
+{
+  g_autoptr(GDir) dir = NULL;
+  g_autoptr(GPtrArray) filenames = NULL;
+  const char *name;
+
+  g_return_val_if_fail (SLATE_IS_CONFIG (config), FALSE);
+  g_return_val_if_fail (directory != NULL, FALSE);
+
+  dir = g_dir_open (directory, 0, error);
+  if (dir == NULL)
+    return slate_config_set_document (config, NULL);
 
-  config->document = hcl_parse_string (hcl_string, error);
-  if (config->document == NULL)
+  filenames = g_ptr_array_new_with_free_func (g_free);
+  while ((name = g_dir_read_name (dir)) != NULL)
     {
-      config->loaded = FALSE;
-      return FALSE;
+      g_autofree char *filename = NULL;
+
+      if (!g_str_has_suffix (name, ".hcl"))
+        continue;
+
+      filename = g_build_filename (directory, name, NULL);
+      if (g_file_test (filename, G_FILE_TEST_IS_REGULAR))
+        g_ptr_array_add (filenames, g_steal_pointer (&filename));
     }
 
-  config->loaded = TRUE;
-  return TRUE;
+  g_ptr_array_sort (filenames, compare_filenames);
+  g_ptr_array_add (filenames, NULL);
+
+  return slate_config_load_files (config,
+                                  (const char * const *) filenames->pdata,
+                                  error);
 }
 
 /**
  * slate_config_get_document:
  * @config: a #SlateConfig
  *
- * Gets the loaded HCL document.
+ * Gets the loaded HCL document. The document is sealed, and the next
+ * load replaces it, so this is only for the thread that loads @config;
+ * other threads should use slate_config_dup_snapshot().
  *
  * Returns: (transfer none) (nullable): the HCL document, or %NULL if not loaded
  */
@@ -145,6 +270,34 @@ slate_config_get_document (SlateConfig *config)
   return config->document;
 }
 
+/**
+ * slate_config_dup_snapshot:
+ * @config: a #SlateConfig
+ *
+ * Gets a reference to the loaded HCL document, for reading from another
+ * thread. The document is sealed with hcl_document_seal(), so it can be
+ * read without locking, and a later load leaves it untouched: callers
+ * keep the configuration they took until they ask again.
+ *
+ * This function is thread safe, and cheap enough to call for every
+ * batch of work.
+ *
+ * Returns: (transfer full) (nullable): the HCL document, or %NULL if not loaded
+ */
+HclDocument *
+slate_config_dup_snapshot (SlateConfig *config)
+{
+  HclDocument *snapshot;
+
+  g_return_val_if_fail (SLATE_IS_CONFIG (config), NULL);
+
+  g_mutex_lock (&config->document_lock);
+  snapshot = config->document ? g_object_ref (config->document) : NULL;
+  g_mutex_unlock (&config->document_lock);
+
+  return snapshot;
+}
+
 /**
  * slate_config_get_string_property:
  * @config: a #SlateConfig
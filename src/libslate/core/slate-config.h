@@ -47,8 +47,17 @@ gboolean       slate_config_load_string            (SlateConfig  *config,
                                                     const char   *hcl_string,
                                                     GError      **error);
 
+gboolean       slate_config_load_files             (SlateConfig        *config,
+                                                    const char * const *filenames,
+                                                    GError            **error);
+
+gboolean       slate_config_load_directory         (SlateConfig  *config,
+                                                    const char   *directory,
+                                                    GError      **error);
+
 /* Accessing configuration */
 HclDocument   *slate_config_get_document           (SlateConfig  *config);
+HclDocument   *slate_config_dup_snapshot           (SlateConfig  *config);
 
 /* Property access */
 const char    *slate_config_get_string_property    (SlateConfig  *config,
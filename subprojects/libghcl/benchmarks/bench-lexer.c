@@ -0,0 +1,242 @@
+/* bench-lexer.c - Benchmarks for the HCL lexer scanners
+ *
+ * Copyright 2024 Geoff Johnson <geoff.jay@gmail.com>
+ */
+
+#include <glib.h>
+#include <hcl.h>
+#include "hcl-scan.h"
+
+#define INPUT_SIZE (8 * 1024 * 1024)
+#define ROUNDS 5
+
+typedef gsize (*ScanFunc) (const gchar *data, gsize length);
+
+static gchar *
+generate_runs (const gchar *alphabet, guint min_run, guint max_run, gchar separator)
+{
+  g_autoptr(GRand) rand = g_rand_new_with_seed (42);
+  gsize alphabet_length = strlen (alphabet);
+  gchar *data = g_malloc (INPUT_SIZE + 1);
+  gsize i = 0;
+
+  while (i < INPUT_SIZE) {
+    guint run = (guint) g_rand_int_range (rand, (gint32) min_run, (gint32) max_run + 1);
+
+    while (run-- > 0 && i < INPUT_SIZE)
+      data[i++] = alphabet[g_rand_int_range (rand, 0, (gint32) alphabet_length)];
+    if (i < INPUT_SIZE)
+      data[i++] = separator;
+  }
+
+  data[INPUT_SIZE] = '\0';
+  return data;
+}
+
+static gchar *
+generate_config (void)
+{
+  GString *config = g_string_sized_new (INPUT_SIZE + 4096);
+  guint i = 0;
+
+  while (config->len < INPUT_SIZE) {
+    g_string_append_printf (config,
+                            "# Generated card %u for the overview dashboard\n"
+                            "card \"card_%u\" {\n"
+                            "  title            = \"Temperature sensor %u\"\n"
+                            "  refresh_interval = %u\n"
+                            "  visible          = true\n"
+                            "  chart {\n"
+                            "    series_name = \"series-%u\"\n"
+                            "    line_width  = 1.5\n"
+                            "  }\n"
+                            "}\n\n",
+                            i, i, i, i % 60, i);
+    i++;
+  }
+
+  return g_string_free (config, FALSE);
+}
+
+/* A calibration table: rows of plain decimals, as in chart series */
+static gchar *
+generate_numbers (void)
+{
+  g_autoptr(GRand) rand = g_rand_new_with_seed (42);
+  GString *numbers = g_string_sized_new (INPUT_SIZE + 4096);
+
+  g_string_append (numbers, "curve = [\n");
+  while (numbers->len < INPUT_SIZE) {
+    g_string_append_printf (numbers, "  %d, %.6f, %.3e,\n",
+                            g_rand_int_range (rand, -100000, 100000),
+                            g_rand_double_range (rand, -1000.0, 1000.0),
+                            g_rand_double_range (rand, 0.0, 1.0e6));
+  }
+  g_string_append (numbers, "]\n");
+
+  return g_string_free (numbers, FALSE);
+}
+
+/* Walks @data the way the lexer does: one scan per run, skip the separator */
+static gsize
+scan_string_scalar (const gchar *data, gsize length)
+{
+  return hcl_scan_string_scalar (data, length, '"');
+}
+
+static gsize
+scan_string (const gchar *data, gsize length)
+{
+  return hcl_scan_string (data, length, '"');
+}
+
+static gdouble
+time_runs (ScanFunc scan, const gchar *data, gsize length, gsize *total)
+{
+  gdouble best = G_MAXDOUBLE;
+  guint round;
+
+  for (round = 0; round < ROUNDS; round++) {
+    g_autoptr(GTimer) timer = g_timer_new ();
+    gsize position = 0;
+    gsize sum = 0;
+
+    while (position < length) {
+      gsize run = scan (data + position, length - position);
+      sum += run;
+      position += run + 1;
+    }
+
+    best = MIN (best, g_timer_elapsed (timer, NULL));
+    *total = sum;
+  }
+
+  return best;
+}
+
+static void
+report (const gchar *name, gsize length, gdouble scalar, gdouble vector)
+{
+  gdouble megabytes = (gdouble) length / (1024.0 * 1024.0);
+
+  g_print ("%-18s scalar %8.1f MB/s   vector %8.1f MB/s   speedup %.2fx\n",
+           name, megabytes / scalar, megabytes / vector, scalar / vector);
+}
+
+static void
+bench_scanner (const gchar *name, ScanFunc scalar, ScanFunc vector, const gchar *data)
+{
+  gsize scalar_total;
+  gsize vector_total;
+  gdouble scalar_time = time_runs (scalar, data, INPUT_SIZE, &scalar_total);
+  gdouble vector_time = time_runs (vector, data, INPUT_SIZE, &vector_total);
+
+  g_assert_cmpuint (scalar_total, ==, vector_total);
+  report (name, INPUT_SIZE, scalar_time, vector_time);
+}
+
+static void
+bench_newlines (const gchar *data, gsize length)
+{
+  gdouble scalar_time = G_MAXDOUBLE;
+  gdouble vector_time = G_MAXDOUBLE;
+  gsize scalar_count = 0;
+  gsize vector_count = 0;
+  guint round;
+
+  for (round = 0; round < ROUNDS; round++) {
+    g_autoptr(GTimer) timer = g_timer_new ();
+    gsize last;
+
+    scalar_count = hcl_scan_count_newlines_scalar (data, length, &last);
+    scalar_time = MIN (scalar_time, g_timer_elapsed (timer, NULL));
+
+    g_timer_start (timer);
+    vector_count = hcl_scan_count_newlines (data, length, &last);
+    vector_time = MIN (vector_time, g_timer_elapsed (timer, NULL));
+  }
+
+  g_assert_cmpuint (scalar_count, ==, vector_count);
+  report ("newline count", length, scalar_time, vector_time);
+}
+
+static void
+bench_tokenize (const gchar *name, const gchar *config)
+{
+  gsize length = strlen (config);
+  gdouble best = G_MAXDOUBLE;
+  gsize tokens = 0;
+  guint round;
+
+  for (round = 0; round < ROUNDS; round++) {
+    g_autoptr(HclLexer) lexer = hcl_lexer_new (config);
+    g_autoptr(GTimer) timer = g_timer_new ();
+    HclSpanToken token;
+
+    tokens = 0;
+    while (hcl_lexer_next_span (lexer, &token, NULL) &&
+           token.type != HCL_TOKEN_TYPE_EOF)
+      tokens++;
+
+    best = MIN (best, g_timer_elapsed (timer, NULL));
+  }
+
+  g_print ("%-18s %zu tokens, %.1f MB/s\n", name,
+           tokens, (gdouble) length / (1024.0 * 1024.0) / best);
+}
+
+static void
+bench_tokenize_objects (const gchar *config)
+{
+  gsize length = strlen (config);
+  gdouble best = G_MAXDOUBLE;
+  gsize tokens = 0;
+  guint round;
+
+  for (round = 0; round < ROUNDS; round++) {
+    g_autoptr(HclLexer) lexer = hcl_lexer_new (config);
+    g_autoptr(GTimer) timer = g_timer_new ();
+
+    tokens = 0;
+    for (;;) {
+      g_autoptr(HclToken) token = hcl_lexer_next_token (lexer, NULL);
+
+      if (!token || hcl_token_get_token_type (token) == HCL_TOKEN_TYPE_EOF)
+        break;
+      tokens++;
+    }
+
+    best = MIN (best, g_timer_elapsed (timer, NULL));
+  }
+
+  g_print ("%-18s %zu tokens, %.1f MB/s\n", "tokenize (objects)",
+           tokens, (gdouble) length / (1024.0 * 1024.0) / best);
+}
+
+int
+main (int argc, char **argv)
+{
+  g_autofree gchar *blanks = generate_runs (" \t", 1, 64, 'x');
+  g_autofree gchar *identifiers = generate_runs ("abcdefghijklmnopqrstuvwxyz_-0123456789",
+                                                 1, 48, ' ');
+  g_autofree gchar *lines = generate_runs ("abcdefgh =\"{}[]#", 20, 120, '\n');
+  g_autofree gchar *strings = generate_runs ("abcdefgh ,.:/{}[]=#", 8, 96, '"');
+  g_autofree gchar *config = generate_config ();
+  g_autofree gchar *numbers = generate_numbers ();
+
+  (void) argc;
+  (void) argv;
+
+  g_print ("Scanning %d MiB inputs, best of %d rounds\n", INPUT_SIZE / (1024 * 1024), ROUNDS);
+
+  bench_scanner ("whitespace", hcl_scan_whitespace_scalar, hcl_scan_whitespace, blanks);
+  bench_scanner ("identifier", hcl_scan_identifier_scalar, hcl_scan_identifier, identifiers);
+  bench_scanner ("comment", hcl_scan_line_scalar, hcl_scan_line, lines);
+  bench_scanner ("string body", scan_string_scalar, scan_string, strings);
+  bench_newlines (config, strlen (config));
+  bench_tokenize ("tokenize", config);
+  bench_tokenize ("tokenize numbers", numbers);
+  bench_tokenize_objects (config);
+
+  return 0;
+}
@@ -0,0 +1,137 @@
+/* bench-parser.c - Benchmarks for the HCL parser on deeply nested input
+ *
+ * Copyright 2024 Geoff Johnson <geoff.jay@gmail.com>
+ */
+
+#include <glib.h>
+#include <hcl.h>
+
+#define INPUT_SIZE (8 * 1024 * 1024)
+#define ROUNDS 5
+
+/*
+ * A layout of boxes nested @depth deep, each with a few attributes and
+ * an object, repeated until the input is INPUT_SIZE long.
+ */
+static gchar *
+generate_layout (guint depth)
+{
+  GString *layout = g_string_sized_new (INPUT_SIZE + 4096);
+  guint i = 0;
+
+  while (layout->len < INPUT_SIZE) {
+    guint level;
+
+    for (level = 0; level < depth; level++)
+      g_string_append_printf (layout,
+                              "box \"box_%u_%u\" {\n"
+                              "  orientation = \"%s\"\n"
+                              "  spacing     = %u\n"
+                              "  margin      = { top = 4, bottom = 4, sizes = [1, 2, 3] }\n",
+                              i, level,
+                              level % 2 ? "horizontal" : "vertical",
+                              level % 16);
+    for (level = 0; level < depth; level++)
+      g_string_append (layout, "}\n");
+    g_string_append_c (layout, '\n');
+    i++;
+  }
+
+  return g_string_free (layout, FALSE);
+}
+
+/* A single value nested @depth lists deep, repeated like the layout */
+static gchar *
+generate_lists (guint depth)
+{
+  GString *lists = g_string_sized_new (INPUT_SIZE + 4096);
+  guint i = 0;
+
+  while (lists->len < INPUT_SIZE) {
+    guint level;
+
+    g_string_append_printf (lists, "value_%u = ", i);
+    for (level = 0; level < depth; level++)
+      g_string_append_c (lists, '[');
+    g_string_append_printf (lists, "%u", i);
+    for (level = 0; level < depth; level++)
+      g_string_append (lists, ", 0]");
+    g_string_append_c (lists, '\n');
+    i++;
+  }
+
+  return g_string_free (lists, FALSE);
+}
+
+static void
+bench_parse (const gchar *name, const gchar *input)
+{
+  g_autoptr(HclParser) parser = hcl_parser_new ();
+  gsize length = strlen (input);
+  gdouble best = G_MAXDOUBLE;
+  guint round;
+
+  hcl_parser_set_max_depth (parser, 0);
+
+  for (round = 0; round < ROUNDS; round++) {
+    g_autoptr(GTimer) timer = g_timer_new ();
+    g_autoptr(GError) error = NULL;
+    g_autoptr(HclDocument) document = hcl_parser_parse_string (parser, input, &error);
+
+    g_assert_no_error (error);
+    best = MIN (best, g_timer_elapsed (timer, NULL));
+  }
+
+  g_print ("%-24s %.1f MB/s\n", name, (gdouble) length / (1024.0 * 1024.0) / best);
+}
+
+static void
+bench_parse_events (const gchar *name, const gchar *input)
+{
+  g_autoptr(HclParser) parser = hcl_parser_new ();
+  HclParserEvents events = { 0, };
+  gsize length = strlen (input);
+  gdouble best = G_MAXDOUBLE;
+  guint round;
+
+  hcl_parser_set_max_depth (parser, 0);
+
+  for (round = 0; round < ROUNDS; round++) {
+    g_autoptr(GTimer) timer = g_timer_new ();
+    g_autoptr(GError) error = NULL;
+
+    hcl_parser_parse_events (parser, input, (gssize) length, &events, NULL, &error);
+    g_assert_no_error (error);
+    best = MIN (best, g_timer_elapsed (timer, NULL));
+  }
+
+  g_print ("%-24s %.1f MB/s\n", name, (gdouble) length / (1024.0 * 1024.0) / best);
+}
+
+int
+main (int argc, char **argv)
+{
+  static const guint depths[] = { 4, 32, 256 };
+  guint i;
+
+  (void) argc;
+  (void) argv;
+
+  g_print ("Parsing %d MiB inputs, best of %d rounds\n", INPUT_SIZE / (1024 * 1024), ROUNDS);
+
+  for (i = 0; i < G_N_ELEMENTS (depths); i++) {
+    g_autofree gchar *layout = generate_layout (depths[i]);
+    g_autofree gchar *lists = generate_lists (depths[i]);
+    g_autofree gchar *layout_name = g_strdup_printf ("blocks, depth %u", depths[i]);
+    g_autofree gchar *events_name = g_strdup_printf ("blocks (events), depth %u", depths[i]);
+    g_autofree gchar *lists_name = g_strdup_printf ("lists, depth %u", depths[i]);
+    g_autofree gchar *lists_events_name = g_strdup_printf ("lists (events), depth %u", depths[i]);
+
+    bench_parse (layout_name, layout);
+    bench_parse_events (events_name, layout);
+    bench_parse (lists_name, lists);
+    bench_parse_events (lists_events_name, lists);
+  }
+
+  return 0;
+}
@@ -0,0 +1,117 @@
+/* bench-writer.c - Benchmarks for writing HCL documents
+ *
+ * Copyright 2024 Geoff Johnson <geoff.jay@gmail.com>
+ */
+
+#include <glib.h>
+#include <gio/gio.h>
+#include <hcl.h>
+
+#define INPUT_SIZE (8 * 1024 * 1024)
+#define ROUNDS 5
+
+/* Boxes nested @depth deep, repeated until the input is INPUT_SIZE long */
+static HclDocument *
+generate_document (guint depth)
+{
+  g_autoptr(HclParser) parser = hcl_parser_new ();
+  g_autoptr(GError) error = NULL;
+  GString *layout = g_string_sized_new (INPUT_SIZE + 4096);
+  HclDocument *document;
+  guint i = 0;
+
+  while (layout->len < INPUT_SIZE) {
+    guint level;
+
+    for (level = 0; level < depth; level++)
+      g_string_append_printf (layout,
+                              "box \"box_%u_%u\" {\n"
+                              "  orientation = \"%s\"\n"
+                              "  spacing     = %u\n"
+                              "  ratio       = %u.25\n"
+                              "  margin      = { top = 4, bottom = 4, sizes = [1, 2, 3] }\n",
+                              i, level,
+                              level % 2 ? "horizontal" : "vertical",
+                              level % 16, level);
+    for (level = 0; level < depth; level++)
+      g_string_append (layout, "}\n");
+    i++;
+  }
+
+  hcl_parser_set_max_depth (parser, 0);
+  document = hcl_parser_parse_string (parser, layout->str, &error);
+  g_assert_no_error (error);
+  g_string_free (layout, TRUE);
+
+  return document;
+}
+
+static void
+bench_write (const gchar *name, HclDocument *document, HclWriterStyle style)
+{
+  g_autoptr(HclWriter) writer = hcl_writer_new ();
+  gdouble best = G_MAXDOUBLE;
+  gsize length = 0;
+  guint round;
+
+  hcl_writer_set_style (writer, style);
+
+  for (round = 0; round < ROUNDS; round++) {
+    g_autoptr(GString) buffer = g_string_new (NULL);
+    g_autoptr(GTimer) timer = g_timer_new ();
+
+    hcl_writer_write_document (writer, document, buffer);
+    best = MIN (best, g_timer_elapsed (timer, NULL));
+    length = buffer->len;
+  }
+
+  g_print ("%-32s %.1f MB/s\n", name, (gdouble) length / (1024.0 * 1024.0) / best);
+}
+
+static void
+bench_write_stream (const gchar *name, HclDocument *document)
+{
+  g_autoptr(HclWriter) writer = hcl_writer_new ();
+  gdouble best = G_MAXDOUBLE;
+  gsize length = 0;
+  guint round;
+
+  for (round = 0; round < ROUNDS; round++) {
+    g_autoptr(GOutputStream) stream = g_memory_output_stream_new_resizable ();
+    g_autoptr(GTimer) timer = g_timer_new ();
+    g_autoptr(GError) error = NULL;
+
+    hcl_writer_write_document_to_stream (writer, document, stream, NULL, &error);
+    g_assert_no_error (error);
+    best = MIN (best, g_timer_elapsed (timer, NULL));
+    length = g_memory_output_stream_get_data_size (G_MEMORY_OUTPUT_STREAM (stream));
+  }
+
+  g_print ("%-32s %.1f MB/s\n", name, (gdouble) length / (1024.0 * 1024.0) / best);
+}
+
+int
+main (int argc, char **argv)
+{
+  static const guint depths[] = { 4, 32, 256 };
+  guint i;
+
+  (void) argc;
+  (void) argv;
+
+  g_print ("Writing documents parsed from %d MiB inputs, best of %d rounds\n",
+           INPUT_SIZE / (1024 * 1024), ROUNDS);
+
+  for (i = 0; i < G_N_ELEMENTS (depths); i++) {
+    g_autoptr(HclDocument) document = generate_document (depths[i]);
+    g_autofree gchar *pretty_name = g_strdup_printf ("pretty, depth %u", depths[i]);
+    g_autofree gchar *compact_name = g_strdup_printf ("compact, depth %u", depths[i]);
+    g_autofree gchar *stream_name = g_strdup_printf ("pretty (stream), depth %u", depths[i]);
+
+    bench_write (pretty_name, document, HCL_WRITER_STYLE_PRETTY);
+    bench_write (compact_name, document, HCL_WRITER_STYLE_COMPACT);
+    bench_write_stream (stream_name, document);
+  }
+
+  return 0;
+}
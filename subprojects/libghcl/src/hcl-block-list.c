@@ -0,0 +1,306 @@
+/* hcl-block-list.c - Indexed list of child blocks
+ *
+ * Copyright 2024 Geoff Johnson <geoff.jay@gmail.com>
+ */
+
+#include "hcl-private.h"
+
+/*
+ * The child blocks of an #HclDocument or #HclBlock, in document order,
+ * with an index by type and by (type, label) that is only built once
+ * somebody asks a typed question.
+ *
+ * The type index maps each type to a bucket holding the blocks of that
+ * type in document order. It hashes the type strings rather than the
+ * interned pointers, so a lookup never has to ask the intern table.
+ * Blocks added after the index was built are appended to their bucket,
+ * so the index never has to be thrown away on mutation, and bucket
+ * arrays stay alive until the list is cleared.
+ *
+ * Label tables are built per bucket on the first label lookup. They
+ * borrow the labels of the blocks, so relabelling a block drops the
+ * table of its bucket in the list it was added to. A block added to more
+ * than one list cannot tell them all, so relabelling it moves the label
+ * epoch instead; every table remembers the epoch it was built at and is
+ * rebuilt once the epoch moves.
+ *
+ * Sealing a list builds every index up front and stops label tables from
+ * being rebuilt, since sealed blocks keep their labels. Lookups then
+ * only read, so several threads can make them at once.
+ */
+
+typedef struct {
+  GPtrArray *blocks;        /* HclBlock*, borrowed from the list */
+  GHashTable *by_label;     /* Label -> first HclBlock* with it */
+  guint label_epoch;
+  gboolean sealed;          /* @by_label stays as it is */
+} HclBlockBucket;
+
+/* The real layout behind the public HclBlockIter */
+typedef struct {
+  GPtrArray *blocks;
+  guint index;
+} HclRealBlockIter;
+
+G_STATIC_ASSERT (sizeof (HclRealBlockIter) <= sizeof (HclBlockIter));
+
+static void
+hcl_block_bucket_free (gpointer data)
+{
+  HclBlockBucket *bucket = data;
+
+  g_ptr_array_unref (bucket->blocks);
+  g_clear_pointer (&bucket->by_label, g_hash_table_unref);
+  g_free (bucket);
+}
+
+void
+hcl_block_list_init (HclBlockList *list, gpointer owner, HclParentKind owner_kind)
+{
+  list->blocks = g_ptr_array_new_with_free_func (g_object_unref);
+  list->by_type = NULL;
+  list->sealed = FALSE;
+  list->owner = owner;
+  list->owner_kind = owner_kind;
+}
+
+void
+hcl_block_list_clear (HclBlockList *list)
+{
+  for (guint i = 0; list->blocks && i < list->blocks->len; i++)
+    hcl_block_unset_parent (g_ptr_array_index (list->blocks, i), list->owner);
+
+  g_clear_pointer (&list->by_type, g_hash_table_unref);
+  g_clear_pointer (&list->blocks, g_ptr_array_unref);
+}
+
+static void
+hcl_block_list_index_block (HclBlockList *list, HclBlock *block)
+{
+  const gchar *type = hcl_block_get_block_type (block);
+  const gchar *label = hcl_block_get_label (block);
+  HclBlockBucket *bucket = g_hash_table_lookup (list->by_type, type);
+
+  if (!bucket) {
+    bucket = g_new0 (HclBlockBucket, 1);
+    bucket->blocks = g_ptr_array_new ();
+    g_hash_table_insert (list->by_type, (gpointer) type, bucket);
+  }
+
+  g_ptr_array_add (bucket->blocks, block);
+
+  if (!bucket->by_label)
+    return;
+
+  /* A stale table may hold labels that were freed, so it cannot be probed */
+  if (bucket->label_epoch != hcl_block_get_label_epoch ()) {
+    g_clear_pointer (&bucket->by_label, g_hash_table_unref);
+    return;
+  }
+
+  /* The first block with a label wins, as with a linear search */
+  if (label && !g_hash_table_contains (bucket->by_label, label))
+    g_hash_table_insert (bucket->by_label, (gpointer) label, block);
+}
+
+void
+hcl_block_list_add (HclBlockList *list, HclBlock *block)
+{
+  g_return_if_fail (!list->sealed);
+
+  g_ptr_array_add (list->blocks, block);
+
+  if (list->by_type)
+    hcl_block_list_index_block (list, block);
+
+  hcl_block_set_parent (block, list->owner, list->owner_kind);
+  hcl_hash_invalidate (list->owner, list->owner_kind);
+}
+
+/*
+ * Drops the label table of the bucket for @type, before a block of that
+ * type in @list changes its label.
+ */
+void
+hcl_block_list_forget_labels (HclBlockList *list, const gchar *type)
+{
+  HclBlockBucket *bucket;
+
+  if (!list->by_type)
+    return;
+
+  bucket = g_hash_table_lookup (list->by_type, type);
+  if (bucket && !bucket->sealed)
+    g_clear_pointer (&bucket->by_label, g_hash_table_unref);
+}
+
+/*
+ * Adds the type index bucket for the interned @type from a stored index,
+ * so a loaded list does not have to be indexed block by block. The
+ * blocks at @positions must all have that type, and every type in the
+ * list must be given a bucket before the list is queried.
+ */
+void
+hcl_block_list_add_bucket (HclBlockList *list,
+                           const gchar *type,
+                           const guint32 *positions,
+                           guint n_positions)
+{
+  HclBlockBucket *bucket = g_new0 (HclBlockBucket, 1);
+
+  if (!list->by_type)
+    list->by_type = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                           NULL, hcl_block_bucket_free);
+
+  bucket->blocks = g_ptr_array_sized_new (n_positions);
+  for (guint i = 0; i < n_positions; i++)
+    g_ptr_array_add (bucket->blocks, g_ptr_array_index (list->blocks, positions[i]));
+
+  g_hash_table_replace (list->by_type, (gpointer) type, bucket);
+}
+
+/* Returns the bucket for @type, building the type index if needed */
+static HclBlockBucket *
+hcl_block_list_lookup_bucket (HclBlockList *list, const gchar *type)
+{
+  if (!list->by_type) {
+    list->by_type = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                           NULL, hcl_block_bucket_free);
+
+    for (guint i = 0; i < list->blocks->len; i++)
+      hcl_block_list_index_block (list, g_ptr_array_index (list->blocks, i));
+  }
+
+  return g_hash_table_lookup (list->by_type, type);
+}
+
+GList *
+hcl_block_list_get_all (HclBlockList *list)
+{
+  GList *result = NULL;
+
+  for (guint i = list->blocks->len; i > 0; i--)
+    result = g_list_prepend (result, g_ptr_array_index (list->blocks, i - 1));
+
+  return result;
+}
+
+GList *
+hcl_block_list_get_by_type (HclBlockList *list, const gchar *type)
+{
+  HclBlockBucket *bucket = hcl_block_list_lookup_bucket (list, type);
+  GList *result = NULL;
+
+  if (!bucket)
+    return NULL;
+
+  for (guint i = bucket->blocks->len; i > 0; i--)
+    result = g_list_prepend (result, g_ptr_array_index (bucket->blocks, i - 1));
+
+  return result;
+}
+
+static HclBlock *
+hcl_block_bucket_get_by_label (HclBlockBucket *bucket, const gchar *label)
+{
+  guint epoch;
+
+  if (bucket->sealed)
+    return g_hash_table_lookup (bucket->by_label, label);
+
+  epoch = hcl_block_get_label_epoch ();
+
+  if (bucket->by_label && bucket->label_epoch != epoch)
+    g_clear_pointer (&bucket->by_label, g_hash_table_unref);
+
+  if (!bucket->by_label) {
+    bucket->by_label = g_hash_table_new (g_str_hash, g_str_equal);
+    bucket->label_epoch = epoch;
+
+    /* Walk backwards so the first block with a label is inserted last */
+    for (guint i = bucket->blocks->len; i > 0; i--) {
+      HclBlock *block = g_ptr_array_index (bucket->blocks, i - 1);
+      const gchar *block_label = hcl_block_get_label (block);
+
+      if (block_label)
+        g_hash_table_insert (bucket->by_label, (gpointer) block_label, block);
+    }
+  }
+
+  return g_hash_table_lookup (bucket->by_label, label);
+}
+
+HclBlock *
+hcl_block_list_get_by_label (HclBlockList *list, const gchar *type, const gchar *label)
+{
+  HclBlockBucket *bucket = hcl_block_list_lookup_bucket (list, type);
+
+  return bucket ? hcl_block_bucket_get_by_label (bucket, label) : NULL;
+}
+
+/*
+ * Builds the type index and every label table, and keeps them from
+ * changing again. Nothing may be added to a sealed list.
+ */
+void
+hcl_block_list_seal (HclBlockList *list)
+{
+  GHashTableIter iter;
+  gpointer bucket;
+
+  if (list->sealed)
+    return;
+
+  /* Any type will do to build the type index */
+  hcl_block_list_lookup_bucket (list, "");
+
+  g_hash_table_iter_init (&iter, list->by_type);
+  while (g_hash_table_iter_next (&iter, NULL, &bucket)) {
+    hcl_block_bucket_get_by_label (bucket, "");
+    ((HclBlockBucket *) bucket)->sealed = TRUE;
+  }
+
+  list->sealed = TRUE;
+}
+
+void
+hcl_block_list_iter_init (HclBlockList *list, HclBlockIter *iter, const gchar *type)
+{
+  HclRealBlockIter *real = (HclRealBlockIter *) iter;
+
+  if (type) {
+    HclBlockBucket *bucket = hcl_block_list_lookup_bucket (list, type);
+    real->blocks = bucket ? bucket->blocks : NULL;
+  } else {
+    real->blocks = list->blocks;
+  }
+
+  real->index = 0;
+}
+
+/**
+ * hcl_block_iter_next:
+ * @iter: an #HclBlockIter
+ * @block: (out) (optional) (transfer none): return location for the block
+ *
+ * Advances @iter to the next block. Blocks added to the container while
+ * iterating are picked up if they match.
+ *
+ * Returns: %FALSE if the end has been reached
+ */
+gboolean
+hcl_block_iter_next (HclBlockIter *iter, HclBlock **block)
+{
+  HclRealBlockIter *real = (HclRealBlockIter *) iter;
+
+  g_return_val_if_fail (iter != NULL, FALSE);
+
+  if (!real->blocks || real->index >= real->blocks->len)
+    return FALSE;
+
+  if (block)
+    *block = g_ptr_array_index (real->blocks, real->index);
+
+  real->index++;
+  return TRUE;
+}
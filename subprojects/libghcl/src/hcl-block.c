@@ -4,6 +4,8 @@
  */
 
 #include "hcl-block.h"
+#include "hcl-private.h"
+#include "hcl-writer.h"
 
 /**
  * SECTION:hcl-block
@@ -17,27 +19,45 @@ struct _HclBlock
 {
   GObject parent_instance;
 
-  gchar *type;
+  const gchar *type;       /* Interned */
   gchar *label;
-  GHashTable *attributes;  /* String -> HclValue* */
-  GPtrArray *blocks;       /* Array of HclBlock* */
+  HclMap *attributes;      /* Interned name -> HclValue*, in order set */
+  HclBlockList blocks;
+  gboolean sealed;         /* Part of a sealed document */
+  gboolean hashed;         /* @hash is set */
+  gboolean shared;         /* Added to more than one parent unsealed */
+  guint hash_epoch;        /* When @hash was set, unless sealed */
+  guint64 hash;
+  gpointer parent;         /* The HclBlock or HclDocument last added to */
+  HclParentKind parent_kind;
 };
 
 G_DEFINE_FINAL_TYPE (HclBlock, hcl_block, G_TYPE_OBJECT)
 
+/*
+ * Bumped whenever a shared block is relabelled, so that the label
+ * indexes of parents it cannot reach can tell they may be stale.
+ */
+static guint label_epoch;
+
 static void
 hcl_block_finalize (GObject *object)
 {
   HclBlock *self = HCL_BLOCK (object);
 
-  g_free (self->type);
+  HclMapIter iter;
+  gpointer value;
+
   g_free (self->label);
 
-  if (self->attributes)
-    g_hash_table_unref (self->attributes);
+  if (self->attributes) {
+    hcl_map_iter_init (&iter, self->attributes);
+    while (hcl_map_iter_next (&iter, NULL, &value))
+      hcl_value_unset_parent (value, self);
+    hcl_map_unref (self->attributes);
+  }
 
-  if (self->blocks)
-    g_ptr_array_unref (self->blocks);
+  hcl_block_list_clear (&self->blocks);
 
   G_OBJECT_CLASS (hcl_block_parent_class)->finalize (object);
 }
@@ -53,9 +73,8 @@ hcl_block_class_init (HclBlockClass *klass)
 static void
 hcl_block_init (HclBlock *self)
 {
-  self->attributes = g_hash_table_new_full (g_str_hash, g_str_equal,
-                                            g_free, g_object_unref);
-  self->blocks = g_ptr_array_new_with_free_func (g_object_unref);
+  self->attributes = hcl_map_new ();
+  hcl_block_list_init (&self->blocks, self, HCL_PARENT_BLOCK);
 }
 
 /**
@@ -69,11 +88,25 @@ hcl_block_init (HclBlock *self)
  */
 HclBlock *
 hcl_block_new (const gchar *type, const gchar *label)
+{
+  return hcl_block_new_interned (g_intern_string (type), g_strdup (label));
+}
+
+/*
+ * hcl_block_new_interned:
+ * @type: an interned block type
+ * @label: (transfer full) (nullable): block label
+ *
+ * Like hcl_block_new(), for callers that interned @type already and own
+ * a copy of @label.
+ */
+HclBlock *
+hcl_block_new_interned (const gchar *type, gchar *label)
 {
   HclBlock *self = g_object_new (HCL_TYPE_BLOCK, NULL);
 
-  self->type = g_strdup (type);
-  self->label = g_strdup (label);
+  self->type = type;
+  self->label = label;
 
   return self;
 }
@@ -121,16 +154,34 @@ void
 hcl_block_set_label (HclBlock *block, const gchar *label)
 {
   g_return_if_fail (HCL_IS_BLOCK (block));
+  g_return_if_fail (!block->sealed);
+
+  /* The label indexes borrow the old label, so drop them before it goes */
+  if (block->shared)
+    g_atomic_int_inc (&label_epoch);
+  else if (block->parent_kind == HCL_PARENT_BLOCK)
+    hcl_block_list_forget_labels (&((HclBlock *) block->parent)->blocks, block->type);
+  else if (block->parent_kind == HCL_PARENT_DOCUMENT)
+    hcl_block_list_forget_labels (hcl_document_get_block_list (block->parent), block->type);
 
   g_free (block->label);
   block->label = g_strdup (label);
+
+  hcl_hash_invalidate (block, HCL_PARENT_BLOCK);
+}
+
+guint
+hcl_block_get_label_epoch (void)
+{
+  return (guint) g_atomic_int_get (&label_epoch);
 }
 
 /**
  * hcl_block_get_attribute_names:
  * @block: an #HclBlock
  *
- * Gets all attribute names from the block.
+ * Gets all attribute names from the block, in the order they were
+ * first set.
  *
  * Returns: (transfer container) (element-type utf8): list of attribute names
  */
@@ -139,7 +190,7 @@ hcl_block_get_attribute_names (HclBlock *block)
 {
   g_return_val_if_fail (HCL_IS_BLOCK (block), NULL);
 
-  return g_hash_table_get_keys (block->attributes);
+  return hcl_map_get_keys (block->attributes);
 }
 
 /**
@@ -157,7 +208,7 @@ hcl_block_get_attribute (HclBlock *block, const gchar *name)
   g_return_val_if_fail (HCL_IS_BLOCK (block), NULL);
   g_return_val_if_fail (name != NULL, NULL);
 
-  return g_hash_table_lookup (block->attributes, name);
+  return hcl_map_lookup_string (block->attributes, name);
 }
 
 /**
@@ -172,10 +223,36 @@ void
 hcl_block_set_attribute (HclBlock *block, const gchar *name, HclValue *value)
 {
   g_return_if_fail (HCL_IS_BLOCK (block));
+  g_return_if_fail (!block->sealed);
   g_return_if_fail (name != NULL);
   g_return_if_fail (HCL_IS_VALUE (value));
 
-  g_hash_table_insert (block->attributes, g_strdup (name), value);
+  hcl_value_map_insert (block->attributes, g_intern_string (name), value,
+                        block, HCL_PARENT_BLOCK);
+}
+
+/*
+ * hcl_block_set_attribute_interned:
+ * @name: an interned attribute name
+ *
+ * Like hcl_block_set_attribute(), for callers that interned @name already.
+ */
+void
+hcl_block_set_attribute_interned (HclBlock *block, const gchar *name, HclValue *value)
+{
+  hcl_value_map_insert (block->attributes, name, value, block, HCL_PARENT_BLOCK);
+}
+
+/*
+ * hcl_block_get_attribute_interned:
+ * @name: an interned attribute name
+ *
+ * Like hcl_block_get_attribute(), for callers that interned @name already.
+ */
+HclValue *
+hcl_block_get_attribute_interned (HclBlock *block, const gchar *name)
+{
+  return hcl_map_lookup (block->attributes, name);
 }
 
 /**
@@ -193,7 +270,7 @@ hcl_block_has_attribute (HclBlock *block, const gchar *name)
   g_return_val_if_fail (HCL_IS_BLOCK (block), FALSE);
   g_return_val_if_fail (name != NULL, FALSE);
 
-  return g_hash_table_contains (block->attributes, name);
+  return hcl_map_lookup_string (block->attributes, name) != NULL;
 }
 
 /**
@@ -207,16 +284,189 @@ hcl_block_has_attribute (HclBlock *block, const gchar *name)
 GList *
 hcl_block_get_blocks (HclBlock *block)
 {
-  GList *result = NULL;
-  guint i;
-
   g_return_val_if_fail (HCL_IS_BLOCK (block), NULL);
 
-  for (i = 0; i < block->blocks->len; i++) {
-    result = g_list_prepend (result, g_ptr_array_index (block->blocks, i));
+  return hcl_block_list_get_all (&block->blocks);
+}
+
+/* Walks the attributes, keyed by interned name, in the order they were set */
+void
+hcl_block_attribute_iter_init (HclBlock *block, HclMapIter *iter)
+{
+  hcl_map_iter_init (iter, block->attributes);
+}
+
+/* The child blocks, for walkers inside the library */
+HclBlockList *
+hcl_block_get_block_list (HclBlock *block)
+{
+  return &block->blocks;
+}
+
+static inline gboolean
+hcl_block_hash_is_current (HclBlock *block)
+{
+  return block->hashed && (block->sealed || block->hash_epoch == hcl_hash_get_epoch ());
+}
+
+/*
+ * hcl_block_set_parent:
+ *
+ * Records that @block was added to @parent, so that changing it clears
+ * the cached hash of @parent. A block added to a second parent is marked
+ * shared for good.
+ */
+void
+hcl_block_set_parent (HclBlock *block, gpointer parent, HclParentKind kind)
+{
+  if (block->sealed)
+    return;
+
+  if (block->parent && block->parent != parent)
+    block->shared = TRUE;
+
+  block->parent = parent;
+  block->parent_kind = kind;
+}
+
+/* Forgets @parent, which no longer holds @block */
+void
+hcl_block_unset_parent (HclBlock *block, gpointer parent)
+{
+  if (block->sealed || block->parent != parent)
+    return;
+
+  block->parent = NULL;
+  block->parent_kind = HCL_PARENT_NONE;
+}
+
+/*
+ * hcl_block_forget_hash:
+ *
+ * Clears the cached hash of @block, for hcl_hash_invalidate(), and gives
+ * the parent to clear next: none if @block had no hash to clear. Returns
+ * %TRUE if @block is shared.
+ */
+gboolean
+hcl_block_forget_hash (HclBlock *block, gpointer *parent, HclParentKind *kind)
+{
+  *parent = block->hashed ? block->parent : NULL;
+  *kind = block->parent_kind;
+  block->hashed = FALSE;
+
+  return block->shared;
+}
+
+/* A block whose children are being hashed */
+typedef struct {
+  HclBlock *block;
+  guint index;
+  guint64 hash;
+} HclBlockHashFrame;
+
+static void
+hcl_block_hash_frame_init (HclBlockHashFrame *frame, HclBlock *block)
+{
+  frame->block = block;
+  frame->index = 0;
+  frame->hash = hcl_hash_combine (hcl_hash_combine (hcl_hash_string (block->type),
+                                                    hcl_hash_string (block->label)),
+                                  hcl_hash_attributes (block->attributes));
+}
+
+/**
+ * hcl_block_hash:
+ * @block: an #HclBlock
+ *
+ * Gets a 64-bit hash of the contents of @block: its type, label,
+ * attributes and nested blocks. Blocks with the same contents hash
+ * alike, whatever order their attributes were set in; the order of
+ * nested blocks counts.
+ *
+ * The hash is cached like that of hcl_value_hash(). Changing @block, or
+ * anything inside it, clears the cached hashes of it and of the blocks
+ * and document holding it, and nothing else.
+ *
+ * Returns: the hash
+ */
+guint64
+hcl_block_hash (HclBlock *block)
+{
+  g_autoptr(GArray) stack = NULL;
+  guint epoch;
+
+  g_return_val_if_fail (HCL_IS_BLOCK (block), 0);
+
+  if (hcl_block_hash_is_current (block))
+    return block->hash;
+
+  /* Hash one block at a time, without recursing */
+  epoch = hcl_hash_get_epoch ();
+  stack = g_array_sized_new (FALSE, FALSE, sizeof (HclBlockHashFrame), 8);
+  g_array_set_size (stack, 1);
+  hcl_block_hash_frame_init (&g_array_index (stack, HclBlockHashFrame, 0), block);
+
+  for (;;) {
+    HclBlockHashFrame *frame = &g_array_index (stack, HclBlockHashFrame, stack->len - 1);
+    GPtrArray *children = frame->block->blocks.blocks;
+    guint64 hash;
+
+    if (frame->index < children->len) {
+      HclBlock *child = g_ptr_array_index (children, frame->index++);
+
+      if (hcl_block_hash_is_current (child)) {
+        frame->hash = hcl_hash_combine (frame->hash, child->hash);
+      } else {
+        g_array_set_size (stack, stack->len + 1);
+        hcl_block_hash_frame_init (&g_array_index (stack, HclBlockHashFrame, stack->len - 1),
+                                   child);
+      }
+      continue;
+    }
+
+    hash = frame->hash;
+    frame->block->hash = hash;
+    frame->block->hash_epoch = epoch;
+    frame->block->hashed = TRUE;
+
+    g_array_set_size (stack, stack->len - 1);
+    if (stack->len == 0)
+      return hash;
+
+    frame = &g_array_index (stack, HclBlockHashFrame, stack->len - 1);
+    frame->hash = hcl_hash_combine (frame->hash, hash);
   }
+}
 
-  return g_list_reverse (result);
+/*
+ * Freezes the attribute values of @block and indexes its children in
+ * full, leaving nothing that a read could change. The children are left
+ * to the caller, so that deep documents do not recurse. Returns %FALSE
+ * if @block was sealed already.
+ */
+gboolean
+hcl_block_seal (HclBlock *block)
+{
+  HclMapIter iter;
+  gpointer value;
+
+  if (block->sealed)
+    return FALSE;
+
+  hcl_map_iter_init (&iter, block->attributes);
+  while (hcl_map_iter_next (&iter, NULL, &value))
+    hcl_value_freeze (value);
+
+  hcl_block_list_seal (&block->blocks);
+
+  /* A sealed block keeps its hash for good, and needs no parent */
+  if (!hcl_block_hash_is_current (block))
+    block->hashed = FALSE;
+  block->parent = NULL;
+  block->parent_kind = HCL_PARENT_NONE;
+  block->sealed = TRUE;
+
+  return TRUE;
 }
 
 /**
@@ -230,9 +480,10 @@ void
 hcl_block_add_block (HclBlock *block, HclBlock *child)
 {
   g_return_if_fail (HCL_IS_BLOCK (block));
+  g_return_if_fail (!block->sealed);
   g_return_if_fail (HCL_IS_BLOCK (child));
 
-  g_ptr_array_add (block->blocks, child);
+  hcl_block_list_add (&block->blocks, child);
 }
 
 /**
@@ -240,25 +491,95 @@ hcl_block_add_block (HclBlock *block, HclBlock *child)
  * @block: an #HclBlock
  * @type: block type to filter by
  *
- * Gets all nested blocks of a specific type.
+ * Gets all nested blocks of a specific type. The first call on @block
+ * indexes its children by type; later calls cost O(k) in the number of
+ * matches.
  *
  * Returns: (transfer container) (element-type HclBlock): list of matching blocks
  */
 GList *
 hcl_block_get_blocks_by_type (HclBlock *block, const gchar *type)
 {
-  GList *result = NULL;
-  guint i;
+  g_return_val_if_fail (HCL_IS_BLOCK (block), NULL);
+  g_return_val_if_fail (type != NULL, NULL);
+
+  return hcl_block_list_get_by_type (&block->blocks, type);
+}
 
+/**
+ * hcl_block_get_block_by_label:
+ * @block: an #HclBlock
+ * @type: block type
+ * @label: block label
+ *
+ * Finds the first nested block with the given type and label, using an
+ * index that is built on first use. Because lookups may build or refresh
+ * the index, a block must not be read from several threads at once unless
+ * it belongs to a sealed document.
+ *
+ * Returns: (transfer none) (nullable): the matching block, or %NULL
+ */
+HclBlock *
+hcl_block_get_block_by_label (HclBlock *block,
+                              const gchar *type,
+                              const gchar *label)
+{
   g_return_val_if_fail (HCL_IS_BLOCK (block), NULL);
   g_return_val_if_fail (type != NULL, NULL);
+  g_return_val_if_fail (label != NULL, NULL);
 
-  for (i = 0; i < block->blocks->len; i++) {
-    HclBlock *child = g_ptr_array_index (block->blocks, i);
-    if (g_strcmp0 (hcl_block_get_block_type (child), type) == 0) {
-      result = g_list_prepend (result, child);
-    }
-  }
+  return hcl_block_list_get_by_label (&block->blocks, type, label);
+}
+
+/**
+ * hcl_block_iter_init:
+ * @iter: an uninitialized #HclBlockIter
+ * @block: an #HclBlock
+ * @type: (nullable): block type to restrict to, or %NULL for all blocks
+ *
+ * Initializes @iter to walk the nested blocks of @block in document
+ * order without allocating.
+ *
+ * |[<!-- language="C" -->
+ * HclBlockIter iter;
+ * HclBlock *child;
+ *
+ * hcl_block_iter_init (&iter, block, "box");
+ * while (hcl_block_iter_next (&iter, &child))
+ *   handle_box (child);
+ * ]|
+ *
+ * The iterator is invalidated if @block is finalized.
+ */
+void
+hcl_block_iter_init (HclBlockIter *iter, HclBlock *block, const gchar *type)
+{
+  g_return_if_fail (iter != NULL);
+  g_return_if_fail (HCL_IS_BLOCK (block));
+
+  hcl_block_list_iter_init (&block->blocks, iter, type);
+}
+
+/**
+ * hcl_block_to_string:
+ * @block: an #HclBlock
+ *
+ * Formats @block as HCL text, the way an #HclWriter in the
+ * %HCL_WRITER_STYLE_PRETTY style writes it.
+ *
+ * Returns: (transfer full): a newly allocated string
+ */
+gchar *
+hcl_block_to_string (HclBlock *block)
+{
+  g_autoptr(HclWriter) writer = NULL;
+  GString *buffer;
+
+  g_return_val_if_fail (HCL_IS_BLOCK (block), NULL);
+
+  writer = hcl_writer_new ();
+  buffer = g_string_new (NULL);
+  hcl_writer_write_block (writer, block, buffer);
 
-  return g_list_reverse (result);
+  return g_string_free (buffer, FALSE);
 }
@@ -19,6 +19,20 @@ G_BEGIN_DECLS
 #define HCL_TYPE_BLOCK (hcl_block_get_type())
 G_DECLARE_FINAL_TYPE (HclBlock, hcl_block, HCL, BLOCK, GObject)
 
+/**
+ * HclBlockIter:
+ *
+ * A stack-allocated iterator over the child blocks of an #HclBlock or
+ * #HclDocument, optionally restricted to one block type. Initialize it
+ * with hcl_block_iter_init() or hcl_document_iter_init() and advance it
+ * with hcl_block_iter_next(). All fields are private.
+ */
+typedef struct {
+  /*< private >*/
+  gpointer dummy1;
+  guint dummy2;
+} HclBlockIter;
+
 /* Constructor */
 HclBlock       *hcl_block_new                   (const gchar *type,
                                                  const gchar *label);
@@ -45,9 +59,20 @@ void            hcl_block_add_block             (HclBlock *block,
                                                  HclBlock *child);
 GList          *hcl_block_get_blocks_by_type    (HclBlock *block,
                                                  const gchar *type);
+HclBlock       *hcl_block_get_block_by_label    (HclBlock *block,
+                                                 const gchar *type,
+                                                 const gchar *label);
+
+/* Iteration */
+void            hcl_block_iter_init             (HclBlockIter *iter,
+                                                 HclBlock *block,
+                                                 const gchar *type);
+gboolean        hcl_block_iter_next             (HclBlockIter *iter,
+                                                 HclBlock **block);
 
 /* Utility */
 gchar          *hcl_block_to_string             (HclBlock *block);
+guint64         hcl_block_hash                  (HclBlock *block);
 
 G_END_DECLS
 
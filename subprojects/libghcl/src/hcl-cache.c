@@ -0,0 +1,1076 @@
+/* hcl-cache.c - Binary cache of parsed HCL documents
+ *
+ * Copyright 2024 Geoff Johnson <geoff.jay@gmail.com>
+ */
+
+#include "hcl-document.h"
+#include "hcl-private.h"
+#include <errno.h>
+#include <glib/gstdio.h>
+#include <string.h>
+
+/**
+ * SECTION:hcl-cache
+ * @short_description: Binary cache of parsed documents
+ * @title: Document cache
+ *
+ * hcl_document_save_cached() writes a document to a compact binary file
+ * that hcl_document_load_cached() turns back into a document without
+ * lexing or parsing anything, for as long as the HCL file the document
+ * was parsed from does not change. hcl_document_parse_cached() does both,
+ * for a file that may be rewritten while it is being parsed.
+ */
+
+/*
+ * File layout
+ *
+ * A header, then one section per record type, each starting at a
+ * multiple of 8 bytes and holding fixed-size records in host byte order;
+ * a cache is only read back on a machine of the same byte order.
+ *
+ * Every distinct string is stored once and nul-terminated, so attribute
+ * names, object keys and block types are interned once per string on
+ * load rather than once per use. Nodes are stored breadth first: the
+ * children of every list, object and block are contiguous and come after
+ * their parent, so the loader builds them from the last to the first
+ * without recursing. The document itself is block 0. Every block also
+ * stores the index of its child blocks by type, which the loader hands
+ * to the block list as it is instead of indexing it again. Packed lists
+ * of numbers keep them in a section of their own, which the loader
+ * copies into the list in one go.
+ */
+
+#define HCL_CACHE_MAGIC "GHCLDOC"
+#define HCL_CACHE_VERSION 2
+#define HCL_CACHE_BYTE_ORDER 0x01020304
+#define HCL_CACHE_NONE G_MAXUINT32
+
+enum {
+  HCL_CACHE_STRINGS,
+  HCL_CACHE_STRING_DATA,
+  HCL_CACHE_VALUES,
+  HCL_CACHE_MEMBERS,
+  HCL_CACHE_BLOCKS,
+  HCL_CACHE_BUCKETS,
+  HCL_CACHE_POSITIONS,
+  HCL_CACHE_NUMBERS,
+  HCL_CACHE_N_SECTIONS
+};
+
+typedef struct {
+  guint32 offset;
+  guint32 count;
+} HclCacheSection;
+
+typedef struct {
+  gchar magic[8];
+  guint32 version;
+  guint32 byte_order;
+  guint64 source_size;
+  gint64 source_mtime;      /* Seconds since the epoch */
+  gint64 saved;             /* When the cache was written, likewise */
+  guint8 source_hash[32];   /* SHA-256 of the source file */
+  HclCacheSection sections[HCL_CACHE_N_SECTIONS];
+} HclCacheHeader;
+
+typedef struct {
+  guint32 offset;           /* Into the string data */
+  guint32 length;
+} HclCacheString;
+
+typedef struct {
+  guint8 type;              /* HclValueType */
+  guint8 number_type;       /* HclNumberType, of the items if packed */
+  guint16 flags;            /* HclCacheValueFlags */
+  guint32 count;            /* Items of a list, members of an object */
+  union {
+    gint64 int_value;
+    gdouble double_value;
+    guint64 index;          /* Bool value, string, first item, number or member */
+  } data;
+} HclCacheValue;
+
+typedef enum {
+  HCL_CACHE_VALUE_PACKED = 1 << 0   /* A list whose items are numbers */
+} HclCacheValueFlags;
+
+typedef struct {
+  guint32 key;              /* String */
+  guint32 value;
+} HclCacheMember;
+
+typedef struct {
+  guint32 type;             /* String, HCL_CACHE_NONE for the document */
+  guint32 label;            /* String or HCL_CACHE_NONE */
+  guint32 first_member;
+  guint32 n_members;
+  guint32 first_block;
+  guint32 n_blocks;
+  guint32 first_bucket;
+  guint32 n_buckets;
+} HclCacheBlock;
+
+typedef struct {
+  guint32 type;             /* String */
+  guint32 first;            /* Into the positions */
+  guint32 count;
+  guint32 reserved;
+} HclCacheBucket;
+
+G_STATIC_ASSERT (sizeof (HclCacheHeader) % 8 == 0);
+G_STATIC_ASSERT (sizeof (HclCacheValue) == 16);
+G_STATIC_ASSERT (sizeof (HclCacheBlock) == 32);
+
+static const gsize hcl_cache_record_sizes[HCL_CACHE_N_SECTIONS] = {
+  sizeof (HclCacheString),
+  1,
+  sizeof (HclCacheValue),
+  sizeof (HclCacheMember),
+  sizeof (HclCacheBlock),
+  sizeof (HclCacheBucket),
+  sizeof (guint32),
+  sizeof (gint64),
+};
+
+/* Gets the size and modification time of @source */
+static gboolean
+hcl_cache_stat_source (const gchar *source,
+                       guint64 *size,
+                       gint64 *mtime,
+                       GError **error)
+{
+  GStatBuf buf;
+
+  if (g_stat (source, &buf) != 0) {
+    int saved_errno = errno;
+
+    g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (saved_errno),
+                 "Failed to get attributes of %s: %s",
+                 source, g_strerror (saved_errno));
+    return FALSE;
+  }
+
+  *size = (guint64) buf.st_size;
+  *mtime = (gint64) buf.st_mtime;
+  return TRUE;
+}
+
+static void
+hcl_cache_hash_contents (const gchar *contents, gsize length, guint8 hash[32])
+{
+  g_autoptr(GChecksum) checksum = g_checksum_new (G_CHECKSUM_SHA256);
+  gsize hash_length = 32;
+
+  g_checksum_update (checksum, (const guchar *) contents, (gssize) length);
+  g_checksum_get_digest (checksum, hash, &hash_length);
+}
+
+static gboolean
+hcl_cache_hash_source (const gchar *source, guint8 hash[32], GError **error)
+{
+  g_autoptr(GBytes) contents = NULL;
+
+  contents = hcl_file_load (source, error);
+  if (!contents)
+    return FALSE;
+
+  hcl_cache_hash_contents (g_bytes_get_data (contents, NULL),
+                           g_bytes_get_size (contents), hash);
+  return TRUE;
+}
+
+/* Writing */
+
+typedef struct {
+  HclDocument *document;
+
+  GHashTable *string_ids;   /* String -> id + 1, strings borrowed */
+  GArray *strings;
+  GString *string_data;
+
+  GArray *values;
+  GPtrArray *value_nodes;   /* HclValue* of each value record */
+  GArray *members;
+  GArray *blocks;
+  GPtrArray *block_nodes;   /* HclBlock* of each block record */
+  GArray *buckets;
+  GArray *positions;
+  GArray *numbers;          /* gint64 or gdouble, of packed lists */
+} HclCacheWriter;
+
+static void
+hcl_cache_writer_init (HclCacheWriter *writer, HclDocument *document)
+{
+  writer->document = document;
+  writer->string_ids = g_hash_table_new (g_str_hash, g_str_equal);
+  writer->strings = g_array_new (FALSE, FALSE, sizeof (HclCacheString));
+  writer->string_data = g_string_new (NULL);
+  writer->values = g_array_new (FALSE, TRUE, sizeof (HclCacheValue));
+  writer->value_nodes = g_ptr_array_new ();
+  writer->members = g_array_new (FALSE, FALSE, sizeof (HclCacheMember));
+  writer->blocks = g_array_new (FALSE, TRUE, sizeof (HclCacheBlock));
+  writer->block_nodes = g_ptr_array_new ();
+  writer->buckets = g_array_new (FALSE, FALSE, sizeof (HclCacheBucket));
+  writer->positions = g_array_new (FALSE, FALSE, sizeof (guint32));
+  writer->numbers = g_array_new (FALSE, FALSE, sizeof (gint64));
+}
+
+static void
+hcl_cache_writer_clear (HclCacheWriter *writer)
+{
+  g_hash_table_unref (writer->string_ids);
+  g_array_unref (writer->strings);
+  g_string_free (writer->string_data, TRUE);
+  g_array_unref (writer->values);
+  g_ptr_array_unref (writer->value_nodes);
+  g_array_unref (writer->members);
+  g_array_unref (writer->blocks);
+  g_ptr_array_unref (writer->block_nodes);
+  g_array_unref (writer->buckets);
+  g_array_unref (writer->positions);
+  g_array_unref (writer->numbers);
+}
+
+static guint32
+hcl_cache_writer_add_string (HclCacheWriter *writer, const gchar *string)
+{
+  guint id = GPOINTER_TO_UINT (g_hash_table_lookup (writer->string_ids, string));
+  HclCacheString record;
+
+  if (id > 0)
+    return id - 1;
+
+  record.offset = writer->string_data->len;
+  record.length = (guint32) strlen (string);
+  g_string_append_len (writer->string_data, string, record.length + 1);
+  g_array_append_val (writer->strings, record);
+
+  id = writer->strings->len;
+  g_hash_table_insert (writer->string_ids, (gpointer) string, GUINT_TO_POINTER (id));
+
+  return id - 1;
+}
+
+/* Adds a value record to be filled in when the value loop gets to it */
+static guint32
+hcl_cache_writer_add_value (HclCacheWriter *writer, HclValue *value)
+{
+  g_array_set_size (writer->values, writer->values->len + 1);
+  g_ptr_array_add (writer->value_nodes, value);
+
+  return writer->values->len - 1;
+}
+
+static void
+hcl_cache_writer_add_member (HclCacheWriter *writer, const gchar *key, HclValue *value)
+{
+  HclCacheMember member;
+
+  member.key = hcl_cache_writer_add_string (writer, key);
+  member.value = hcl_cache_writer_add_value (writer, value);
+  g_array_append_val (writer->members, member);
+}
+
+/*
+ * Adds the type index of the child blocks in @list: one bucket per type,
+ * in the order the types first appear, each listing the positions of
+ * the blocks of its type.
+ */
+static void
+hcl_cache_writer_add_buckets (HclCacheWriter *writer,
+                              HclBlockList *list,
+                              HclCacheBlock *record)
+{
+  g_autoptr(GHashTable) by_type = g_hash_table_new (NULL, NULL);
+  guint32 next = writer->positions->len;
+  guint i;
+
+  record->first_bucket = writer->buckets->len;
+
+  for (i = 0; i < list->blocks->len; i++) {
+    const gchar *type = hcl_block_get_block_type (g_ptr_array_index (list->blocks, i));
+    guint bucket = GPOINTER_TO_UINT (g_hash_table_lookup (by_type, type));
+
+    if (bucket == 0) {
+      HclCacheBucket new_bucket = { hcl_cache_writer_add_string (writer, type), 0, 0, 0 };
+
+      g_array_append_val (writer->buckets, new_bucket);
+      bucket = writer->buckets->len;
+      g_hash_table_insert (by_type, (gpointer) type, GUINT_TO_POINTER (bucket));
+    }
+
+    g_array_index (writer->buckets, HclCacheBucket, bucket - 1).count++;
+  }
+
+  record->n_buckets = writer->buckets->len - record->first_bucket;
+
+  /* Lay the buckets out one after the other and fill them */
+  for (i = record->first_bucket; i < writer->buckets->len; i++) {
+    HclCacheBucket *bucket = &g_array_index (writer->buckets, HclCacheBucket, i);
+
+    bucket->first = next;
+    next += bucket->count;
+    bucket->count = 0;
+  }
+
+  g_array_set_size (writer->positions, next);
+
+  for (i = 0; i < list->blocks->len; i++) {
+    const gchar *type = hcl_block_get_block_type (g_ptr_array_index (list->blocks, i));
+    guint bucket = GPOINTER_TO_UINT (g_hash_table_lookup (by_type, type));
+    HclCacheBucket *record_bucket = &g_array_index (writer->buckets, HclCacheBucket, bucket - 1);
+
+    g_array_index (writer->positions, guint32, record_bucket->first + record_bucket->count++) = i;
+  }
+}
+
+/* Fills in the block record at @index, adding records for its children */
+static void
+hcl_cache_writer_write_block (HclCacheWriter *writer, guint index)
+{
+  HclBlock *block = g_ptr_array_index (writer->block_nodes, index);
+  HclCacheBlock record = { 0, };
+  HclBlockList *list;
+  GList *names;
+  GList *l;
+
+  record.first_member = writer->members->len;
+
+  if (block) {
+    const gchar *label = hcl_block_get_label (block);
+
+    record.type = hcl_cache_writer_add_string (writer, hcl_block_get_block_type (block));
+    record.label = label ? hcl_cache_writer_add_string (writer, label) : HCL_CACHE_NONE;
+
+    names = hcl_block_get_attribute_names (block);
+    for (l = names; l; l = l->next)
+      hcl_cache_writer_add_member (writer, l->data,
+                                   hcl_block_get_attribute_interned (block, l->data));
+    list = hcl_block_get_block_list (block);
+  } else {
+    record.type = HCL_CACHE_NONE;
+    record.label = HCL_CACHE_NONE;
+
+    names = hcl_document_get_attribute_names (writer->document);
+    for (l = names; l; l = l->next)
+      hcl_cache_writer_add_member (writer, l->data,
+                                   hcl_document_get_attribute_interned (writer->document, l->data));
+    list = hcl_document_get_block_list (writer->document);
+  }
+
+  g_list_free (names);
+  record.n_members = writer->members->len - record.first_member;
+
+  record.first_block = writer->blocks->len;
+  record.n_blocks = list->blocks->len;
+  g_array_set_size (writer->blocks, writer->blocks->len + list->blocks->len);
+  for (guint i = 0; i < list->blocks->len; i++)
+    g_ptr_array_add (writer->block_nodes, g_ptr_array_index (list->blocks, i));
+
+  hcl_cache_writer_add_buckets (writer, list, &record);
+
+  g_array_index (writer->blocks, HclCacheBlock, index) = record;
+}
+
+/* Fills in the value record at @index, adding records for its children */
+static void
+hcl_cache_writer_write_value (HclCacheWriter *writer, guint index)
+{
+  HclValue *value = g_ptr_array_index (writer->value_nodes, index);
+  HclCacheValue record = { 0, };
+  HclMapIter iter;
+  const gchar *key;
+  gpointer member;
+
+  record.type = hcl_value_get_value_type (value);
+
+  switch (record.type) {
+    case HCL_VALUE_TYPE_BOOL:
+      record.data.index = hcl_value_get_bool (value) ? 1 : 0;
+      break;
+
+    case HCL_VALUE_TYPE_NUMBER:
+      record.number_type = hcl_value_get_number_type (value);
+      if (record.number_type == HCL_NUMBER_TYPE_INTEGER)
+        record.data.int_value = hcl_value_get_int (value);
+      else
+        record.data.double_value = hcl_value_get_double (value);
+      break;
+
+    case HCL_VALUE_TYPE_STRING:
+      record.data.index = hcl_cache_writer_add_string (writer, hcl_value_get_string (value));
+      break;
+
+    case HCL_VALUE_TYPE_LIST:
+      record.count = hcl_value_list_get_length (value);
+
+      if (hcl_value_is_array (value)) {
+        const gint64 *ints = hcl_value_get_int_array (value, NULL);
+
+        record.flags = HCL_CACHE_VALUE_PACKED;
+        record.number_type = hcl_value_get_number_type (value);
+        record.data.index = writer->numbers->len;
+        g_array_append_vals (writer->numbers,
+                             ints ? (gconstpointer) ints
+                                  : (gconstpointer) hcl_value_get_double_array (value, NULL),
+                             record.count);
+        break;
+      }
+
+      record.data.index = writer->values->len;
+      for (guint i = 0; i < record.count; i++)
+        hcl_cache_writer_add_value (writer, hcl_value_list_get_item (value, i));
+      break;
+
+    case HCL_VALUE_TYPE_OBJECT:
+      record.data.index = writer->members->len;
+      hcl_value_object_iter_init (value, &iter);
+      while (hcl_map_iter_next (&iter, &key, &member))
+        hcl_cache_writer_add_member (writer, key, member);
+      record.count = writer->members->len - (guint) record.data.index;
+      break;
+
+    default:
+      break;
+  }
+
+  g_array_index (writer->values, HclCacheValue, index) = record;
+}
+
+static void
+hcl_cache_append_section (GByteArray *bytes,
+                          HclCacheHeader *header,
+                          guint section,
+                          gconstpointer data,
+                          guint count)
+{
+  static const guint8 padding[8] = { 0, };
+  gsize size = count * hcl_cache_record_sizes[section];
+
+  header->sections[section].offset = bytes->len;
+  header->sections[section].count = count;
+
+  if (size > 0)
+    g_byte_array_append (bytes, data, size);
+  g_byte_array_append (bytes, padding, (8 - size % 8) % 8);
+}
+
+/*
+ * Writes @document to @filename under @header, whose source fields are
+ * filled in already.
+ */
+static gboolean
+hcl_cache_write (HclDocument *document,
+                 const gchar *filename,
+                 HclCacheHeader *header,
+                 GError **error)
+{
+  g_autoptr(GByteArray) bytes = NULL;
+  HclCacheWriter writer;
+  guint i;
+
+  memcpy (header->magic, HCL_CACHE_MAGIC, sizeof header->magic);
+  header->version = HCL_CACHE_VERSION;
+  header->byte_order = HCL_CACHE_BYTE_ORDER;
+
+  hcl_cache_writer_init (&writer, document);
+
+  /* Both loops add the children of the record they fill to their end */
+  g_array_set_size (writer.blocks, 1);
+  g_ptr_array_add (writer.block_nodes, NULL);
+  for (i = 0; i < writer.blocks->len; i++)
+    hcl_cache_writer_write_block (&writer, i);
+
+  for (i = 0; i < writer.values->len; i++)
+    hcl_cache_writer_write_value (&writer, i);
+
+  bytes = g_byte_array_new ();
+  g_byte_array_set_size (bytes, sizeof *header);
+
+  hcl_cache_append_section (bytes, header, HCL_CACHE_STRINGS,
+                            writer.strings->data, writer.strings->len);
+  hcl_cache_append_section (bytes, header, HCL_CACHE_STRING_DATA,
+                            writer.string_data->str, writer.string_data->len);
+  hcl_cache_append_section (bytes, header, HCL_CACHE_VALUES,
+                            writer.values->data, writer.values->len);
+  hcl_cache_append_section (bytes, header, HCL_CACHE_MEMBERS,
+                            writer.members->data, writer.members->len);
+  hcl_cache_append_section (bytes, header, HCL_CACHE_BLOCKS,
+                            writer.blocks->data, writer.blocks->len);
+  hcl_cache_append_section (bytes, header, HCL_CACHE_BUCKETS,
+                            writer.buckets->data, writer.buckets->len);
+  hcl_cache_append_section (bytes, header, HCL_CACHE_POSITIONS,
+                            writer.positions->data, writer.positions->len);
+  hcl_cache_append_section (bytes, header, HCL_CACHE_NUMBERS,
+                            writer.numbers->data, writer.numbers->len);
+
+  memcpy (bytes->data, header, sizeof *header);
+
+  hcl_cache_writer_clear (&writer);
+
+  return g_file_set_contents (filename, (const gchar *) bytes->data, bytes->len, error);
+}
+
+/**
+ * hcl_document_save_cached:
+ * @document: an #HclDocument
+ * @filename: path of the cache file to write
+ * @source: path of the HCL file @document was parsed from
+ * @error: return location for error
+ *
+ * Writes @document to @filename in a compact binary form that
+ * hcl_document_load_cached() reads back without parsing. The size,
+ * modification time and a SHA-256 hash of @source are stored alongside,
+ * so the cache is only used while @source is unchanged; save it right
+ * after parsing @source. They are taken from @source as it is now, so
+ * if it may have been rewritten since it was parsed, as an editor saving
+ * it would, use hcl_document_parse_cached() instead.
+ *
+ * The file is replaced atomically, so concurrent loads see either the
+ * old cache or the new one.
+ *
+ * Returns: %TRUE on success, %FALSE on error
+ */
+gboolean
+hcl_document_save_cached (HclDocument *document,
+                          const gchar *filename,
+                          const gchar *source,
+                          GError **error)
+{
+  HclCacheHeader header = { 0, };
+
+  g_return_val_if_fail (HCL_IS_DOCUMENT (document), FALSE);
+  g_return_val_if_fail (filename != NULL, FALSE);
+  g_return_val_if_fail (source != NULL, FALSE);
+
+  header.saved = g_get_real_time () / G_USEC_PER_SEC;
+
+  if (!hcl_cache_stat_source (source, &header.source_size, &header.source_mtime, error) ||
+      !hcl_cache_hash_source (source, header.source_hash, error))
+    return FALSE;
+
+  return hcl_cache_write (document, filename, &header, error);
+}
+
+/* Reading */
+
+/*
+ * Checks that @source is still the file @header was written for. A file
+ * can change again within the second its modification time was taken
+ * in, so a time that is not older than the cache proves nothing and the
+ * contents are compared instead, as they are when only the time moved.
+ */
+static gboolean
+hcl_cache_source_matches (const HclCacheHeader *header,
+                          const gchar *source,
+                          const gchar *filename,
+                          GError **error)
+{
+  guint64 size;
+  gint64 mtime;
+  guint8 hash[32];
+
+  if (!hcl_cache_stat_source (source, &size, &mtime, error))
+    return FALSE;
+
+  if (size == header->source_size &&
+      mtime == header->source_mtime && mtime < header->saved)
+    return TRUE;
+
+  if (size == header->source_size) {
+    if (!hcl_cache_hash_source (source, hash, error))
+      return FALSE;
+
+    if (memcmp (hash, header->source_hash, sizeof hash) == 0)
+      return TRUE;
+  }
+
+  g_set_error (error, HCL_CACHE_ERROR, HCL_CACHE_ERROR_STALE,
+               "%s changed since %s was written", source, filename);
+  return FALSE;
+}
+
+typedef struct {
+  const gchar *filename;
+
+  const HclCacheString *strings;
+  guint32 n_strings;
+  const gchar *string_data;
+  const HclCacheValue *values;
+  guint32 n_values;
+  const HclCacheMember *members;
+  guint32 n_members;
+  const HclCacheBlock *blocks;
+  guint32 n_blocks;
+  const HclCacheBucket *buckets;
+  guint32 n_buckets;
+  const guint32 *positions;
+  guint32 n_positions;
+  const gint64 *numbers;    /* Or gdouble, by the list they belong to */
+  guint32 n_numbers;
+
+  const gchar **interned;   /* Per string, interned on first use */
+  HclValue **value_nodes;
+  HclBlock **block_nodes;
+} HclCacheReader;
+
+static gboolean
+hcl_cache_reader_invalid (HclCacheReader *reader, GError **error)
+{
+  g_set_error (error, HCL_CACHE_ERROR, HCL_CACHE_ERROR_INVALID,
+               "Document cache %s is damaged", reader->filename);
+  return FALSE;
+}
+
+/* Checks that @first + @count fits in @length */
+static inline gboolean
+hcl_cache_range_valid (guint64 first, guint64 count, guint64 length)
+{
+  return first <= length && count <= length - first;
+}
+
+/* Points @reader at the sections of the mapped cache and checks them */
+static gboolean
+hcl_cache_reader_init (HclCacheReader *reader,
+                       const HclCacheHeader *header,
+                       const guint8 *data,
+                       gsize length,
+                       GError **error)
+{
+  gconstpointer sections[HCL_CACHE_N_SECTIONS];
+  guint32 string_data_length;
+  guint i;
+
+  for (i = 0; i < HCL_CACHE_N_SECTIONS; i++) {
+    const HclCacheSection *section = &header->sections[i];
+
+    if (section->offset % 8 != 0 ||
+        !hcl_cache_range_valid (section->offset,
+                                (guint64) section->count * hcl_cache_record_sizes[i],
+                                length))
+      return hcl_cache_reader_invalid (reader, error);
+
+    sections[i] = data + section->offset;
+  }
+
+  reader->strings = sections[HCL_CACHE_STRINGS];
+  reader->n_strings = header->sections[HCL_CACHE_STRINGS].count;
+  reader->string_data = sections[HCL_CACHE_STRING_DATA];
+  reader->values = sections[HCL_CACHE_VALUES];
+  reader->n_values = header->sections[HCL_CACHE_VALUES].count;
+  reader->members = sections[HCL_CACHE_MEMBERS];
+  reader->n_members = header->sections[HCL_CACHE_MEMBERS].count;
+  reader->blocks = sections[HCL_CACHE_BLOCKS];
+  reader->n_blocks = header->sections[HCL_CACHE_BLOCKS].count;
+  reader->buckets = sections[HCL_CACHE_BUCKETS];
+  reader->n_buckets = header->sections[HCL_CACHE_BUCKETS].count;
+  reader->positions = sections[HCL_CACHE_POSITIONS];
+  reader->n_positions = header->sections[HCL_CACHE_POSITIONS].count;
+  reader->numbers = sections[HCL_CACHE_NUMBERS];
+  reader->n_numbers = header->sections[HCL_CACHE_NUMBERS].count;
+
+  /* Every string has to end inside the string data, with its nul */
+  string_data_length = header->sections[HCL_CACHE_STRING_DATA].count;
+  for (i = 0; i < reader->n_strings; i++) {
+    const HclCacheString *string = &reader->strings[i];
+
+    if (!hcl_cache_range_valid (string->offset, (guint64) string->length + 1,
+                                string_data_length) ||
+        reader->string_data[string->offset + string->length] != '\0')
+      return hcl_cache_reader_invalid (reader, error);
+  }
+
+  if (reader->n_blocks == 0 || reader->blocks[0].type != HCL_CACHE_NONE)
+    return hcl_cache_reader_invalid (reader, error);
+
+  reader->interned = g_new0 (const gchar *, reader->n_strings);
+  reader->value_nodes = g_new0 (HclValue *, reader->n_values);
+  reader->block_nodes = g_new0 (HclBlock *, reader->n_blocks);
+
+  return TRUE;
+}
+
+static void
+hcl_cache_reader_clear (HclCacheReader *reader)
+{
+  guint i;
+
+  for (i = 0; reader->value_nodes && i < reader->n_values; i++)
+    g_clear_object (&reader->value_nodes[i]);
+  for (i = 0; reader->block_nodes && i < reader->n_blocks; i++)
+    g_clear_object (&reader->block_nodes[i]);
+
+  g_free (reader->interned);
+  g_free (reader->value_nodes);
+  g_free (reader->block_nodes);
+}
+
+static const gchar *
+hcl_cache_reader_get_string (HclCacheReader *reader, guint64 id)
+{
+  if (id >= reader->n_strings)
+    return NULL;
+
+  return reader->string_data + reader->strings[id].offset;
+}
+
+static const gchar *
+hcl_cache_reader_get_interned (HclCacheReader *reader, guint64 id)
+{
+  if (id >= reader->n_strings)
+    return NULL;
+
+  if (!reader->interned[id])
+    reader->interned[id] = g_intern_string (hcl_cache_reader_get_string (reader, id));
+
+  return reader->interned[id];
+}
+
+/*
+ * Gets the key and the built value of member @index, whose value has to
+ * come at @first or later.
+ */
+static HclValue *
+hcl_cache_reader_get_member_value (HclCacheReader *reader,
+                                   guint64 index,
+                                   guint64 first,
+                                   const gchar **key)
+{
+  const HclCacheMember *member = &reader->members[index];
+
+  *key = hcl_cache_reader_get_interned (reader, member->key);
+  if (!*key || member->value < first || member->value >= reader->n_values)
+    return NULL;
+
+  return reader->value_nodes[member->value];
+}
+
+/* Builds the value at @index, whose children have all been built */
+static gboolean
+hcl_cache_reader_build_value (HclCacheReader *reader, guint32 index, GError **error)
+{
+  const HclCacheValue *record = &reader->values[index];
+  HclValue *value;
+  const gchar *string;
+
+  switch (record->type) {
+    case HCL_VALUE_TYPE_NULL:
+      value = hcl_value_new_null ();
+      break;
+
+    case HCL_VALUE_TYPE_BOOL:
+      value = hcl_value_new_bool (record->data.index != 0);
+      break;
+
+    case HCL_VALUE_TYPE_NUMBER:
+      if (record->number_type == HCL_NUMBER_TYPE_INTEGER)
+        value = hcl_value_new_int (record->data.int_value);
+      else if (record->number_type == HCL_NUMBER_TYPE_FLOAT)
+        value = hcl_value_new_double (record->data.double_value);
+      else
+        return hcl_cache_reader_invalid (reader, error);
+      break;
+
+    case HCL_VALUE_TYPE_STRING:
+      string = hcl_cache_reader_get_string (reader, record->data.index);
+      if (!string)
+        return hcl_cache_reader_invalid (reader, error);
+      value = hcl_value_new_string_len (string,
+                                        (gssize) reader->strings[record->data.index].length);
+      break;
+
+    case HCL_VALUE_TYPE_LIST:
+      if (record->flags & HCL_CACHE_VALUE_PACKED) {
+        if (!hcl_cache_range_valid (record->data.index, record->count, reader->n_numbers))
+          return hcl_cache_reader_invalid (reader, error);
+
+        if (record->number_type == HCL_NUMBER_TYPE_INTEGER)
+          value = hcl_value_new_int_array (reader->numbers + record->data.index, record->count);
+        else if (record->number_type == HCL_NUMBER_TYPE_FLOAT)
+          value = hcl_value_new_double_array ((const gdouble *) (reader->numbers + record->data.index),
+                                              record->count);
+        else
+          return hcl_cache_reader_invalid (reader, error);
+        break;
+      }
+
+      if (record->data.index <= index ||
+          !hcl_cache_range_valid (record->data.index, record->count, reader->n_values))
+        return hcl_cache_reader_invalid (reader, error);
+
+      value = hcl_value_new_list ();
+      for (guint32 i = 0; i < record->count; i++)
+        hcl_value_list_add_item (value,
+                                 g_object_ref (reader->value_nodes[record->data.index + i]));
+      break;
+
+    case HCL_VALUE_TYPE_OBJECT:
+      if (!hcl_cache_range_valid (record->data.index, record->count, reader->n_members))
+        return hcl_cache_reader_invalid (reader, error);
+
+      value = hcl_value_new_object ();
+      for (guint32 i = 0; i < record->count; i++) {
+        const gchar *key;
+        HclValue *member = hcl_cache_reader_get_member_value (reader,
+                                                              record->data.index + i,
+                                                              (guint64) index + 1, &key);
+
+        if (!member) {
+          g_object_unref (value);
+          return hcl_cache_reader_invalid (reader, error);
+        }
+
+        hcl_value_object_set_member_interned (value, key, g_object_ref (member));
+      }
+      break;
+
+    default:
+      return hcl_cache_reader_invalid (reader, error);
+  }
+
+  reader->value_nodes[index] = value;
+  return TRUE;
+}
+
+/*
+ * Adds the attributes, child blocks and child block index of the block
+ * at @index to @block, or to @document for block 0. The child blocks
+ * have all been built.
+ */
+static gboolean
+hcl_cache_reader_fill_block (HclCacheReader *reader,
+                             guint32 index,
+                             HclBlock *block,
+                             HclDocument *document,
+                             GError **error)
+{
+  const HclCacheBlock *record = &reader->blocks[index];
+  HclBlockList *list;
+  guint64 indexed = 0;
+  guint32 i;
+
+  if (!hcl_cache_range_valid (record->first_member, record->n_members, reader->n_members) ||
+      (record->n_blocks > 0 && record->first_block <= index) ||
+      !hcl_cache_range_valid (record->first_block, record->n_blocks, reader->n_blocks) ||
+      !hcl_cache_range_valid (record->first_bucket, record->n_buckets, reader->n_buckets))
+    return hcl_cache_reader_invalid (reader, error);
+
+  for (i = 0; i < record->n_members; i++) {
+    const gchar *key;
+    HclValue *value = hcl_cache_reader_get_member_value (reader, record->first_member + i,
+                                                         0, &key);
+
+    if (!value)
+      return hcl_cache_reader_invalid (reader, error);
+
+    if (block)
+      hcl_block_set_attribute_interned (block, key, g_object_ref (value));
+    else
+      hcl_document_set_attribute_interned (document, key, g_object_ref (value));
+  }
+
+  list = block ? hcl_block_get_block_list (block) : hcl_document_get_block_list (document);
+  for (i = 0; i < record->n_blocks; i++)
+    hcl_block_list_add (list, g_object_ref (reader->block_nodes[record->first_block + i]));
+
+  for (i = 0; i < record->n_buckets; i++) {
+    const HclCacheBucket *bucket = &reader->buckets[record->first_bucket + i];
+    const gchar *type = hcl_cache_reader_get_interned (reader, bucket->type);
+    const guint32 *positions = reader->positions + bucket->first;
+
+    if (!type || !hcl_cache_range_valid (bucket->first, bucket->count, reader->n_positions))
+      return hcl_cache_reader_invalid (reader, error);
+
+    for (guint32 j = 0; j < bucket->count; j++) {
+      if (positions[j] >= record->n_blocks ||
+          hcl_block_get_block_type (g_ptr_array_index (list->blocks, positions[j])) != type)
+        return hcl_cache_reader_invalid (reader, error);
+    }
+
+    hcl_block_list_add_bucket (list, type, positions, bucket->count);
+    indexed += bucket->count;
+  }
+
+  if (indexed != record->n_blocks)
+    return hcl_cache_reader_invalid (reader, error);
+
+  return TRUE;
+}
+
+/* Builds the document, children first */
+static HclDocument *
+hcl_cache_reader_read (HclCacheReader *reader, GError **error)
+{
+  g_autoptr(HclDocument) document = NULL;
+  guint32 i;
+
+  for (i = reader->n_values; i > 0; i--) {
+    if (!hcl_cache_reader_build_value (reader, i - 1, error))
+      return NULL;
+  }
+
+  for (i = reader->n_blocks; i > 1; i--) {
+    const HclCacheBlock *record = &reader->blocks[i - 1];
+    const gchar *type = hcl_cache_reader_get_interned (reader, record->type);
+    const gchar *label = NULL;
+    HclBlock *block;
+
+    if (record->label != HCL_CACHE_NONE)
+      label = hcl_cache_reader_get_string (reader, record->label);
+
+    if (!type || (record->label != HCL_CACHE_NONE && !label)) {
+      hcl_cache_reader_invalid (reader, error);
+      return NULL;
+    }
+
+    block = hcl_block_new_interned (type, g_strdup (label));
+    reader->block_nodes[i - 1] = block;
+
+    if (!hcl_cache_reader_fill_block (reader, i - 1, block, NULL, error))
+      return NULL;
+  }
+
+  document = hcl_document_new ();
+  if (!hcl_cache_reader_fill_block (reader, 0, NULL, document, error))
+    return NULL;
+
+  return g_steal_pointer (&document);
+}
+
+/**
+ * hcl_document_load_cached:
+ * @filename: path of a cache file written by hcl_document_save_cached()
+ * @source: path of the HCL file the cache was written for
+ * @error: return location for error
+ *
+ * Loads a document from a cache written by hcl_document_save_cached(),
+ * which is much cheaper than parsing @source again. The cache is
+ * memory-mapped and only the strings of the document are copied out of
+ * it.
+ *
+ * The cache is only used if @source has the size and the modification
+ * time it had when the cache was written. If only the modification time
+ * differs, or @source was modified within a second of the cache being
+ * written, @source is hashed and the cache is used if the hash matches.
+ * Otherwise this fails with %HCL_CACHE_ERROR_STALE, and the caller should
+ * parse @source and save the cache again.
+ *
+ * Returns: (transfer full) (nullable): the cached document, or %NULL on
+ *   error
+ */
+HclDocument *
+hcl_document_load_cached (const gchar *filename, const gchar *source, GError **error)
+{
+  g_autoptr(GMappedFile) mapping = NULL;
+  HclCacheReader reader = { 0, };
+  const HclCacheHeader *header;
+  HclDocument *document;
+  const guint8 *data;
+  gsize length;
+
+  g_return_val_if_fail (filename != NULL, NULL);
+  g_return_val_if_fail (source != NULL, NULL);
+
+  mapping = g_mapped_file_new (filename, FALSE, error);
+  if (!mapping)
+    return NULL;
+
+  data = (const guint8 *) g_mapped_file_get_contents (mapping);
+  length = g_mapped_file_get_length (mapping);
+  reader.filename = filename;
+
+  if (length < sizeof *header) {
+    hcl_cache_reader_invalid (&reader, error);
+    return NULL;
+  }
+
+  /* Mappings are page-aligned, so the header can be read in place */
+  header = (const HclCacheHeader *) data;
+
+  if (memcmp (header->magic, HCL_CACHE_MAGIC, sizeof header->magic) != 0 ||
+      header->version != HCL_CACHE_VERSION ||
+      header->byte_order != HCL_CACHE_BYTE_ORDER) {
+    g_set_error (error, HCL_CACHE_ERROR, HCL_CACHE_ERROR_INVALID,
+                 "%s is not a document cache of this version of libghcl",
+                 filename);
+    return NULL;
+  }
+
+  if (!hcl_cache_source_matches (header, source, filename, error))
+    return NULL;
+
+  if (!hcl_cache_reader_init (&reader, header, data, length, error)) {
+    hcl_cache_reader_clear (&reader);
+    return NULL;
+  }
+
+  document = hcl_cache_reader_read (&reader, error);
+  hcl_cache_reader_clear (&reader);
+
+  return document;
+}
+
+/**
+ * hcl_document_parse_cached:
+ * @filename: path of the cache file
+ * @source: path of the HCL file to parse
+ * @error: return location for error
+ *
+ * Loads @source from the cache at @filename if it is current, like
+ * hcl_document_load_cached(), and parses @source and writes the cache
+ * otherwise. The size, modification time and hash stored in the cache
+ * are those of the very bytes that were parsed, so a @source rewritten
+ * during the parse is picked up by the next load rather than hidden
+ * behind a cache of the text it replaced.
+ *
+ * The directory holding @filename is created if needed. Failing to write
+ * the cache is not an error; the next call simply parses again.
+ *
+ * Returns: (transfer full) (nullable): the document, or %NULL if @source
+ *   could not be read or parsed
+ */
+HclDocument *
+hcl_document_parse_cached (const gchar *filename, const gchar *source, GError **error)
+{
+  g_autoptr(HclParser) parser = NULL;
+  g_autofree gchar *contents = NULL;
+  g_autofree gchar *directory = NULL;
+  HclCacheHeader header = { 0, };
+  HclDocument *document;
+  gsize length;
+
+  g_return_val_if_fail (filename != NULL, NULL);
+  g_return_val_if_fail (source != NULL, NULL);
+
+  document = hcl_document_load_cached (filename, source, NULL);
+  if (document)
+    return document;
+
+  /*
+   * Taken before the read: a later change gets a modification time no
+   * older than this, which makes the next load compare hashes. The text
+   * is read rather than mapped, so a rewrite in place cannot change it
+   * under the parser.
+   */
+  header.saved = g_get_real_time () / G_USEC_PER_SEC;
+  if (!hcl_cache_stat_source (source, &header.source_size, &header.source_mtime, error) ||
+      !g_file_get_contents (source, &contents, &length, error))
+    return NULL;
+
+  parser = hcl_parser_new ();
+  document = hcl_parser_parse_text (parser, contents, length, 1, 1, error);
+  if (!document)
+    return NULL;
+
+  /* A size that moved means the file changed between the stat and the read */
+  if (length != header.source_size)
+    return document;
+
+  hcl_cache_hash_contents (contents, length, header.source_hash);
+
+  directory = g_path_get_dirname (filename);
+  if (g_mkdir_with_parents (directory, 0700) == 0)
+    hcl_cache_write (document, filename, &header, NULL);
+
+  return document;
+}
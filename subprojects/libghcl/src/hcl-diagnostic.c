@@ -0,0 +1,185 @@
+/* hcl-diagnostic.c - Parse errors collected by a recovering parse
+ *
+ * Copyright 2024 Geoff Johnson <geoff.jay@gmail.com>
+ */
+
+#include "hcl-diagnostic.h"
+
+/**
+ * SECTION:hcl-diagnostic
+ * @short_description: A parse error with its location
+ * @title: HclDiagnostic
+ *
+ * #HclDiagnostic describes one error found by
+ * hcl_parser_parse_string_recover(): the #HclParserError code, the
+ * message the non-recovering parser would have failed with, and the span
+ * of input it points at.
+ */
+
+struct _HclDiagnostic
+{
+  GObject parent_instance;
+
+  HclParserError code;
+  gchar *message;
+  gsize offset;
+  gsize length;
+  gsize line;
+  gsize column;
+};
+
+G_DEFINE_FINAL_TYPE (HclDiagnostic, hcl_diagnostic, G_TYPE_OBJECT)
+
+static void
+hcl_diagnostic_finalize (GObject *object)
+{
+  HclDiagnostic *self = HCL_DIAGNOSTIC (object);
+
+  g_free (self->message);
+
+  G_OBJECT_CLASS (hcl_diagnostic_parent_class)->finalize (object);
+}
+
+static void
+hcl_diagnostic_class_init (HclDiagnosticClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = hcl_diagnostic_finalize;
+}
+
+static void
+hcl_diagnostic_init (HclDiagnostic *self)
+{
+  (void)self; /* Suppress unused parameter warning */
+}
+
+/**
+ * hcl_diagnostic_new:
+ * @code: the error code
+ * @message: a description of the error
+ * @offset: byte offset of the span in the input
+ * @length: length of the span in bytes
+ * @line: line number of the start of the span
+ * @column: column number of the start of the span
+ *
+ * Creates a new diagnostic.
+ *
+ * Returns: (transfer full): a new #HclDiagnostic
+ */
+HclDiagnostic *
+hcl_diagnostic_new (HclParserError code,
+                    const gchar *message,
+                    gsize offset,
+                    gsize length,
+                    gsize line,
+                    gsize column)
+{
+  HclDiagnostic *self = g_object_new (HCL_TYPE_DIAGNOSTIC, NULL);
+
+  self->code = code;
+  self->message = g_strdup (message);
+  self->offset = offset;
+  self->length = length;
+  self->line = line;
+  self->column = column;
+
+  return self;
+}
+
+/**
+ * hcl_diagnostic_get_code:
+ * @diagnostic: an #HclDiagnostic
+ *
+ * Gets the error code.
+ *
+ * Returns: the error code
+ */
+HclParserError
+hcl_diagnostic_get_code (HclDiagnostic *diagnostic)
+{
+  g_return_val_if_fail (HCL_IS_DIAGNOSTIC (diagnostic), HCL_PARSER_ERROR_SYNTAX);
+
+  return diagnostic->code;
+}
+
+/**
+ * hcl_diagnostic_get_message:
+ * @diagnostic: an #HclDiagnostic
+ *
+ * Gets the error message.
+ *
+ * Returns: the error message
+ */
+const gchar *
+hcl_diagnostic_get_message (HclDiagnostic *diagnostic)
+{
+  g_return_val_if_fail (HCL_IS_DIAGNOSTIC (diagnostic), NULL);
+
+  return diagnostic->message;
+}
+
+/**
+ * hcl_diagnostic_get_offset:
+ * @diagnostic: an #HclDiagnostic
+ *
+ * Gets the byte offset in the input where the span starts.
+ *
+ * Returns: the byte offset
+ */
+gsize
+hcl_diagnostic_get_offset (HclDiagnostic *diagnostic)
+{
+  g_return_val_if_fail (HCL_IS_DIAGNOSTIC (diagnostic), 0);
+
+  return diagnostic->offset;
+}
+
+/**
+ * hcl_diagnostic_get_length:
+ * @diagnostic: an #HclDiagnostic
+ *
+ * Gets the length of the span in bytes. It is 0 for errors at the end
+ * of the input.
+ *
+ * Returns: the length in bytes
+ */
+gsize
+hcl_diagnostic_get_length (HclDiagnostic *diagnostic)
+{
+  g_return_val_if_fail (HCL_IS_DIAGNOSTIC (diagnostic), 0);
+
+  return diagnostic->length;
+}
+
+/**
+ * hcl_diagnostic_get_line:
+ * @diagnostic: an #HclDiagnostic
+ *
+ * Gets the line number where the span starts.
+ *
+ * Returns: the line number
+ */
+gsize
+hcl_diagnostic_get_line (HclDiagnostic *diagnostic)
+{
+  g_return_val_if_fail (HCL_IS_DIAGNOSTIC (diagnostic), 0);
+
+  return diagnostic->line;
+}
+
+/**
+ * hcl_diagnostic_get_column:
+ * @diagnostic: an #HclDiagnostic
+ *
+ * Gets the column number where the span starts.
+ *
+ * Returns: the column number
+ */
+gsize
+hcl_diagnostic_get_column (HclDiagnostic *diagnostic)
+{
+  g_return_val_if_fail (HCL_IS_DIAGNOSTIC (diagnostic), 0);
+
+  return diagnostic->column;
+}
@@ -0,0 +1,40 @@
+/* hcl-diagnostic.h - Parse errors collected by a recovering parse
+ *
+ * Copyright 2024 Geoff Johnson <geoff.jay@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ */
+
+#ifndef __HCL_DIAGNOSTIC_H__
+#define __HCL_DIAGNOSTIC_H__
+
+#include <glib-object.h>
+#include "hcl-enums.h"
+
+G_BEGIN_DECLS
+
+#define HCL_TYPE_DIAGNOSTIC (hcl_diagnostic_get_type())
+G_DECLARE_FINAL_TYPE (HclDiagnostic, hcl_diagnostic, HCL, DIAGNOSTIC, GObject)
+
+/* Constructor */
+HclDiagnostic  *hcl_diagnostic_new              (HclParserError code,
+                                                 const gchar *message,
+                                                 gsize offset,
+                                                 gsize length,
+                                                 gsize line,
+                                                 gsize column);
+
+/* Properties */
+HclParserError  hcl_diagnostic_get_code         (HclDiagnostic *diagnostic);
+const gchar    *hcl_diagnostic_get_message      (HclDiagnostic *diagnostic);
+gsize           hcl_diagnostic_get_offset       (HclDiagnostic *diagnostic);
+gsize           hcl_diagnostic_get_length       (HclDiagnostic *diagnostic);
+gsize           hcl_diagnostic_get_line         (HclDiagnostic *diagnostic);
+gsize           hcl_diagnostic_get_column       (HclDiagnostic *diagnostic);
+
+G_END_DECLS
+
+#endif /* __HCL_DIAGNOSTIC_H__ */
@@ -0,0 +1,371 @@
+/* hcl-diff.c - Structural differences between HCL documents
+ *
+ * Copyright 2024 Geoff Johnson <geoff.jay@gmail.com>
+ */
+
+#include "hcl-diff.h"
+#include "hcl-private.h"
+
+/**
+ * SECTION:hcl-diff
+ * @short_description: Structural differences between documents
+ * @title: HclChange
+ *
+ * hcl_document_diff() compares two documents, typically a configuration
+ * before and after a reload, and lists what changed as #HclChange
+ * objects:
+ *
+ * - attributes added, removed or set to a different value, in the
+ *   document or in a block found in both documents
+ * - blocks added, removed or modified. Blocks are matched by type and
+ *   label; unlabelled blocks, and blocks that share a type and label,
+ *   are matched in the order they appear.
+ *
+ * The changes of a document or block come before those of its children,
+ * and a modified block comes before the changes inside it. An added or
+ * removed block is a single change: its contents are not listed.
+ *
+ * Blocks and values are compared by their cached hashes, from
+ * hcl_block_hash() and hcl_value_hash(), so a subtree that did not
+ * change is passed over without walking it, and comparing a document
+ * again after a few changes hashes only what changed.
+ * The order of attributes and of object members does not count as a
+ * change, while the order of blocks and of list items does: a block
+ * whose children were only reordered is modified, with nothing changed
+ * inside it.
+ */
+
+struct _HclChange
+{
+  GObject parent_instance;
+
+  HclChangeType change_type;
+  const gchar *name;       /* Interned attribute name, NULL for a block */
+  HclBlock *old_block;
+  HclBlock *new_block;
+  HclValue *old_value;
+  HclValue *new_value;
+};
+
+G_DEFINE_FINAL_TYPE (HclChange, hcl_change, G_TYPE_OBJECT)
+
+static void
+hcl_change_finalize (GObject *object)
+{
+  HclChange *self = HCL_CHANGE (object);
+
+  g_clear_object (&self->old_block);
+  g_clear_object (&self->new_block);
+  g_clear_object (&self->old_value);
+  g_clear_object (&self->new_value);
+
+  G_OBJECT_CLASS (hcl_change_parent_class)->finalize (object);
+}
+
+static void
+hcl_change_class_init (HclChangeClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = hcl_change_finalize;
+}
+
+static void
+hcl_change_init (HclChange *self)
+{
+  (void)self; /* Suppress unused parameter warning */
+}
+
+static HclChange *
+hcl_change_new (HclChangeType change_type,
+                const gchar *name,
+                HclBlock *old_block,
+                HclBlock *new_block,
+                HclValue *old_value,
+                HclValue *new_value)
+{
+  HclChange *self = g_object_new (HCL_TYPE_CHANGE, NULL);
+
+  self->change_type = change_type;
+  self->name = name;
+  self->old_block = old_block ? g_object_ref (old_block) : NULL;
+  self->new_block = new_block ? g_object_ref (new_block) : NULL;
+  self->old_value = old_value ? g_object_ref (old_value) : NULL;
+  self->new_value = new_value ? g_object_ref (new_value) : NULL;
+
+  return self;
+}
+
+/**
+ * hcl_change_get_change_type:
+ * @change: an #HclChange
+ *
+ * Returns: whether the block or attribute was added, removed or modified
+ */
+HclChangeType
+hcl_change_get_change_type (HclChange *change)
+{
+  g_return_val_if_fail (HCL_IS_CHANGE (change), HCL_CHANGE_TYPE_MODIFIED);
+
+  return change->change_type;
+}
+
+/**
+ * hcl_change_get_name:
+ * @change: an #HclChange
+ *
+ * Gets the name of the attribute that changed.
+ *
+ * Returns: (nullable): the attribute name, or %NULL if a block changed
+ */
+const gchar *
+hcl_change_get_name (HclChange *change)
+{
+  g_return_val_if_fail (HCL_IS_CHANGE (change), NULL);
+
+  return change->name;
+}
+
+/**
+ * hcl_change_get_old_block:
+ * @change: an #HclChange
+ *
+ * Gets the block that changed, as it was in the old document. For an
+ * attribute, this is the block holding it.
+ *
+ * Returns: (transfer none) (nullable): the block, or %NULL for an added
+ *   block or an attribute of the document itself
+ */
+HclBlock *
+hcl_change_get_old_block (HclChange *change)
+{
+  g_return_val_if_fail (HCL_IS_CHANGE (change), NULL);
+
+  return change->old_block;
+}
+
+/**
+ * hcl_change_get_new_block:
+ * @change: an #HclChange
+ *
+ * Gets the block that changed, as it is in the new document. For an
+ * attribute, this is the block holding it.
+ *
+ * Returns: (transfer none) (nullable): the block, or %NULL for a removed
+ *   block or an attribute of the document itself
+ */
+HclBlock *
+hcl_change_get_new_block (HclChange *change)
+{
+  g_return_val_if_fail (HCL_IS_CHANGE (change), NULL);
+
+  return change->new_block;
+}
+
+/**
+ * hcl_change_get_old_value:
+ * @change: an #HclChange
+ *
+ * Returns: (transfer none) (nullable): the value the attribute had, or
+ *   %NULL for an added attribute or a block
+ */
+HclValue *
+hcl_change_get_old_value (HclChange *change)
+{
+  g_return_val_if_fail (HCL_IS_CHANGE (change), NULL);
+
+  return change->old_value;
+}
+
+/**
+ * hcl_change_get_new_value:
+ * @change: an #HclChange
+ *
+ * Returns: (transfer none) (nullable): the value the attribute has now,
+ *   or %NULL for a removed attribute or a block
+ */
+HclValue *
+hcl_change_get_new_value (HclChange *change)
+{
+  g_return_val_if_fail (HCL_IS_CHANGE (change), NULL);
+
+  return change->new_value;
+}
+
+typedef struct {
+  GPtrArray *changes;
+  GQueue pending;           /* Old and new block of each modified pair */
+} HclDiff;
+
+static void
+hcl_diff_add (HclDiff *diff,
+              HclChangeType change_type,
+              const gchar *name,
+              HclBlock *old_block,
+              HclBlock *new_block,
+              HclValue *old_value,
+              HclValue *new_value)
+{
+  g_ptr_array_add (diff->changes,
+                   hcl_change_new (change_type, name, old_block, new_block, old_value, new_value));
+}
+
+/* Compares the attributes of two documents, or of the blocks given */
+static void
+hcl_diff_attributes (HclDiff *diff,
+                     HclBlock *old_block,
+                     HclMapIter *old_attributes,
+                     HclBlock *new_block,
+                     HclMapIter *new_attributes)
+{
+  HclMap *old_map = old_attributes->map;
+  HclMap *new_map = new_attributes->map;
+  const gchar *name;
+  gpointer value;
+
+  while (hcl_map_iter_next (new_attributes, &name, &value)) {
+    HclValue *old_value = hcl_map_lookup (old_map, name);
+
+    if (!old_value)
+      hcl_diff_add (diff, HCL_CHANGE_TYPE_ADDED, name, old_block, new_block, NULL, value);
+    else if (old_value != value &&
+             hcl_value_hash (old_value) != hcl_value_hash (value))
+      hcl_diff_add (diff, HCL_CHANGE_TYPE_MODIFIED, name, old_block, new_block, old_value, value);
+  }
+
+  while (hcl_map_iter_next (old_attributes, &name, &value)) {
+    if (!hcl_map_lookup (new_map, name))
+      hcl_diff_add (diff, HCL_CHANGE_TYPE_REMOVED, name, old_block, new_block, value, NULL);
+  }
+}
+
+/* Blocks are matched by type, which is interned, and label */
+static guint
+hcl_diff_block_key_hash (gconstpointer key)
+{
+  HclBlock *block = (HclBlock *) key;
+  const gchar *label = hcl_block_get_label (block);
+
+  return g_direct_hash (hcl_block_get_block_type (block)) ^ (label ? g_str_hash (label) : 0);
+}
+
+static gboolean
+hcl_diff_block_key_equal (gconstpointer a, gconstpointer b)
+{
+  HclBlock *block_a = (HclBlock *) a;
+  HclBlock *block_b = (HclBlock *) b;
+
+  return hcl_block_get_block_type (block_a) == hcl_block_get_block_type (block_b) &&
+         g_strcmp0 (hcl_block_get_label (block_a), hcl_block_get_label (block_b)) == 0;
+}
+
+/* Compares the child blocks of two documents or blocks */
+static void
+hcl_diff_blocks (HclDiff *diff, HclBlockList *old_list, HclBlockList *new_list)
+{
+  g_autoptr(GHashTable) unmatched = NULL;
+  g_autofree guint *next = NULL;
+  g_autofree gboolean *matched = NULL;
+  GPtrArray *old_blocks = old_list->blocks;
+  GPtrArray *new_blocks = new_list->blocks;
+
+  if (old_blocks->len == 0 && new_blocks->len == 0)
+    return;
+
+  /*
+   * Type and label -> position + 1 of the first old block with them that
+   * is not matched yet, and @next chains each old block to the next one
+   * with the same type and label.
+   */
+  unmatched = g_hash_table_new (hcl_diff_block_key_hash, hcl_diff_block_key_equal);
+  next = g_new (guint, old_blocks->len);
+  matched = g_new0 (gboolean, old_blocks->len);
+
+  for (guint i = old_blocks->len; i > 0; i--) {
+    HclBlock *block = g_ptr_array_index (old_blocks, i - 1);
+
+    next[i - 1] = GPOINTER_TO_UINT (g_hash_table_lookup (unmatched, block));
+    g_hash_table_replace (unmatched, block, GUINT_TO_POINTER (i));
+  }
+
+  for (guint i = 0; i < new_blocks->len; i++) {
+    HclBlock *block = g_ptr_array_index (new_blocks, i);
+    guint position = GPOINTER_TO_UINT (g_hash_table_lookup (unmatched, block));
+    HclBlock *old_block;
+
+    if (position == 0) {
+      hcl_diff_add (diff, HCL_CHANGE_TYPE_ADDED, NULL, NULL, block, NULL, NULL);
+      continue;
+    }
+
+    old_block = g_ptr_array_index (old_blocks, position - 1);
+    matched[position - 1] = TRUE;
+    g_hash_table_insert (unmatched, block, GUINT_TO_POINTER (next[position - 1]));
+
+    if (old_block != block &&
+        hcl_block_hash (old_block) != hcl_block_hash (block)) {
+      hcl_diff_add (diff, HCL_CHANGE_TYPE_MODIFIED, NULL, old_block, block, NULL, NULL);
+      g_queue_push_tail (&diff->pending, old_block);
+      g_queue_push_tail (&diff->pending, block);
+    }
+  }
+
+  for (guint i = 0; i < old_blocks->len; i++) {
+    if (!matched[i])
+      hcl_diff_add (diff, HCL_CHANGE_TYPE_REMOVED, NULL, g_ptr_array_index (old_blocks, i), NULL, NULL, NULL);
+  }
+}
+
+/**
+ * hcl_document_diff:
+ * @old_document: an #HclDocument
+ * @new_document: the #HclDocument to compare it with
+ *
+ * Lists the blocks and attributes that differ between @old_document and
+ * @new_document, in the order described in the section introduction.
+ * Identical documents give an empty array.
+ *
+ * Neither document is changed, other than to cache hashes. Sealed
+ * documents have theirs worked out already, so they can be compared from
+ * any thread.
+ *
+ * Returns: (transfer full) (element-type HclChange): the changes
+ */
+GPtrArray *
+hcl_document_diff (HclDocument *old_document, HclDocument *new_document)
+{
+  HclDiff diff;
+  HclMapIter old_attributes;
+  HclMapIter new_attributes;
+
+  g_return_val_if_fail (HCL_IS_DOCUMENT (old_document), NULL);
+  g_return_val_if_fail (HCL_IS_DOCUMENT (new_document), NULL);
+
+  diff.changes = g_ptr_array_new_with_free_func (g_object_unref);
+  if (old_document == new_document)
+    return diff.changes;
+
+  g_queue_init (&diff.pending);
+
+  hcl_document_attribute_iter_init (old_document, &old_attributes);
+  hcl_document_attribute_iter_init (new_document, &new_attributes);
+  hcl_diff_attributes (&diff, NULL, &old_attributes, NULL, &new_attributes);
+  hcl_diff_blocks (&diff,
+                   hcl_document_get_block_list (old_document),
+                   hcl_document_get_block_list (new_document));
+
+  /* Breadth first, so that a block's changes come before its children's */
+  while (!g_queue_is_empty (&diff.pending)) {
+    HclBlock *old_block = g_queue_pop_head (&diff.pending);
+    HclBlock *new_block = g_queue_pop_head (&diff.pending);
+
+    hcl_block_attribute_iter_init (old_block, &old_attributes);
+    hcl_block_attribute_iter_init (new_block, &new_attributes);
+    hcl_diff_attributes (&diff, old_block, &old_attributes, new_block, &new_attributes);
+    hcl_diff_blocks (&diff,
+                     hcl_block_get_block_list (old_block),
+                     hcl_block_get_block_list (new_block));
+  }
+
+  return diff.changes;
+}
@@ -0,0 +1,39 @@
+/* hcl-diff.h - Structural differences between HCL documents
+ *
+ * Copyright 2024 Geoff Johnson <geoff.jay@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ */
+
+#ifndef __HCL_DIFF_H__
+#define __HCL_DIFF_H__
+
+#include <glib-object.h>
+#include "hcl-block.h"
+#include "hcl-document.h"
+#include "hcl-enums.h"
+#include "hcl-value.h"
+
+G_BEGIN_DECLS
+
+#define HCL_TYPE_CHANGE (hcl_change_get_type())
+G_DECLARE_FINAL_TYPE (HclChange, hcl_change, HCL, CHANGE, GObject)
+
+/* Properties */
+HclChangeType   hcl_change_get_change_type      (HclChange *change);
+const gchar    *hcl_change_get_name             (HclChange *change);
+HclBlock       *hcl_change_get_old_block        (HclChange *change);
+HclBlock       *hcl_change_get_new_block        (HclChange *change);
+HclValue       *hcl_change_get_old_value        (HclChange *change);
+HclValue       *hcl_change_get_new_value        (HclChange *change);
+
+/* Comparison */
+GPtrArray      *hcl_document_diff               (HclDocument *old_document,
+                                                 HclDocument *new_document);
+
+G_END_DECLS
+
+#endif /* __HCL_DIFF_H__ */
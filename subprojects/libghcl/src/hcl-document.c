@@ -4,6 +4,8 @@
  */
 
 #include "hcl-document.h"
+#include "hcl-private.h"
+#include "hcl-writer.h"
 
 /**
  * SECTION:hcl-document
@@ -11,14 +13,27 @@
  * @title: HclDocument
  *
  * #HclDocument represents a complete HCL configuration document.
+ *
+ * A document is not safe to read from several threads at once, since
+ * lookups build their indexes as they go. hcl_document_seal() builds
+ * them all up front and makes the document immutable, after which any
+ * number of threads can read it without locking.
  */
 
 struct _HclDocument
 {
   GObject parent_instance;
 
-  GHashTable *attributes;  /* String -> HclValue* */
-  GPtrArray *blocks;       /* Array of HclBlock* */
+  HclMap *attributes;      /* Interned name -> HclValue*, in order set */
+  HclBlockList blocks;
+
+  /* HclStatement in input order, or NULL unless filled by the parser */
+  GArray *statements;
+
+  gboolean sealed;
+  gboolean hashed;         /* @hash is set */
+  guint hash_epoch;        /* When @hash was set, unless sealed */
+  guint64 hash;
 };
 
 G_DEFINE_FINAL_TYPE (HclDocument, hcl_document, G_TYPE_OBJECT)
@@ -27,12 +42,18 @@ static void
 hcl_document_finalize (GObject *object)
 {
   HclDocument *self = HCL_DOCUMENT (object);
+  HclMapIter iter;
+  gpointer value;
 
-  if (self->attributes)
-    g_hash_table_unref (self->attributes);
+  if (self->attributes) {
+    hcl_map_iter_init (&iter, self->attributes);
+    while (hcl_map_iter_next (&iter, NULL, &value))
+      hcl_value_unset_parent (value, self);
+    hcl_map_unref (self->attributes);
+  }
 
-  if (self->blocks)
-    g_ptr_array_unref (self->blocks);
+  hcl_block_list_clear (&self->blocks);
+  g_clear_pointer (&self->statements, g_array_unref);
 
   G_OBJECT_CLASS (hcl_document_parent_class)->finalize (object);
 }
@@ -48,9 +69,8 @@ hcl_document_class_init (HclDocumentClass *klass)
 static void
 hcl_document_init (HclDocument *self)
 {
-  self->attributes = g_hash_table_new_full (g_str_hash, g_str_equal,
-                                            g_free, g_object_unref);
-  self->blocks = g_ptr_array_new_with_free_func (g_object_unref);
+  self->attributes = hcl_map_new ();
+  hcl_block_list_init (&self->blocks, self, HCL_PARENT_DOCUMENT);
 }
 
 /**
@@ -66,11 +86,69 @@ hcl_document_new (void)
   return g_object_new (HCL_TYPE_DOCUMENT, NULL);
 }
 
+static void
+hcl_statement_clear (gpointer data)
+{
+  HclStatement *statement = data;
+
+  g_object_unref (statement->node);
+}
+
+/*
+ * The statement table only describes the text the document was parsed
+ * from, so it is dropped as soon as the document is changed through the
+ * public API.
+ */
+static void
+hcl_document_forget_statements (HclDocument *document)
+{
+  g_clear_pointer (&document->statements, g_array_unref);
+}
+
+/*
+ * hcl_document_add_statement:
+ * @offset: byte offset of the first token of the statement
+ * @name: (nullable): the interned attribute name, or %NULL for a block
+ * @node: the #HclValue of the attribute or the #HclBlock
+ *
+ * Records a top-level statement of the text @document is parsed from,
+ * for hcl_parser_reparse(). The parser calls this after adding @node.
+ */
+void
+hcl_document_add_statement (HclDocument *document,
+                            gsize offset,
+                            const gchar *name,
+                            gpointer node)
+{
+  HclStatement statement = { offset, name, g_object_ref (node) };
+
+  if (!document->statements) {
+    document->statements = g_array_new (FALSE, FALSE, sizeof (HclStatement));
+    g_array_set_clear_func (document->statements, hcl_statement_clear);
+  }
+
+  g_array_append_val (document->statements, statement);
+}
+
+/*
+ * hcl_document_get_statements:
+ *
+ * Returns: (transfer none) (nullable): the top-level statements of the
+ *   text @document was parsed from, or %NULL if it was not parsed or was
+ *   changed since
+ */
+GArray *
+hcl_document_get_statements (HclDocument *document)
+{
+  return document->statements;
+}
+
 /**
  * hcl_document_get_attribute_names:
  * @document: an #HclDocument
  *
- * Gets all attribute names from the document.
+ * Gets all attribute names from the document, in the order they were
+ * first set.
  *
  * Returns: (transfer container) (element-type utf8): list of attribute names
  */
@@ -79,7 +157,7 @@ hcl_document_get_attribute_names (HclDocument *document)
 {
   g_return_val_if_fail (HCL_IS_DOCUMENT (document), NULL);
 
-  return g_hash_table_get_keys (document->attributes);
+  return hcl_map_get_keys (document->attributes);
 }
 
 /**
@@ -97,7 +175,7 @@ hcl_document_get_attribute (HclDocument *document, const gchar *name)
   g_return_val_if_fail (HCL_IS_DOCUMENT (document), NULL);
   g_return_val_if_fail (name != NULL, NULL);
 
-  return g_hash_table_lookup (document->attributes, name);
+  return hcl_map_lookup_string (document->attributes, name);
 }
 
 /**
@@ -112,10 +190,39 @@ void
 hcl_document_set_attribute (HclDocument *document, const gchar *name, HclValue *value)
 {
   g_return_if_fail (HCL_IS_DOCUMENT (document));
+  g_return_if_fail (!document->sealed);
   g_return_if_fail (name != NULL);
   g_return_if_fail (HCL_IS_VALUE (value));
 
-  g_hash_table_insert (document->attributes, g_strdup (name), value);
+  hcl_document_forget_statements (document);
+  hcl_value_map_insert (document->attributes, g_intern_string (name), value,
+                        document, HCL_PARENT_DOCUMENT);
+}
+
+/*
+ * hcl_document_set_attribute_interned:
+ * @name: an interned attribute name
+ *
+ * Like hcl_document_set_attribute(), for callers that interned @name
+ * already.
+ */
+void
+hcl_document_set_attribute_interned (HclDocument *document, const gchar *name, HclValue *value)
+{
+  hcl_value_map_insert (document->attributes, name, value, document, HCL_PARENT_DOCUMENT);
+}
+
+/*
+ * hcl_document_get_attribute_interned:
+ * @name: an interned attribute name
+ *
+ * Like hcl_document_get_attribute(), for callers that interned @name
+ * already.
+ */
+HclValue *
+hcl_document_get_attribute_interned (HclDocument *document, const gchar *name)
+{
+  return hcl_map_lookup (document->attributes, name);
 }
 
 /**
@@ -133,7 +240,7 @@ hcl_document_has_attribute (HclDocument *document, const gchar *name)
   g_return_val_if_fail (HCL_IS_DOCUMENT (document), FALSE);
   g_return_val_if_fail (name != NULL, FALSE);
 
-  return g_hash_table_contains (document->attributes, name);
+  return hcl_map_lookup_string (document->attributes, name) != NULL;
 }
 
 /**
@@ -147,16 +254,23 @@ hcl_document_has_attribute (HclDocument *document, const gchar *name)
 GList *
 hcl_document_get_blocks (HclDocument *document)
 {
-  GList *result = NULL;
-  guint i;
-
   g_return_val_if_fail (HCL_IS_DOCUMENT (document), NULL);
 
-  for (i = 0; i < document->blocks->len; i++) {
-    result = g_list_prepend (result, g_ptr_array_index (document->blocks, i));
-  }
+  return hcl_block_list_get_all (&document->blocks);
+}
+
+/* Walks the attributes, keyed by interned name, in the order they were set */
+void
+hcl_document_attribute_iter_init (HclDocument *document, HclMapIter *iter)
+{
+  hcl_map_iter_init (iter, document->attributes);
+}
 
-  return g_list_reverse (result);
+/* The top-level blocks, for walkers inside the library */
+HclBlockList *
+hcl_document_get_block_list (HclDocument *document)
+{
+  return &document->blocks;
 }
 
 /**
@@ -170,9 +284,45 @@ void
 hcl_document_add_block (HclDocument *document, HclBlock *block)
 {
   g_return_if_fail (HCL_IS_DOCUMENT (document));
+  g_return_if_fail (!document->sealed);
   g_return_if_fail (HCL_IS_BLOCK (block));
 
-  g_ptr_array_add (document->blocks, block);
+  hcl_document_forget_statements (document);
+  hcl_block_list_add (&document->blocks, block);
+}
+
+/**
+ * hcl_document_merge:
+ * @document: an #HclDocument
+ * @other: the #HclDocument to merge into @document
+ *
+ * Merges the contents of @other into @document, as if the text of @other
+ * had been appended to that of @document: attributes of @other replace
+ * attributes of the same name, and blocks of @other are added after the
+ * blocks of @document. Values and blocks are shared, not copied.
+ */
+void
+hcl_document_merge (HclDocument *document, HclDocument *other)
+{
+  HclMapIter iter;
+  const gchar *name;
+  gpointer value;
+
+  g_return_if_fail (HCL_IS_DOCUMENT (document));
+  g_return_if_fail (!document->sealed);
+  g_return_if_fail (HCL_IS_DOCUMENT (other));
+  g_return_if_fail (document != other);
+
+  hcl_document_forget_statements (document);
+
+  hcl_map_iter_init (&iter, other->attributes);
+  while (hcl_map_iter_next (&iter, &name, &value))
+    hcl_value_map_insert (document->attributes, name, g_object_ref (value),
+                          document, HCL_PARENT_DOCUMENT);
+
+  for (guint i = 0; i < other->blocks.blocks->len; i++)
+    hcl_block_list_add (&document->blocks,
+                        g_object_ref (g_ptr_array_index (other->blocks.blocks, i)));
 }
 
 /**
@@ -180,25 +330,207 @@ hcl_document_add_block (HclDocument *document, HclBlock *block)
  * @document: an #HclDocument
  * @type: block type to filter by
  *
- * Gets all top-level blocks of a specific type.
+ * Gets all top-level blocks of a specific type. The first call on
+ * @document indexes its blocks by type; later calls cost O(k) in the
+ * number of matches.
  *
  * Returns: (transfer container) (element-type HclBlock): list of matching blocks
  */
 GList *
 hcl_document_get_blocks_by_type (HclDocument *document, const gchar *type)
 {
-  GList *result = NULL;
-  guint i;
+  g_return_val_if_fail (HCL_IS_DOCUMENT (document), NULL);
+  g_return_val_if_fail (type != NULL, NULL);
+
+  return hcl_block_list_get_by_type (&document->blocks, type);
+}
 
+/**
+ * hcl_document_get_block_by_label:
+ * @document: an #HclDocument
+ * @type: block type
+ * @label: block label
+ *
+ * Finds the first top-level block with the given type and label, using
+ * an index that is built on first use. Because lookups may build or
+ * refresh the index, a document must not be read from several threads
+ * at once unless it is sealed.
+ *
+ * Returns: (transfer none) (nullable): the matching block, or %NULL
+ */
+HclBlock *
+hcl_document_get_block_by_label (HclDocument *document,
+                                 const gchar *type,
+                                 const gchar *label)
+{
   g_return_val_if_fail (HCL_IS_DOCUMENT (document), NULL);
   g_return_val_if_fail (type != NULL, NULL);
+  g_return_val_if_fail (label != NULL, NULL);
+
+  return hcl_block_list_get_by_label (&document->blocks, type, label);
+}
+
+/**
+ * hcl_document_iter_init:
+ * @iter: an uninitialized #HclBlockIter
+ * @document: an #HclDocument
+ * @type: (nullable): block type to restrict to, or %NULL for all blocks
+ *
+ * Initializes @iter to walk the top-level blocks of @document in
+ * document order without allocating. Advance it with
+ * hcl_block_iter_next().
+ */
+void
+hcl_document_iter_init (HclBlockIter *iter, HclDocument *document, const gchar *type)
+{
+  g_return_if_fail (iter != NULL);
+  g_return_if_fail (HCL_IS_DOCUMENT (document));
+
+  hcl_block_list_iter_init (&document->blocks, iter, type);
+}
+
+/**
+ * hcl_document_to_string:
+ * @document: an #HclDocument
+ *
+ * Formats @document as HCL text, the way an #HclWriter in the
+ * %HCL_WRITER_STYLE_PRETTY style writes it. To save a document, write
+ * it to a stream with hcl_writer_write_document_to_stream() instead of
+ * holding all of the text in memory.
+ *
+ * Returns: (transfer full): a newly allocated string
+ */
+gchar *
+hcl_document_to_string (HclDocument *document)
+{
+  g_autoptr(HclWriter) writer = NULL;
+  GString *buffer;
+
+  g_return_val_if_fail (HCL_IS_DOCUMENT (document), NULL);
+
+  writer = hcl_writer_new ();
+  buffer = g_string_new (NULL);
+  hcl_writer_write_document (writer, document, buffer);
+
+  return g_string_free (buffer, FALSE);
+}
+
+/* Clears the cached hash of @document, for hcl_hash_invalidate() */
+void
+hcl_document_forget_hash (HclDocument *document)
+{
+  document->hashed = FALSE;
+}
+
+/**
+ * hcl_document_hash:
+ * @document: an #HclDocument
+ *
+ * Gets a 64-bit hash of the contents of @document, built from
+ * hcl_value_hash() of its attributes and hcl_block_hash() of its
+ * blocks. Documents with the same contents hash alike, whatever order
+ * their attributes were set in, so the hash can tell whether a reloaded
+ * configuration changed, or key a cache of what was built from it.
+ *
+ * The hash is cached, and a change anywhere in @document clears the
+ * cached hashes on the way from the change up to @document and nothing
+ * else, so asking again after a few changes hashes only what changed.
+ * The hash of a sealed document is worked out when it is sealed.
+ *
+ * Returns: the hash
+ */
+guint64
+hcl_document_hash (HclDocument *document)
+{
+  GPtrArray *blocks;
+  guint64 hash;
+  guint epoch;
+
+  g_return_val_if_fail (HCL_IS_DOCUMENT (document), 0);
+
+  epoch = hcl_hash_get_epoch ();
+  if (document->hashed && (document->sealed || document->hash_epoch == epoch))
+    return document->hash;
+
+  hash = hcl_hash_combine (HCL_HASH_SEED, hcl_hash_attributes (document->attributes));
+
+  blocks = document->blocks.blocks;
+  for (guint i = 0; i < blocks->len; i++)
+    hash = hcl_hash_combine (hash, hcl_block_hash (g_ptr_array_index (blocks, i)));
+
+  document->hash = hash;
+  document->hash_epoch = epoch;
+  document->hashed = TRUE;
+
+  return hash;
+}
 
-  for (i = 0; i < document->blocks->len; i++) {
-    HclBlock *block = g_ptr_array_index (document->blocks, i);
-    if (g_strcmp0 (hcl_block_get_block_type (block), type) == 0) {
-      result = g_list_prepend (result, block);
-    }
+/**
+ * hcl_document_seal:
+ * @document: an #HclDocument
+ *
+ * Makes @document and everything in it immutable: every attribute value
+ * is frozen with hcl_value_freeze(), and every block index is built, so
+ * that no lookup has anything left to fill in. Changing a sealed
+ * document, or any block or value in it, is a programmer error.
+ *
+ * A sealed document can be read from any number of threads at once
+ * without locking, as long as each holds a reference to it. Sealing a
+ * document that is already sealed does nothing.
+ */
+void
+hcl_document_seal (HclDocument *document)
+{
+  g_autoptr(GPtrArray) pending = NULL;
+  HclMapIter iter;
+  gpointer value;
+
+  g_return_if_fail (HCL_IS_DOCUMENT (document));
+
+  if (document->sealed)
+    return;
+
+  hcl_map_iter_init (&iter, document->attributes);
+  while (hcl_map_iter_next (&iter, NULL, &value))
+    hcl_value_freeze (value);
+
+  hcl_block_list_seal (&document->blocks);
+
+  /* Blocks can nest deeper than the stack allows, so walk them by hand */
+  pending = g_ptr_array_new ();
+  for (guint i = 0; i < document->blocks.blocks->len; i++)
+    g_ptr_array_add (pending, g_ptr_array_index (document->blocks.blocks, i));
+
+  while (pending->len > 0) {
+    HclBlock *block = g_ptr_array_steal_index_fast (pending, pending->len - 1);
+    HclBlockList *children;
+
+    /* A block shared with another sealed document is done already */
+    if (!hcl_block_seal (block))
+      continue;
+
+    children = hcl_block_get_block_list (block);
+    for (guint i = 0; i < children->blocks->len; i++)
+      g_ptr_array_add (pending, g_ptr_array_index (children->blocks, i));
   }
 
-  return g_list_reverse (result);
+  /* Cache every hash now, so that reading one writes nothing */
+  if (document->hashed && document->hash_epoch != hcl_hash_get_epoch ())
+    document->hashed = FALSE;
+  document->sealed = TRUE;
+  hcl_document_hash (document);
+}
+
+/**
+ * hcl_document_is_sealed:
+ * @document: an #HclDocument
+ *
+ * Returns: %TRUE if hcl_document_seal() has been called on @document
+ */
+gboolean
+hcl_document_is_sealed (HclDocument *document)
+{
+  g_return_val_if_fail (HCL_IS_DOCUMENT (document), FALSE);
+
+  return document->sealed;
 }
@@ -39,9 +39,34 @@ void            hcl_document_add_block          (HclDocument *document,
                                                  HclBlock *block);
 GList          *hcl_document_get_blocks_by_type (HclDocument *document,
                                                  const gchar *type);
+HclBlock       *hcl_document_get_block_by_label (HclDocument *document,
+                                                 const gchar *type,
+                                                 const gchar *label);
+void            hcl_document_iter_init          (HclBlockIter *iter,
+                                                 HclDocument *document,
+                                                 const gchar *type);
 
 /* Utility */
+void            hcl_document_merge              (HclDocument *document,
+                                                 HclDocument *other);
 gchar          *hcl_document_to_string          (HclDocument *document);
+guint64         hcl_document_hash               (HclDocument *document);
+
+/* Sharing between threads */
+void            hcl_document_seal               (HclDocument *document);
+gboolean        hcl_document_is_sealed          (HclDocument *document);
+
+/* Binary cache */
+gboolean        hcl_document_save_cached        (HclDocument *document,
+                                                 const gchar *filename,
+                                                 const gchar *source,
+                                                 GError **error);
+HclDocument    *hcl_document_load_cached        (const gchar *filename,
+                                                 const gchar *source,
+                                                 GError **error);
+HclDocument    *hcl_document_parse_cached       (const gchar *filename,
+                                                 const gchar *source,
+                                                 GError **error);
 
 G_END_DECLS
 
@@ -15,3 +15,25 @@ hcl_parser_error_quark (void)
 {
   return g_quark_from_static_string ("hcl-parser-error-quark");
 }
+
+/**
+ * hcl_path_error_quark:
+ *
+ * Returns: the error quark for HCL path expression errors
+ */
+GQuark
+hcl_path_error_quark (void)
+{
+  return g_quark_from_static_string ("hcl-path-error-quark");
+}
+
+/**
+ * hcl_cache_error_quark:
+ *
+ * Returns: the error quark for HCL document cache errors
+ */
+GQuark
+hcl_cache_error_quark (void)
+{
+  return g_quark_from_static_string ("hcl-cache-error-quark");
+}
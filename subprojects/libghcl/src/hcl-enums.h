@@ -91,6 +91,69 @@ typedef enum {
   HCL_TOKEN_TYPE_COMMENT
 } HclTokenType;
 
+/**
+ * HclSpanFlags:
+ * @HCL_SPAN_FLAG_NONE: No flags
+ * @HCL_SPAN_FLAG_ESCAPED: The string literal contains escape sequences
+ *   and its value differs from the text between the quotes
+ * @HCL_SPAN_FLAG_FLOAT: The number has a fraction or an exponent and
+ *   its value is a double
+ *
+ * Facts about a span token that the lexer learns while scanning it, so
+ * consumers don't have to rescan the lexeme.
+ */
+typedef enum {
+  HCL_SPAN_FLAG_NONE    = 0,
+  HCL_SPAN_FLAG_ESCAPED = 1 << 0,
+  HCL_SPAN_FLAG_FLOAT   = 1 << 1
+} HclSpanFlags;
+
+/**
+ * HclEventResult:
+ * @HCL_EVENT_RESULT_CONTINUE: Keep parsing
+ * @HCL_EVENT_RESULT_SKIP: Skip the block, attribute value, list, object
+ *   or object member the event announced, without reporting anything
+ *   inside it; for other events this is the same as
+ *   %HCL_EVENT_RESULT_CONTINUE
+ * @HCL_EVENT_RESULT_STOP: Stop parsing
+ *
+ * What the parser should do after an #HclParserEvents callback returns.
+ */
+typedef enum {
+  HCL_EVENT_RESULT_CONTINUE,
+  HCL_EVENT_RESULT_SKIP,
+  HCL_EVENT_RESULT_STOP
+} HclEventResult;
+
+/**
+ * HclWriterStyle:
+ * @HCL_WRITER_STYLE_PRETTY: Indented, with spaces around `=` and after
+ *   commas, one object member per line and lists of lists or objects
+ *   split over several lines
+ * @HCL_WRITER_STYLE_COMPACT: As few bytes as possible; every attribute
+ *   and block still starts on a line of its own
+ *
+ * How an #HclWriter lays out the text it writes.
+ */
+typedef enum {
+  HCL_WRITER_STYLE_PRETTY,
+  HCL_WRITER_STYLE_COMPACT
+} HclWriterStyle;
+
+/**
+ * HclChangeType:
+ * @HCL_CHANGE_TYPE_ADDED: Only in the new document
+ * @HCL_CHANGE_TYPE_REMOVED: Only in the old document
+ * @HCL_CHANGE_TYPE_MODIFIED: In both documents, with different contents
+ *
+ * What an #HclChange found between two documents.
+ */
+typedef enum {
+  HCL_CHANGE_TYPE_ADDED,
+  HCL_CHANGE_TYPE_REMOVED,
+  HCL_CHANGE_TYPE_MODIFIED
+} HclChangeType;
+
 /**
  * HclParserError:
  * @HCL_PARSER_ERROR_SYNTAX: Syntax error
@@ -101,6 +164,8 @@ typedef enum {
  * @HCL_PARSER_ERROR_INVALID_NUMBER: Invalid number format
  * @HCL_PARSER_ERROR_INVALID_CHARACTER: Invalid character
  * @HCL_PARSER_ERROR_BUFFER_OVERFLOW: Buffer overflow
+ * @HCL_PARSER_ERROR_TOO_DEEP: Blocks, lists and objects are nested deeper
+ *   than the parser allows, see hcl_parser_set_max_depth()
  *
  * Parser error codes.
  */
@@ -112,12 +177,45 @@ typedef enum {
   HCL_PARSER_ERROR_UNTERMINATED_STRING,
   HCL_PARSER_ERROR_INVALID_NUMBER,
   HCL_PARSER_ERROR_INVALID_CHARACTER,
-  HCL_PARSER_ERROR_BUFFER_OVERFLOW
+  HCL_PARSER_ERROR_BUFFER_OVERFLOW,
+  HCL_PARSER_ERROR_TOO_DEEP
 } HclParserError;
 
 #define HCL_PARSER_ERROR hcl_parser_error_quark()
 GQuark hcl_parser_error_quark (void);
 
+/**
+ * HclPathError:
+ * @HCL_PATH_ERROR_SYNTAX: The path expression is malformed
+ * @HCL_PATH_ERROR_INVALID_INDEX: A list index is out of range
+ *
+ * Path expression error codes.
+ */
+typedef enum {
+  HCL_PATH_ERROR_SYNTAX,
+  HCL_PATH_ERROR_INVALID_INDEX
+} HclPathError;
+
+#define HCL_PATH_ERROR hcl_path_error_quark()
+GQuark hcl_path_error_quark (void);
+
+/**
+ * HclCacheError:
+ * @HCL_CACHE_ERROR_INVALID: The file is not a document cache, was
+ *   written by another version of libghcl or is damaged
+ * @HCL_CACHE_ERROR_STALE: The source file changed since the cache was
+ *   written
+ *
+ * Document cache error codes.
+ */
+typedef enum {
+  HCL_CACHE_ERROR_INVALID,
+  HCL_CACHE_ERROR_STALE
+} HclCacheError;
+
+#define HCL_CACHE_ERROR hcl_cache_error_quark()
+GQuark hcl_cache_error_quark (void);
+
 G_END_DECLS
 
 #endif /* __HCL_ENUMS_H__ */
@@ -0,0 +1,1392 @@
+/* hcl-frozen-document.c - Compact read-only HCL document
+ *
+ * Copyright 2024 Geoff Johnson <geoff.jay@gmail.com>
+ */
+
+#include "hcl-frozen-document.h"
+#include "hcl-parser.h"
+#include "hcl-private.h"
+#include <string.h>
+
+/**
+ * SECTION:hcl-frozen-document
+ * @short_description: Compact read-only HCL document
+ * @title: HclFrozenDocument
+ *
+ * #HclFrozenDocument holds a parsed configuration in two allocations: one
+ * block holding every node, and a #GStringChunk holding every string,
+ * with keys, block types and labels interned. Freeing the document
+ * frees both at once, so dropping a large configuration on reload costs
+ * two frees rather than one per value.
+ *
+ * Nodes are plain structs laid out in flat arrays; the items of a list,
+ * the members of an object and the attributes and child blocks of a
+ * block are contiguous. Attributes and object members keep the order
+ * they were set in, as in #HclDocument, and are found by binary search
+ * through a sorted index kept alongside them. The accessors mirror those
+ * of #HclDocument, #HclBlock and #HclValue, but a frozen document cannot
+ * be modified and the #HclFrozenBlock and #HclFrozenValue pointers it
+ * hands out are only valid as long as the document is alive.
+ */
+
+typedef struct _HclFrozenMember HclFrozenMember;
+
+struct _HclFrozenValue
+{
+  HclValueType type;
+  HclNumberType number_type;
+  guint n_children;
+  guint sorted;                       /* As a member: see below */
+
+  union {
+    gboolean bool_value;
+    gint64 int_value;
+    gdouble double_value;
+    const gchar *string_value;
+    gsize first;                      /* Child index while building */
+    const HclFrozenValue *items;      /* List items */
+    const HclFrozenMember *members;   /* Object members */
+  } data;
+};
+
+/*
+ * The members of a block or an object are in the order they were set.
+ * The @sorted field of the value of the k-th member gives the position
+ * of the member with the k-th smallest key, so the index for binary
+ * search fits in what would otherwise be padding.
+ */
+struct _HclFrozenMember
+{
+  const gchar *key;
+  HclFrozenValue value;
+};
+
+struct _HclFrozenBlock
+{
+  const gchar *type;
+  const gchar *label;
+  guint n_attributes;
+  guint n_blocks;
+
+  union {
+    gsize first;
+    const HclFrozenMember *members;
+  } attributes;
+
+  union {
+    gsize first;
+    const HclFrozenBlock *blocks;
+  } blocks;
+};
+
+struct _HclFrozenDocument
+{
+  GObject parent_instance;
+
+  GStringChunk *strings;
+  gpointer arena;
+  const HclFrozenBlock *root;
+};
+
+G_DEFINE_FINAL_TYPE (HclFrozenDocument, hcl_frozen_document, G_TYPE_OBJECT)
+
+static void
+hcl_frozen_document_finalize (GObject *object)
+{
+  HclFrozenDocument *self = HCL_FROZEN_DOCUMENT (object);
+
+  g_string_chunk_free (self->strings);
+  g_free (self->arena);
+
+  G_OBJECT_CLASS (hcl_frozen_document_parent_class)->finalize (object);
+}
+
+static void
+hcl_frozen_document_class_init (HclFrozenDocumentClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = hcl_frozen_document_finalize;
+}
+
+static void
+hcl_frozen_document_init (HclFrozenDocument *self)
+{
+  (void)self; /* Suppress unused parameter warning */
+}
+
+/*
+ * Building
+ *
+ * Nodes arrive depth first, so the children of a container are not
+ * contiguous while it is open. They are collected on pending stacks
+ * instead, and moved to the end of the finished arrays in one piece when
+ * the container closes. Children refer to each other by index until the
+ * finished arrays are copied into the arena and the indices turned into
+ * pointers.
+ */
+
+typedef enum {
+  HCL_FROZEN_FRAME_BLOCK,
+  HCL_FROZEN_FRAME_LIST,
+  HCL_FROZEN_FRAME_OBJECT
+} HclFrozenFrameKind;
+
+typedef struct {
+  HclFrozenFrameKind kind;
+  const gchar *key;           /* Key of the member whose value comes next */
+  const gchar *type;
+  const gchar *label;
+  guint values_start;
+  guint members_start;
+  guint blocks_start;
+} HclFrozenFrame;
+
+typedef struct {
+  GStringChunk *strings;
+
+  /* Finished nodes, in their final order */
+  GArray *values;
+  GArray *members;
+  GArray *blocks;
+
+  /* Children of the containers that are still open */
+  GArray *pending_values;
+  GArray *pending_members;
+  GArray *pending_blocks;
+  GArray *frames;
+
+  HclFrozenBlock root;
+} HclFrozenBuilder;
+
+static void
+hcl_frozen_builder_init (HclFrozenBuilder *builder, gsize size_hint)
+{
+  builder->strings = g_string_chunk_new (CLAMP (size_hint, 256, 64 * 1024));
+  builder->values = g_array_new (FALSE, FALSE, sizeof (HclFrozenValue));
+  builder->members = g_array_new (FALSE, FALSE, sizeof (HclFrozenMember));
+  builder->blocks = g_array_new (FALSE, FALSE, sizeof (HclFrozenBlock));
+  builder->pending_values = g_array_new (FALSE, FALSE, sizeof (HclFrozenValue));
+  builder->pending_members = g_array_new (FALSE, FALSE, sizeof (HclFrozenMember));
+  builder->pending_blocks = g_array_new (FALSE, FALSE, sizeof (HclFrozenBlock));
+  builder->frames = g_array_new (FALSE, FALSE, sizeof (HclFrozenFrame));
+}
+
+static void
+hcl_frozen_builder_clear (HclFrozenBuilder *builder)
+{
+  g_clear_pointer (&builder->strings, g_string_chunk_free);
+  g_array_unref (builder->values);
+  g_array_unref (builder->members);
+  g_array_unref (builder->blocks);
+  g_array_unref (builder->pending_values);
+  g_array_unref (builder->pending_members);
+  g_array_unref (builder->pending_blocks);
+  g_array_unref (builder->frames);
+}
+
+static HclFrozenFrame *
+hcl_frozen_builder_top (HclFrozenBuilder *builder)
+{
+  return &g_array_index (builder->frames, HclFrozenFrame, builder->frames->len - 1);
+}
+
+static const gchar *
+hcl_frozen_builder_intern (HclFrozenBuilder *builder, const gchar *string)
+{
+  return string ? g_string_chunk_insert_const (builder->strings, string) : NULL;
+}
+
+static void
+hcl_frozen_builder_push (HclFrozenBuilder *builder,
+                         HclFrozenFrameKind kind,
+                         const gchar *type,
+                         const gchar *label)
+{
+  HclFrozenFrame frame = { 0, };
+
+  frame.kind = kind;
+  frame.type = hcl_frozen_builder_intern (builder, type);
+  frame.label = hcl_frozen_builder_intern (builder, label);
+  frame.values_start = builder->pending_values->len;
+  frame.members_start = builder->pending_members->len;
+  frame.blocks_start = builder->pending_blocks->len;
+
+  g_array_append_val (builder->frames, frame);
+}
+
+static void
+hcl_frozen_builder_set_key (HclFrozenBuilder *builder, const gchar *key)
+{
+  hcl_frozen_builder_top (builder)->key = hcl_frozen_builder_intern (builder, key);
+}
+
+static void
+hcl_frozen_builder_add_value (HclFrozenBuilder *builder, const HclFrozenValue *value)
+{
+  HclFrozenFrame *frame = hcl_frozen_builder_top (builder);
+
+  if (frame->kind == HCL_FROZEN_FRAME_LIST) {
+    g_array_append_vals (builder->pending_values, value, 1);
+  } else {
+    HclFrozenMember member = { frame->key, *value };
+    g_array_append_val (builder->pending_members, member);
+  }
+}
+
+/* Moves the pending elements from @start on to the end of @finished */
+static gsize
+hcl_frozen_builder_move (GArray *pending, guint start, GArray *finished)
+{
+  gsize first = finished->len;
+
+  g_array_append_vals (finished,
+                       pending->data + (gsize) start * g_array_get_element_size (pending),
+                       pending->len - start);
+  g_array_set_size (pending, start);
+
+  return first;
+}
+
+/* Orders member positions by key, and by position among equal keys */
+static gint
+hcl_frozen_position_compare (gconstpointer a, gconstpointer b, gpointer user_data)
+{
+  const HclFrozenMember *members = user_data;
+  guint first = *(const guint *) a;
+  guint second = *(const guint *) b;
+  gint cmp = strcmp (members[first].key, members[second].key);
+
+  if (cmp != 0)
+    return cmp;
+
+  return first < second ? -1 : first > second;
+}
+
+/*
+ * Fills in the sorted index of the pending members from @start on. A key
+ * set more than once keeps its first position and its last value, as in
+ * #HclMap, and the other members with it are dropped. Returns the number
+ * of members left.
+ */
+static guint
+hcl_frozen_builder_index_members (HclFrozenBuilder *builder, guint start)
+{
+  HclFrozenMember *members;
+  guint count = builder->pending_members->len - start;
+  g_autofree guint *order = NULL;
+  g_autofree guint *moved = NULL;
+  gboolean duplicates = FALSE;
+  guint kept = 0;
+  guint i;
+
+  if (count == 0)
+    return 0;
+
+  members = &g_array_index (builder->pending_members, HclFrozenMember, start);
+
+  order = g_new (guint, count);
+  for (i = 0; i < count; i++)
+    order[i] = i;
+
+  g_qsort_with_data (order, (gint) count, sizeof (guint),
+                     hcl_frozen_position_compare, members);
+
+  /* Each run of equal keys keeps its first position and its last value */
+  for (i = 0; i < count; i++) {
+    guint end = i;
+
+    while (end + 1 < count && members[order[end + 1]].key == members[order[i]].key)
+      end++;
+
+    if (end > i) {
+      members[order[i]].value = members[order[end]].value;
+      for (guint j = i + 1; j <= end; j++)
+        members[order[j]].key = NULL;
+      duplicates = TRUE;
+    }
+
+    order[kept++] = order[i];
+    i = end;
+  }
+
+  /* Close up the gaps, then point the index at the new positions */
+  if (duplicates) {
+    moved = g_new (guint, count);
+
+    for (i = 0, kept = 0; i < count; i++) {
+      moved[i] = kept;
+      if (members[i].key != NULL)
+        members[kept++] = members[i];
+    }
+
+    for (i = 0; i < kept; i++)
+      order[i] = moved[order[i]];
+  }
+
+  for (i = 0; i < kept; i++)
+    members[i].value.sorted = order[i];
+
+  g_array_set_size (builder->pending_members, start + kept);
+  return kept;
+}
+
+static void
+hcl_frozen_builder_pop_container (HclFrozenBuilder *builder)
+{
+  HclFrozenFrame frame = *hcl_frozen_builder_top (builder);
+  HclFrozenValue value = { 0, };
+
+  if (frame.kind == HCL_FROZEN_FRAME_LIST) {
+    value.type = HCL_VALUE_TYPE_LIST;
+    value.n_children = builder->pending_values->len - frame.values_start;
+    value.data.first = hcl_frozen_builder_move (builder->pending_values,
+                                                frame.values_start,
+                                                builder->values);
+  } else {
+    value.type = HCL_VALUE_TYPE_OBJECT;
+    value.n_children = hcl_frozen_builder_index_members (builder, frame.members_start);
+    value.data.first = hcl_frozen_builder_move (builder->pending_members,
+                                                frame.members_start,
+                                                builder->members);
+  }
+
+  g_array_set_size (builder->frames, builder->frames->len - 1);
+  hcl_frozen_builder_add_value (builder, &value);
+}
+
+static void
+hcl_frozen_builder_pop_block (HclFrozenBuilder *builder)
+{
+  HclFrozenFrame frame = *hcl_frozen_builder_top (builder);
+  HclFrozenBlock block = { 0, };
+
+  block.type = frame.type;
+  block.label = frame.label;
+  block.n_attributes = hcl_frozen_builder_index_members (builder, frame.members_start);
+  block.attributes.first = hcl_frozen_builder_move (builder->pending_members,
+                                                    frame.members_start,
+                                                    builder->members);
+  block.n_blocks = builder->pending_blocks->len - frame.blocks_start;
+  block.blocks.first = hcl_frozen_builder_move (builder->pending_blocks,
+                                                frame.blocks_start,
+                                                builder->blocks);
+
+  g_array_set_size (builder->frames, builder->frames->len - 1);
+
+  /* The document itself is the outermost block */
+  if (builder->frames->len == 0)
+    builder->root = block;
+  else
+    g_array_append_val (builder->pending_blocks, block);
+}
+
+static void
+hcl_frozen_value_relocate (HclFrozenValue *value,
+                           const HclFrozenValue *values,
+                           const HclFrozenMember *members)
+{
+  if (value->type == HCL_VALUE_TYPE_LIST)
+    value->data.items = values + value->data.first;
+  else if (value->type == HCL_VALUE_TYPE_OBJECT)
+    value->data.members = members + value->data.first;
+}
+
+static void
+hcl_frozen_block_relocate (HclFrozenBlock *block,
+                           const HclFrozenMember *members,
+                           const HclFrozenBlock *blocks)
+{
+  block->attributes.members = members + block->attributes.first;
+  block->blocks.blocks = blocks + block->blocks.first;
+}
+
+/* Copies the finished nodes into one allocation owned by a new document */
+static HclFrozenDocument *
+hcl_frozen_builder_finish (HclFrozenBuilder *builder)
+{
+  HclFrozenDocument *self = g_object_new (HCL_TYPE_FROZEN_DOCUMENT, NULL);
+  gsize values_size = builder->values->len * sizeof (HclFrozenValue);
+  gsize members_size = builder->members->len * sizeof (HclFrozenMember);
+  gsize blocks_size = (builder->blocks->len + 1) * sizeof (HclFrozenBlock);
+  HclFrozenValue *values;
+  HclFrozenMember *members;
+  HclFrozenBlock *blocks;
+  guint i;
+
+  g_assert (builder->frames->len == 0);
+
+  /* Every node type is a multiple of 8 bytes, so the arrays stay aligned */
+  self->arena = g_malloc (values_size + members_size + blocks_size);
+  values = self->arena;
+  members = (HclFrozenMember *) ((guint8 *) self->arena + values_size);
+  blocks = (HclFrozenBlock *) ((guint8 *) members + members_size);
+
+  if (values_size > 0)
+    memcpy (values, builder->values->data, values_size);
+  if (members_size > 0)
+    memcpy (members, builder->members->data, members_size);
+  if (builder->blocks->len > 0)
+    memcpy (blocks, builder->blocks->data, blocks_size - sizeof (HclFrozenBlock));
+  blocks[builder->blocks->len] = builder->root;
+
+  for (i = 0; i < builder->values->len; i++)
+    hcl_frozen_value_relocate (&values[i], values, members);
+
+  for (i = 0; i < builder->members->len; i++)
+    hcl_frozen_value_relocate (&members[i].value, values, members);
+
+  for (i = 0; i <= builder->blocks->len; i++)
+    hcl_frozen_block_relocate (&blocks[i], members, blocks);
+
+  self->root = &blocks[builder->blocks->len];
+  self->strings = g_steal_pointer (&builder->strings);
+
+  return self;
+}
+
+/* Parser events */
+
+static HclEventResult
+hcl_frozen_on_block_begin (const gchar *type,
+                           const gchar *label,
+                           gpointer user_data,
+                           GError **error)
+{
+  (void)error;
+
+  hcl_frozen_builder_push (user_data, HCL_FROZEN_FRAME_BLOCK, type, label);
+  return HCL_EVENT_RESULT_CONTINUE;
+}
+
+static HclEventResult
+hcl_frozen_on_block_end (gpointer user_data, GError **error)
+{
+  (void)error;
+
+  hcl_frozen_builder_pop_block (user_data);
+  return HCL_EVENT_RESULT_CONTINUE;
+}
+
+static HclEventResult
+hcl_frozen_on_key (const gchar *name, gpointer user_data, GError **error)
+{
+  (void)error;
+
+  hcl_frozen_builder_set_key (user_data, name);
+  return HCL_EVENT_RESULT_CONTINUE;
+}
+
+static HclEventResult
+hcl_frozen_on_value (const HclEventValue *event, gpointer user_data, GError **error)
+{
+  HclFrozenBuilder *builder = user_data;
+  HclFrozenValue value = { 0, };
+
+  (void)error;
+
+  value.type = event->type;
+
+  switch (event->type) {
+    case HCL_VALUE_TYPE_STRING:
+      value.data.string_value = g_string_chunk_insert_len (builder->strings,
+                                                           event->string,
+                                                           (gssize) event->length);
+      break;
+
+    case HCL_VALUE_TYPE_NUMBER:
+      value.number_type = event->number_type;
+      if (event->number_type == HCL_NUMBER_TYPE_INTEGER)
+        value.data.int_value = event->int_value;
+      else
+        value.data.double_value = event->double_value;
+      break;
+
+    case HCL_VALUE_TYPE_BOOL:
+      value.data.bool_value = event->bool_value;
+      break;
+
+    default:
+      break;
+  }
+
+  hcl_frozen_builder_add_value (builder, &value);
+  return HCL_EVENT_RESULT_CONTINUE;
+}
+
+static HclEventResult
+hcl_frozen_on_list_begin (gpointer user_data, GError **error)
+{
+  (void)error;
+
+  hcl_frozen_builder_push (user_data, HCL_FROZEN_FRAME_LIST, NULL, NULL);
+  return HCL_EVENT_RESULT_CONTINUE;
+}
+
+static HclEventResult
+hcl_frozen_on_object_begin (gpointer user_data, GError **error)
+{
+  (void)error;
+
+  hcl_frozen_builder_push (user_data, HCL_FROZEN_FRAME_OBJECT, NULL, NULL);
+  return HCL_EVENT_RESULT_CONTINUE;
+}
+
+static HclEventResult
+hcl_frozen_on_container_end (gpointer user_data, GError **error)
+{
+  (void)error;
+
+  hcl_frozen_builder_pop_container (user_data);
+  return HCL_EVENT_RESULT_CONTINUE;
+}
+
+static const HclParserEvents hcl_frozen_events = {
+  hcl_frozen_on_block_begin,
+  hcl_frozen_on_block_end,
+  hcl_frozen_on_key,
+  hcl_frozen_on_value,
+  hcl_frozen_on_list_begin,
+  hcl_frozen_on_container_end,
+  hcl_frozen_on_object_begin,
+  hcl_frozen_on_key,
+  hcl_frozen_on_container_end,
+};
+
+/* Tree conversion */
+
+static void
+hcl_frozen_builder_add_tree_array (HclFrozenBuilder *builder, HclValue *array)
+{
+  HclFrozenValue value = { 0, };
+  guint length;
+  const gint64 *ints = hcl_value_get_int_array (array, &length);
+  const gdouble *doubles = ints ? NULL : hcl_value_get_double_array (array, &length);
+
+  value.type = HCL_VALUE_TYPE_NUMBER;
+  value.number_type = hcl_value_get_number_type (array);
+
+  for (guint i = 0; i < length; i++) {
+    if (ints)
+      value.data.int_value = ints[i];
+    else
+      value.data.double_value = doubles[i];
+    hcl_frozen_builder_add_value (builder, &value);
+  }
+}
+
+static void
+hcl_frozen_builder_add_tree_value (HclFrozenBuilder *builder, HclValue *tree_value)
+{
+  HclFrozenValue value = { 0, };
+  GList *keys;
+  GList *l;
+  guint i;
+
+  value.type = hcl_value_get_value_type (tree_value);
+
+  switch (value.type) {
+    case HCL_VALUE_TYPE_BOOL:
+      value.data.bool_value = hcl_value_get_bool (tree_value);
+      break;
+
+    case HCL_VALUE_TYPE_NUMBER:
+      value.number_type = hcl_value_get_number_type (tree_value);
+      if (value.number_type == HCL_NUMBER_TYPE_INTEGER)
+        value.data.int_value = hcl_value_get_int (tree_value);
+      else
+        value.data.double_value = hcl_value_get_double (tree_value);
+      break;
+
+    case HCL_VALUE_TYPE_STRING:
+      value.data.string_value = g_string_chunk_insert (builder->strings,
+                                                       hcl_value_get_string (tree_value));
+      break;
+
+    case HCL_VALUE_TYPE_LIST:
+      hcl_frozen_builder_push (builder, HCL_FROZEN_FRAME_LIST, NULL, NULL);
+      if (hcl_value_is_array (tree_value)) {
+        hcl_frozen_builder_add_tree_array (builder, tree_value);
+      } else {
+        for (i = 0; i < hcl_value_list_get_length (tree_value); i++)
+          hcl_frozen_builder_add_tree_value (builder, hcl_value_list_get_item (tree_value, i));
+      }
+      hcl_frozen_builder_pop_container (builder);
+      return;
+
+    case HCL_VALUE_TYPE_OBJECT:
+      hcl_frozen_builder_push (builder, HCL_FROZEN_FRAME_OBJECT, NULL, NULL);
+      keys = hcl_value_object_get_keys (tree_value);
+      for (l = keys; l; l = l->next) {
+        hcl_frozen_builder_set_key (builder, l->data);
+        hcl_frozen_builder_add_tree_value (builder,
+                                           hcl_value_object_get_member (tree_value, l->data));
+      }
+      g_list_free (keys);
+      hcl_frozen_builder_pop_container (builder);
+      return;
+
+    default:
+      break;
+  }
+
+  hcl_frozen_builder_add_value (builder, &value);
+}
+
+static void
+hcl_frozen_builder_add_tree_block (HclFrozenBuilder *builder, HclBlock *block)
+{
+  GList *names = hcl_block_get_attribute_names (block);
+  GList *blocks = hcl_block_get_blocks (block);
+  GList *l;
+
+  hcl_frozen_builder_push (builder, HCL_FROZEN_FRAME_BLOCK,
+                           hcl_block_get_block_type (block),
+                           hcl_block_get_label (block));
+
+  for (l = names; l; l = l->next) {
+    hcl_frozen_builder_set_key (builder, l->data);
+    hcl_frozen_builder_add_tree_value (builder, hcl_block_get_attribute (block, l->data));
+  }
+
+  for (l = blocks; l; l = l->next)
+    hcl_frozen_builder_add_tree_block (builder, l->data);
+
+  hcl_frozen_builder_pop_block (builder);
+
+  g_list_free (names);
+  g_list_free (blocks);
+}
+
+/**
+ * hcl_frozen_document_new_from_string:
+ * @input: HCL input text
+ * @length: length of @input in bytes, or -1 if it is nul-terminated
+ * @error: return location for error
+ *
+ * Parses HCL text straight into a frozen document, without building an
+ * #HclDocument first.
+ *
+ * Returns: (transfer full) (nullable): a new #HclFrozenDocument or %NULL
+ *   on error
+ */
+HclFrozenDocument *
+hcl_frozen_document_new_from_string (const gchar *input, gssize length, GError **error)
+{
+  g_autoptr(HclParser) parser = NULL;
+  HclFrozenDocument *self = NULL;
+  HclFrozenBuilder builder;
+
+  g_return_val_if_fail (input != NULL || length == 0, NULL);
+
+  if (length < 0)
+    length = (gssize) strlen (input);
+
+  parser = hcl_parser_new ();
+  hcl_frozen_builder_init (&builder, (gsize) length);
+  hcl_frozen_builder_push (&builder, HCL_FROZEN_FRAME_BLOCK, NULL, NULL);
+
+  if (hcl_parser_parse_events (parser, input, length, &hcl_frozen_events,
+                               &builder, error)) {
+    hcl_frozen_builder_pop_block (&builder);
+    self = hcl_frozen_builder_finish (&builder);
+  }
+
+  hcl_frozen_builder_clear (&builder);
+  return self;
+}
+
+/**
+ * hcl_frozen_document_new_from_file:
+ * @filename: path to HCL file
+ * @error: return location for error
+ *
+ * Parses an HCL file straight into a frozen document.
+ *
+ * Returns: (transfer full) (nullable): a new #HclFrozenDocument or %NULL
+ *   on error
+ */
+HclFrozenDocument *
+hcl_frozen_document_new_from_file (const gchar *filename, GError **error)
+{
+  g_autoptr(GBytes) contents = NULL;
+  const gchar *data;
+  gsize length;
+
+  g_return_val_if_fail (filename != NULL, NULL);
+
+  contents = hcl_file_load (filename, error);
+  if (!contents)
+    return NULL;
+
+  data = g_bytes_get_data (contents, &length);
+
+  return hcl_frozen_document_new_from_string (data, (gssize) length, error);
+}
+
+/**
+ * hcl_frozen_document_new_from_document:
+ * @document: an #HclDocument
+ *
+ * Creates a frozen copy of @document. Later changes to @document do not
+ * affect the copy.
+ *
+ * Returns: (transfer full): a new #HclFrozenDocument
+ */
+HclFrozenDocument *
+hcl_frozen_document_new_from_document (HclDocument *document)
+{
+  HclFrozenDocument *self;
+  HclFrozenBuilder builder;
+  GList *names;
+  GList *blocks;
+  GList *l;
+
+  g_return_val_if_fail (HCL_IS_DOCUMENT (document), NULL);
+
+  names = hcl_document_get_attribute_names (document);
+  blocks = hcl_document_get_blocks (document);
+
+  hcl_frozen_builder_init (&builder, 0);
+  hcl_frozen_builder_push (&builder, HCL_FROZEN_FRAME_BLOCK, NULL, NULL);
+
+  for (l = names; l; l = l->next) {
+    hcl_frozen_builder_set_key (&builder, l->data);
+    hcl_frozen_builder_add_tree_value (&builder,
+                                       hcl_document_get_attribute (document, l->data));
+  }
+
+  for (l = blocks; l; l = l->next)
+    hcl_frozen_builder_add_tree_block (&builder, l->data);
+
+  hcl_frozen_builder_pop_block (&builder);
+  self = hcl_frozen_builder_finish (&builder);
+  hcl_frozen_builder_clear (&builder);
+
+  g_list_free (names);
+  g_list_free (blocks);
+
+  return self;
+}
+
+/* Lookups shared by blocks, the document and objects */
+
+static const HclFrozenMember *
+hcl_frozen_members_lookup (const HclFrozenMember *members, guint count, const gchar *key)
+{
+  guint low = 0;
+  guint high = count;
+
+  while (low < high) {
+    guint middle = low + (high - low) / 2;
+    const HclFrozenMember *member = &members[members[middle].value.sorted];
+    gint cmp = strcmp (key, member->key);
+
+    if (cmp == 0)
+      return member;
+
+    if (cmp < 0)
+      high = middle;
+    else
+      low = middle + 1;
+  }
+
+  return NULL;
+}
+
+static GList *
+hcl_frozen_members_get_keys (const HclFrozenMember *members, guint count)
+{
+  GList *result = NULL;
+
+  for (guint i = count; i > 0; i--)
+    result = g_list_prepend (result, (gpointer) members[i - 1].key);
+
+  return result;
+}
+
+/**
+ * hcl_frozen_document_get_attribute_names:
+ * @document: an #HclFrozenDocument
+ *
+ * Gets all top-level attribute names, in the order they were set.
+ *
+ * Returns: (transfer container) (element-type utf8): list of attribute names
+ */
+GList *
+hcl_frozen_document_get_attribute_names (HclFrozenDocument *document)
+{
+  g_return_val_if_fail (HCL_IS_FROZEN_DOCUMENT (document), NULL);
+
+  return hcl_frozen_block_get_attribute_names (document->root);
+}
+
+/**
+ * hcl_frozen_document_get_attribute:
+ * @document: an #HclFrozenDocument
+ * @name: attribute name
+ *
+ * Gets a top-level attribute value.
+ *
+ * Returns: (transfer none) (nullable): the attribute value
+ */
+const HclFrozenValue *
+hcl_frozen_document_get_attribute (HclFrozenDocument *document, const gchar *name)
+{
+  g_return_val_if_fail (HCL_IS_FROZEN_DOCUMENT (document), NULL);
+
+  return hcl_frozen_block_get_attribute (document->root, name);
+}
+
+/**
+ * hcl_frozen_document_has_attribute:
+ * @document: an #HclFrozenDocument
+ * @name: attribute name
+ *
+ * Checks if the document has a top-level attribute.
+ *
+ * Returns: %TRUE if the document has the attribute
+ */
+gboolean
+hcl_frozen_document_has_attribute (HclFrozenDocument *document, const gchar *name)
+{
+  g_return_val_if_fail (HCL_IS_FROZEN_DOCUMENT (document), FALSE);
+
+  return hcl_frozen_block_has_attribute (document->root, name);
+}
+
+/**
+ * hcl_frozen_document_get_blocks:
+ * @document: an #HclFrozenDocument
+ *
+ * Gets all top-level blocks.
+ *
+ * Returns: (transfer container) (element-type HclFrozenBlock): list of blocks
+ */
+GList *
+hcl_frozen_document_get_blocks (HclFrozenDocument *document)
+{
+  g_return_val_if_fail (HCL_IS_FROZEN_DOCUMENT (document), NULL);
+
+  return hcl_frozen_block_get_blocks (document->root);
+}
+
+/**
+ * hcl_frozen_document_get_blocks_by_type:
+ * @document: an #HclFrozenDocument
+ * @type: block type to filter by
+ *
+ * Gets all top-level blocks of a specific type.
+ *
+ * Returns: (transfer container) (element-type HclFrozenBlock): list of
+ *   matching blocks
+ */
+GList *
+hcl_frozen_document_get_blocks_by_type (HclFrozenDocument *document, const gchar *type)
+{
+  g_return_val_if_fail (HCL_IS_FROZEN_DOCUMENT (document), NULL);
+
+  return hcl_frozen_block_get_blocks_by_type (document->root, type);
+}
+
+/**
+ * hcl_frozen_document_get_n_blocks:
+ * @document: an #HclFrozenDocument
+ *
+ * Gets the number of top-level blocks.
+ *
+ * Returns: the number of blocks
+ */
+guint
+hcl_frozen_document_get_n_blocks (HclFrozenDocument *document)
+{
+  g_return_val_if_fail (HCL_IS_FROZEN_DOCUMENT (document), 0);
+
+  return document->root->n_blocks;
+}
+
+/**
+ * hcl_frozen_document_get_block:
+ * @document: an #HclFrozenDocument
+ * @index: index of the block
+ *
+ * Gets a top-level block by position, without building a list.
+ *
+ * Returns: (transfer none) (nullable): the block, or %NULL if @index is
+ *   out of range
+ */
+const HclFrozenBlock *
+hcl_frozen_document_get_block (HclFrozenDocument *document, guint index)
+{
+  g_return_val_if_fail (HCL_IS_FROZEN_DOCUMENT (document), NULL);
+
+  return hcl_frozen_block_get_block (document->root, index);
+}
+
+/**
+ * hcl_frozen_block_get_block_type:
+ * @block: an #HclFrozenBlock
+ *
+ * Gets the type of a block.
+ *
+ * Returns: (transfer none): the block type
+ */
+const gchar *
+hcl_frozen_block_get_block_type (const HclFrozenBlock *block)
+{
+  g_return_val_if_fail (block != NULL, NULL);
+
+  return block->type;
+}
+
+/**
+ * hcl_frozen_block_get_label:
+ * @block: an #HclFrozenBlock
+ *
+ * Gets the label of a block.
+ *
+ * Returns: (transfer none) (nullable): the block label
+ */
+const gchar *
+hcl_frozen_block_get_label (const HclFrozenBlock *block)
+{
+  g_return_val_if_fail (block != NULL, NULL);
+
+  return block->label;
+}
+
+/**
+ * hcl_frozen_block_get_attribute_names:
+ * @block: an #HclFrozenBlock
+ *
+ * Gets all attribute names of a block, in the order they were set.
+ *
+ * Returns: (transfer container) (element-type utf8): list of attribute names
+ */
+GList *
+hcl_frozen_block_get_attribute_names (const HclFrozenBlock *block)
+{
+  g_return_val_if_fail (block != NULL, NULL);
+
+  return hcl_frozen_members_get_keys (block->attributes.members, block->n_attributes);
+}
+
+/**
+ * hcl_frozen_block_get_attribute:
+ * @block: an #HclFrozenBlock
+ * @name: attribute name
+ *
+ * Gets an attribute value from a block.
+ *
+ * Returns: (transfer none) (nullable): the attribute value
+ */
+const HclFrozenValue *
+hcl_frozen_block_get_attribute (const HclFrozenBlock *block, const gchar *name)
+{
+  const HclFrozenMember *member;
+
+  g_return_val_if_fail (block != NULL, NULL);
+  g_return_val_if_fail (name != NULL, NULL);
+
+  member = hcl_frozen_members_lookup (block->attributes.members, block->n_attributes, name);
+
+  return member ? &member->value : NULL;
+}
+
+/**
+ * hcl_frozen_block_has_attribute:
+ * @block: an #HclFrozenBlock
+ * @name: attribute name
+ *
+ * Checks if a block has an attribute.
+ *
+ * Returns: %TRUE if the block has the attribute
+ */
+gboolean
+hcl_frozen_block_has_attribute (const HclFrozenBlock *block, const gchar *name)
+{
+  return hcl_frozen_block_get_attribute (block, name) != NULL;
+}
+
+/**
+ * hcl_frozen_block_get_blocks:
+ * @block: an #HclFrozenBlock
+ *
+ * Gets all nested blocks of a block.
+ *
+ * Returns: (transfer container) (element-type HclFrozenBlock): list of blocks
+ */
+GList *
+hcl_frozen_block_get_blocks (const HclFrozenBlock *block)
+{
+  GList *result = NULL;
+
+  g_return_val_if_fail (block != NULL, NULL);
+
+  for (guint i = block->n_blocks; i > 0; i--)
+    result = g_list_prepend (result, (gpointer) &block->blocks.blocks[i - 1]);
+
+  return result;
+}
+
+/**
+ * hcl_frozen_block_get_blocks_by_type:
+ * @block: an #HclFrozenBlock
+ * @type: block type to filter by
+ *
+ * Gets all nested blocks of a specific type.
+ *
+ * Returns: (transfer container) (element-type HclFrozenBlock): list of
+ *   matching blocks
+ */
+GList *
+hcl_frozen_block_get_blocks_by_type (const HclFrozenBlock *block, const gchar *type)
+{
+  GList *result = NULL;
+
+  g_return_val_if_fail (block != NULL, NULL);
+  g_return_val_if_fail (type != NULL, NULL);
+
+  for (guint i = block->n_blocks; i > 0; i--) {
+    const HclFrozenBlock *child = &block->blocks.blocks[i - 1];
+
+    if (g_strcmp0 (child->type, type) == 0)
+      result = g_list_prepend (result, (gpointer) child);
+  }
+
+  return result;
+}
+
+/**
+ * hcl_frozen_block_get_n_blocks:
+ * @block: an #HclFrozenBlock
+ *
+ * Gets the number of nested blocks of a block.
+ *
+ * Returns: the number of blocks
+ */
+guint
+hcl_frozen_block_get_n_blocks (const HclFrozenBlock *block)
+{
+  g_return_val_if_fail (block != NULL, 0);
+
+  return block->n_blocks;
+}
+
+/**
+ * hcl_frozen_block_get_block:
+ * @block: an #HclFrozenBlock
+ * @index: index of the nested block
+ *
+ * Gets a nested block by position, without building a list.
+ *
+ * Returns: (transfer none) (nullable): the block, or %NULL if @index is
+ *   out of range
+ */
+const HclFrozenBlock *
+hcl_frozen_block_get_block (const HclFrozenBlock *block, guint index)
+{
+  g_return_val_if_fail (block != NULL, NULL);
+
+  if (index >= block->n_blocks)
+    return NULL;
+
+  return &block->blocks.blocks[index];
+}
+
+/**
+ * hcl_frozen_value_get_value_type:
+ * @value: an #HclFrozenValue
+ *
+ * Gets the type of a value.
+ *
+ * Returns: the #HclValueType
+ */
+HclValueType
+hcl_frozen_value_get_value_type (const HclFrozenValue *value)
+{
+  g_return_val_if_fail (value != NULL, HCL_VALUE_TYPE_NULL);
+
+  return value->type;
+}
+
+/**
+ * hcl_frozen_value_get_number_type:
+ * @value: an #HclFrozenValue holding a number
+ *
+ * Gets whether a number was written as an integer or as a float.
+ *
+ * Returns: the #HclNumberType
+ */
+HclNumberType
+hcl_frozen_value_get_number_type (const HclFrozenValue *value)
+{
+  g_return_val_if_fail (value != NULL, HCL_NUMBER_TYPE_INTEGER);
+  g_return_val_if_fail (value->type == HCL_VALUE_TYPE_NUMBER, HCL_NUMBER_TYPE_INTEGER);
+
+  return value->number_type;
+}
+
+/**
+ * hcl_frozen_value_is_null:
+ * @value: an #HclFrozenValue
+ *
+ * Checks if a value is null.
+ *
+ * Returns: %TRUE if the value is null
+ */
+gboolean
+hcl_frozen_value_is_null (const HclFrozenValue *value)
+{
+  g_return_val_if_fail (value != NULL, FALSE);
+
+  return value->type == HCL_VALUE_TYPE_NULL;
+}
+
+/**
+ * hcl_frozen_value_is_bool:
+ * @value: an #HclFrozenValue
+ *
+ * Checks if a value is a boolean.
+ *
+ * Returns: %TRUE if the value is a boolean
+ */
+gboolean
+hcl_frozen_value_is_bool (const HclFrozenValue *value)
+{
+  g_return_val_if_fail (value != NULL, FALSE);
+
+  return value->type == HCL_VALUE_TYPE_BOOL;
+}
+
+/**
+ * hcl_frozen_value_is_number:
+ * @value: an #HclFrozenValue
+ *
+ * Checks if a value is a number.
+ *
+ * Returns: %TRUE if the value is a number
+ */
+gboolean
+hcl_frozen_value_is_number (const HclFrozenValue *value)
+{
+  g_return_val_if_fail (value != NULL, FALSE);
+
+  return value->type == HCL_VALUE_TYPE_NUMBER;
+}
+
+/**
+ * hcl_frozen_value_is_string:
+ * @value: an #HclFrozenValue
+ *
+ * Checks if a value is a string.
+ *
+ * Returns: %TRUE if the value is a string
+ */
+gboolean
+hcl_frozen_value_is_string (const HclFrozenValue *value)
+{
+  g_return_val_if_fail (value != NULL, FALSE);
+
+  return value->type == HCL_VALUE_TYPE_STRING;
+}
+
+/**
+ * hcl_frozen_value_is_list:
+ * @value: an #HclFrozenValue
+ *
+ * Checks if a value is a list.
+ *
+ * Returns: %TRUE if the value is a list
+ */
+gboolean
+hcl_frozen_value_is_list (const HclFrozenValue *value)
+{
+  g_return_val_if_fail (value != NULL, FALSE);
+
+  return value->type == HCL_VALUE_TYPE_LIST;
+}
+
+/**
+ * hcl_frozen_value_is_object:
+ * @value: an #HclFrozenValue
+ *
+ * Checks if a value is an object.
+ *
+ * Returns: %TRUE if the value is an object
+ */
+gboolean
+hcl_frozen_value_is_object (const HclFrozenValue *value)
+{
+  g_return_val_if_fail (value != NULL, FALSE);
+
+  return value->type == HCL_VALUE_TYPE_OBJECT;
+}
+
+/**
+ * hcl_frozen_value_get_bool:
+ * @value: an #HclFrozenValue holding a boolean
+ *
+ * Gets a boolean value.
+ *
+ * Returns: the boolean value
+ */
+gboolean
+hcl_frozen_value_get_bool (const HclFrozenValue *value)
+{
+  g_return_val_if_fail (value != NULL, FALSE);
+  g_return_val_if_fail (value->type == HCL_VALUE_TYPE_BOOL, FALSE);
+
+  return value->data.bool_value;
+}
+
+/**
+ * hcl_frozen_value_get_int:
+ * @value: an #HclFrozenValue holding a number
+ *
+ * Gets a number as an integer, truncating floats.
+ *
+ * Returns: the integer value
+ */
+gint64
+hcl_frozen_value_get_int (const HclFrozenValue *value)
+{
+  g_return_val_if_fail (value != NULL, 0);
+  g_return_val_if_fail (value->type == HCL_VALUE_TYPE_NUMBER, 0);
+
+  if (value->number_type == HCL_NUMBER_TYPE_INTEGER)
+    return value->data.int_value;
+  else
+    return (gint64) value->data.double_value;
+}
+
+/**
+ * hcl_frozen_value_get_double:
+ * @value: an #HclFrozenValue holding a number
+ *
+ * Gets a number as a double.
+ *
+ * Returns: the double value
+ */
+gdouble
+hcl_frozen_value_get_double (const HclFrozenValue *value)
+{
+  g_return_val_if_fail (value != NULL, 0.0);
+  g_return_val_if_fail (value->type == HCL_VALUE_TYPE_NUMBER, 0.0);
+
+  if (value->number_type == HCL_NUMBER_TYPE_FLOAT)
+    return value->data.double_value;
+  else
+    return (gdouble) value->data.int_value;
+}
+
+/**
+ * hcl_frozen_value_get_string:
+ * @value: an #HclFrozenValue holding a string
+ *
+ * Gets a string value.
+ *
+ * Returns: (transfer none): the string value
+ */
+const gchar *
+hcl_frozen_value_get_string (const HclFrozenValue *value)
+{
+  g_return_val_if_fail (value != NULL, NULL);
+  g_return_val_if_fail (value->type == HCL_VALUE_TYPE_STRING, NULL);
+
+  return value->data.string_value;
+}
+
+/**
+ * hcl_frozen_value_list_get_length:
+ * @value: an #HclFrozenValue holding a list
+ *
+ * Gets the number of items in a list.
+ *
+ * Returns: the list length
+ */
+guint
+hcl_frozen_value_list_get_length (const HclFrozenValue *value)
+{
+  g_return_val_if_fail (value != NULL, 0);
+  g_return_val_if_fail (value->type == HCL_VALUE_TYPE_LIST, 0);
+
+  return value->n_children;
+}
+
+/**
+ * hcl_frozen_value_list_get_item:
+ * @value: an #HclFrozenValue holding a list
+ * @index: item index
+ *
+ * Gets an item of a list.
+ *
+ * Returns: (transfer none) (nullable): the item, or %NULL if @index is
+ *   out of range
+ */
+const HclFrozenValue *
+hcl_frozen_value_list_get_item (const HclFrozenValue *value, guint index)
+{
+  g_return_val_if_fail (value != NULL, NULL);
+  g_return_val_if_fail (value->type == HCL_VALUE_TYPE_LIST, NULL);
+
+  if (index >= value->n_children)
+    return NULL;
+
+  return &value->data.items[index];
+}
+
+/**
+ * hcl_frozen_value_object_get_keys:
+ * @value: an #HclFrozenValue holding an object
+ *
+ * Gets the keys of an object, in the order they were set.
+ *
+ * Returns: (transfer container) (element-type utf8): list of keys
+ */
+GList *
+hcl_frozen_value_object_get_keys (const HclFrozenValue *value)
+{
+  g_return_val_if_fail (value != NULL, NULL);
+  g_return_val_if_fail (value->type == HCL_VALUE_TYPE_OBJECT, NULL);
+
+  return hcl_frozen_members_get_keys (value->data.members, value->n_children);
+}
+
+/**
+ * hcl_frozen_value_object_get_member:
+ * @value: an #HclFrozenValue holding an object
+ * @key: member key
+ *
+ * Gets a member of an object.
+ *
+ * Returns: (transfer none) (nullable): the member value
+ */
+const HclFrozenValue *
+hcl_frozen_value_object_get_member (const HclFrozenValue *value, const gchar *key)
+{
+  const HclFrozenMember *member;
+
+  g_return_val_if_fail (value != NULL, NULL);
+  g_return_val_if_fail (value->type == HCL_VALUE_TYPE_OBJECT, NULL);
+  g_return_val_if_fail (key != NULL, NULL);
+
+  member = hcl_frozen_members_lookup (value->data.members, value->n_children, key);
+
+  return member ? &member->value : NULL;
+}
+
+/**
+ * hcl_frozen_value_object_has_member:
+ * @value: an #HclFrozenValue holding an object
+ * @key: member key
+ *
+ * Checks if an object has a member.
+ *
+ * Returns: %TRUE if the object has the member
+ */
+gboolean
+hcl_frozen_value_object_has_member (const HclFrozenValue *value, const gchar *key)
+{
+  return hcl_frozen_value_object_get_member (value, key) != NULL;
+}
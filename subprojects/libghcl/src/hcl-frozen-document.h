@@ -0,0 +1,86 @@
+/* hcl-frozen-document.h - Compact read-only HCL document
+ *
+ * Copyright 2024 Geoff Johnson <geoff.jay@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ */
+
+#ifndef __HCL_FROZEN_DOCUMENT_H__
+#define __HCL_FROZEN_DOCUMENT_H__
+
+#include <glib-object.h>
+#include "hcl-document.h"
+#include "hcl-enums.h"
+
+G_BEGIN_DECLS
+
+#define HCL_TYPE_FROZEN_DOCUMENT (hcl_frozen_document_get_type())
+G_DECLARE_FINAL_TYPE (HclFrozenDocument, hcl_frozen_document, HCL, FROZEN_DOCUMENT, GObject)
+
+typedef struct _HclFrozenBlock HclFrozenBlock;
+typedef struct _HclFrozenValue HclFrozenValue;
+
+/* Constructors */
+HclFrozenDocument    *hcl_frozen_document_new_from_string     (const gchar *input,
+                                                               gssize length,
+                                                               GError **error);
+HclFrozenDocument    *hcl_frozen_document_new_from_file       (const gchar *filename,
+                                                               GError **error);
+HclFrozenDocument    *hcl_frozen_document_new_from_document   (HclDocument *document);
+
+/* Document */
+GList                *hcl_frozen_document_get_attribute_names (HclFrozenDocument *document);
+const HclFrozenValue *hcl_frozen_document_get_attribute       (HclFrozenDocument *document,
+                                                               const gchar *name);
+gboolean              hcl_frozen_document_has_attribute       (HclFrozenDocument *document,
+                                                               const gchar *name);
+GList                *hcl_frozen_document_get_blocks          (HclFrozenDocument *document);
+GList                *hcl_frozen_document_get_blocks_by_type  (HclFrozenDocument *document,
+                                                               const gchar *type);
+guint                 hcl_frozen_document_get_n_blocks        (HclFrozenDocument *document);
+const HclFrozenBlock *hcl_frozen_document_get_block           (HclFrozenDocument *document,
+                                                               guint index);
+
+/* Blocks */
+const gchar          *hcl_frozen_block_get_block_type         (const HclFrozenBlock *block);
+const gchar          *hcl_frozen_block_get_label              (const HclFrozenBlock *block);
+GList                *hcl_frozen_block_get_attribute_names    (const HclFrozenBlock *block);
+const HclFrozenValue *hcl_frozen_block_get_attribute          (const HclFrozenBlock *block,
+                                                               const gchar *name);
+gboolean              hcl_frozen_block_has_attribute          (const HclFrozenBlock *block,
+                                                               const gchar *name);
+GList                *hcl_frozen_block_get_blocks             (const HclFrozenBlock *block);
+GList                *hcl_frozen_block_get_blocks_by_type     (const HclFrozenBlock *block,
+                                                               const gchar *type);
+guint                 hcl_frozen_block_get_n_blocks           (const HclFrozenBlock *block);
+const HclFrozenBlock *hcl_frozen_block_get_block              (const HclFrozenBlock *block,
+                                                               guint index);
+
+/* Values */
+HclValueType          hcl_frozen_value_get_value_type         (const HclFrozenValue *value);
+HclNumberType         hcl_frozen_value_get_number_type        (const HclFrozenValue *value);
+gboolean              hcl_frozen_value_is_null                (const HclFrozenValue *value);
+gboolean              hcl_frozen_value_is_bool                (const HclFrozenValue *value);
+gboolean              hcl_frozen_value_is_number              (const HclFrozenValue *value);
+gboolean              hcl_frozen_value_is_string              (const HclFrozenValue *value);
+gboolean              hcl_frozen_value_is_list                (const HclFrozenValue *value);
+gboolean              hcl_frozen_value_is_object              (const HclFrozenValue *value);
+gboolean              hcl_frozen_value_get_bool               (const HclFrozenValue *value);
+gint64                hcl_frozen_value_get_int                (const HclFrozenValue *value);
+gdouble               hcl_frozen_value_get_double             (const HclFrozenValue *value);
+const gchar          *hcl_frozen_value_get_string             (const HclFrozenValue *value);
+guint                 hcl_frozen_value_list_get_length        (const HclFrozenValue *value);
+const HclFrozenValue *hcl_frozen_value_list_get_item          (const HclFrozenValue *value,
+                                                               guint index);
+GList                *hcl_frozen_value_object_get_keys        (const HclFrozenValue *value);
+const HclFrozenValue *hcl_frozen_value_object_get_member      (const HclFrozenValue *value,
+                                                               const gchar *key);
+gboolean              hcl_frozen_value_object_has_member      (const HclFrozenValue *value,
+                                                               const gchar *key);
+
+G_END_DECLS
+
+#endif /* __HCL_FROZEN_DOCUMENT_H__ */
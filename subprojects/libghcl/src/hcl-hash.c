@@ -0,0 +1,115 @@
+/* hcl-hash.c - Structural hashes of values, blocks and documents
+ *
+ * Copyright 2024 Geoff Johnson <geoff.jay@gmail.com>
+ */
+
+#include "hcl-private.h"
+#include "hcl-value.h"
+#include <string.h>
+
+/*
+ * Moved whenever a shared node changes, since only one of the
+ * containers holding it can be told. See hcl-private.h.
+ */
+static guint hash_epoch;
+
+/*
+ * Hashes the text of @string rather than its interned address, so that
+ * hashes do not depend on what else has been interned and can be kept
+ * between runs.
+ */
+guint64
+hcl_hash_string (const gchar *string)
+{
+  guint64 hash = G_GUINT64_CONSTANT (0xCBF29CE484222325);
+
+  if (!string)
+    return 0;
+
+  /* FNV-1a */
+  for (const guchar *p = (const guchar *) string; *p; p++) {
+    hash ^= *p;
+    hash *= G_GUINT64_CONSTANT (0x100000001B3);
+  }
+
+  return hcl_hash_mix (hash);
+}
+
+/* Packed numbers hash like the values they stand for */
+guint64
+hcl_hash_number (HclNumberType number_type, gint64 int_value, gdouble double_value)
+{
+  guint64 bits;
+
+  if (number_type == HCL_NUMBER_TYPE_INTEGER) {
+    bits = (guint64) int_value;
+  } else {
+    /* -0.0 == 0.0, so they must hash alike */
+    if (double_value == 0.0)
+      double_value = 0.0;
+    memcpy (&bits, &double_value, sizeof bits);
+  }
+
+  return hcl_hash_combine (hcl_hash_combine (HCL_VALUE_TYPE_NUMBER, number_type), bits);
+}
+
+/*
+ * Sums the attributes of a block or document, so that the order they
+ * were set in does not count.
+ */
+guint64
+hcl_hash_attributes (HclMap *attributes)
+{
+  HclMapIter iter;
+  const gchar *name;
+  gpointer value;
+  guint64 hash = 0;
+
+  hcl_map_iter_init (&iter, attributes);
+  while (hcl_map_iter_next (&iter, &name, &value))
+    hash += hcl_hash_combine (hcl_hash_string (name), hcl_value_hash (value));
+
+  return hash;
+}
+
+guint
+hcl_hash_get_epoch (void)
+{
+  return (guint) g_atomic_int_get (&hash_epoch);
+}
+
+/*
+ * Clears the cached hash of @node and of everything holding it, after
+ * @node changed. The walk stops at the first node without a cached
+ * hash: its ancestors had theirs cleared when it lost it, since working
+ * out a hash caches the hashes of everything below.
+ */
+void
+hcl_hash_invalidate (gpointer node, HclParentKind kind)
+{
+  gboolean shared = FALSE;
+
+  while (node) {
+    switch (kind) {
+      case HCL_PARENT_VALUE:
+        shared |= hcl_value_forget_hash (node, &node, &kind);
+        break;
+
+      case HCL_PARENT_BLOCK:
+        shared |= hcl_block_forget_hash (node, &node, &kind);
+        break;
+
+      case HCL_PARENT_DOCUMENT:
+        hcl_document_forget_hash (node);
+        node = NULL;
+        break;
+
+      default:
+        node = NULL;
+        break;
+    }
+  }
+
+  if (shared)
+    g_atomic_int_inc (&hash_epoch);
+}
@@ -4,8 +4,10 @@
  */
 
 #include "hcl-lexer.h"
+#include "hcl-private.h"
+#include "hcl-scan.h"
+#include <math.h>
 #include <string.h>
-#include <ctype.h>
 
 /**
  * SECTION:hcl-lexer
@@ -21,9 +23,10 @@ struct _HclToken
   GObject parent_instance;
 
   HclTokenType type;
-  gchar *value;
+  gchar *value;            /* Not owned if @static_value is set */
   gsize line;
   gsize column;
+  gboolean static_value;
 };
 
 G_DEFINE_FINAL_TYPE (HclToken, hcl_token, G_TYPE_OBJECT)
@@ -33,7 +36,8 @@ hcl_token_finalize (GObject *object)
 {
   HclToken *self = HCL_TOKEN (object);
 
-  g_free (self->value);
+  if (!self->static_value)
+    g_free (self->value);
 
   G_OBJECT_CLASS (hcl_token_parent_class)->finalize (object);
 }
@@ -141,6 +145,69 @@ hcl_token_get_column (HclToken *token)
 }
 
 /* Lexer implementation */
+
+/*
+ * What a byte can start. hcl_lexer_scan() dispatches on the class of
+ * the first byte of a token, looked up in hcl_lexer_char_class, rather
+ * than comparing it against every punctuation character in turn.
+ */
+typedef enum {
+  HCL_CHAR_INVALID          = 0,
+  HCL_CHAR_PUNCTUATION      = 1,  /* Single-byte token, including '\n' */
+  HCL_CHAR_QUOTE            = 2,
+  HCL_CHAR_HASH             = 3,
+  HCL_CHAR_SLASH            = 4,
+  HCL_CHAR_DIGIT            = 5,
+  HCL_CHAR_MINUS            = 6,
+  HCL_CHAR_IDENTIFIER_START = 7,
+  HCL_CHAR_BLANK            = 8   /* ' ', '\t' and '\r' */
+} HclCharClass;
+
+/* Bytes from 0x80 up are all invalid and left to zero initialization */
+static const guint8 hcl_lexer_char_class[256] = {
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 8, 1, 0, 0, 8, 0, 0,  /* 0x00 */
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  /* 0x10 */
+  8, 0, 2, 3, 0, 0, 0, 2, 1, 1, 0, 0, 1, 6, 1, 4,  /* 0x20 */
+  5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 0, 0, 0, 1, 0, 0,  /* 0x30 */
+  0, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,  /* 0x40 */
+  7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 1, 0, 1, 0, 7,  /* 0x50 */
+  0, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,  /* 0x60 */
+  7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 1, 0, 1, 0, 0,  /* 0x70 */
+};
+
+/* Token type of each HCL_CHAR_PUNCTUATION byte */
+static const guint8 hcl_lexer_punctuation_type[128] = {
+  ['\n'] = HCL_TOKEN_TYPE_NEWLINE,
+  ['=']  = HCL_TOKEN_TYPE_ASSIGN,
+  ['{']  = HCL_TOKEN_TYPE_LBRACE,
+  ['}']  = HCL_TOKEN_TYPE_RBRACE,
+  ['[']  = HCL_TOKEN_TYPE_LBRACKET,
+  [']']  = HCL_TOKEN_TYPE_RBRACKET,
+  ['(']  = HCL_TOKEN_TYPE_LPAREN,
+  [')']  = HCL_TOKEN_TYPE_RPAREN,
+  [',']  = HCL_TOKEN_TYPE_COMMA,
+  ['.']  = HCL_TOKEN_TYPE_DOT,
+};
+
+/*
+ * Values of the tokens whose text is fixed. Materialized tokens of these
+ * types point here instead of owning a copy.
+ */
+static const gchar * const hcl_lexer_token_text[] = {
+  [HCL_TOKEN_TYPE_EOF]      = "",
+  [HCL_TOKEN_TYPE_NULL]     = "null",
+  [HCL_TOKEN_TYPE_ASSIGN]   = "=",
+  [HCL_TOKEN_TYPE_LBRACE]   = "{",
+  [HCL_TOKEN_TYPE_RBRACE]   = "}",
+  [HCL_TOKEN_TYPE_LBRACKET] = "[",
+  [HCL_TOKEN_TYPE_RBRACKET] = "]",
+  [HCL_TOKEN_TYPE_LPAREN]   = "(",
+  [HCL_TOKEN_TYPE_RPAREN]   = ")",
+  [HCL_TOKEN_TYPE_COMMA]    = ",",
+  [HCL_TOKEN_TYPE_DOT]      = ".",
+  [HCL_TOKEN_TYPE_NEWLINE]  = "\n",
+};
+
 struct _HclLexer
 {
   GObject parent_instance;
@@ -151,7 +218,15 @@ struct _HclLexer
   gsize line;
   gsize column;
 
-  HclToken *peeked_token;
+  /* Tokens scanned ahead of the caller, oldest at @lookahead_head */
+  HclSpanToken lookahead[HCL_LEXER_LOOKAHEAD];
+  guint lookahead_head;
+  guint lookahead_count;
+  HclToken *peeked_token;  /* Materialized oldest lookahead for hcl_lexer_peek_token() */
+
+  /* What the last failed scan stopped at, for hcl_lexer_recover() */
+  HclSpanToken error_span;
+  gboolean failed;
 };
 
 G_DEFINE_FINAL_TYPE (HclLexer, hcl_lexer, G_TYPE_OBJECT)
@@ -201,12 +276,58 @@ hcl_lexer_new (const gchar *input)
   return self;
 }
 
-static gchar
-hcl_lexer_current_char (HclLexer *lexer)
+/**
+ * hcl_lexer_new_with_length:
+ * @input: input text to tokenize
+ * @length: length of @input in bytes, or -1 if it is nul-terminated
+ *
+ * Creates a new HCL lexer over the first @length bytes of @input, which
+ * does not need to be nul-terminated. The lexer does not copy @input.
+ *
+ * Returns: (transfer full): a new #HclLexer
+ */
+HclLexer *
+hcl_lexer_new_with_length (const gchar *input, gssize length)
 {
-  if (lexer->position >= lexer->input_length)
-    return '\0';
-  return lexer->input[lexer->position];
+  HclLexer *self;
+
+  g_return_val_if_fail (input != NULL || length == 0, NULL);
+
+  if (length < 0)
+    return hcl_lexer_new (input);
+
+  self = g_object_new (HCL_TYPE_LEXER, NULL);
+  self->input = input;
+  self->input_length = (gsize) length;
+
+  return self;
+}
+
+/*
+ * hcl_lexer_reset:
+ *
+ * Points the lexer at new input without allocating a new lexer. @line and
+ * @column are the position reported for the first byte, for input that
+ * is a slice of a larger text.
+ */
+void
+hcl_lexer_reset (HclLexer *lexer,
+                 const gchar *input,
+                 gsize length,
+                 gsize line,
+                 gsize column)
+{
+  g_return_if_fail (HCL_IS_LEXER (lexer));
+
+  lexer->input = input;
+  lexer->input_length = length;
+  lexer->position = 0;
+  lexer->line = line;
+  lexer->column = column;
+  lexer->lookahead_head = 0;
+  lexer->lookahead_count = 0;
+  lexer->failed = FALSE;
+  g_clear_object (&lexer->peeked_token);
 }
 
 static gchar
@@ -218,362 +339,824 @@ hcl_lexer_peek_char (HclLexer *lexer, gsize offset)
   return lexer->input[pos];
 }
 
+/* Advances over @count bytes known not to contain a newline */
 static void
-hcl_lexer_advance (HclLexer *lexer)
+hcl_lexer_advance_columns (HclLexer *lexer, gsize count)
 {
-  if (lexer->position < lexer->input_length) {
-    if (lexer->input[lexer->position] == '\n') {
-      lexer->line++;
-      lexer->column = 1;
-    } else {
-      lexer->column++;
-    }
-    lexer->position++;
+  lexer->position += count;
+  lexer->column += count;
+}
+
+/* Advances over @count bytes that may contain newlines */
+static void
+hcl_lexer_advance_by (HclLexer *lexer, gsize count)
+{
+  gsize last_newline = 0;
+  gsize newlines = hcl_scan_count_newlines (lexer->input + lexer->position,
+                                            count, &last_newline);
+
+  if (newlines > 0) {
+    lexer->line += newlines;
+    lexer->column = count - last_newline;
+  } else {
+    lexer->column += count;
   }
+  lexer->position += count;
+}
+
+/*
+ * hcl_lexer_recover:
+ *
+ * After a scan failed, fills @span with the text it failed on and moves
+ * the lexer past it, so scanning can carry on behind the error. Tokens
+ * already in the lookahead ring are kept.
+ *
+ * Returns: %FALSE if the last scan did not fail
+ */
+gboolean
+hcl_lexer_recover (HclLexer *lexer, HclSpanToken *span)
+{
+  g_return_val_if_fail (HCL_IS_LEXER (lexer), FALSE);
+  g_return_val_if_fail (span != NULL, FALSE);
+
+  if (!lexer->failed)
+    return FALSE;
+
+  *span = lexer->error_span;
+  lexer->failed = FALSE;
+
+  /* Strings and numbers are behind us, only a stray character is not */
+  if (span->type == HCL_TOKEN_TYPE_INVALID && span->offset == lexer->position)
+    hcl_lexer_advance_columns (lexer, span->length);
+
+  return TRUE;
 }
 
+/* Moves past the closing quote of the string the lexer is inside */
 static void
-hcl_lexer_skip_whitespace (HclLexer *lexer)
+hcl_lexer_skip_string_tail (HclLexer *lexer, gchar quote_char)
 {
-  while (lexer->position < lexer->input_length) {
-    gchar c = hcl_lexer_current_char (lexer);
-    if (c == ' ' || c == '\t' || c == '\r') {
-      hcl_lexer_advance (lexer);
-    } else {
+  const gchar *text = lexer->input + lexer->position;
+  gsize available = lexer->input_length - lexer->position;
+  gsize i = 0;
+
+  while ((i += hcl_scan_string (text + i, available - i, quote_char)) < available) {
+    if (text[i] == quote_char) {
+      i++;
       break;
     }
+
+    i = MIN (i + 2, available);
   }
+
+  hcl_lexer_advance_by (lexer, i);
 }
 
-static gboolean
-hcl_lexer_is_identifier_char (gchar c)
+static void
+hcl_lexer_skip_whitespace (HclLexer *lexer)
 {
-  return isalnum (c) || c == '_' || c == '-';
+  gsize count;
+
+  /* Most tokens follow another directly or after a single blank */
+  if (lexer->position >= lexer->input_length ||
+      hcl_lexer_char_class[(guchar) lexer->input[lexer->position]] != HCL_CHAR_BLANK)
+    return;
+
+  if (lexer->position + 1 >= lexer->input_length ||
+      hcl_lexer_char_class[(guchar) lexer->input[lexer->position + 1]] != HCL_CHAR_BLANK) {
+    hcl_lexer_advance_columns (lexer, 1);
+    return;
+  }
+
+  count = hcl_scan_whitespace (lexer->input + lexer->position,
+                               lexer->input_length - lexer->position);
+
+  hcl_lexer_advance_columns (lexer, count);
 }
 
-static HclToken *
-hcl_lexer_read_string (HclLexer *lexer, GError **error)
+static void
+hcl_lexer_begin_span (HclLexer *lexer, HclSpanToken *token, HclTokenType type)
 {
-  gsize start_line = lexer->line;
-  gsize start_column = lexer->column;
-  GString *value = g_string_new (NULL);
-  gchar quote_char = hcl_lexer_current_char (lexer);
-
-  hcl_lexer_advance (lexer); /* Skip opening quote */
+  token->type = type;
+  token->offset = lexer->position;
+  token->length = 0;
+  token->line = lexer->line;
+  token->column = lexer->column;
+  token->flags = HCL_SPAN_FLAG_NONE;
+}
 
-  while (lexer->position < lexer->input_length) {
-    gchar c = hcl_lexer_current_char (lexer);
+static void
+hcl_lexer_end_span (HclLexer *lexer, HclSpanToken *token)
+{
+  token->length = lexer->position - token->offset;
+}
 
-    if (c == quote_char) {
-      hcl_lexer_advance (lexer); /* Skip closing quote */
-      HclToken *token = hcl_token_new (HCL_TOKEN_TYPE_STRING, value->str,
-                                       start_line, start_column);
-      g_string_free (value, TRUE);
-      return token;
+static gboolean
+hcl_lexer_scan_string (HclLexer *lexer, HclSpanToken *token, GError **error)
+{
+  const gchar *text = lexer->input + lexer->position;
+  gsize available = lexer->input_length - lexer->position;
+  gchar quote_char = text[0];
+  gsize i = 1; /* Skip opening quote */
+
+  hcl_lexer_begin_span (lexer, token, HCL_TOKEN_TYPE_STRING);
+
+  /* Jump from one quote or backslash to the next; the bytes in between
+   * need no attention at all */
+  while ((i += hcl_scan_string (text + i, available - i, quote_char)) < available) {
+    if (text[i] == quote_char) {
+      hcl_lexer_advance_by (lexer, i + 1); /* Include closing quote */
+      hcl_lexer_end_span (lexer, token);
+      return TRUE;
     }
 
-    if (c == '\\') {
-      hcl_lexer_advance (lexer);
-      if (lexer->position >= lexer->input_length) {
-        g_set_error (error, HCL_PARSER_ERROR, HCL_PARSER_ERROR_UNTERMINATED_STRING,
-                     "Unterminated string at line %zu, column %zu",
-                     start_line, start_column);
-        g_string_free (value, TRUE);
-        return NULL;
-      }
-
-      gchar escaped = hcl_lexer_current_char (lexer);
-      switch (escaped) {
-        case 'n':
-          g_string_append_c (value, '\n');
-          break;
-        case 't':
-          g_string_append_c (value, '\t');
-          break;
-        case 'r':
-          g_string_append_c (value, '\r');
-          break;
-        case '\\':
-          g_string_append_c (value, '\\');
-          break;
-        case '"':
-          g_string_append_c (value, '"');
-          break;
-        case '\'':
-          g_string_append_c (value, '\'');
-          break;
-        default:
-          g_set_error (error, HCL_PARSER_ERROR, HCL_PARSER_ERROR_INVALID_ESCAPE,
-                       "Invalid escape sequence '\\%c' at line %zu, column %zu",
-                       escaped, lexer->line, lexer->column);
-          g_string_free (value, TRUE);
-          return NULL;
-      }
-      hcl_lexer_advance (lexer);
-    } else {
-      g_string_append_c (value, c);
-      hcl_lexer_advance (lexer);
+    token->flags |= HCL_SPAN_FLAG_ESCAPED;
+    if (i + 1 >= available)
+      break;
+
+    switch (text[i + 1]) {
+      case 'n':
+      case 't':
+      case 'r':
+      case '\\':
+      case '"':
+      case '\'':
+        i += 2;
+        break;
+      default:
+        hcl_lexer_advance_by (lexer, i + 1);
+        g_set_error (error, HCL_PARSER_ERROR, HCL_PARSER_ERROR_INVALID_ESCAPE,
+                     "Invalid escape sequence '\\%c' at line %zu, column %zu",
+                     text[i + 1], lexer->line, lexer->column);
+        hcl_lexer_advance_by (lexer, 1);
+        hcl_lexer_skip_string_tail (lexer, quote_char);
+        return FALSE;
     }
   }
 
+  hcl_lexer_advance_by (lexer, available);
   g_set_error (error, HCL_PARSER_ERROR, HCL_PARSER_ERROR_UNTERMINATED_STRING,
                "Unterminated string at line %zu, column %zu",
-               start_line, start_column);
-  g_string_free (value, TRUE);
-  return NULL;
+               token->line, token->column);
+  return FALSE;
 }
 
-static HclToken *
-hcl_lexer_read_number (HclLexer *lexer)
+/* Powers of ten that a double holds exactly */
+static const gdouble hcl_lexer_exact_powers[] = {
+  1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+#define HCL_LEXER_MAX_EXACT_MANTISSA (G_GUINT64_CONSTANT (1) << 53)
+
+/* Stores @magnitude as a signed integer, clamping like g_ascii_strtoll() */
+static void
+hcl_lexer_set_int (HclSpanToken *token, guint64 magnitude, gboolean negative, gboolean overflow)
+{
+  if (negative) {
+    if (overflow || magnitude > (guint64) G_MAXINT64 + 1)
+      token->number.int_value = G_MININT64;
+    else
+      token->number.int_value = (gint64) (0 - magnitude);
+  } else {
+    if (overflow || magnitude > G_MAXINT64)
+      token->number.int_value = G_MAXINT64;
+    else
+      token->number.int_value = (gint64) magnitude;
+  }
+}
+
+/*
+ * Converts mantissa * 10^exponent to the nearest double. Both operands
+ * are exact in the common case, and IEEE arithmetic rounds a single
+ * multiplication or division of exact operands correctly (Clinger's fast
+ * path). Anything else goes to g_ascii_strtod() on the lexeme.
+ */
+static gdouble
+hcl_lexer_make_double (const gchar *text,
+                       gsize length,
+                       guint64 mantissa,
+                       gint exponent,
+                       gboolean negative,
+                       gboolean overflow)
+{
+  gchar buffer[G_ASCII_DTOSTR_BUF_SIZE];
+  g_autofree gchar *long_text = NULL;
+  const gchar *copy;
+  gdouble value;
+
+  if (!overflow && mantissa <= HCL_LEXER_MAX_EXACT_MANTISSA) {
+    value = (gdouble) mantissa;
+
+    if (mantissa == 0 || exponent == 0)
+      return negative ? -value : value;
+
+    if (exponent < 0 && exponent >= -22)
+      return negative ? -(value / hcl_lexer_exact_powers[-exponent])
+                      : value / hcl_lexer_exact_powers[-exponent];
+
+    /* A short mantissa can absorb part of a larger exponent exactly */
+    if (exponent > 22 && exponent <= 22 + 15) {
+      value *= hcl_lexer_exact_powers[exponent - 22];
+      if (value <= (gdouble) HCL_LEXER_MAX_EXACT_MANTISSA)
+        exponent = 22;
+    }
+
+    if (exponent > 0 && exponent <= 22)
+      return negative ? -(value * hcl_lexer_exact_powers[exponent])
+                      : value * hcl_lexer_exact_powers[exponent];
+  }
+
+  /* The lexeme is not nul-terminated inside the input buffer */
+  if (length < sizeof buffer) {
+    memcpy (buffer, text, length);
+    buffer[length] = '\0';
+    copy = buffer;
+  } else {
+    copy = long_text = g_strndup (text, length);
+  }
+
+  return g_ascii_strtod (copy, NULL);
+}
+
+/* Scans the digits after a 0x or 0b prefix, starting at byte @i of @text */
+static gsize
+hcl_lexer_scan_radix (HclSpanToken *token,
+                      const gchar *text,
+                      gsize available,
+                      gsize i,
+                      guint radix,
+                      gboolean negative)
+{
+  guint64 magnitude = 0;
+  gboolean overflow = FALSE;
+
+  for (; i < available; i++) {
+    gint digit = g_ascii_xdigit_value (text[i]);
+
+    if (digit < 0 || (guint) digit >= radix)
+      break;
+
+    if (magnitude > (G_MAXUINT64 - (guint) digit) / radix)
+      overflow = TRUE;
+    else
+      magnitude = magnitude * radix + (guint) digit;
+  }
+
+  hcl_lexer_set_int (token, magnitude, negative, overflow);
+  return i;
+}
+
+/* Adds a decimal digit to @mantissa, noting when it no longer fits */
+static inline void
+hcl_lexer_add_digit (guint64 *mantissa, gboolean *overflow, gchar c)
+{
+  guint digit = (guint) (c - '0');
+
+  if (*mantissa > (G_MAXUINT64 - digit) / 10)
+    *overflow = TRUE;
+  else
+    *mantissa = *mantissa * 10 + digit;
+}
+
+/*
+ * Scans a number and converts it in the same pass. The value is left in
+ * @token as an integer, or as a double with %HCL_SPAN_FLAG_FLOAT set when
+ * the lexeme has a fraction or an exponent. A float too large for a
+ * double is an error, since no other HCL literal can stand for it.
+ */
+static gboolean
+hcl_lexer_scan_number (HclLexer *lexer, HclSpanToken *token, GError **error)
 {
-  gsize start_line = lexer->line;
-  gsize start_column = lexer->column;
-  GString *value = g_string_new (NULL);
-  gboolean is_hex = FALSE;
-  gboolean is_binary = FALSE;
-  gboolean has_dot = FALSE;
-  gboolean has_exp = FALSE;
+  const gchar *text = lexer->input + lexer->position;
+  gsize available = lexer->input_length - lexer->position;
+  gboolean negative = FALSE;
+  gboolean overflow = FALSE;
+  guint64 mantissa = 0;
+  gint exponent = 0;
+  gsize i = 0;
 
-  gchar first_char = hcl_lexer_current_char (lexer);
+  hcl_lexer_begin_span (lexer, token, HCL_TOKEN_TYPE_NUMBER);
 
   /* Handle negative numbers */
-  if (first_char == '-') {
-    g_string_append_c (value, first_char);
-    hcl_lexer_advance (lexer);
-    first_char = hcl_lexer_current_char (lexer);
+  if (text[0] == '-') {
+    negative = TRUE;
+    i++;
   }
 
   /* Check for hex (0x) or binary (0b) prefixes */
-  if (first_char == '0' && lexer->position + 1 < lexer->input_length) {
-    gchar second_char = hcl_lexer_peek_char (lexer, 1);
-    if (second_char == 'x' || second_char == 'X') {
-      is_hex = TRUE;
-      g_string_append_c (value, first_char);
-      hcl_lexer_advance (lexer);
-      g_string_append_c (value, hcl_lexer_current_char (lexer));
-      hcl_lexer_advance (lexer);
-    } else if (second_char == 'b' || second_char == 'B') {
-      is_binary = TRUE;
-      g_string_append_c (value, first_char);
-      hcl_lexer_advance (lexer);
-      g_string_append_c (value, hcl_lexer_current_char (lexer));
-      hcl_lexer_advance (lexer);
+  if (i + 1 < available && text[i] == '0' &&
+      (text[i + 1] == 'x' || text[i + 1] == 'X' ||
+       text[i + 1] == 'b' || text[i + 1] == 'B')) {
+    guint radix = (text[i + 1] == 'x' || text[i + 1] == 'X') ? 16 : 2;
+
+    i = hcl_lexer_scan_radix (token, text, available, i + 2, radix, negative);
+    hcl_lexer_advance_columns (lexer, i);
+    hcl_lexer_end_span (lexer, token);
+    return TRUE;
+  }
+
+  for (; i < available && g_ascii_isdigit (text[i]); i++)
+    hcl_lexer_add_digit (&mantissa, &overflow, text[i]);
+
+  if (i < available && text[i] == '.') {
+    token->flags |= HCL_SPAN_FLAG_FLOAT;
+
+    for (i++; i < available && g_ascii_isdigit (text[i]); i++) {
+      hcl_lexer_add_digit (&mantissa, &overflow, text[i]);
+      exponent--;
     }
   }
 
-  while (lexer->position < lexer->input_length) {
-    gchar c = hcl_lexer_current_char (lexer);
+  if (i < available && (text[i] == 'e' || text[i] == 'E')) {
+    gboolean negative_exponent = FALSE;
+    gint written = 0;
 
-    if (is_hex) {
-      if (isxdigit (c)) {
-        g_string_append_c (value, c);
-        hcl_lexer_advance (lexer);
-      } else {
-        break;
-      }
-    } else if (is_binary) {
-      if (c == '0' || c == '1') {
-        g_string_append_c (value, c);
-        hcl_lexer_advance (lexer);
-      } else {
-        break;
-      }
-    } else {
-      /* Decimal number */
-      if (isdigit (c)) {
-        g_string_append_c (value, c);
-        hcl_lexer_advance (lexer);
-      } else if (c == '.' && !has_dot && !has_exp) {
-        has_dot = TRUE;
-        g_string_append_c (value, c);
-        hcl_lexer_advance (lexer);
-      } else if ((c == 'e' || c == 'E') && !has_exp) {
-        has_exp = TRUE;
-        g_string_append_c (value, c);
-        hcl_lexer_advance (lexer);
-        /* Handle optional +/- after exponent */
-        if (lexer->position < lexer->input_length) {
-          gchar exp_sign = hcl_lexer_current_char (lexer);
-          if (exp_sign == '+' || exp_sign == '-') {
-            g_string_append_c (value, exp_sign);
-            hcl_lexer_advance (lexer);
-          }
-        }
-      } else {
-        break;
-      }
+    token->flags |= HCL_SPAN_FLAG_FLOAT;
+
+    /* Handle optional +/- after exponent */
+    i++;
+    if (i < available && (text[i] == '+' || text[i] == '-')) {
+      negative_exponent = text[i] == '-';
+      i++;
     }
+
+    /* Anything this large is out of range whatever the mantissa */
+    for (; i < available && g_ascii_isdigit (text[i]); i++) {
+      if (written < 100000)
+        written = written * 10 + (text[i] - '0');
+    }
+
+    exponent += negative_exponent ? -written : written;
   }
 
-  HclToken *token = hcl_token_new (HCL_TOKEN_TYPE_NUMBER, value->str,
-                                   start_line, start_column);
-  g_string_free (value, TRUE);
-  return token;
+  if (token->flags & HCL_SPAN_FLAG_FLOAT)
+    token->number.double_value = hcl_lexer_make_double (text, i, mantissa, exponent,
+                                                        negative, overflow);
+  else
+    hcl_lexer_set_int (token, mantissa, negative, overflow);
+
+  hcl_lexer_advance_columns (lexer, i);
+  hcl_lexer_end_span (lexer, token);
+
+  if ((token->flags & HCL_SPAN_FLAG_FLOAT) && !isfinite (token->number.double_value)) {
+    g_set_error (error, HCL_PARSER_ERROR, HCL_PARSER_ERROR_INVALID_NUMBER,
+                 "Number '%.*s' is out of range at line %zu, column %zu",
+                 (gint) i, text, token->line, token->column);
+    lexer->error_span = *token;
+    lexer->failed = TRUE;
+    return FALSE;
+  }
+
+  return TRUE;
 }
 
-static HclToken *
-hcl_lexer_read_identifier (HclLexer *lexer)
+static void
+hcl_lexer_scan_identifier (HclLexer *lexer, HclSpanToken *token)
+{
+  hcl_lexer_begin_span (lexer, token, HCL_TOKEN_TYPE_IDENTIFIER);
+
+  hcl_lexer_advance_columns (lexer,
+                             hcl_scan_identifier (lexer->input + lexer->position,
+                                                  lexer->input_length - lexer->position));
+
+  hcl_lexer_end_span (lexer, token);
+
+  /* Check for boolean and null literals */
+  const gchar *text = lexer->input + token->offset;
+  if ((token->length == 4 && memcmp (text, "true", 4) == 0) ||
+      (token->length == 5 && memcmp (text, "false", 5) == 0)) {
+    token->type = HCL_TOKEN_TYPE_BOOL;
+  } else if (token->length == 4 && memcmp (text, "null", 4) == 0) {
+    token->type = HCL_TOKEN_TYPE_NULL;
+  }
+}
+
+static void
+hcl_lexer_scan_comment (HclLexer *lexer, HclSpanToken *token)
+{
+  hcl_lexer_begin_span (lexer, token, HCL_TOKEN_TYPE_COMMENT);
+
+  hcl_lexer_advance_columns (lexer,
+                             hcl_scan_line (lexer->input + lexer->position,
+                                            lexer->input_length - lexer->position));
+
+  hcl_lexer_end_span (lexer, token);
+}
+
+static gboolean
+hcl_lexer_scan (HclLexer *lexer, HclSpanToken *token, GError **error)
 {
-  gsize start_line = lexer->line;
-  gsize start_column = lexer->column;
-  GString *value = g_string_new (NULL);
+  hcl_lexer_skip_whitespace (lexer);
+
+  if (lexer->position >= lexer->input_length) {
+    hcl_lexer_begin_span (lexer, token, HCL_TOKEN_TYPE_EOF);
+    return TRUE;
+  }
+
+  guchar c = (guchar) lexer->input[lexer->position];
+  HclCharClass klass = hcl_lexer_char_class[c];
 
-  while (lexer->position < lexer->input_length) {
-    gchar c = hcl_lexer_current_char (lexer);
-    if (hcl_lexer_is_identifier_char (c)) {
-      g_string_append_c (value, c);
-      hcl_lexer_advance (lexer);
+  /* Punctuation is the most common token, so it skips the switch */
+  if (G_LIKELY (klass == HCL_CHAR_PUNCTUATION)) {
+    hcl_lexer_begin_span (lexer, token, hcl_lexer_punctuation_type[c]);
+    if (c == '\n') {
+      lexer->line++;
+      lexer->column = 1;
+      lexer->position++;
     } else {
-      break;
+      hcl_lexer_advance_columns (lexer, 1);
     }
+    token->length = 1;
+    return TRUE;
   }
 
-  HclTokenType type = HCL_TOKEN_TYPE_IDENTIFIER;
+  switch (klass) {
+    case HCL_CHAR_QUOTE:
+      if (hcl_lexer_scan_string (lexer, token, error))
+        return TRUE;
 
-  /* Check for boolean literals */
-  if (g_strcmp0 (value->str, "true") == 0 || g_strcmp0 (value->str, "false") == 0) {
-    type = HCL_TOKEN_TYPE_BOOL;
-  }
-  /* Check for null literal */
-  else if (g_strcmp0 (value->str, "null") == 0) {
-    type = HCL_TOKEN_TYPE_NULL;
+      hcl_lexer_end_span (lexer, token);
+      lexer->error_span = *token;
+      lexer->failed = TRUE;
+      return FALSE;
+
+    case HCL_CHAR_HASH:
+      hcl_lexer_scan_comment (lexer, token);
+      return TRUE;
+
+    case HCL_CHAR_SLASH:
+      if (hcl_lexer_peek_char (lexer, 1) != '/')
+        break;
+      hcl_lexer_scan_comment (lexer, token);
+      return TRUE;
+
+    case HCL_CHAR_MINUS:
+      if (hcl_lexer_char_class[(guchar) hcl_lexer_peek_char (lexer, 1)] != HCL_CHAR_DIGIT)
+        break;
+      G_GNUC_FALLTHROUGH;
+
+    case HCL_CHAR_DIGIT:
+      return hcl_lexer_scan_number (lexer, token, error);
+
+    case HCL_CHAR_IDENTIFIER_START:
+      hcl_lexer_scan_identifier (lexer, token);
+      return TRUE;
+
+    case HCL_CHAR_PUNCTUATION:
+    case HCL_CHAR_BLANK:
+    case HCL_CHAR_INVALID:
+    default:
+      break;
   }
 
-  HclToken *token = hcl_token_new (type, value->str, start_line, start_column);
-  g_string_free (value, TRUE);
-  return token;
+  /* Left in place; hcl_lexer_recover() steps over the whole character */
+  hcl_lexer_begin_span (lexer, &lexer->error_span, HCL_TOKEN_TYPE_INVALID);
+  lexer->error_span.length = MIN ((gsize) g_utf8_skip[c],
+                                  lexer->input_length - lexer->position);
+  lexer->failed = TRUE;
+
+  g_set_error (error, HCL_PARSER_ERROR, HCL_PARSER_ERROR_SYNTAX,
+               "Unexpected character '%c' at line %zu, column %zu",
+               c, lexer->line, lexer->column);
+  return FALSE;
 }
 
-static HclToken *
-hcl_lexer_read_comment (HclLexer *lexer)
-{
-  gsize start_line = lexer->line;
-  gsize start_column = lexer->column;
-  GString *value = g_string_new (NULL);
-
-  /* Skip initial # or // */
-  if (hcl_lexer_current_char (lexer) == '#') {
-    hcl_lexer_advance (lexer);
-  } else if (hcl_lexer_current_char (lexer) == '/' &&
-             hcl_lexer_peek_char (lexer, 1) == '/') {
-    hcl_lexer_advance (lexer);
-    hcl_lexer_advance (lexer);
-  }
+/* Writes the unescaped value to @value, which must hold @length bytes */
+static gsize
+hcl_lexer_unescape_into (const gchar *text, gsize length, gchar *value)
+{
+  gchar *out = value;
+  const gchar *end = text + length;
 
-  while (lexer->position < lexer->input_length) {
-    gchar c = hcl_lexer_current_char (lexer);
-    if (c == '\n') {
+  while (text < end) {
+    const gchar *backslash = memchr (text, '\\', (gsize) (end - text));
+    gsize run = backslash ? (gsize) (backslash - text) : (gsize) (end - text);
+
+    /* Copy everything up to the next escape in one go */
+    memcpy (out, text, run);
+    out += run;
+    text += run;
+
+    if (!backslash || text + 1 >= end)
       break;
+
+    switch (text[1]) {
+      case 'n':
+        *out++ = '\n';
+        break;
+      case 't':
+        *out++ = '\t';
+        break;
+      case 'r':
+        *out++ = '\r';
+        break;
+      default:
+        /* '\\', '"' and '\'' stand for themselves */
+        *out++ = text[1];
+        break;
     }
-    g_string_append_c (value, c);
-    hcl_lexer_advance (lexer);
+    text += 2;
   }
 
-  HclToken *token = hcl_token_new (HCL_TOKEN_TYPE_COMMENT, value->str,
-                                   start_line, start_column);
-  g_string_free (value, TRUE);
+  /* A trailing lone backslash is kept as written */
+  if (text < end)
+    *out++ = *text;
+
+  return (gsize) (out - value);
+}
+
+static gchar *
+hcl_lexer_unescape (const gchar *text, gsize length)
+{
+  gchar *value = g_malloc (length + 1);
+
+  value[hcl_lexer_unescape_into (text, length, value)] = '\0';
+  return value;
+}
+
+static HclToken *
+hcl_lexer_materialize (HclLexer *lexer, const HclSpanToken *span)
+{
+  HclToken *token = g_object_new (HCL_TYPE_TOKEN, NULL);
+  const gchar *text = NULL;
+
+  if ((gsize) span->type < G_N_ELEMENTS (hcl_lexer_token_text))
+    text = hcl_lexer_token_text[span->type];
+
+  token->type = span->type;
+  token->static_value = text != NULL;
+  token->value = text ? (gchar *) text : hcl_lexer_span_dup_value (lexer, span);
+  token->line = span->line;
+  token->column = span->column;
+
   return token;
 }
 
 /**
- * hcl_lexer_next_token:
+ * hcl_lexer_next_span:
  * @lexer: an #HclLexer
+ * @token: (out caller-allocates): return location for the token
  * @error: return location for error
  *
- * Gets the next token from the lexer.
+ * Gets the next token from the lexer as a span into the input, without
+ * allocating any memory.
  *
- * Returns: (transfer full) (nullable): the next token or %NULL on error
+ * Returns: %TRUE if @token was filled in, %FALSE on error
  */
-HclToken *
-hcl_lexer_next_token (HclLexer *lexer, GError **error)
+gboolean
+hcl_lexer_next_span (HclLexer *lexer, HclSpanToken *token, GError **error)
 {
-  g_return_val_if_fail (HCL_IS_LEXER (lexer), NULL);
+  g_return_val_if_fail (HCL_IS_LEXER (lexer), FALSE);
+  g_return_val_if_fail (token != NULL, FALSE);
 
   /* Return peeked token if available */
-  if (lexer->peeked_token) {
-    HclToken *token = lexer->peeked_token;
-    lexer->peeked_token = NULL;
-    return token;
+  if (lexer->lookahead_count > 0) {
+    *token = lexer->lookahead[lexer->lookahead_head];
+    lexer->lookahead_head = (lexer->lookahead_head + 1) % HCL_LEXER_LOOKAHEAD;
+    lexer->lookahead_count--;
+    g_clear_object (&lexer->peeked_token);
+    return TRUE;
   }
 
-  hcl_lexer_skip_whitespace (lexer);
+  return hcl_lexer_scan (lexer, token, error);
+}
 
-  if (lexer->position >= lexer->input_length) {
-    return hcl_token_new (HCL_TOKEN_TYPE_EOF, "", lexer->line, lexer->column);
+/**
+ * hcl_lexer_peek_span:
+ * @lexer: an #HclLexer
+ * @token: (out caller-allocates): return location for the token
+ * @error: return location for error
+ *
+ * Peeks at the next token as a span without consuming it.
+ *
+ * Returns: %TRUE if @token was filled in, %FALSE on error
+ */
+gboolean
+hcl_lexer_peek_span (HclLexer *lexer, HclSpanToken *token, GError **error)
+{
+  return hcl_lexer_peek_span_nth (lexer, 0, token, error);
+}
+
+/**
+ * hcl_lexer_peek_span_nth:
+ * @lexer: an #HclLexer
+ * @n: how many tokens to look past, less than %HCL_LEXER_LOOKAHEAD
+ * @token: (out caller-allocates): return location for the token
+ * @error: return location for error
+ *
+ * Peeks at the token @n places after the next one without consuming
+ * anything, so `0` gives the same token as hcl_lexer_peek_span(). The
+ * tokens in between are kept in a fixed ring inside the lexer; peeking
+ * never allocates.
+ *
+ * Returns: %TRUE if @token was filled in, %FALSE on error
+ */
+gboolean
+hcl_lexer_peek_span_nth (HclLexer *lexer,
+                         guint n,
+                         HclSpanToken *token,
+                         GError **error)
+{
+  g_return_val_if_fail (HCL_IS_LEXER (lexer), FALSE);
+  g_return_val_if_fail (n < HCL_LEXER_LOOKAHEAD, FALSE);
+  g_return_val_if_fail (token != NULL, FALSE);
+
+  while (lexer->lookahead_count <= n) {
+    guint tail = (lexer->lookahead_head + lexer->lookahead_count) % HCL_LEXER_LOOKAHEAD;
+
+    if (!hcl_lexer_scan (lexer, &lexer->lookahead[tail], error))
+      return FALSE;
+    lexer->lookahead_count++;
+  }
+
+  *token = lexer->lookahead[(lexer->lookahead_head + n) % HCL_LEXER_LOOKAHEAD];
+  return TRUE;
+}
+
+/**
+ * hcl_lexer_span_get_text:
+ * @lexer: the #HclLexer that produced @token
+ * @token: a span token
+ * @length: (out) (optional): return location for the text length
+ *
+ * Gets the raw text of a span token inside the lexer input. For string
+ * literals this is the text between the quotes with escape sequences left
+ * as written; for comments it is the text after the comment marker.
+ *
+ * Returns: (transfer none): a pointer into the lexer input; it is not
+ *   nul-terminated at @length
+ */
+const gchar *
+hcl_lexer_span_get_text (HclLexer *lexer, const HclSpanToken *token, gsize *length)
+{
+  const gchar *text;
+  gsize text_length;
+
+  g_return_val_if_fail (HCL_IS_LEXER (lexer), NULL);
+  g_return_val_if_fail (token != NULL, NULL);
+
+  text = lexer->input + token->offset;
+  text_length = token->length;
+
+  if (token->type == HCL_TOKEN_TYPE_STRING && text_length >= 2) {
+    text += 1;
+    text_length -= 2;
+  } else if (token->type == HCL_TOKEN_TYPE_COMMENT && text_length > 0) {
+    gsize marker = text[0] == '#' ? 1 : 2;
+    text += marker;
+    text_length -= marker;
   }
 
-  gchar c = hcl_lexer_current_char (lexer);
-  gsize line = lexer->line;
-  gsize column = lexer->column;
+  if (length)
+    *length = text_length;
 
-  switch (c) {
-    case '\n':
-      hcl_lexer_advance (lexer);
-      return hcl_token_new (HCL_TOKEN_TYPE_NEWLINE, "\n", line, column);
+  return text;
+}
 
-    case '=':
-      hcl_lexer_advance (lexer);
-      return hcl_token_new (HCL_TOKEN_TYPE_ASSIGN, "=", line, column);
+/**
+ * hcl_lexer_span_dup_value:
+ * @lexer: the #HclLexer that produced @token
+ * @token: a span token
+ *
+ * Materializes the value of a span token, processing escape sequences in
+ * string literals. This is the value hcl_token_get_value() would return
+ * for the same token. String literals without %HCL_SPAN_FLAG_ESCAPED are
+ * copied straight out of the input.
+ *
+ * Returns: (transfer full): a newly allocated string
+ */
+gchar *
+hcl_lexer_span_dup_value (HclLexer *lexer, const HclSpanToken *token)
+{
+  const gchar *text;
+  gsize length;
 
-    case '{':
-      hcl_lexer_advance (lexer);
-      return hcl_token_new (HCL_TOKEN_TYPE_LBRACE, "{", line, column);
+  g_return_val_if_fail (HCL_IS_LEXER (lexer), NULL);
+  g_return_val_if_fail (token != NULL, NULL);
 
-    case '}':
-      hcl_lexer_advance (lexer);
-      return hcl_token_new (HCL_TOKEN_TYPE_RBRACE, "}", line, column);
+  text = hcl_lexer_span_get_text (lexer, token, &length);
 
-    case '[':
-      hcl_lexer_advance (lexer);
-      return hcl_token_new (HCL_TOKEN_TYPE_LBRACKET, "[", line, column);
+  if (token->flags & HCL_SPAN_FLAG_ESCAPED)
+    return hcl_lexer_unescape (text, length);
 
-    case ']':
-      hcl_lexer_advance (lexer);
-      return hcl_token_new (HCL_TOKEN_TYPE_RBRACKET, "]", line, column);
+  return g_strndup (text, length);
+}
 
-    case '(':
-      hcl_lexer_advance (lexer);
-      return hcl_token_new (HCL_TOKEN_TYPE_LPAREN, "(", line, column);
+/*
+ * hcl_lexer_span_copy_value:
+ * @buffer: buffer that receives the value
+ *
+ * Like hcl_lexer_span_dup_value(), but replaces the contents of @buffer
+ * with the value so callers can reuse one allocation for many tokens.
+ */
+void
+hcl_lexer_span_copy_value (HclLexer *lexer,
+                           const HclSpanToken *token,
+                           GString *buffer)
+{
+  const gchar *text;
+  gsize length;
 
-    case ')':
-      hcl_lexer_advance (lexer);
-      return hcl_token_new (HCL_TOKEN_TYPE_RPAREN, ")", line, column);
+  text = hcl_lexer_span_get_text (lexer, token, &length);
 
-    case ',':
-      hcl_lexer_advance (lexer);
-      return hcl_token_new (HCL_TOKEN_TYPE_COMMA, ",", line, column);
+  if (token->flags & HCL_SPAN_FLAG_ESCAPED) {
+    g_string_set_size (buffer, length);
+    g_string_truncate (buffer, hcl_lexer_unescape_into (text, length, buffer->str));
+  } else {
+    g_string_truncate (buffer, 0);
+    g_string_append_len (buffer, text, (gssize) length);
+  }
+}
 
-    case '.':
-      hcl_lexer_advance (lexer);
-      return hcl_token_new (HCL_TOKEN_TYPE_DOT, ".", line, column);
+/*
+ * hcl_lexer_span_intern:
+ *
+ * Returns the value of a span token as an interned string. Short values,
+ * which is nearly all keys and block types, are interned straight from a
+ * stack buffer without allocating.
+ */
+const gchar *
+hcl_lexer_span_intern (HclLexer *lexer, const HclSpanToken *token)
+{
+  g_autofree gchar *copy = NULL;
+  gchar buffer[128];
+  const gchar *text;
+  gsize length;
 
-    case '"':
-    case '\'':
-      return hcl_lexer_read_string (lexer, error);
+  text = hcl_lexer_span_get_text (lexer, token, &length);
 
-    case '#':
-      return hcl_lexer_read_comment (lexer);
+  if (token->flags & HCL_SPAN_FLAG_ESCAPED) {
+    if (length >= sizeof buffer)
+      return g_intern_string (copy = hcl_lexer_unescape (text, length));
 
-    case '/':
-      if (hcl_lexer_peek_char (lexer, 1) == '/') {
-        return hcl_lexer_read_comment (lexer);
-      }
-      /* Fall through for division or other uses */
-      break;
+    buffer[hcl_lexer_unescape_into (text, length, buffer)] = '\0';
+  } else {
+    if (length >= sizeof buffer)
+      return g_intern_string (copy = g_strndup (text, length));
 
-    default:
-      if (isdigit (c) || (c == '-' && isdigit (hcl_lexer_peek_char (lexer, 1)))) {
-        return hcl_lexer_read_number (lexer);
-      } else if (isalpha (c) || c == '_') {
-        return hcl_lexer_read_identifier (lexer);
-      }
-      break;
+    memcpy (buffer, text, length);
+    buffer[length] = '\0';
   }
 
-  g_set_error (error, HCL_PARSER_ERROR, HCL_PARSER_ERROR_SYNTAX,
-               "Unexpected character '%c' at line %zu, column %zu",
-               c, line, column);
-  return NULL;
+  return g_intern_string (buffer);
+}
+
+/**
+ * hcl_lexer_span_equal:
+ * @lexer: the #HclLexer that produced @token
+ * @token: a span token
+ * @text: text to compare with
+ *
+ * Compares the text of a span token, as returned by
+ * hcl_lexer_span_get_text(), with @text without allocating.
+ *
+ * Returns: %TRUE if the token text equals @text
+ */
+gboolean
+hcl_lexer_span_equal (HclLexer *lexer, const HclSpanToken *token, const gchar *text)
+{
+  const gchar *span_text;
+  gsize length;
+
+  g_return_val_if_fail (HCL_IS_LEXER (lexer), FALSE);
+  g_return_val_if_fail (token != NULL, FALSE);
+  g_return_val_if_fail (text != NULL, FALSE);
+
+  span_text = hcl_lexer_span_get_text (lexer, token, &length);
+
+  return strncmp (span_text, text, length) == 0 && text[length] == '\0';
+}
+
+/**
+ * hcl_lexer_next_token:
+ * @lexer: an #HclLexer
+ * @error: return location for error
+ *
+ * Gets the next token from the lexer.
+ *
+ * Returns: (transfer full) (nullable): the next token or %NULL on error
+ */
+HclToken *
+hcl_lexer_next_token (HclLexer *lexer, GError **error)
+{
+  HclSpanToken span;
+
+  g_return_val_if_fail (HCL_IS_LEXER (lexer), NULL);
+
+  /* Return peeked token if available */
+  if (lexer->peeked_token) {
+    HclToken *token = g_steal_pointer (&lexer->peeked_token);
+
+    /* Drops the span the token was made from */
+    hcl_lexer_next_span (lexer, &span, NULL);
+    return token;
+  }
+
+  if (!hcl_lexer_next_span (lexer, &span, error))
+    return NULL;
+
+  return hcl_lexer_materialize (lexer, &span);
 }
 
 /**
@@ -591,7 +1174,12 @@ hcl_lexer_peek_token (HclLexer *lexer, GError **error)
   g_return_val_if_fail (HCL_IS_LEXER (lexer), NULL);
 
   if (!lexer->peeked_token) {
-    lexer->peeked_token = hcl_lexer_next_token (lexer, error);
+    HclSpanToken span;
+
+    if (!hcl_lexer_peek_span (lexer, &span, error))
+      return NULL;
+
+    lexer->peeked_token = hcl_lexer_materialize (lexer, &span);
   }
 
   return lexer->peeked_token;
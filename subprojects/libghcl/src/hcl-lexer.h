@@ -16,6 +16,48 @@
 
 G_BEGIN_DECLS
 
+/**
+ * HclSpanToken:
+ * @type: the token type
+ * @offset: byte offset of the lexeme in the lexer input
+ * @length: length of the lexeme in bytes
+ * @line: line number of the first character
+ * @column: column number of the first character
+ * @flags: #HclSpanFlags describing the lexeme
+ * @number: the value of a %HCL_TOKEN_TYPE_NUMBER token, converted while
+ *   scanning: @number.double_value if @flags has %HCL_SPAN_FLAG_FLOAT,
+ *   @number.int_value otherwise. Unset for other token types.
+ *
+ * A lightweight token that refers back into the input buffer of the
+ * #HclLexer that produced it instead of owning a copy of its text. Span
+ * tokens live on the stack and are only valid while the lexer input is.
+ *
+ * The lexeme covers the whole token as written, including the quotes of
+ * a string literal and the leading marker of a comment. Use
+ * hcl_lexer_span_get_text() or hcl_lexer_span_dup_value() to get at the
+ * token value.
+ */
+typedef struct {
+  HclTokenType type;
+  gsize offset;
+  gsize length;
+  gsize line;
+  gsize column;
+  HclSpanFlags flags;
+  union {
+    gint64 int_value;
+    gdouble double_value;
+  } number;
+} HclSpanToken;
+
+/**
+ * HCL_LEXER_LOOKAHEAD:
+ *
+ * The number of tokens an #HclLexer can hold ahead of the caller; see
+ * hcl_lexer_peek_span_nth().
+ */
+#define HCL_LEXER_LOOKAHEAD 4
+
 #define HCL_TYPE_TOKEN (hcl_token_get_type())
 G_DECLARE_FINAL_TYPE (HclToken, hcl_token, HCL, TOKEN, GObject)
 
@@ -35,6 +77,8 @@ gsize           hcl_token_get_column       (HclToken *token);
 
 /* Lexer API */
 HclLexer       *hcl_lexer_new              (const gchar *input);
+HclLexer       *hcl_lexer_new_with_length  (const gchar *input,
+                                            gssize length);
 HclToken       *hcl_lexer_next_token       (HclLexer *lexer,
                                             GError **error);
 HclToken       *hcl_lexer_peek_token       (HclLexer *lexer,
@@ -43,6 +87,26 @@ gboolean        hcl_lexer_at_end           (HclLexer *lexer);
 gsize           hcl_lexer_get_line         (HclLexer *lexer);
 gsize           hcl_lexer_get_column       (HclLexer *lexer);
 
+/* Span token API */
+gboolean        hcl_lexer_next_span        (HclLexer *lexer,
+                                            HclSpanToken *token,
+                                            GError **error);
+gboolean        hcl_lexer_peek_span        (HclLexer *lexer,
+                                            HclSpanToken *token,
+                                            GError **error);
+gboolean        hcl_lexer_peek_span_nth    (HclLexer *lexer,
+                                            guint n,
+                                            HclSpanToken *token,
+                                            GError **error);
+const gchar    *hcl_lexer_span_get_text    (HclLexer *lexer,
+                                            const HclSpanToken *token,
+                                            gsize *length);
+gchar          *hcl_lexer_span_dup_value   (HclLexer *lexer,
+                                            const HclSpanToken *token);
+gboolean        hcl_lexer_span_equal       (HclLexer *lexer,
+                                            const HclSpanToken *token,
+                                            const gchar *text);
+
 G_END_DECLS
 
 #endif /* __HCL_LEXER_H__ */
@@ -0,0 +1,282 @@
+/* hcl-map.c - Insertion-ordered attribute and member storage
+ *
+ * Copyright 2024 Geoff Johnson <geoff.jay@gmail.com>
+ */
+
+#include "hcl-private.h"
+#include <string.h>
+
+/*
+ * The attributes of a block or document, or the members of an object,
+ * keyed by interned name and kept in the order each name was first set.
+ * Setting a name again replaces its value where it stands.
+ *
+ * Entries live in one array. Most blocks have a handful of attributes,
+ * and comparing that many keys in a row is cheaper than hashing, so
+ * lookups scan the array until it holds more than HCL_MAP_LINEAR_MAX
+ * entries. Past that, an open-addressing table of positions into the
+ * array is kept alongside, sized to stay at most half full. The table
+ * hashes the contents of the keys, so it can be probed with a key that
+ * was never interned.
+ *
+ * Maps are reference counted so that frozen objects can share theirs.
+ */
+
+#define HCL_MAP_LINEAR_MAX 16
+
+struct _HclMap
+{
+  gatomicrefcount ref_count;
+  guint len;
+  guint allocated;
+  guint index_mask;         /* Slots in @index - 1, once there is one */
+  HclMapEntry *entries;
+  guint32 *index;           /* Position + 1 of an entry, 0 for a free slot */
+};
+
+static inline guint
+hcl_map_hash (const gchar *key)
+{
+  /* Fibonacci hashing spreads g_str_hash() over the low bits the mask keeps */
+  return (guint) (((guint64) g_str_hash (key) * G_GUINT64_CONSTANT (0x9E3779B97F4A7C15)) >> 32);
+}
+
+static void
+hcl_map_index_add (HclMap *map, guint position)
+{
+  guint slot = hcl_map_hash (map->entries[position].key) & map->index_mask;
+
+  while (map->index[slot] != 0)
+    slot = (slot + 1) & map->index_mask;
+
+  map->index[slot] = position + 1;
+}
+
+static void
+hcl_map_rebuild_index (HclMap *map)
+{
+  guint slots = 1;
+
+  /* Room to double before the table is half full */
+  while (slots < map->len * 4)
+    slots <<= 1;
+
+  g_free (map->index);
+  map->index = g_new0 (guint32, slots);
+  map->index_mask = slots - 1;
+
+  for (guint i = 0; i < map->len; i++)
+    hcl_map_index_add (map, i);
+}
+
+static gint
+hcl_map_find (HclMap *map, const gchar *key)
+{
+  if (map->index == NULL) {
+    for (guint i = 0; i < map->len; i++) {
+      if (map->entries[i].key == key)
+        return i;
+    }
+
+    return -1;
+  }
+
+  for (guint slot = hcl_map_hash (key) & map->index_mask; ; slot = (slot + 1) & map->index_mask) {
+    guint32 position = map->index[slot];
+
+    if (position == 0)
+      return -1;
+    if (map->entries[position - 1].key == key)
+      return position - 1;
+  }
+}
+
+/* Like hcl_map_find(), for a @key that need not be interned */
+static gint
+hcl_map_find_string (HclMap *map, const gchar *key)
+{
+  if (map->index == NULL) {
+    for (guint i = 0; i < map->len; i++) {
+      if (strcmp (map->entries[i].key, key) == 0)
+        return i;
+    }
+
+    return -1;
+  }
+
+  for (guint slot = hcl_map_hash (key) & map->index_mask; ; slot = (slot + 1) & map->index_mask) {
+    guint32 position = map->index[slot];
+
+    if (position == 0)
+      return -1;
+    if (strcmp (map->entries[position - 1].key, key) == 0)
+      return position - 1;
+  }
+}
+
+HclMap *
+hcl_map_new (void)
+{
+  HclMap *map = g_new0 (HclMap, 1);
+
+  g_atomic_ref_count_init (&map->ref_count);
+
+  return map;
+}
+
+HclMap *
+hcl_map_ref (HclMap *map)
+{
+  g_atomic_ref_count_inc (&map->ref_count);
+
+  return map;
+}
+
+void
+hcl_map_unref (HclMap *map)
+{
+  if (!g_atomic_ref_count_dec (&map->ref_count))
+    return;
+
+  for (guint i = 0; i < map->len; i++)
+    g_object_unref (map->entries[i].value);
+
+  g_free (map->entries);
+  g_free (map->index);
+  g_free (map);
+}
+
+/* A map of its own with the same entries, sharing the values */
+HclMap *
+hcl_map_copy (HclMap *map)
+{
+  HclMap *copy = hcl_map_new ();
+
+  if (map->len == 0)
+    return copy;
+
+  copy->len = copy->allocated = map->len;
+  copy->entries = g_new (HclMapEntry, map->len);
+  memcpy (copy->entries, map->entries, map->len * sizeof (HclMapEntry));
+  for (guint i = 0; i < copy->len; i++)
+    g_object_ref (copy->entries[i].value);
+
+  if (map->index) {
+    copy->index_mask = map->index_mask;
+    copy->index = g_new (guint32, map->index_mask + 1);
+    memcpy (copy->index, map->index, (map->index_mask + 1) * sizeof (guint32));
+  }
+
+  return copy;
+}
+
+guint
+hcl_map_get_size (HclMap *map)
+{
+  return map->len;
+}
+
+/* The value set for the interned @key, or %NULL */
+gpointer
+hcl_map_lookup (HclMap *map, const gchar *key)
+{
+  gint position = hcl_map_find (map, key);
+
+  return position >= 0 ? map->entries[position].value : NULL;
+}
+
+/*
+ * The value set for @key, matched on its contents, or %NULL. This only
+ * reads the map, so threads may call it at once on a map none changes.
+ */
+gpointer
+hcl_map_lookup_string (HclMap *map, const gchar *key)
+{
+  gint position = hcl_map_find_string (map, key);
+
+  return position >= 0 ? map->entries[position].value : NULL;
+}
+
+/*
+ * Sets the interned @key to @value, taking the reference, and returns
+ * the value it replaces, if any, with its reference.
+ */
+gpointer
+hcl_map_replace (HclMap *map, const gchar *key, gpointer value)
+{
+  gint position = hcl_map_find (map, key);
+
+  if (position >= 0) {
+    gpointer old = map->entries[position].value;
+
+    map->entries[position].value = value;
+
+    return old;
+  }
+
+  if (map->len == map->allocated) {
+    map->allocated = MAX (4, map->allocated * 2);
+    map->entries = g_renew (HclMapEntry, map->entries, map->allocated);
+  }
+
+  map->entries[map->len].key = key;
+  map->entries[map->len].value = value;
+  map->len++;
+
+  if (map->len <= HCL_MAP_LINEAR_MAX)
+    return NULL;
+
+  if (map->index == NULL || map->len * 2 > map->index_mask + 1)
+    hcl_map_rebuild_index (map);
+  else
+    hcl_map_index_add (map, map->len - 1);
+
+  return NULL;
+}
+
+/* Sets the interned @key to @value, taking the reference */
+void
+hcl_map_insert (HclMap *map, const gchar *key, gpointer value)
+{
+  gpointer old = hcl_map_replace (map, key, value);
+
+  if (old)
+    g_object_unref (old);
+}
+
+/* The keys in the order they were first set */
+GList *
+hcl_map_get_keys (HclMap *map)
+{
+  GList *keys = NULL;
+
+  for (guint i = map->len; i > 0; i--)
+    keys = g_list_prepend (keys, (gpointer) map->entries[i - 1].key);
+
+  return keys;
+}
+
+void
+hcl_map_iter_init (HclMapIter *iter, HclMap *map)
+{
+  iter->map = map;
+  iter->index = 0;
+}
+
+gboolean
+hcl_map_iter_next (HclMapIter *iter, const gchar **key, gpointer *value)
+{
+  HclMapEntry *entry;
+
+  if (iter->index >= iter->map->len)
+    return FALSE;
+
+  entry = &iter->map->entries[iter->index++];
+
+  if (key)
+    *key = entry->key;
+  if (value)
+    *value = entry->value;
+
+  return TRUE;
+}
@@ -4,23 +4,67 @@
  */
 
 #include "hcl-parser.h"
+#include "hcl-diagnostic.h"
 #include "hcl-lexer.h"
+#include "hcl-private.h"
+#include "hcl-scan.h"
+#include "hcl-stream-parser.h"
 #include <errno.h>
+#include <string.h>
 
 /**
  * SECTION:hcl-parser
  * @short_description: HCL parser
  * @title: HclParser
  *
- * #HclParser parses HCL configuration text into a document tree.
+ * #HclParser parses HCL configuration text into a document tree, or
+ * reports its structure through #HclParserEvents callbacks without
+ * building one.
  */
 
+/*
+ * Both the tree parser and the event parser are loops over an explicit
+ * stack of frames, one for each block body, list and object that is open
+ * at the current token, so how deeply the input nests costs heap rather
+ * than C stack. The tree parser adds blocks to their parent as soon as
+ * they open; lists and objects are owned by their frame until they close
+ * and are handed to the frame below. The event parser only uses the kind
+ * of each frame.
+ */
+
+typedef enum {
+  HCL_PARSE_FRAME_BODY,
+  HCL_PARSE_FRAME_LIST,
+  HCL_PARSE_FRAME_OBJECT
+} HclParseFrameKind;
+
+typedef struct {
+  HclParseFrameKind kind;
+  HclDocument *document;    /* BODY: the document, for the root body */
+  HclBlock *block;          /* BODY: the block, for every other body */
+  HclValue *container;      /* LIST, OBJECT: the value being filled */
+  const gchar *name;        /* Interned attribute name or member key */
+  gsize start;              /* BODY: offset of the statement being read */
+} HclParseFrame;
+
 struct _HclParser
 {
   GObject parent_instance;
 
   HclLexer *lexer;
-  HclToken *current_token;
+  HclSpanToken current_token;
+  gboolean has_current;
+
+  GArray *frames;  /* HclParseFrame, reused from one parse to the next */
+  guint max_depth;
+
+  /* Set while hcl_parser_parse_string_recover() runs */
+  GPtrArray *diagnostics;
+  GString *closers;  /* Brackets still open while skipping an error */
+
+  /* Scratch space for the strings handed to event callbacks */
+  GString *name_buffer;
+  GString *text_buffer;
 };
 
 G_DEFINE_FINAL_TYPE (HclParser, hcl_parser, G_TYPE_OBJECT)
@@ -33,8 +77,10 @@ hcl_parser_finalize (GObject *object)
   if (self->lexer)
     g_object_unref (self->lexer);
 
-  if (self->current_token)
-    g_object_unref (self->current_token);
+  g_array_unref (self->frames);
+  g_string_free (self->closers, TRUE);
+  g_string_free (self->name_buffer, TRUE);
+  g_string_free (self->text_buffer, TRUE);
 
   G_OBJECT_CLASS (hcl_parser_parent_class)->finalize (object);
 }
@@ -50,7 +96,11 @@ hcl_parser_class_init (HclParserClass *klass)
 static void
 hcl_parser_init (HclParser *self)
 {
-  (void)self; /* Suppress unused parameter warning */
+  self->frames = g_array_new (FALSE, FALSE, sizeof (HclParseFrame));
+  self->max_depth = HCL_PARSER_DEFAULT_MAX_DEPTH;
+  self->closers = g_string_new (NULL);
+  self->name_buffer = g_string_sized_new (32);
+  self->text_buffer = g_string_sized_new (64);
 }
 
 /**
@@ -66,23 +116,60 @@ hcl_parser_new (void)
   return g_object_new (HCL_TYPE_PARSER, NULL);
 }
 
+/**
+ * hcl_parser_get_max_depth:
+ * @parser: an #HclParser
+ *
+ * Gets how deeply blocks, lists and objects may nest in the input.
+ *
+ * Returns: the maximum depth, or 0 if it is unlimited
+ */
+guint
+hcl_parser_get_max_depth (HclParser *parser)
+{
+  g_return_val_if_fail (HCL_IS_PARSER (parser), 0);
+
+  return parser->max_depth;
+}
+
+/**
+ * hcl_parser_set_max_depth:
+ * @parser: an #HclParser
+ * @max_depth: the maximum depth, or 0 for no limit
+ *
+ * Sets how deeply blocks, lists and objects may nest in the input before
+ * parsing fails with %HCL_PARSER_ERROR_TOO_DEEP. The top level of the
+ * input is at depth 0, and every block body, list or object opens one
+ * more level. The default is %HCL_PARSER_DEFAULT_MAX_DEPTH.
+ *
+ * The parser keeps its state on the heap, both when building a document
+ * and in hcl_parser_parse_events(), so a larger limit, or none, only
+ * costs memory.
+ */
+void
+hcl_parser_set_max_depth (HclParser *parser, guint max_depth)
+{
+  g_return_if_fail (HCL_IS_PARSER (parser));
+
+  parser->max_depth = max_depth;
+}
+
 static gboolean
 hcl_parser_advance (HclParser *parser, GError **error)
 {
-  if (parser->current_token)
-    g_object_unref (parser->current_token);
-
-  parser->current_token = hcl_lexer_next_token (parser->lexer, error);
-  return parser->current_token != NULL;
+  parser->has_current = hcl_lexer_next_span (parser->lexer,
+                                             &parser->current_token,
+                                             error);
+  return parser->has_current;
 }
 
 static gboolean
 hcl_parser_match (HclParser *parser, HclTokenType type)
 {
-  if (!parser->current_token)
+  if (!parser->has_current)
     return FALSE;
 
-  return hcl_token_get_token_type (parser->current_token) == type;
+  return parser->current_token.type == type;
 }
 
 static gboolean
@@ -92,475 +179,1669 @@ hcl_parser_consume (HclParser *parser, HclTokenType type, GError **error)
     g_set_error (error, HCL_PARSER_ERROR, HCL_PARSER_ERROR_UNEXPECTED_TOKEN,
                  "Expected token type %d but got %d at line %zu, column %zu",
                  type,
-                 parser->current_token ? (int)hcl_token_get_token_type (parser->current_token) : -1,
-                 parser->current_token ? hcl_token_get_line (parser->current_token) : 0,
-                 parser->current_token ? hcl_token_get_column (parser->current_token) : 0);
+                 parser->has_current ? (int)parser->current_token.type : -1,
+                 parser->has_current ? parser->current_token.line : 0,
+                 parser->has_current ? parser->current_token.column : 0);
     return FALSE;
   }
 
   return hcl_parser_advance (parser, error);
 }
 
-static void
+/* Returns %FALSE if the lexer failed */
+static gboolean
 hcl_parser_skip_newlines (HclParser *parser, GError **error)
 {
-  while (parser->current_token &&
+  while (parser->has_current &&
          hcl_parser_match (parser, HCL_TOKEN_TYPE_NEWLINE)) {
     hcl_parser_advance (parser, error);
   }
+
+  return parser->has_current;
 }
 
-static HclValue *hcl_parser_parse_value (HclParser *parser, GError **error);
+static gchar *
+hcl_parser_dup_current (HclParser *parser)
+{
+  return hcl_lexer_span_dup_value (parser->lexer, &parser->current_token);
+}
+
+static const gchar *
+hcl_parser_intern_current (HclParser *parser)
+{
+  return hcl_lexer_span_intern (parser->lexer, &parser->current_token);
+}
 
+/* Builds a string value straight from the input unless it needs unescaping */
 static HclValue *
-hcl_parser_parse_list (HclParser *parser, GError **error)
+hcl_parser_new_string_value (HclParser *parser)
 {
-  HclValue *list = hcl_value_new_list ();
+  const gchar *text;
+  gsize length;
 
-  if (!hcl_parser_consume (parser, HCL_TOKEN_TYPE_LBRACKET, error)) {
-    g_object_unref (list);
-    return NULL;
-  }
+  if (parser->current_token.flags & HCL_SPAN_FLAG_ESCAPED)
+    return hcl_value_new_take_string (hcl_parser_dup_current (parser));
 
-  hcl_parser_skip_newlines (parser, error);
+  text = hcl_lexer_span_get_text (parser->lexer, &parser->current_token, &length);
+  return hcl_value_new_string_len (text, (gssize) length);
+}
 
-  while (parser->current_token &&
-         !hcl_parser_match (parser, HCL_TOKEN_TYPE_RBRACKET)) {
-    HclValue *item = hcl_parser_parse_value (parser, error);
-    if (!item) {
-      g_object_unref (list);
-      return NULL;
-    }
+/*
+ * Looks at the token after the identifier that starts a statement, once,
+ * to tell a block from an attribute. @has_label tells the block parsers
+ * whether a label follows, so they do not have to test for one again.
+ */
+static gboolean
+hcl_parser_at_block (HclParser *parser,
+                     gboolean *is_block,
+                     gboolean *has_label,
+                     GError **error)
+{
+  HclSpanToken peek;
 
-    hcl_value_list_add_item (list, item);
+  if (!hcl_lexer_peek_span (parser->lexer, &peek, error))
+    return FALSE;
 
-    hcl_parser_skip_newlines (parser, error);
+  /* If next token is assignment, it's an attribute */
+  *has_label = (peek.type == HCL_TOKEN_TYPE_STRING ||
+                peek.type == HCL_TOKEN_TYPE_IDENTIFIER);
+  *is_block = *has_label || peek.type == HCL_TOKEN_TYPE_LBRACE;
+  return TRUE;
+}
 
-    if (hcl_parser_match (parser, HCL_TOKEN_TYPE_COMMA)) {
-      hcl_parser_advance (parser, error);
-      hcl_parser_skip_newlines (parser, error);
-    }
-  }
+/* Gets the value the lexer converted, returning %TRUE if it is a float */
+static gboolean
+hcl_parser_read_number (HclParser *parser, gint64 *int_value, gdouble *double_value)
+{
+  const HclSpanToken *token = &parser->current_token;
 
-  if (!hcl_parser_consume (parser, HCL_TOKEN_TYPE_RBRACKET, error)) {
-    g_object_unref (list);
-    return NULL;
+  if (token->flags & HCL_SPAN_FLAG_FLOAT) {
+    *double_value = token->number.double_value;
+    return TRUE;
   }
 
-  return list;
+  *int_value = token->number.int_value;
+  *double_value = (gdouble) *int_value;
+  return FALSE;
 }
 
 static HclValue *
-hcl_parser_parse_object (HclParser *parser, GError **error)
+hcl_parser_parse_number (HclParser *parser)
 {
-  HclValue *object = hcl_value_new_object ();
+  gint64 int_value;
+  gdouble double_value;
 
-  if (!hcl_parser_consume (parser, HCL_TOKEN_TYPE_LBRACE, error)) {
-    g_object_unref (object);
-    return NULL;
-  }
+  if (hcl_parser_read_number (parser, &int_value, &double_value))
+    return hcl_value_new_double (double_value);
 
-  hcl_parser_skip_newlines (parser, error);
+  return hcl_value_new_int (int_value);
+}
 
-  while (parser->current_token &&
-         !hcl_parser_match (parser, HCL_TOKEN_TYPE_RBRACE)) {
-    /* Parse key */
-    if (!hcl_parser_match (parser, HCL_TOKEN_TYPE_IDENTIFIER) &&
-        !hcl_parser_match (parser, HCL_TOKEN_TYPE_STRING)) {
-      g_set_error (error, HCL_PARSER_ERROR, HCL_PARSER_ERROR_SYNTAX,
-                   "Expected identifier or string for object key");
-      g_object_unref (object);
-      return NULL;
-    }
+/* Reports that the current token cannot start a value */
+static void
+hcl_parser_set_value_error (HclParser *parser, GError **error)
+{
+  if (!parser->has_current ||
+      hcl_parser_match (parser, HCL_TOKEN_TYPE_EOF)) {
+    g_set_error (error, HCL_PARSER_ERROR, HCL_PARSER_ERROR_MISSING_VALUE,
+                 "Expected value but reached end of input");
+    return;
+  }
 
-    const gchar *key = hcl_token_get_value (parser->current_token);
-    gchar *key_copy = g_strdup (key);
+  g_set_error (error, HCL_PARSER_ERROR, HCL_PARSER_ERROR_SYNTAX,
+               "Unexpected token for value at line %zu, column %zu",
+               parser->current_token.line,
+               parser->current_token.column);
+}
 
-    hcl_parser_advance (parser, error);
+/* Checks that one more level of nesting below @depth is allowed */
+static gboolean
+hcl_parser_check_depth (HclParser *parser, guint depth, GError **error)
+{
+  if (parser->max_depth == 0 || depth < parser->max_depth)
+    return TRUE;
+
+  g_set_error (error, HCL_PARSER_ERROR, HCL_PARSER_ERROR_TOO_DEEP,
+               "Nesting deeper than %u levels at line %zu, column %zu",
+               parser->max_depth,
+               parser->current_token.line,
+               parser->current_token.column);
+  return FALSE;
+}
 
-    if (!hcl_parser_consume (parser, HCL_TOKEN_TYPE_ASSIGN, error)) {
-      g_free (key_copy);
-      g_object_unref (object);
-      return NULL;
-    }
+static HclParseFrame *
+hcl_parser_push_frame (HclParser *parser, HclParseFrameKind kind, GError **error)
+{
+  HclParseFrame *frame;
 
-    HclValue *value = hcl_parser_parse_value (parser, error);
-    if (!value) {
-      g_free (key_copy);
-      g_object_unref (object);
-      return NULL;
-    }
+  /* The root body does not count towards the depth */
+  if (parser->frames->len > 0 &&
+      !hcl_parser_check_depth (parser, parser->frames->len - 1, error))
+    return NULL;
 
-    hcl_value_object_set_member (object, key_copy, value);
-    g_free (key_copy);
+  g_array_set_size (parser->frames, parser->frames->len + 1);
+  frame = &g_array_index (parser->frames, HclParseFrame, parser->frames->len - 1);
+  *frame = (HclParseFrame) { .kind = kind };
 
-    hcl_parser_skip_newlines (parser, error);
+  return frame;
+}
 
-    if (hcl_parser_match (parser, HCL_TOKEN_TYPE_COMMA)) {
-      hcl_parser_advance (parser, error);
-      hcl_parser_skip_newlines (parser, error);
-    }
-  }
+static HclParseFrame *
+hcl_parser_top_frame (HclParser *parser)
+{
+  return &g_array_index (parser->frames, HclParseFrame, parser->frames->len - 1);
+}
 
-  if (!hcl_parser_consume (parser, HCL_TOKEN_TYPE_RBRACE, error)) {
-    g_object_unref (object);
-    return NULL;
-  }
+/* Drops every frame, with the lists and objects still being filled */
+static void
+hcl_parser_clear_frames (HclParser *parser)
+{
+  for (guint i = 0; i < parser->frames->len; i++)
+    g_clear_object (&g_array_index (parser->frames, HclParseFrame, i).container);
 
-  return object;
+  g_array_set_size (parser->frames, 0);
 }
 
-static HclValue *
-hcl_parser_parse_value (HclParser *parser, GError **error)
+/* Skips the comma after a list item or object member */
+static gboolean
+hcl_parser_skip_separator (HclParser *parser, GError **error)
 {
-  if (!parser->current_token) {
-    g_set_error (error, HCL_PARSER_ERROR, HCL_PARSER_ERROR_MISSING_VALUE,
-                 "Expected value but reached end of input");
-    return NULL;
-  }
+  if (!hcl_parser_skip_newlines (parser, error))
+    return FALSE;
 
-  HclTokenType type = hcl_token_get_token_type (parser->current_token);
-  const gchar *value = hcl_token_get_value (parser->current_token);
+  if (hcl_parser_match (parser, HCL_TOKEN_TYPE_COMMA))
+    return hcl_parser_advance (parser, error) &&
+           hcl_parser_skip_newlines (parser, error);
 
-  switch (type) {
-    case HCL_TOKEN_TYPE_STRING: {
-      HclValue *val = hcl_value_new_string (value);
-      hcl_parser_advance (parser, error);
-      return val;
-    }
+  return TRUE;
+}
+
+/* Hands a finished value to the frame on top of the stack */
+static gboolean
+hcl_parser_add_value (HclParser *parser, HclValue *value, GError **error)
+{
+  HclParseFrame *frame = hcl_parser_top_frame (parser);
 
-    case HCL_TOKEN_TYPE_NUMBER: {
-      HclValue *val;
-      if (strchr (value, '.') || strchr (value, 'e') || strchr (value, 'E')) {
-        gdouble num = g_ascii_strtod (value, NULL);
-        val = hcl_value_new_double (num);
+  switch (frame->kind) {
+    case HCL_PARSE_FRAME_BODY:
+      if (frame->block) {
+        hcl_block_set_attribute_interned (frame->block, frame->name, value);
       } else {
-        gint64 num = g_ascii_strtoll (value, NULL, 10);
-        val = hcl_value_new_int (num);
+        hcl_document_set_attribute_interned (frame->document, frame->name, value);
+        hcl_document_add_statement (frame->document, frame->start, frame->name, value);
       }
-      hcl_parser_advance (parser, error);
-      return val;
-    }
-
-    case HCL_TOKEN_TYPE_BOOL: {
-      gboolean bool_val = g_strcmp0 (value, "true") == 0;
-      HclValue *val = hcl_value_new_bool (bool_val);
-      hcl_parser_advance (parser, error);
-      return val;
-    }
+      return TRUE;
 
-    case HCL_TOKEN_TYPE_IDENTIFIER: {
-      HclValue *val = hcl_value_new_string (value);
-      hcl_parser_advance (parser, error);
-      return val;
-    }
-
-    case HCL_TOKEN_TYPE_LBRACKET:
-      return hcl_parser_parse_list (parser, error);
+    case HCL_PARSE_FRAME_LIST:
+      hcl_value_list_add_item (frame->container, value);
+      break;
 
-    case HCL_TOKEN_TYPE_LBRACE:
-      return hcl_parser_parse_object (parser, error);
+    case HCL_PARSE_FRAME_OBJECT:
+      hcl_value_object_set_member_interned (frame->container, frame->name, value);
+      break;
 
     default:
-      g_set_error (error, HCL_PARSER_ERROR, HCL_PARSER_ERROR_SYNTAX,
-                   "Unexpected token for value at line %zu, column %zu",
-                   hcl_token_get_line (parser->current_token),
-                   hcl_token_get_column (parser->current_token));
-      return NULL;
+      g_assert_not_reached ();
   }
+
+  return hcl_parser_skip_separator (parser, error);
 }
 
+/*
+ * Starts the value at the current token. Scalars are added to the frame
+ * on top of the stack straight away; lists and objects push a frame of
+ * their own.
+ */
 static gboolean
-hcl_parser_parse_attribute (HclParser *parser, HclDocument *document, GError **error)
+hcl_parser_begin_value (HclParser *parser, GError **error)
 {
-  if (!hcl_parser_match (parser, HCL_TOKEN_TYPE_IDENTIFIER)) {
+  HclParseFrame *frame;
+  HclValue *value;
+
+  if (!parser->has_current) {
+    hcl_parser_set_value_error (parser, error);
     return FALSE;
   }
 
-  const gchar *name = hcl_token_get_value (parser->current_token);
-  gchar *name_copy = g_strdup (name);
+  switch (parser->current_token.type) {
+    case HCL_TOKEN_TYPE_STRING:
+    case HCL_TOKEN_TYPE_IDENTIFIER:
+      value = hcl_parser_new_string_value (parser);
+      break;
+
+    case HCL_TOKEN_TYPE_NUMBER:
+      /* Numbers in a list go straight into its packed array if they can */
+      frame = hcl_parser_top_frame (parser);
+      if (frame->kind == HCL_PARSE_FRAME_LIST) {
+        gint64 int_value = 0;
+        gdouble double_value;
+        HclNumberType number_type = hcl_parser_read_number (parser, &int_value, &double_value)
+                                    ? HCL_NUMBER_TYPE_FLOAT : HCL_NUMBER_TYPE_INTEGER;
+
+        if (hcl_value_list_add_number (frame->container, number_type, int_value, double_value))
+          return hcl_parser_advance (parser, error) &&
+                 hcl_parser_skip_separator (parser, error);
+      }
 
-  hcl_parser_advance (parser, error);
+      value = hcl_parser_parse_number (parser);
+      break;
 
-  if (!hcl_parser_consume (parser, HCL_TOKEN_TYPE_ASSIGN, error)) {
-    g_free (name_copy);
-    return FALSE;
+    case HCL_TOKEN_TYPE_BOOL:
+      value = hcl_value_new_bool (hcl_lexer_span_equal (parser->lexer,
+                                                        &parser->current_token,
+                                                        "true"));
+      break;
+
+    case HCL_TOKEN_TYPE_NULL:
+      value = hcl_value_new_null ();
+      break;
+
+    case HCL_TOKEN_TYPE_LBRACKET:
+    case HCL_TOKEN_TYPE_LBRACE:
+      frame = hcl_parser_push_frame (parser,
+                                     hcl_parser_match (parser, HCL_TOKEN_TYPE_LBRACKET)
+                                     ? HCL_PARSE_FRAME_LIST
+                                     : HCL_PARSE_FRAME_OBJECT,
+                                     error);
+      if (!frame)
+        return FALSE;
+
+      frame->container = frame->kind == HCL_PARSE_FRAME_LIST ? hcl_value_new_list ()
+                                                             : hcl_value_new_object ();
+      return hcl_parser_advance (parser, error) &&
+             hcl_parser_skip_newlines (parser, error);
+
+    default:
+      hcl_parser_set_value_error (parser, error);
+      return FALSE;
   }
 
-  HclValue *value = hcl_parser_parse_value (parser, error);
-  if (!value) {
-    g_free (name_copy);
+  if (!hcl_parser_advance (parser, error)) {
+    g_object_unref (value);
     return FALSE;
   }
 
-  hcl_document_set_attribute (document, name_copy, value);
-  g_free (name_copy);
+  return hcl_parser_add_value (parser, value, error);
+}
 
-  return TRUE;
+/* Closes the list or object on top of the stack at its closing bracket */
+static gboolean
+hcl_parser_end_value (HclParser *parser, GError **error)
+{
+  HclParseFrame *frame = hcl_parser_top_frame (parser);
+  HclValue *value = g_steal_pointer (&frame->container);
+
+  g_array_set_size (parser->frames, parser->frames->len - 1);
+
+  if (!hcl_parser_advance (parser, error)) {
+    g_object_unref (value);
+    return FALSE;
+  }
+
+  return hcl_parser_add_value (parser, value, error);
 }
 
+/* Parses the next member of the object on top of the stack */
 static gboolean
-hcl_parser_parse_block (HclParser *parser, HclDocument *document, GError **error)
+hcl_parser_step_object (HclParser *parser, HclParseFrame *frame, GError **error)
 {
-  if (!hcl_parser_match (parser, HCL_TOKEN_TYPE_IDENTIFIER)) {
+  if (!hcl_parser_match (parser, HCL_TOKEN_TYPE_IDENTIFIER) &&
+      !hcl_parser_match (parser, HCL_TOKEN_TYPE_STRING)) {
+    g_set_error (error, HCL_PARSER_ERROR, HCL_PARSER_ERROR_SYNTAX,
+                 "Expected identifier or string for object key");
     return FALSE;
   }
 
-  const gchar *type = hcl_token_get_value (parser->current_token);
-  gchar *type_copy = g_strdup (type);
+  frame->name = hcl_parser_intern_current (parser);
 
-  hcl_parser_advance (parser, error);
+  return hcl_parser_advance (parser, error) &&
+         hcl_parser_consume (parser, HCL_TOKEN_TYPE_ASSIGN, error) &&
+         hcl_parser_begin_value (parser, error);
+}
 
+/* Opens the block at the current identifier; see hcl_parser_at_block() */
+static gboolean
+hcl_parser_begin_block (HclParser *parser, gboolean has_label, GError **error)
+{
+  HclParseFrame *parent = hcl_parser_top_frame (parser);
+  HclDocument *document = parent->document;
+  HclBlock *parent_block = parent->block;
+  HclParseFrame *frame;
+  const gchar *type;
   gchar *label = NULL;
-  if (hcl_parser_match (parser, HCL_TOKEN_TYPE_STRING) ||
-      hcl_parser_match (parser, HCL_TOKEN_TYPE_IDENTIFIER)) {
-    label = g_strdup (hcl_token_get_value (parser->current_token));
-    hcl_parser_advance (parser, error);
+  HclBlock *block;
+
+  /* Checked up front, so a recovering parse skips the whole block */
+  if (!hcl_parser_check_depth (parser, parser->frames->len - 1, error))
+    return FALSE;
+
+  type = hcl_parser_intern_current (parser);
+  if (!hcl_parser_advance (parser, error))
+    return FALSE;
+
+  if (has_label) {
+    label = hcl_parser_dup_current (parser);
+    if (!hcl_parser_advance (parser, error)) {
+      g_free (label);
+      return FALSE;
+    }
   }
 
-  HclBlock *block = hcl_block_new (type_copy, label);
+  block = hcl_block_new_interned (type, label);
 
   if (!hcl_parser_consume (parser, HCL_TOKEN_TYPE_LBRACE, error)) {
-    g_free (type_copy);
-    g_free (label);
     g_object_unref (block);
     return FALSE;
   }
 
-  hcl_parser_skip_newlines (parser, error);
-
-  while (parser->current_token &&
-         !hcl_parser_match (parser, HCL_TOKEN_TYPE_RBRACE)) {
-
-    /* Check for nested block */
-    if (hcl_parser_match (parser, HCL_TOKEN_TYPE_IDENTIFIER)) {
-      HclToken *peek = hcl_lexer_peek_token (parser->lexer, error);
-      gboolean is_block = FALSE;
-
-      if (peek) {
-        HclTokenType peek_type = hcl_token_get_token_type (peek);
-        is_block = (peek_type == HCL_TOKEN_TYPE_STRING ||
-                   peek_type == HCL_TOKEN_TYPE_IDENTIFIER ||
-                   peek_type == HCL_TOKEN_TYPE_LBRACE);
-
-        /* If next token is assignment, it's an attribute */
-        if (peek_type == HCL_TOKEN_TYPE_ASSIGN) {
-          is_block = FALSE;
-        }
-      }
-
-      if (is_block) {
-        /* Parse nested block - create a temporary document to hold it */
-        HclDocument *temp_doc = hcl_document_new ();
-        if (!hcl_parser_parse_block (parser, temp_doc, error)) {
-          g_object_unref (temp_doc);
-          g_free (type_copy);
-          g_free (label);
-          g_object_unref (block);
-          return FALSE;
-        }
+  if (parent_block) {
+    hcl_block_add_block (parent_block, block);
+  } else {
+    hcl_block_list_add (hcl_document_get_block_list (document), block);
+    hcl_document_add_statement (document, parent->start, NULL, block);
+  }
 
-        /* Move the block from temp document to our block */
-        GList *blocks = hcl_document_get_blocks (temp_doc);
-        if (blocks) {
-          hcl_block_add_block (block, g_object_ref (blocks->data));
-        }
+  frame = hcl_parser_push_frame (parser, HCL_PARSE_FRAME_BODY, error);
+  if (!frame)
+    return FALSE;
 
-        g_list_free (blocks);
-        g_object_unref (temp_doc);
-      } else {
-        /* Parse attribute */
-        const gchar *attr_name = hcl_token_get_value (parser->current_token);
-        gchar *attr_name_copy = g_strdup (attr_name);
-
-        hcl_parser_advance (parser, error);
-
-        if (!hcl_parser_consume (parser, HCL_TOKEN_TYPE_ASSIGN, error)) {
-          g_free (attr_name_copy);
-          g_free (type_copy);
-          g_free (label);
-          g_object_unref (block);
-          return FALSE;
-        }
+  frame->block = block;
 
-        HclValue *value = hcl_parser_parse_value (parser, error);
-        if (!value) {
-          g_free (attr_name_copy);
-          g_free (type_copy);
-          g_free (label);
-          g_object_unref (block);
-          return FALSE;
-        }
+  return TRUE;
+}
 
-        hcl_block_set_attribute (block, attr_name_copy, value);
-        g_free (attr_name_copy);
-      }
-    } else {
-      g_set_error (error, HCL_PARSER_ERROR, HCL_PARSER_ERROR_SYNTAX,
-                   "Expected identifier in block body");
-      g_free (type_copy);
-      g_free (label);
-      g_object_unref (block);
+/*
+ * Parses the next attribute or block of the body on top of the stack, or
+ * closes it. Returns %FALSE with @done set once the root body is over.
+ */
+static gboolean
+hcl_parser_step_body (HclParser *parser,
+                      HclParseFrame *frame,
+                      gboolean *done,
+                      GError **error)
+{
+  gboolean is_root = parser->frames->len == 1;
+  gboolean is_block;
+  gboolean has_label;
+
+  if (hcl_parser_match (parser, HCL_TOKEN_TYPE_EOF) ||
+      (frame->block && hcl_parser_match (parser, HCL_TOKEN_TYPE_RBRACE))) {
+    if (is_root) {
+      *done = TRUE;
       return FALSE;
     }
 
-    hcl_parser_skip_newlines (parser, error);
+    g_array_set_size (parser->frames, parser->frames->len - 1);
+    return hcl_parser_consume (parser, HCL_TOKEN_TYPE_RBRACE, error);
   }
 
-  if (!hcl_parser_consume (parser, HCL_TOKEN_TYPE_RBRACE, error)) {
-    g_free (type_copy);
-    g_free (label);
-    g_object_unref (block);
+  /* Skip comments */
+  if (hcl_parser_match (parser, HCL_TOKEN_TYPE_COMMENT))
+    return hcl_parser_advance (parser, error);
+
+  if (!hcl_parser_match (parser, HCL_TOKEN_TYPE_IDENTIFIER)) {
+    g_set_error_literal (error, HCL_PARSER_ERROR, HCL_PARSER_ERROR_SYNTAX,
+                         frame->block ? "Expected identifier in block body"
+                                      : "Expected identifier at top level");
     return FALSE;
   }
 
-  hcl_document_add_block (document, block);
+  if (!hcl_parser_at_block (parser, &is_block, &has_label, error))
+    return FALSE;
+
+  frame->start = parser->current_token.offset;
 
-  g_free (type_copy);
-  g_free (label);
-  return TRUE;
+  if (is_block)
+    return hcl_parser_begin_block (parser, has_label, error);
+
+  frame->name = hcl_parser_intern_current (parser);
+
+  return hcl_parser_advance (parser, error) &&
+         hcl_parser_consume (parser, HCL_TOKEN_TYPE_ASSIGN, error) &&
+         hcl_parser_begin_value (parser, error);
 }
 
-/**
- * hcl_parser_parse_string:
- * @parser: an #HclParser
- * @input: HCL input string
- * @error: return location for error
- *
- * Parses an HCL string into a document.
- *
- * Returns: (transfer full) (nullable): parsed document or %NULL on error
+/*
+ * Takes one step on the frame on top of the stack. Returns %FALSE with
+ * @done set once the root body is over.
  */
-HclDocument *
-hcl_parser_parse_string (HclParser *parser, const gchar *input, GError **error)
+static gboolean
+hcl_parser_step (HclParser *parser, gboolean *done, GError **error)
 {
-  g_return_val_if_fail (HCL_IS_PARSER (parser), NULL);
-  g_return_val_if_fail (input != NULL, NULL);
+  HclParseFrame *frame;
 
-  /* Clean up previous state */
-  if (parser->lexer)
-    g_object_unref (parser->lexer);
-  if (parser->current_token)
-    g_object_unref (parser->current_token);
+  if (!hcl_parser_skip_newlines (parser, error))
+    return FALSE;
 
-  parser->lexer = hcl_lexer_new (input);
-  parser->current_token = NULL;
+  frame = hcl_parser_top_frame (parser);
 
-  /* Initialize first token */
-  if (!hcl_parser_advance (parser, error)) {
-    return NULL;
+  switch (frame->kind) {
+    case HCL_PARSE_FRAME_BODY:
+      return hcl_parser_step_body (parser, frame, done, error);
+
+    case HCL_PARSE_FRAME_LIST:
+      return hcl_parser_match (parser, HCL_TOKEN_TYPE_RBRACKET)
+             ? hcl_parser_end_value (parser, error)
+             : hcl_parser_begin_value (parser, error);
+
+    case HCL_PARSE_FRAME_OBJECT:
+      return hcl_parser_match (parser, HCL_TOKEN_TYPE_RBRACE)
+             ? hcl_parser_end_value (parser, error)
+             : hcl_parser_step_object (parser, frame, error);
+
+    default:
+      g_assert_not_reached ();
   }
 
-  HclDocument *document = hcl_document_new ();
+  return FALSE;
+}
 
-  hcl_parser_skip_newlines (parser, error);
+/*
+ * Adds @error to the diagnostics, at the text the lexer failed on if it
+ * was a lexer error and at the current token otherwise.
+ */
+static void
+hcl_parser_add_diagnostic (HclParser *parser, const GError *error)
+{
+  HclSpanToken span;
+
+  if (!hcl_lexer_recover (parser->lexer, &span))
+    span = parser->current_token;
+
+  g_ptr_array_add (parser->diagnostics,
+                   hcl_diagnostic_new ((HclParserError) error->code,
+                                       error->message,
+                                       span.offset,
+                                       span.length,
+                                       span.line,
+                                       span.column));
+}
 
-  while (parser->current_token &&
-         !hcl_parser_match (parser, HCL_TOKEN_TYPE_EOF)) {
+/* Moves to the next token, recording the lexer errors on the way */
+static void
+hcl_parser_advance_recovering (HclParser *parser)
+{
+  GError *error = NULL;
 
-    /* Skip comments */
-    if (hcl_parser_match (parser, HCL_TOKEN_TYPE_COMMENT)) {
-      hcl_parser_advance (parser, error);
-      hcl_parser_skip_newlines (parser, error);
-      continue;
-    }
+  while (!hcl_parser_advance (parser, &error)) {
+    hcl_parser_add_diagnostic (parser, error);
+    g_clear_error (&error);
+  }
+}
 
-    /* Try to parse as block first */
-    if (hcl_parser_match (parser, HCL_TOKEN_TYPE_IDENTIFIER)) {
-      HclToken *peek = hcl_lexer_peek_token (parser->lexer, error);
-      gboolean is_block = FALSE;
+/*
+ * Records @error and gets back to where parsing can go on. The lists and
+ * objects being filled are dropped, with the attribute they belonged to,
+ * and tokens are skipped up to the end of the line, or up to a '}' that
+ * closes the block around the error. Brackets opened on the way, and
+ * those of the dropped values, have to be closed before a newline counts.
+ */
+static void
+hcl_parser_recover (HclParser *parser, const GError *error)
+{
+  GString *closers = parser->closers;
+  HclParseFrame *frame;
 
-      if (peek) {
-        HclTokenType peek_type = hcl_token_get_token_type (peek);
-        is_block = (peek_type == HCL_TOKEN_TYPE_STRING ||
-                   peek_type == HCL_TOKEN_TYPE_IDENTIFIER ||
-                   peek_type == HCL_TOKEN_TYPE_LBRACE);
+  hcl_parser_add_diagnostic (parser, error);
 
-        /* If next token is assignment, it's an attribute */
-        if (peek_type == HCL_TOKEN_TYPE_ASSIGN) {
-          is_block = FALSE;
-        }
-      }
+  if (!parser->has_current)
+    hcl_parser_advance_recovering (parser);
 
-      if (is_block) {
-        if (!hcl_parser_parse_block (parser, document, error)) {
-          g_object_unref (document);
-          return NULL;
+  while ((frame = hcl_parser_top_frame (parser))->kind != HCL_PARSE_FRAME_BODY) {
+    g_string_prepend_c (closers, frame->kind == HCL_PARSE_FRAME_LIST ? ']' : '}');
+    g_clear_object (&frame->container);
+    g_array_set_size (parser->frames, parser->frames->len - 1);
+  }
+
+  while (!hcl_parser_match (parser, HCL_TOKEN_TYPE_EOF)) {
+    const gchar *match;
+
+    switch (parser->current_token.type) {
+      case HCL_TOKEN_TYPE_NEWLINE:
+        if (closers->len == 0) {
+          hcl_parser_advance_recovering (parser);
+          return;
         }
-      } else {
-        if (!hcl_parser_parse_attribute (parser, document, error)) {
-          g_object_unref (document);
-          return NULL;
+        break;
+
+      case HCL_TOKEN_TYPE_LBRACKET:
+        g_string_append_c (closers, ']');
+        break;
+
+      case HCL_TOKEN_TYPE_LBRACE:
+        g_string_append_c (closers, '}');
+        break;
+
+      case HCL_TOKEN_TYPE_RBRACKET:
+      case HCL_TOKEN_TYPE_RBRACE:
+        /* Anything opened after the bracket this matches was left open */
+        match = g_strrstr (closers->str,
+                           hcl_parser_match (parser, HCL_TOKEN_TYPE_RBRACE) ? "}" : "]");
+        if (match) {
+          g_string_truncate (closers, (gsize) (match - closers->str));
+        } else if (hcl_parser_match (parser, HCL_TOKEN_TYPE_RBRACE)) {
+          g_string_truncate (closers, 0);
+          if (frame->block)
+            return;
         }
-      }
-    } else {
-      g_set_error (error, HCL_PARSER_ERROR, HCL_PARSER_ERROR_SYNTAX,
-                   "Expected identifier at top level");
-      g_object_unref (document);
-      return NULL;
+        break;
+
+      default:
+        break;
     }
 
-    hcl_parser_skip_newlines (parser, error);
+    hcl_parser_advance_recovering (parser);
   }
 
-  return document;
+  g_string_truncate (closers, 0);
 }
 
-/**
- * hcl_parser_parse_file:
- * @parser: an #HclParser
- * @filename: path to HCL file
- * @error: return location for error
- *
- * Parses an HCL file into a document.
+/*
+ * Parses attributes and blocks into @document, or into @block if it is
+ * not %NULL, up to the end of the input; a block body also ends at a '}'
+ * that closes nothing. Expects the first token to have been read.
  *
- * Returns: (transfer full) (nullable): parsed document or %NULL on error
+ * If the parser is collecting diagnostics, errors are recorded and
+ * skipped over instead, and this only returns once the input is over.
  */
-HclDocument *
-hcl_parser_parse_file (HclParser *parser, const gchar *filename, GError **error)
+static gboolean
+hcl_parser_parse_body (HclParser *parser,
+                       HclDocument *document,
+                       HclBlock *block,
+                       GError **error)
 {
-  g_return_val_if_fail (HCL_IS_PARSER (parser), NULL);
-  g_return_val_if_fail (filename != NULL, NULL);
+  HclParseFrame *frame;
+  gboolean done = FALSE;
 
-  gchar *contents;
-  if (!g_file_get_contents (filename, &contents, NULL, error)) {
-    return NULL;
+  frame = hcl_parser_push_frame (parser, HCL_PARSE_FRAME_BODY, error);
+  frame->document = document;
+  frame->block = block;
+
+  while (!done) {
+    g_autoptr(GError) local_error = NULL;
+
+    if (hcl_parser_step (parser, &done, &local_error) || done)
+      continue;
+
+    if (!parser->diagnostics) {
+      g_propagate_error (error, g_steal_pointer (&local_error));
+      break;
+    }
+
+    hcl_parser_recover (parser, local_error);
   }
 
-  HclDocument *document = hcl_parser_parse_string (parser, contents, error);
-  g_free (contents);
+  hcl_parser_clear_frames (parser);
+
+  return done;
+}
+
+static void
+hcl_parser_set_input (HclParser *parser,
+                      const gchar *input,
+                      gsize length,
+                      gsize line,
+                      gsize column)
+{
+  /* Reuse the lexer of the previous parse */
+  if (!parser->lexer)
+    parser->lexer = hcl_lexer_new_with_length (input, (gssize) length);
 
-  return document;
+  hcl_lexer_reset (parser->lexer, input, length, line, column);
+  parser->has_current = FALSE;
 }
 
 /**
- * hcl_parse_string:
+ * hcl_parser_parse_string:
+ * @parser: an #HclParser
  * @input: HCL input string
  * @error: return location for error
  *
- * Convenience function to parse an HCL string.
+ * Parses an HCL string into a document.
  *
  * Returns: (transfer full) (nullable): parsed document or %NULL on error
  */
 HclDocument *
-hcl_parse_string (const gchar *input, GError **error)
+hcl_parser_parse_string (HclParser *parser, const gchar *input, GError **error)
 {
-  g_autoptr(HclParser) parser = hcl_parser_new ();
-  return hcl_parser_parse_string (parser, input, error);
+  g_return_val_if_fail (HCL_IS_PARSER (parser), NULL);
+  g_return_val_if_fail (input != NULL, NULL);
+
+  return hcl_parser_parse_text (parser, input, strlen (input), 1, 1, error);
 }
 
 /**
- * hcl_parse_file:
- * @filename: path to HCL file
- * @error: return location for error
+ * hcl_parser_parse_string_recover:
+ * @parser: an #HclParser
+ * @input: HCL input string
+ * @diagnostics: (out) (element-type HclDiagnostic) (transfer full): return
+ *   location for the errors found, in input order
  *
- * Convenience function to parse an HCL file.
+ * Parses an HCL string into a document like hcl_parser_parse_string(),
+ * but does not stop at the first error. Each error is recorded as an
+ * #HclDiagnostic and parsing carries on at the next line, or after the
+ * block the error is in when that comes first. Attributes whose value
+ * could not be parsed and blocks whose header could not be parsed are
+ * left out of the document; everything else is kept.
  *
- * Returns: (transfer full) (nullable): parsed document or %NULL on error
+ * This suits editors that check the text on every change and want to
+ * show all of its errors at once.
+ *
+ * Returns: (transfer full): the best-effort document, which is never %NULL
  */
 HclDocument *
-hcl_parse_file (const gchar *filename, GError **error)
+hcl_parser_parse_string_recover (HclParser *parser,
+                                 const gchar *input,
+                                 GPtrArray **diagnostics)
 {
-  g_autoptr(HclParser) parser = hcl_parser_new ();
-  return hcl_parser_parse_file (parser, filename, error);
+  g_autoptr(HclDocument) document = NULL;
+
+  g_return_val_if_fail (HCL_IS_PARSER (parser), NULL);
+  g_return_val_if_fail (input != NULL, NULL);
+  g_return_val_if_fail (diagnostics != NULL, NULL);
+
+  parser->diagnostics = g_ptr_array_new_with_free_func (g_object_unref);
+  document = hcl_document_new ();
+
+  hcl_parser_set_input (parser, input, strlen (input), 1, 1);
+  hcl_parser_advance_recovering (parser);
+  hcl_parser_parse_body (parser, document, NULL, NULL);
+
+  *diagnostics = g_steal_pointer (&parser->diagnostics);
+
+  return g_steal_pointer (&document);
+}
+
+/* Index of the first statement that starts after @offset */
+static guint
+hcl_statements_search (GArray *statements, gsize offset)
+{
+  guint low = 0;
+  guint high = statements->len;
+
+  while (low < high) {
+    guint mid = low + (high - low) / 2;
+
+    if (g_array_index (statements, HclStatement, mid).offset <= offset)
+      low = mid + 1;
+    else
+      high = mid;
+  }
+
+  return low;
+}
+
+/*
+ * Adds a statement of another document to @document, at @offset, and its
+ * block to @blocks if it is one.
+ */
+static void
+hcl_parser_reuse_statement (HclDocument *document,
+                            const HclStatement *statement,
+                            gsize offset,
+                            GPtrArray *blocks)
+{
+  if (statement->name) {
+    hcl_document_set_attribute_interned (document, statement->name,
+                                         g_object_ref (statement->node));
+  } else {
+    hcl_block_list_add (hcl_document_get_block_list (document),
+                        g_object_ref (statement->node));
+    if (blocks)
+      g_ptr_array_add (blocks, g_object_ref (statement->node));
+  }
+
+  hcl_document_add_statement (document, offset, statement->name, statement->node);
+}
+
+/* Lists the top-level blocks of @document */
+static GPtrArray *
+hcl_parser_list_blocks (HclDocument *document)
+{
+  HclBlockList *list = hcl_document_get_block_list (document);
+  GPtrArray *blocks = g_ptr_array_new_full (list->blocks->len, g_object_unref);
+
+  for (guint i = 0; i < list->blocks->len; i++)
+    g_ptr_array_add (blocks, g_object_ref (g_ptr_array_index (list->blocks, i)));
+
+  return blocks;
+}
+
+/**
+ * hcl_parser_reparse:
+ * @parser: an #HclParser
+ * @document: the document parsed from @old_text
+ * @old_text: the text before the edit
+ * @offset: byte offset of the edit in @old_text
+ * @removed: number of bytes removed at @offset
+ * @inserted: the nul-terminated text inserted at @offset
+ * @changed: (out) (optional) (element-type HclBlock) (transfer container):
+ *   return location for the top-level blocks of the new document that
+ *   were parsed again
+ * @replaced: (out) (optional) (element-type HclBlock) (transfer container):
+ *   return location for the top-level blocks of @document they replace
+ * @error: return location for error
+ *
+ * Parses the text that results from replacing @removed bytes of
+ * @old_text at @offset with @inserted, reusing what it can of @document.
+ *
+ * Only the top-level attributes and blocks that the edit touches are
+ * lexed and parsed again. Every other top-level attribute value and
+ * block of the new document is the very object @document has, so
+ * callers can tell what is unchanged by comparing pointers; @changed
+ * and @replaced list the blocks that are not. @document is not
+ * modified.
+ *
+ * @document must have come from parsing @old_text, with
+ * hcl_parser_parse_string(), hcl_parser_parse_file() or an earlier
+ * hcl_parser_reparse(), and not have been modified since. Otherwise,
+ * and if the edited statements only parse in the context of the whole
+ * text, the whole new text is parsed and every block is reported.
+ *
+ * Returns: (transfer full) (nullable): the new document, or %NULL on
+ *   error
+ */
+HclDocument *
+hcl_parser_reparse (HclParser *parser,
+                    HclDocument *document,
+                    const gchar *old_text,
+                    gsize offset,
+                    gsize removed,
+                    const gchar *inserted,
+                    GPtrArray **changed,
+                    GPtrArray **replaced,
+                    GError **error)
+{
+  g_autoptr(HclDocument) region = NULL;
+  g_autoptr(HclDocument) result = NULL;
+  g_autoptr(GPtrArray) changed_blocks = NULL;
+  g_autoptr(GPtrArray) replaced_blocks = NULL;
+  g_autoptr(GString) text = NULL;
+  GArray *statements;
+  GArray *parsed;
+  gsize old_length;
+  gsize inserted_length;
+  gsize start, end;
+  gsize line = 1;
+  gsize column;
+  gsize newlines;
+  gsize last_newline = 0;
+  guint first, last;
+
+  g_return_val_if_fail (HCL_IS_PARSER (parser), NULL);
+  g_return_val_if_fail (HCL_IS_DOCUMENT (document), NULL);
+  g_return_val_if_fail (old_text != NULL, NULL);
+  g_return_val_if_fail (inserted != NULL, NULL);
+
+  old_length = strlen (old_text);
+  inserted_length = strlen (inserted);
+
+  g_return_val_if_fail (offset <= old_length, NULL);
+  g_return_val_if_fail (removed <= old_length - offset, NULL);
+
+  text = g_string_sized_new (old_length - removed + inserted_length);
+  g_string_append_len (text, old_text, (gssize) offset);
+  g_string_append_len (text, inserted, (gssize) inserted_length);
+  g_string_append_len (text, old_text + offset + removed,
+                       (gssize) (old_length - offset - removed));
+
+  statements = hcl_document_get_statements (document);
+  if (!statements ||
+      g_array_index (statements, HclStatement, statements->len - 1).offset >= old_length)
+    goto reparse_all;
+
+  /*
+   * The edit is parsed again from the start of the statement it begins
+   * in up to the start of the first statement after it. A statement that
+   * starts right where the edit ends is included too, as the edit may
+   * run into its first token.
+   */
+  first = hcl_statements_search (statements, offset);
+  if (first > 0) {
+    first--;
+    start = g_array_index (statements, HclStatement, first).offset;
+  } else {
+    start = 0;
+  }
+
+  last = hcl_statements_search (statements, offset + removed);
+  end = last < statements->len
+        ? g_array_index (statements, HclStatement, last).offset - removed + inserted_length
+        : text->len;
+
+  newlines = hcl_scan_count_newlines (text->str, start, &last_newline);
+  line += newlines;
+  column = newlines > 0 ? start - last_newline : start + 1;
+
+  region = hcl_parser_parse_text (parser, text->str + start, end - start,
+                                  line, column, NULL);
+  if (!region)
+    goto reparse_all;
+
+  result = hcl_document_new ();
+  changed_blocks = g_ptr_array_new_with_free_func (g_object_unref);
+  replaced_blocks = g_ptr_array_new_with_free_func (g_object_unref);
+
+  for (guint i = 0; i < first; i++) {
+    const HclStatement *statement = &g_array_index (statements, HclStatement, i);
+
+    hcl_parser_reuse_statement (result, statement, statement->offset, NULL);
+  }
+
+  parsed = hcl_document_get_statements (region);
+  for (guint i = 0; parsed && i < parsed->len; i++) {
+    const HclStatement *statement = &g_array_index (parsed, HclStatement, i);
+
+    hcl_parser_reuse_statement (result, statement, start + statement->offset,
+                                changed_blocks);
+  }
+
+  for (guint i = first; i < last; i++) {
+    const HclStatement *statement = &g_array_index (statements, HclStatement, i);
+
+    if (!statement->name)
+      g_ptr_array_add (replaced_blocks, g_object_ref (statement->node));
+  }
+
+  for (guint i = last; i < statements->len; i++) {
+    const HclStatement *statement = &g_array_index (statements, HclStatement, i);
+
+    hcl_parser_reuse_statement (result, statement,
+                                statement->offset - removed + inserted_length, NULL);
+  }
+
+  if (changed)
+    *changed = g_steal_pointer (&changed_blocks);
+  if (replaced)
+    *replaced = g_steal_pointer (&replaced_blocks);
+
+  return g_steal_pointer (&result);
+
+reparse_all:
+  result = hcl_parser_parse_text (parser, text->str, text->len, 1, 1, error);
+  if (!result)
+    return NULL;
+
+  if (changed)
+    *changed = hcl_parser_list_blocks (result);
+  if (replaced)
+    *replaced = hcl_parser_list_blocks (document);
+
+  return g_steal_pointer (&result);
+}
+
+/*
+ * hcl_parser_parse_text:
+ * @line: line number of the first byte of @input
+ * @column: column number of the first byte of @input
+ *
+ * Parses @length bytes of @input, which need not be nul-terminated,
+ * reporting positions relative to @line and @column. This lets callers
+ * parse a slice of a larger text with the positions of the whole text.
+ */
+HclDocument *
+hcl_parser_parse_text (HclParser *parser,
+                       const gchar *input,
+                       gsize length,
+                       gsize line,
+                       gsize column,
+                       GError **error)
+{
+  g_autoptr(HclDocument) document = NULL;
+
+  hcl_parser_set_input (parser, input, length, line, column);
+
+  /* Initialize first token */
+  if (!hcl_parser_advance (parser, error)) {
+    return NULL;
+  }
+
+  document = hcl_document_new ();
+
+  if (!hcl_parser_parse_body (parser, document, NULL, error)) {
+    return NULL;
+  }
+
+  return g_steal_pointer (&document);
+}
+
+/*
+ * hcl_parser_parse_block_text:
+ *
+ * Like hcl_parser_parse_text(), but parses the text as the body of
+ * @block, adding its attributes and nested blocks to @block.
+ */
+gboolean
+hcl_parser_parse_block_text (HclParser *parser,
+                             const gchar *input,
+                             gsize length,
+                             gsize line,
+                             gsize column,
+                             HclBlock *block,
+                             GError **error)
+{
+  hcl_parser_set_input (parser, input, length, line, column);
+
+  return hcl_parser_advance (parser, error) &&
+         hcl_parser_parse_body (parser, NULL, block, error) &&
+         hcl_parser_consume (parser, HCL_TOKEN_TYPE_EOF, error);
+}
+
+/*
+ * hcl_file_load:
+ *
+ * Maps @filename read-only so the lexer can work over the page cache
+ * without a heap copy. Files that map empty, like those in /proc or
+ * FIFOs whose size is not known up front, and files that cannot be
+ * mapped at all are read instead.
+ *
+ * Returns: (transfer full) (nullable): the file contents, not
+ *   nul-terminated
+ */
+GBytes *
+hcl_file_load (const gchar *filename, GError **error)
+{
+  GMappedFile *mapping;
+  gchar *contents;
+  gsize length;
+
+  mapping = g_mapped_file_new (filename, FALSE, NULL);
+  if (mapping) {
+    if (g_mapped_file_get_length (mapping) > 0) {
+      GBytes *bytes = g_mapped_file_get_bytes (mapping);
+
+      g_mapped_file_unref (mapping);
+      return bytes;
+    }
+
+    g_mapped_file_unref (mapping);
+  }
+
+  if (!g_file_get_contents (filename, &contents, &length, error))
+    return NULL;
+
+  return g_bytes_new_take (contents, length);
+}
+
+/**
+ * hcl_parser_parse_file:
+ * @parser: an #HclParser
+ * @filename: path to HCL file
+ * @error: return location for error
+ *
+ * Parses an HCL file into a document. The file is memory-mapped where
+ * possible and parsed in place, so only the values of the document are
+ * copied out of it.
+ *
+ * Returns: (transfer full) (nullable): parsed document or %NULL on error
+ */
+HclDocument *
+hcl_parser_parse_file (HclParser *parser, const gchar *filename, GError **error)
+{
+  g_autoptr(GBytes) contents = NULL;
+  const gchar *data;
+  gsize length;
+
+  g_return_val_if_fail (HCL_IS_PARSER (parser), NULL);
+  g_return_val_if_fail (filename != NULL, NULL);
+
+  contents = hcl_file_load (filename, error);
+  if (!contents) {
+    return NULL;
+  }
+
+  data = g_bytes_get_data (contents, &length);
+
+  return hcl_parser_parse_text (parser, data, length, 1, 1, error);
+}
+
+/**
+ * hcl_parser_parse_stream:
+ * @parser: an #HclParser
+ * @stream: a #GInputStream to read HCL text from
+ * @cancellable: (nullable): a #GCancellable
+ * @error: return location for error
+ *
+ * Parses HCL text read from @stream in chunks, without ever holding the
+ * whole text in memory. See #HclStreamParser for a version that hands out
+ * blocks while the stream is still being read.
+ *
+ * Returns: (transfer full) (nullable): parsed document or %NULL on error
+ */
+HclDocument *
+hcl_parser_parse_stream (HclParser *parser,
+                         GInputStream *stream,
+                         GCancellable *cancellable,
+                         GError **error)
+{
+  g_autoptr(HclStreamParser) stream_parser = NULL;
+  g_autoptr(HclDocument) document = NULL;
+
+  g_return_val_if_fail (HCL_IS_PARSER (parser), NULL);
+  g_return_val_if_fail (G_IS_INPUT_STREAM (stream), NULL);
+
+  document = hcl_document_new ();
+  stream_parser = hcl_stream_parser_new ();
+  hcl_stream_parser_set_document (stream_parser, document);
+
+  if (!hcl_stream_parser_parse (stream_parser, stream, cancellable, error))
+    return NULL;
+
+  return g_steal_pointer (&document);
+}
+
+/* State of one hcl_parser_parse_events() run */
+typedef struct {
+  HclParser *parser;
+  const HclParserEvents *events;
+  gpointer user_data;
+  guint depth;  /* Frames in use; parser->frames may hold more */
+} HclEventContext;
+
+/*
+ * Applies what a callback returned. Returns %FALSE if parsing has to end,
+ * either because the callback asked for it or because it set an error,
+ * and sets @skip if it asked to skip what it was just told about.
+ */
+static gboolean
+hcl_parser_event_result (HclEventResult result, gboolean *skip, GError **error)
+{
+  if (result == HCL_EVENT_RESULT_STOP || *error != NULL)
+    return FALSE;
+
+  if (skip)
+    *skip = (result == HCL_EVENT_RESULT_SKIP);
+
+  return TRUE;
+}
+
+/* Invokes an optional callback of @context, see hcl_parser_event_result() */
+#define HCL_PARSER_EMIT(context, skip, error, callback, ...)             \
+  ((context)->events->callback == NULL ||                                \
+   hcl_parser_event_result ((context)->events->callback (__VA_ARGS__),   \
+                            (skip), (error)))
+
+/* Skips the list, object or block body opening at the current token */
+static gboolean
+hcl_parser_skip_balanced (HclParser *parser, GError **error)
+{
+  gsize line = parser->current_token.line;
+  gsize column = parser->current_token.column;
+  gsize depth = 0;
+
+  do {
+    switch (parser->current_token.type) {
+      case HCL_TOKEN_TYPE_LBRACE:
+      case HCL_TOKEN_TYPE_LBRACKET:
+        depth++;
+        break;
+
+      case HCL_TOKEN_TYPE_RBRACE:
+      case HCL_TOKEN_TYPE_RBRACKET:
+        depth--;
+        break;
+
+      case HCL_TOKEN_TYPE_EOF:
+        g_set_error (error, HCL_PARSER_ERROR, HCL_PARSER_ERROR_SYNTAX,
+                     "Unterminated bracket opened at line %zu, column %zu",
+                     line, column);
+        return FALSE;
+
+      default:
+        break;
+    }
+
+    if (!hcl_parser_advance (parser, error))
+      return FALSE;
+  } while (depth > 0);
+
+  return TRUE;
+}
+
+static gboolean
+hcl_parser_skip_value (HclParser *parser, GError **error)
+{
+  switch (parser->current_token.type) {
+    case HCL_TOKEN_TYPE_STRING:
+    case HCL_TOKEN_TYPE_IDENTIFIER:
+    case HCL_TOKEN_TYPE_NUMBER:
+    case HCL_TOKEN_TYPE_BOOL:
+    case HCL_TOKEN_TYPE_NULL:
+      return hcl_parser_advance (parser, error);
+
+    case HCL_TOKEN_TYPE_LBRACKET:
+    case HCL_TOKEN_TYPE_LBRACE:
+      return hcl_parser_skip_balanced (parser, error);
+
+    default:
+      hcl_parser_set_value_error (parser, error);
+      return FALSE;
+  }
+}
+
+/*
+ * Opens a frame for hcl_parser_parse_events(). The frames it leaves are
+ * kept until the parse is over, so going in and out of a level does not
+ * resize the stack: it only grows the first time a level is reached.
+ */
+static gboolean
+hcl_parser_emit_push (HclEventContext *context, HclParseFrameKind kind, GError **error)
+{
+  GArray *frames = context->parser->frames;
+
+  /* The root body does not count towards the depth */
+  if (context->depth > 0 &&
+      !hcl_parser_check_depth (context->parser, context->depth - 1, error))
+    return FALSE;
+
+  if (context->depth == frames->len) {
+    g_array_set_size (frames, frames->len + 1);
+    g_array_index (frames, HclParseFrame, context->depth) = (HclParseFrame) { 0, };
+  }
+
+  g_array_index (frames, HclParseFrame, context->depth++).kind = kind;
+
+  return TRUE;
+}
+
+static HclParseFrameKind
+hcl_parser_emit_top (HclEventContext *context)
+{
+  return g_array_index (context->parser->frames, HclParseFrame, context->depth - 1).kind;
+}
+
+/*
+ * Finishes a value that was reported or skipped. Items and members are
+ * followed by a separator; an attribute ends with its line.
+ */
+static gboolean
+hcl_parser_emit_value_end (HclEventContext *context, GError **error)
+{
+  if (hcl_parser_emit_top (context) == HCL_PARSE_FRAME_BODY)
+    return TRUE;
+
+  return hcl_parser_skip_separator (context->parser, error);
+}
+
+/* Reports the list or object at the current token and opens a frame for it */
+static gboolean
+hcl_parser_emit_container (HclEventContext *context, GError **error)
+{
+  HclParser *parser = context->parser;
+  gboolean is_list = hcl_parser_match (parser, HCL_TOKEN_TYPE_LBRACKET);
+  gboolean skip = FALSE;
+
+  if (is_list ? !HCL_PARSER_EMIT (context, &skip, error,
+                                  list_begin, context->user_data, error)
+              : !HCL_PARSER_EMIT (context, &skip, error,
+                                  object_begin, context->user_data, error))
+    return FALSE;
+
+  if (skip)
+    return hcl_parser_skip_balanced (parser, error) &&
+           hcl_parser_emit_value_end (context, error);
+
+  return hcl_parser_emit_push (context,
+                               is_list ? HCL_PARSE_FRAME_LIST : HCL_PARSE_FRAME_OBJECT,
+                               error) &&
+         hcl_parser_advance (parser, error);
+}
+
+/* Closes the list or object on top of the stack at its closing bracket */
+static gboolean
+hcl_parser_emit_container_end (HclEventContext *context, GError **error)
+{
+  HclParser *parser = context->parser;
+  gboolean is_list = hcl_parser_emit_top (context) == HCL_PARSE_FRAME_LIST;
+
+  context->depth--;
+
+  if (!hcl_parser_advance (parser, error))
+    return FALSE;
+
+  if (is_list ? !HCL_PARSER_EMIT (context, NULL, error,
+                                  list_end, context->user_data, error)
+              : !HCL_PARSER_EMIT (context, NULL, error,
+                                  object_end, context->user_data, error))
+    return FALSE;
+
+  return hcl_parser_emit_value_end (context, error);
+}
+
+/* Reports the value at the current token; lists and objects only open */
+static gboolean
+hcl_parser_emit_value (HclEventContext *context, GError **error)
+{
+  HclParser *parser = context->parser;
+  HclEventValue value = { 0, };
+
+  switch (parser->current_token.type) {
+    case HCL_TOKEN_TYPE_STRING:
+    case HCL_TOKEN_TYPE_IDENTIFIER:
+      value.type = HCL_VALUE_TYPE_STRING;
+
+      /* Nobody is listening, don't bother copying the string */
+      if (context->events->value == NULL)
+        break;
+
+      hcl_lexer_span_copy_value (parser->lexer, &parser->current_token,
+                                 parser->text_buffer);
+      value.string = parser->text_buffer->str;
+      value.length = parser->text_buffer->len;
+      break;
+
+    case HCL_TOKEN_TYPE_NUMBER:
+      value.type = HCL_VALUE_TYPE_NUMBER;
+      value.number_type = hcl_parser_read_number (parser, &value.int_value,
+                                                  &value.double_value)
+                          ? HCL_NUMBER_TYPE_FLOAT
+                          : HCL_NUMBER_TYPE_INTEGER;
+      break;
+
+    case HCL_TOKEN_TYPE_BOOL:
+      value.type = HCL_VALUE_TYPE_BOOL;
+      value.bool_value = hcl_lexer_span_equal (parser->lexer,
+                                               &parser->current_token,
+                                               "true");
+      break;
+
+    case HCL_TOKEN_TYPE_NULL:
+      value.type = HCL_VALUE_TYPE_NULL;
+      break;
+
+    case HCL_TOKEN_TYPE_LBRACKET:
+    case HCL_TOKEN_TYPE_LBRACE:
+      return hcl_parser_emit_container (context, error);
+
+    default:
+      hcl_parser_set_value_error (parser, error);
+      return FALSE;
+  }
+
+  return HCL_PARSER_EMIT (context, NULL, error,
+                          value, &value, context->user_data, error) &&
+         hcl_parser_advance (parser, error) &&
+         hcl_parser_emit_value_end (context, error);
+}
+
+/* Reports the next member of the object on top of the stack */
+static gboolean
+hcl_parser_emit_member (HclEventContext *context, GError **error)
+{
+  HclParser *parser = context->parser;
+  gboolean skip = FALSE;
+
+  if (!hcl_parser_match (parser, HCL_TOKEN_TYPE_IDENTIFIER) &&
+      !hcl_parser_match (parser, HCL_TOKEN_TYPE_STRING)) {
+    g_set_error (error, HCL_PARSER_ERROR, HCL_PARSER_ERROR_SYNTAX,
+                 "Expected identifier or string for object key");
+    return FALSE;
+  }
+
+  hcl_lexer_span_copy_value (parser->lexer, &parser->current_token,
+                             parser->name_buffer);
+
+  if (!hcl_parser_advance (parser, error) ||
+      !hcl_parser_consume (parser, HCL_TOKEN_TYPE_ASSIGN, error) ||
+      !HCL_PARSER_EMIT (context, &skip, error, object_key,
+                        parser->name_buffer->str, context->user_data, error))
+    return FALSE;
+
+  if (skip)
+    return hcl_parser_skip_value (parser, error) &&
+           hcl_parser_skip_separator (parser, error);
+
+  return hcl_parser_emit_value (context, error);
+}
+
+static gboolean
+hcl_parser_emit_attribute (HclEventContext *context, GError **error)
+{
+  HclParser *parser = context->parser;
+  gboolean skip = FALSE;
+
+  hcl_lexer_span_copy_value (parser->lexer, &parser->current_token,
+                             parser->name_buffer);
+
+  if (!hcl_parser_advance (parser, error) ||
+      !hcl_parser_consume (parser, HCL_TOKEN_TYPE_ASSIGN, error) ||
+      !HCL_PARSER_EMIT (context, &skip, error, attribute,
+                        parser->name_buffer->str, context->user_data, error))
+    return FALSE;
+
+  if (skip)
+    return hcl_parser_skip_value (parser, error);
+
+  return hcl_parser_emit_value (context, error);
+}
+
+/* Reports the block at the current identifier and opens a frame for its body */
+static gboolean
+hcl_parser_emit_block (HclEventContext *context, gboolean has_label, GError **error)
+{
+  HclParser *parser = context->parser;
+  const gchar *label = NULL;
+  gboolean skip = FALSE;
+
+  hcl_lexer_span_copy_value (parser->lexer, &parser->current_token,
+                             parser->name_buffer);
+
+  if (!hcl_parser_advance (parser, error))
+    return FALSE;
+
+  if (has_label) {
+    hcl_lexer_span_copy_value (parser->lexer, &parser->current_token,
+                               parser->text_buffer);
+    label = parser->text_buffer->str;
+
+    if (!hcl_parser_advance (parser, error))
+      return FALSE;
+  }
+
+  /* Fails with the same error as the tree parser */
+  if (!hcl_parser_match (parser, HCL_TOKEN_TYPE_LBRACE))
+    return hcl_parser_consume (parser, HCL_TOKEN_TYPE_LBRACE, error);
+
+  if (!HCL_PARSER_EMIT (context, &skip, error, block_begin,
+                        parser->name_buffer->str, label,
+                        context->user_data, error))
+    return FALSE;
+
+  if (skip)
+    return hcl_parser_skip_balanced (parser, error);
+
+  return hcl_parser_emit_push (context, HCL_PARSE_FRAME_BODY, error) &&
+         hcl_parser_advance (parser, error);
+}
+
+/*
+ * Reports the next attribute or block of the body on top of the stack,
+ * or closes it. Returns %FALSE with @done set once the root body is over.
+ */
+static gboolean
+hcl_parser_emit_body (HclEventContext *context, gboolean *done, GError **error)
+{
+  HclParser *parser = context->parser;
+  gboolean is_root = context->depth == 1;
+  gboolean is_block;
+  gboolean has_label;
+
+  if (hcl_parser_match (parser, HCL_TOKEN_TYPE_EOF) ||
+      (!is_root && hcl_parser_match (parser, HCL_TOKEN_TYPE_RBRACE))) {
+    if (is_root) {
+      *done = TRUE;
+      return FALSE;
+    }
+
+    context->depth--;
+    return hcl_parser_consume (parser, HCL_TOKEN_TYPE_RBRACE, error) &&
+           HCL_PARSER_EMIT (context, NULL, error,
+                            block_end, context->user_data, error);
+  }
+
+  if (hcl_parser_match (parser, HCL_TOKEN_TYPE_COMMENT))
+    return hcl_parser_advance (parser, error);
+
+  if (!hcl_parser_match (parser, HCL_TOKEN_TYPE_IDENTIFIER)) {
+    g_set_error_literal (error, HCL_PARSER_ERROR, HCL_PARSER_ERROR_SYNTAX,
+                         is_root ? "Expected identifier at top level"
+                                 : "Expected identifier in block body");
+    return FALSE;
+  }
+
+  if (!hcl_parser_at_block (parser, &is_block, &has_label, error))
+    return FALSE;
+
+  return is_block ? hcl_parser_emit_block (context, has_label, error)
+                  : hcl_parser_emit_attribute (context, error);
+}
+
+/*
+ * Takes one step of hcl_parser_parse_events() on the frame on top of the
+ * stack. Returns %FALSE with @done set once the root body is over.
+ */
+static gboolean
+hcl_parser_emit_step (HclEventContext *context, gboolean *done, GError **error)
+{
+  HclParser *parser = context->parser;
+
+  if (!hcl_parser_skip_newlines (parser, error))
+    return FALSE;
+
+  switch (hcl_parser_emit_top (context)) {
+    case HCL_PARSE_FRAME_BODY:
+      return hcl_parser_emit_body (context, done, error);
+
+    case HCL_PARSE_FRAME_LIST:
+      return hcl_parser_match (parser, HCL_TOKEN_TYPE_RBRACKET)
+             ? hcl_parser_emit_container_end (context, error)
+             : hcl_parser_emit_value (context, error);
+
+    case HCL_PARSE_FRAME_OBJECT:
+      return hcl_parser_match (parser, HCL_TOKEN_TYPE_RBRACE)
+             ? hcl_parser_emit_container_end (context, error)
+             : hcl_parser_emit_member (context, error);
+
+    default:
+      g_assert_not_reached ();
+  }
+
+  return FALSE;
+}
+
+/**
+ * hcl_parser_parse_events:
+ * @parser: an #HclParser
+ * @input: HCL input text
+ * @length: length of @input in bytes, or -1 if it is nul-terminated
+ * @events: callbacks to invoke
+ * @user_data: user data to pass to the callbacks
+ * @error: return location for error
+ *
+ * Parses HCL text and reports its blocks, attributes and values through
+ * @events in document order, without building an #HclDocument. Callbacks
+ * can return %HCL_EVENT_RESULT_SKIP to pass over a subtree, which is then
+ * only checked for balanced brackets, or %HCL_EVENT_RESULT_STOP to end
+ * the parse early.
+ *
+ * Returns: %TRUE if the input was parsed or a callback stopped the parse
+ *   without an error, %FALSE on error
+ */
+gboolean
+hcl_parser_parse_events (HclParser *parser,
+                         const gchar *input,
+                         gssize length,
+                         const HclParserEvents *events,
+                         gpointer user_data,
+                         GError **error)
+{
+  HclEventContext context = { parser, events, user_data, 0 };
+  GError *local_error = NULL;
+  gboolean done = FALSE;
+
+  g_return_val_if_fail (HCL_IS_PARSER (parser), FALSE);
+  g_return_val_if_fail (input != NULL || length == 0, FALSE);
+  g_return_val_if_fail (events != NULL, FALSE);
+
+  if (length < 0)
+    length = (gssize) strlen (input);
+
+  hcl_parser_set_input (parser, input, (gsize) length, 1, 1);
+  hcl_parser_emit_push (&context, HCL_PARSE_FRAME_BODY, NULL);
+
+  if (hcl_parser_advance (parser, &local_error))
+    while (hcl_parser_emit_step (&context, &done, &local_error))
+      ;
+
+  hcl_parser_clear_frames (parser);
+
+  /*
+   * Every failure sets an error, so without one the input is over or a
+   * callback stopped us
+   */
+  if (local_error == NULL)
+    return TRUE;
+
+  g_propagate_error (error, local_error);
+  return FALSE;
+}
+
+/**
+ * hcl_parser_parse_file_events:
+ * @parser: an #HclParser
+ * @filename: path to HCL file
+ * @events: callbacks to invoke
+ * @user_data: user data to pass to the callbacks
+ * @error: return location for error
+ *
+ * Parses an HCL file with hcl_parser_parse_events().
+ *
+ * Returns: %TRUE if the file was parsed or a callback stopped the parse
+ *   without an error, %FALSE on error
+ */
+gboolean
+hcl_parser_parse_file_events (HclParser *parser,
+                              const gchar *filename,
+                              const HclParserEvents *events,
+                              gpointer user_data,
+                              GError **error)
+{
+  g_autoptr(GBytes) contents = NULL;
+  const gchar *data;
+  gsize length;
+
+  g_return_val_if_fail (HCL_IS_PARSER (parser), FALSE);
+  g_return_val_if_fail (filename != NULL, FALSE);
+
+  contents = hcl_file_load (filename, error);
+  if (!contents)
+    return FALSE;
+
+  data = g_bytes_get_data (contents, &length);
+
+  return hcl_parser_parse_events (parser, data, (gssize) length,
+                                  events, user_data, error);
+}
+
+/**
+ * hcl_parse_string:
+ * @input: HCL input string
+ * @error: return location for error
+ *
+ * Convenience function to parse an HCL string.
+ *
+ * Returns: (transfer full) (nullable): parsed document or %NULL on error
+ */
+HclDocument *
+hcl_parse_string (const gchar *input, GError **error)
+{
+  g_autoptr(HclParser) parser = hcl_parser_new ();
+  return hcl_parser_parse_string (parser, input, error);
+}
+
+/**
+ * hcl_parse_file:
+ * @filename: path to HCL file
+ * @error: return location for error
+ *
+ * Convenience function to parse an HCL file.
+ *
+ * Returns: (transfer full) (nullable): parsed document or %NULL on error
+ */
+HclDocument *
+hcl_parse_file (const gchar *filename, GError **error)
+{
+  g_autoptr(HclParser) parser = hcl_parser_new ();
+  return hcl_parser_parse_file (parser, filename, error);
+}
+
+typedef struct {
+  const gchar *filename;
+  HclDocument *document;
+  GError *error;
+} HclParseFileJob;
+
+static void
+hcl_parse_file_job (gpointer data, gpointer user_data)
+{
+  HclParseFileJob *job = data;
+
+  (void)user_data;
+
+  job->document = hcl_parse_file (job->filename, &job->error);
+}
+
+/**
+ * hcl_parse_files:
+ * @filenames: (array zero-terminated=1): %NULL-terminated array of paths
+ *   to HCL files
+ * @error: return location for error
+ *
+ * Parses several HCL files and merges them into one document with
+ * hcl_document_merge(), in the order they are listed, so the result is
+ * the same as parsing the files one after another. The files are parsed
+ * concurrently on a thread pool with one thread per processor.
+ *
+ * If any file fails to parse, the error of the first such file in
+ * @filenames is returned, prefixed with its path.
+ *
+ * Returns: (transfer full) (nullable): merged document or %NULL on error
+ */
+HclDocument *
+hcl_parse_files (const gchar * const *filenames, GError **error)
+{
+  g_autofree HclParseFileJob *jobs = NULL;
+  HclDocument *document = NULL;
+  GError *document_error = NULL;
+  GThreadPool *pool;
+  guint n_files;
+  guint i;
+
+  g_return_val_if_fail (filenames != NULL, NULL);
+  g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+  n_files = g_strv_length ((gchar **) filenames);
+  jobs = g_new0 (HclParseFileJob, n_files);
+
+  for (i = 0; i < n_files; i++)
+    jobs[i].filename = filenames[i];
+
+  if (n_files > 1) {
+    /* Parsers share no state, so every file can have its own thread */
+    pool = g_thread_pool_new (hcl_parse_file_job, NULL,
+                              (gint) MIN (n_files, g_get_num_processors ()),
+                              FALSE, NULL);
+
+    for (i = 0; i < n_files; i++)
+      g_thread_pool_push (pool, &jobs[i], NULL);
+
+    g_thread_pool_free (pool, FALSE, TRUE);
+  } else if (n_files == 1) {
+    hcl_parse_file_job (&jobs[0], NULL);
+  }
+
+  for (i = 0; i < n_files; i++) {
+    if (jobs[i].error && !document_error) {
+      document_error = g_steal_pointer (&jobs[i].error);
+      g_prefix_error (&document_error, "%s: ", jobs[i].filename);
+    }
+
+    if (!document_error) {
+      if (document)
+        hcl_document_merge (document, jobs[i].document);
+      else
+        document = g_object_ref (jobs[i].document);
+    }
+
+    g_clear_object (&jobs[i].document);
+    g_clear_error (&jobs[i].error);
+  }
+
+  if (document_error) {
+    g_propagate_error (error, document_error);
+    g_clear_object (&document);
+    return NULL;
+  }
+
+  return document ? document : hcl_document_new ();
 }
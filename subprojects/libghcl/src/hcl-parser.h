@@ -11,7 +11,7 @@
 #ifndef __HCL_PARSER_H__
 #define __HCL_PARSER_H__
 
-#include <glib-object.h>
+#include <gio/gio.h>
 #include "hcl-document.h"
 #include "hcl-enums.h"
 
@@ -20,18 +20,142 @@ G_BEGIN_DECLS
 #define HCL_TYPE_PARSER (hcl_parser_get_type())
 G_DECLARE_FINAL_TYPE (HclParser, hcl_parser, HCL, PARSER, GObject)
 
+/**
+ * HCL_PARSER_DEFAULT_MAX_DEPTH:
+ *
+ * How deeply blocks, lists and objects may nest in the input of a new
+ * #HclParser.
+ */
+#define HCL_PARSER_DEFAULT_MAX_DEPTH 512
+
+/**
+ * HclEventValue:
+ * @type: %HCL_VALUE_TYPE_STRING, %HCL_VALUE_TYPE_NUMBER,
+ *   %HCL_VALUE_TYPE_BOOL or %HCL_VALUE_TYPE_NULL
+ * @number_type: the kind of number, for %HCL_VALUE_TYPE_NUMBER
+ * @string: the nul-terminated string with escape sequences processed,
+ *   for %HCL_VALUE_TYPE_STRING; %NULL otherwise
+ * @length: length of @string in bytes
+ * @int_value: the number, for %HCL_NUMBER_TYPE_INTEGER
+ * @double_value: the number as a double, for either number type
+ * @bool_value: the boolean, for %HCL_VALUE_TYPE_BOOL
+ *
+ * A scalar value reported by the #HclParserEvents value callback. It is
+ * owned by the parser and only valid during the callback.
+ */
+typedef struct {
+  HclValueType type;
+  HclNumberType number_type;
+  const gchar *string;
+  gsize length;
+  gint64 int_value;
+  gdouble double_value;
+  gboolean bool_value;
+} HclEventValue;
+
+/**
+ * HclParserEvents:
+ * @block_begin: called when a block body is entered, with the block type
+ *   and its label or %NULL; return %HCL_EVENT_RESULT_SKIP to skip the
+ *   body, in which case @block_end is not called for it
+ * @block_end: called when a block that was not skipped is closed
+ * @attribute: called with the name of an attribute, before its value;
+ *   return %HCL_EVENT_RESULT_SKIP to skip the value
+ * @value: called for every string, number, boolean and null value
+ * @list_begin: called when a list starts; return %HCL_EVENT_RESULT_SKIP
+ *   to skip its items, in which case @list_end is not called for it
+ * @list_end: called when a list that was not skipped ends
+ * @object_begin: called when an object starts; return
+ *   %HCL_EVENT_RESULT_SKIP to skip its members, in which case
+ *   @object_end is not called for it
+ * @object_key: called with the key of an object member, before its
+ *   value; return %HCL_EVENT_RESULT_SKIP to skip the value
+ * @object_end: called when an object that was not skipped ends
+ *
+ * Callbacks for hcl_parser_parse_events(), in the spirit of
+ * #GMarkupParser. Every callback may be %NULL. Strings passed to the
+ * callbacks are owned by the parser and only valid during the call.
+ *
+ * A callback may fail by setting @error and returning
+ * %HCL_EVENT_RESULT_STOP; the error is then returned by
+ * hcl_parser_parse_events().
+ */
+typedef struct {
+  HclEventResult (*block_begin)  (const gchar *type,
+                                  const gchar *label,
+                                  gpointer user_data,
+                                  GError **error);
+  HclEventResult (*block_end)    (gpointer user_data,
+                                  GError **error);
+  HclEventResult (*attribute)    (const gchar *name,
+                                  gpointer user_data,
+                                  GError **error);
+  HclEventResult (*value)        (const HclEventValue *value,
+                                  gpointer user_data,
+                                  GError **error);
+  HclEventResult (*list_begin)   (gpointer user_data,
+                                  GError **error);
+  HclEventResult (*list_end)     (gpointer user_data,
+                                  GError **error);
+  HclEventResult (*object_begin) (gpointer user_data,
+                                  GError **error);
+  HclEventResult (*object_key)   (const gchar *key,
+                                  gpointer user_data,
+                                  GError **error);
+  HclEventResult (*object_end)   (gpointer user_data,
+                                  GError **error);
+} HclParserEvents;
+
 /* Constructor */
 HclParser      *hcl_parser_new                  (void);
 
+/* Properties */
+guint           hcl_parser_get_max_depth        (HclParser *parser);
+void            hcl_parser_set_max_depth        (HclParser *parser,
+                                                 guint max_depth);
+
 /* Parsing */
 HclDocument    *hcl_parser_parse_string         (HclParser *parser,
                                                  const gchar *input,
                                                  GError **error);
 
+HclDocument    *hcl_parser_parse_string_recover (HclParser *parser,
+                                                 const gchar *input,
+                                                 GPtrArray **diagnostics);
+
+HclDocument    *hcl_parser_reparse              (HclParser *parser,
+                                                 HclDocument *document,
+                                                 const gchar *old_text,
+                                                 gsize offset,
+                                                 gsize removed,
+                                                 const gchar *inserted,
+                                                 GPtrArray **changed,
+                                                 GPtrArray **replaced,
+                                                 GError **error);
+
 HclDocument    *hcl_parser_parse_file           (HclParser *parser,
                                                  const gchar *filename,
                                                  GError **error);
 
+HclDocument    *hcl_parser_parse_stream         (HclParser *parser,
+                                                 GInputStream *stream,
+                                                 GCancellable *cancellable,
+                                                 GError **error);
+
+/* Event-driven parsing */
+gboolean        hcl_parser_parse_events         (HclParser *parser,
+                                                 const gchar *input,
+                                                 gssize length,
+                                                 const HclParserEvents *events,
+                                                 gpointer user_data,
+                                                 GError **error);
+
+gboolean        hcl_parser_parse_file_events    (HclParser *parser,
+                                                 const gchar *filename,
+                                                 const HclParserEvents *events,
+                                                 gpointer user_data,
+                                                 GError **error);
+
 /* Convenience functions */
 HclDocument    *hcl_parse_string                (const gchar *input,
                                                  GError **error);
@@ -39,6 +163,9 @@ HclDocument    *hcl_parse_string                (const gchar *input,
 HclDocument    *hcl_parse_file                  (const gchar *filename,
                                                  GError **error);
 
+HclDocument    *hcl_parse_files                 (const gchar * const *filenames,
+                                                 GError **error);
+
 G_END_DECLS
 
 #endif /* __HCL_PARSER_H__ */
@@ -0,0 +1,681 @@
+/* hcl-path.c - Compiled path expressions over HCL documents
+ *
+ * Copyright 2024 Geoff Johnson <geoff.jay@gmail.com>
+ */
+
+#include "hcl-path.h"
+#include "hcl-private.h"
+#include <string.h>
+
+/**
+ * SECTION:hcl-path
+ * @short_description: Compiled path expressions
+ * @title: HclPath
+ *
+ * #HclPath is a path expression compiled once and evaluated against any
+ * number of documents or blocks, for example:
+ *
+ * |[
+ * dashboard["main"].card[*].chart.title
+ * ]|
+ *
+ * A path is a list of steps separated by dots. Each step is a name,
+ * optionally followed by selectors in brackets. From a document or block,
+ * a name matches the attribute of that name and then every child block of
+ * that type. From an object value, it matches the member of that name.
+ *
+ * A selector directly after a name picks among what the name matched:
+ *
+ * - `["text"]` picks the member with that key from an object attribute,
+ *   and the first block with that label
+ * - `[n]` picks item @n from a list attribute, and the @n-th block of
+ *   the type, counting from zero
+ * - `[*]` expands every item or member of a list or object attribute,
+ *   and keeps every block of the type
+ *
+ * Further selectors apply to the values matched so far, so `grid[0][1]`
+ * picks the second item of the first item of a list attribute `grid`.
+ *
+ * Matches are produced lazily by an #HclPathIter in document order, with
+ * object members in the order they were set. Evaluating a path does not
+ * allocate once the path has been used, except when several iterators
+ * walk the same path at the same time.
+ */
+
+typedef enum {
+  HCL_PATH_SELECT_NONE,
+  HCL_PATH_SELECT_KEY,
+  HCL_PATH_SELECT_INDEX,
+  HCL_PATH_SELECT_ALL
+} HclPathSelect;
+
+typedef struct {
+  const gchar *name;       /* Interned; NULL for a bare selector */
+  HclPathSelect select;
+  const gchar *key;        /* Interned */
+  guint index;
+} HclPathStep;
+
+typedef enum {
+  HCL_PATH_NODE_DOCUMENT,
+  HCL_PATH_NODE_BLOCK,
+  HCL_PATH_NODE_VALUE
+} HclPathNodeKind;
+
+typedef enum {
+  HCL_PATH_PHASE_START,
+  HCL_PATH_PHASE_EXPAND,
+  HCL_PATH_PHASE_BLOCKS,
+  HCL_PATH_PHASE_BLOCK_ITER,
+  HCL_PATH_PHASE_DONE
+} HclPathPhase;
+
+/* Where the evaluation of one step stands for one input node */
+typedef struct {
+  HclPathNodeKind kind;
+  gpointer input;
+  HclPathPhase phase;
+  HclValue *expanding;     /* List or object being expanded by [*] */
+  guint index;
+  HclMapIter members;
+  HclBlockIter blocks;
+} HclPathFrame;
+
+/* The real layout behind the public HclPathIter */
+typedef struct {
+  HclPath *path;
+  HclPathFrame *frames;
+  gint depth;
+} HclRealPathIter;
+
+G_STATIC_ASSERT (sizeof (HclRealPathIter) <= sizeof (HclPathIter));
+
+struct _HclPath
+{
+  GObject parent_instance;
+
+  gchar *expression;
+  HclPathStep *steps;
+  guint n_steps;
+  HclPathFrame *spare_frames;  /* Lent to one iterator at a time */
+};
+
+G_DEFINE_FINAL_TYPE (HclPath, hcl_path, G_TYPE_OBJECT)
+
+static void
+hcl_path_finalize (GObject *object)
+{
+  HclPath *self = HCL_PATH (object);
+
+  g_free (self->expression);
+  g_free (self->steps);
+  g_free (self->spare_frames);
+
+  G_OBJECT_CLASS (hcl_path_parent_class)->finalize (object);
+}
+
+static void
+hcl_path_class_init (HclPathClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = hcl_path_finalize;
+}
+
+static void
+hcl_path_init (HclPath *self)
+{
+  (void)self; /* Suppress unused parameter warning */
+}
+
+/*
+ * Compiling
+ */
+
+static gboolean
+hcl_path_is_name_start (gchar c)
+{
+  return g_ascii_isalpha (c) || c == '_';
+}
+
+static gboolean
+hcl_path_is_name_char (gchar c)
+{
+  return g_ascii_isalnum (c) || c == '_' || c == '-';
+}
+
+static void
+hcl_path_set_syntax_error (GError **error, const gchar *expression, const gchar *at,
+                           const gchar *expected)
+{
+  if (*at)
+    g_set_error (error, HCL_PATH_ERROR, HCL_PATH_ERROR_SYNTAX,
+                 "Expected %s at offset %u in path '%s', found '%c'",
+                 expected, (guint) (at - expression), expression, *at);
+  else
+    g_set_error (error, HCL_PATH_ERROR, HCL_PATH_ERROR_SYNTAX,
+                 "Expected %s at the end of path '%s'", expected, expression);
+}
+
+/* Parses the selector starting after '[' at @p into @step */
+static const gchar *
+hcl_path_parse_selector (const gchar *expression, const gchar *p, HclPathStep *step,
+                         GError **error)
+{
+  if (*p == '*') {
+    step->select = HCL_PATH_SELECT_ALL;
+    p++;
+  } else if (g_ascii_isdigit (*p)) {
+    guint64 index = 0;
+
+    for (; g_ascii_isdigit (*p); p++) {
+      index = index * 10 + (guint64) (*p - '0');
+      if (index > G_MAXUINT) {
+        g_set_error (error, HCL_PATH_ERROR, HCL_PATH_ERROR_INVALID_INDEX,
+                     "Index too large in path '%s'", expression);
+        return NULL;
+      }
+    }
+
+    step->select = HCL_PATH_SELECT_INDEX;
+    step->index = (guint) index;
+  } else if (*p == '-' && g_ascii_isdigit (p[1])) {
+    g_set_error (error, HCL_PATH_ERROR, HCL_PATH_ERROR_INVALID_INDEX,
+                 "Negative index at offset %u in path '%s'",
+                 (guint) (p - expression), expression);
+    return NULL;
+  } else if (*p == '"') {
+    g_autoptr(GString) key = g_string_new (NULL);
+
+    for (p++; *p != '"'; p++) {
+      if (*p == '\0') {
+        hcl_path_set_syntax_error (error, expression, p, "'\"'");
+        return NULL;
+      }
+
+      if (*p == '\\') {
+        p++;
+        if (*p != '"' && *p != '\\') {
+          hcl_path_set_syntax_error (error, expression, p, "'\"' or '\\' after '\\'");
+          return NULL;
+        }
+      }
+
+      g_string_append_c (key, *p);
+    }
+
+    step->select = HCL_PATH_SELECT_KEY;
+    step->key = g_intern_string (key->str);
+    p++;
+  } else {
+    hcl_path_set_syntax_error (error, expression, p, "'*', an index or a quoted key");
+    return NULL;
+  }
+
+  if (*p != ']') {
+    hcl_path_set_syntax_error (error, expression, p, "']'");
+    return NULL;
+  }
+
+  return p + 1;
+}
+
+static gboolean
+hcl_path_compile (HclPath *self, GError **error)
+{
+  g_autoptr(GArray) steps = g_array_new (FALSE, TRUE, sizeof (HclPathStep));
+  const gchar *expression = self->expression;
+  const gchar *p = expression;
+
+  for (;;) {
+    HclPathStep step = { 0 };
+    const gchar *start = p;
+    g_autofree gchar *name = NULL;
+
+    if (!hcl_path_is_name_start (*p)) {
+      hcl_path_set_syntax_error (error, expression, p, "a name");
+      return FALSE;
+    }
+
+    while (hcl_path_is_name_char (*p))
+      p++;
+
+    name = g_strndup (start, p - start);
+    step.name = g_intern_string (name);
+
+    /* The first selector belongs to the name, later ones stand alone */
+    while (*p == '[') {
+      p = hcl_path_parse_selector (expression, p + 1, &step, error);
+      if (!p)
+        return FALSE;
+
+      g_array_append_val (steps, step);
+      memset (&step, 0, sizeof step);
+    }
+
+    if (step.name)
+      g_array_append_val (steps, step);
+
+    if (*p == '\0')
+      break;
+
+    if (*p != '.') {
+      hcl_path_set_syntax_error (error, expression, p, "'.' or '['");
+      return FALSE;
+    }
+
+    p++;
+  }
+
+  self->n_steps = steps->len;
+  self->steps = (HclPathStep *) g_array_free (g_steal_pointer (&steps), FALSE);
+
+  return TRUE;
+}
+
+/**
+ * hcl_path_new:
+ * @expression: a path expression
+ * @error: return location for a #GError, or %NULL
+ *
+ * Compiles @expression. See the section description for the syntax.
+ *
+ * Returns: (transfer full) (nullable): a new #HclPath, or %NULL with
+ *   @error set to an #HclPathError if @expression is malformed
+ */
+HclPath *
+hcl_path_new (const gchar *expression, GError **error)
+{
+  g_autoptr(HclPath) self = NULL;
+
+  g_return_val_if_fail (expression != NULL, NULL);
+  g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+  self = g_object_new (HCL_TYPE_PATH, NULL);
+  self->expression = g_strdup (expression);
+
+  if (!hcl_path_compile (self, error))
+    return NULL;
+
+  return g_steal_pointer (&self);
+}
+
+/**
+ * hcl_path_get_expression:
+ * @path: an #HclPath
+ *
+ * Gets the expression @path was compiled from.
+ *
+ * Returns: the path expression
+ */
+const gchar *
+hcl_path_get_expression (HclPath *path)
+{
+  g_return_val_if_fail (HCL_IS_PATH (path), NULL);
+
+  return path->expression;
+}
+
+/*
+ * Evaluating
+ *
+ * Evaluation is a depth-first walk with one frame per step. Each frame
+ * produces the matches of its step for one input node, one at a time;
+ * every match becomes the input of the next step's frame, and matches of
+ * the last step are handed to the caller.
+ */
+
+/* Applies the selector of @step to @value; returns TRUE if it matched */
+static gboolean
+hcl_path_frame_select (const HclPathStep *step, HclPathFrame *frame, HclValue *value,
+                       HclValue **match)
+{
+  HclValueType type;
+
+  if (!value)
+    return FALSE;
+
+  type = hcl_value_get_value_type (value);
+
+  switch (step->select) {
+    case HCL_PATH_SELECT_NONE:
+      *match = value;
+      return TRUE;
+
+    case HCL_PATH_SELECT_KEY:
+      if (type != HCL_VALUE_TYPE_OBJECT)
+        return FALSE;
+      *match = hcl_value_object_get_member_interned (value, step->key);
+      return *match != NULL;
+
+    case HCL_PATH_SELECT_INDEX:
+      if (type != HCL_VALUE_TYPE_LIST)
+        return FALSE;
+      *match = hcl_value_list_get_item (value, step->index);
+      return *match != NULL;
+
+    case HCL_PATH_SELECT_ALL:
+      if (type == HCL_VALUE_TYPE_OBJECT)
+        hcl_value_object_iter_init (value, &frame->members);
+      else if (type != HCL_VALUE_TYPE_LIST)
+        return FALSE;
+
+      frame->expanding = value;
+      frame->index = 0;
+      frame->phase = HCL_PATH_PHASE_EXPAND;
+      return FALSE;
+
+    default:
+      g_assert_not_reached ();
+  }
+}
+
+static HclBlockList *
+hcl_path_frame_block_list (HclPathFrame *frame)
+{
+  if (frame->kind == HCL_PATH_NODE_DOCUMENT)
+    return hcl_document_get_block_list (frame->input);
+
+  return hcl_block_get_block_list (frame->input);
+}
+
+/* Produces the next match of @step for the input of @frame */
+static gboolean
+hcl_path_frame_next (const HclPathStep *step, HclPathFrame *frame,
+                     HclPathNodeKind *kind, gpointer *match)
+{
+  for (;;) {
+    switch (frame->phase) {
+      case HCL_PATH_PHASE_START: {
+        HclValue *value = NULL;
+
+        if (frame->kind == HCL_PATH_NODE_VALUE) {
+          value = frame->input;
+          frame->phase = HCL_PATH_PHASE_DONE;
+
+          if (step->name)
+            value = hcl_value_is_object (value)
+                    ? hcl_value_object_get_member_interned (value, step->name)
+                    : NULL;
+        } else if (step->name) {
+          value = frame->kind == HCL_PATH_NODE_DOCUMENT
+                  ? hcl_document_get_attribute_interned (frame->input, step->name)
+                  : hcl_block_get_attribute_interned (frame->input, step->name);
+          frame->phase = HCL_PATH_PHASE_BLOCKS;
+        } else {
+          /* Selectors after a block have nothing to pick from */
+          frame->phase = HCL_PATH_PHASE_DONE;
+        }
+
+        if (hcl_path_frame_select (step, frame, value, (HclValue **) match)) {
+          *kind = HCL_PATH_NODE_VALUE;
+          return TRUE;
+        }
+        break;
+      }
+
+      case HCL_PATH_PHASE_EXPAND: {
+        HclValue *value = frame->expanding;
+
+        if (hcl_value_is_list (value)) {
+          *match = hcl_value_list_get_item (value, frame->index++);
+        } else if (!hcl_map_iter_next (&frame->members, NULL, match)) {
+          *match = NULL;
+        }
+
+        if (*match) {
+          *kind = HCL_PATH_NODE_VALUE;
+          return TRUE;
+        }
+
+        frame->phase = frame->kind == HCL_PATH_NODE_VALUE
+                       ? HCL_PATH_PHASE_DONE
+                       : HCL_PATH_PHASE_BLOCKS;
+        break;
+      }
+
+      case HCL_PATH_PHASE_BLOCKS: {
+        HclBlockList *list = hcl_path_frame_block_list (frame);
+
+        frame->phase = HCL_PATH_PHASE_DONE;
+
+        if (step->select == HCL_PATH_SELECT_KEY) {
+          *match = hcl_block_list_get_by_label (list, step->name, step->key);
+        } else {
+          hcl_block_list_iter_init (list, &frame->blocks, step->name);
+
+          if (step->select != HCL_PATH_SELECT_INDEX) {
+            frame->phase = HCL_PATH_PHASE_BLOCK_ITER;
+            break;
+          }
+
+          *match = NULL;
+          for (guint i = 0; i <= step->index; i++) {
+            if (!hcl_block_iter_next (&frame->blocks, (HclBlock **) match)) {
+              *match = NULL;
+              break;
+            }
+          }
+        }
+
+        if (*match) {
+          *kind = HCL_PATH_NODE_BLOCK;
+          return TRUE;
+        }
+        break;
+      }
+
+      case HCL_PATH_PHASE_BLOCK_ITER:
+        if (hcl_block_iter_next (&frame->blocks, (HclBlock **) match)) {
+          *kind = HCL_PATH_NODE_BLOCK;
+          return TRUE;
+        }
+        frame->phase = HCL_PATH_PHASE_DONE;
+        break;
+
+      case HCL_PATH_PHASE_DONE:
+      default:
+        return FALSE;
+    }
+  }
+}
+
+static void
+hcl_path_iter_start (HclPathIter *iter, HclPath *path, HclPathNodeKind kind, gpointer root)
+{
+  HclRealPathIter *real = (HclRealPathIter *) iter;
+  HclPathFrame *frames;
+
+  /* Borrow the spare frames if no other iterator has them */
+  frames = g_atomic_pointer_get (&path->spare_frames);
+  if (!frames || !g_atomic_pointer_compare_and_exchange (&path->spare_frames, frames, NULL))
+    frames = g_new (HclPathFrame, path->n_steps);
+
+  real->path = g_object_ref (path);
+  real->frames = frames;
+  real->depth = 0;
+
+  frames[0].kind = kind;
+  frames[0].input = root;
+  frames[0].phase = HCL_PATH_PHASE_START;
+}
+
+/**
+ * hcl_path_iter_init:
+ * @iter: an uninitialized #HclPathIter
+ * @path: an #HclPath
+ * @document: the document to evaluate @path against
+ *
+ * Initializes @iter to walk the matches of @path in @document. Walk it
+ * with hcl_path_iter_next(), and call hcl_path_iter_clear() if you stop
+ * before it is exhausted.
+ *
+ * |[<!-- language="C" -->
+ * g_auto(HclPathIter) iter = { 0 };
+ * HclValue *title;
+ *
+ * hcl_path_iter_init (&iter, path, document);
+ * while (hcl_path_iter_next (&iter, NULL, &title))
+ *   add_title (hcl_value_get_string (title));
+ * ]|
+ *
+ * @document must not be modified while @iter is in use.
+ */
+void
+hcl_path_iter_init (HclPathIter *iter, HclPath *path, HclDocument *document)
+{
+  g_return_if_fail (iter != NULL);
+  g_return_if_fail (HCL_IS_PATH (path));
+  g_return_if_fail (HCL_IS_DOCUMENT (document));
+
+  hcl_path_iter_start (iter, path, HCL_PATH_NODE_DOCUMENT, document);
+}
+
+/**
+ * hcl_path_iter_init_block:
+ * @iter: an uninitialized #HclPathIter
+ * @path: an #HclPath
+ * @block: the block to evaluate @path against
+ *
+ * Like hcl_path_iter_init(), with names in the first step of @path
+ * matched against the attributes and child blocks of @block.
+ */
+void
+hcl_path_iter_init_block (HclPathIter *iter, HclPath *path, HclBlock *block)
+{
+  g_return_if_fail (iter != NULL);
+  g_return_if_fail (HCL_IS_PATH (path));
+  g_return_if_fail (HCL_IS_BLOCK (block));
+
+  hcl_path_iter_start (iter, path, HCL_PATH_NODE_BLOCK, block);
+}
+
+/**
+ * hcl_path_iter_next:
+ * @iter: an #HclPathIter
+ * @block: (out) (optional) (nullable) (transfer none): return location
+ *   for a block match
+ * @value: (out) (optional) (nullable) (transfer none): return location
+ *   for a value match
+ *
+ * Advances @iter to the next match. A match is either a block or a
+ * value; the location for the other kind is set to %NULL. Passing %NULL
+ * for @block or @value skips matches of that kind.
+ *
+ * Returns: %FALSE once there are no more matches
+ */
+gboolean
+hcl_path_iter_next (HclPathIter *iter, HclBlock **block, HclValue **value)
+{
+  HclRealPathIter *real = (HclRealPathIter *) iter;
+  HclPathNodeKind kind;
+  gpointer match;
+
+  g_return_val_if_fail (iter != NULL, FALSE);
+
+  while (real->depth >= 0) {
+    HclPathFrame *frame = &real->frames[real->depth];
+    HclPathFrame *next;
+
+    if (!hcl_path_frame_next (&real->path->steps[real->depth], frame, &kind, &match)) {
+      real->depth--;
+      continue;
+    }
+
+    if ((guint) real->depth + 1 == real->path->n_steps) {
+      if (kind == HCL_PATH_NODE_BLOCK ? !block : !value)
+        continue;
+
+      if (block)
+        *block = kind == HCL_PATH_NODE_BLOCK ? match : NULL;
+      if (value)
+        *value = kind == HCL_PATH_NODE_VALUE ? match : NULL;
+
+      return TRUE;
+    }
+
+    next = &real->frames[++real->depth];
+    next->kind = kind;
+    next->input = match;
+    next->phase = HCL_PATH_PHASE_START;
+  }
+
+  hcl_path_iter_clear (iter);
+
+  return FALSE;
+}
+
+/**
+ * hcl_path_iter_clear:
+ * @iter: an #HclPathIter
+ *
+ * Releases what @iter holds. This happens by itself once
+ * hcl_path_iter_next() returns %FALSE, and clearing an iterator twice is
+ * harmless.
+ */
+void
+hcl_path_iter_clear (HclPathIter *iter)
+{
+  HclRealPathIter *real = (HclRealPathIter *) iter;
+
+  g_return_if_fail (iter != NULL);
+
+  if (!real->path)
+    return;
+
+  /* Give the frames back unless another iterator already did */
+  if (!g_atomic_pointer_compare_and_exchange (&real->path->spare_frames, NULL, real->frames))
+    g_free (real->frames);
+
+  real->frames = NULL;
+  real->depth = -1;
+  g_clear_object (&real->path);
+}
+
+/**
+ * hcl_path_get_value:
+ * @path: an #HclPath
+ * @document: an #HclDocument
+ *
+ * Finds the first value @path matches in @document.
+ *
+ * Returns: (transfer none) (nullable): the first matching value, or %NULL
+ */
+HclValue *
+hcl_path_get_value (HclPath *path, HclDocument *document)
+{
+  g_auto(HclPathIter) iter = { 0 };
+  HclValue *value = NULL;
+
+  g_return_val_if_fail (HCL_IS_PATH (path), NULL);
+  g_return_val_if_fail (HCL_IS_DOCUMENT (document), NULL);
+
+  hcl_path_iter_init (&iter, path, document);
+  hcl_path_iter_next (&iter, NULL, &value);
+
+  return value;
+}
+
+/**
+ * hcl_path_get_block:
+ * @path: an #HclPath
+ * @document: an #HclDocument
+ *
+ * Finds the first block @path matches in @document.
+ *
+ * Returns: (transfer none) (nullable): the first matching block, or %NULL
+ */
+HclBlock *
+hcl_path_get_block (HclPath *path, HclDocument *document)
+{
+  g_auto(HclPathIter) iter = { 0 };
+  HclBlock *block = NULL;
+
+  g_return_val_if_fail (HCL_IS_PATH (path), NULL);
+  g_return_val_if_fail (HCL_IS_DOCUMENT (document), NULL);
+
+  hcl_path_iter_init (&iter, path, document);
+  hcl_path_iter_next (&iter, &block, NULL);
+
+  return block;
+}
@@ -0,0 +1,66 @@
+/* hcl-path.h - Compiled path expressions over HCL documents
+ *
+ * Copyright 2024 Geoff Johnson <geoff.jay@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ */
+
+#ifndef __HCL_PATH_H__
+#define __HCL_PATH_H__
+
+#include <glib-object.h>
+#include "hcl-document.h"
+#include "hcl-enums.h"
+
+G_BEGIN_DECLS
+
+#define HCL_TYPE_PATH (hcl_path_get_type())
+G_DECLARE_FINAL_TYPE (HclPath, hcl_path, HCL, PATH, GObject)
+
+/**
+ * HclPathIter:
+ *
+ * A stack-allocated iterator over the matches of an #HclPath. Initialize
+ * it with hcl_path_iter_init() or hcl_path_iter_init_block(). All fields
+ * are private.
+ */
+typedef struct {
+  /*< private >*/
+  gpointer dummy1;
+  gpointer dummy2;
+  gint dummy3;
+} HclPathIter;
+
+/* Constructor */
+HclPath        *hcl_path_new                    (const gchar *expression,
+                                                 GError **error);
+
+/* Properties */
+const gchar    *hcl_path_get_expression         (HclPath *path);
+
+/* Evaluation */
+void            hcl_path_iter_init              (HclPathIter *iter,
+                                                 HclPath *path,
+                                                 HclDocument *document);
+void            hcl_path_iter_init_block        (HclPathIter *iter,
+                                                 HclPath *path,
+                                                 HclBlock *block);
+gboolean        hcl_path_iter_next              (HclPathIter *iter,
+                                                 HclBlock **block,
+                                                 HclValue **value);
+void            hcl_path_iter_clear             (HclPathIter *iter);
+
+/* Convenience */
+HclValue       *hcl_path_get_value              (HclPath *path,
+                                                 HclDocument *document);
+HclBlock       *hcl_path_get_block              (HclPath *path,
+                                                 HclDocument *document);
+
+G_DEFINE_AUTO_CLEANUP_CLEAR_FUNC (HclPathIter, hcl_path_iter_clear)
+
+G_END_DECLS
+
+#endif /* __HCL_PATH_H__ */
@@ -0,0 +1,255 @@
+/* hcl-private.h - Internal interfaces shared between libghcl modules
+ *
+ * Copyright 2024 Geoff Johnson <geoff.jay@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ */
+
+#ifndef __HCL_PRIVATE_H__
+#define __HCL_PRIVATE_H__
+
+#include "hcl-document.h"
+#include "hcl-lexer.h"
+#include "hcl-parser.h"
+
+G_BEGIN_DECLS
+
+/* Not installed; nothing in here is part of the public API */
+
+/*
+ * Attribute names, object keys and block types are interned with
+ * g_intern_string(), so each distinct key is stored once and the parser
+ * and the cache can match keys by pointer. Names handed to the public
+ * lookups are matched on their contents instead: asking the intern table
+ * takes a lock every thread shares, which readers of a sealed document
+ * must not need, and a name that was never interned simply matches
+ * nothing.
+ */
+
+/* hcl-map.c */
+typedef struct {
+  const gchar *key;        /* Interned */
+  gpointer value;          /* HclValue*, owned */
+} HclMapEntry;
+
+typedef struct _HclMap HclMap;
+
+typedef struct {
+  HclMap *map;
+  guint index;
+} HclMapIter;
+
+HclMap         *hcl_map_new                     (void);
+HclMap         *hcl_map_ref                     (HclMap *map);
+void            hcl_map_unref                   (HclMap *map);
+HclMap         *hcl_map_copy                    (HclMap *map);
+guint           hcl_map_get_size                (HclMap *map);
+gpointer        hcl_map_lookup                  (HclMap *map,
+                                                 const gchar *key);
+gpointer        hcl_map_lookup_string           (HclMap *map,
+                                                 const gchar *key);
+void            hcl_map_insert                  (HclMap *map,
+                                                 const gchar *key,
+                                                 gpointer value);
+gpointer        hcl_map_replace                 (HclMap *map,
+                                                 const gchar *key,
+                                                 gpointer value);
+GList          *hcl_map_get_keys                (HclMap *map);
+void            hcl_map_iter_init               (HclMapIter *iter,
+                                                 HclMap *map);
+gboolean        hcl_map_iter_next               (HclMapIter *iter,
+                                                 const gchar **key,
+                                                 gpointer *value);
+
+/* hcl-hash.c */
+
+/*
+ * Values, blocks and documents cache a 64-bit hash of their contents.
+ * A mutable list, object or block remembers the container it was added
+ * to, so a change clears the cached hashes of its ancestors and nothing
+ * else. Frozen values, sealed blocks and scalars never change, and need
+ * no parent.
+ *
+ * A mutable node added to a second container cannot clear both, so it
+ * is marked shared, and a change below it moves the hash epoch instead.
+ * A cache of a node that can still change holds only for the epoch it
+ * was computed in.
+ */
+typedef enum {
+  HCL_PARENT_NONE,
+  HCL_PARENT_VALUE,
+  HCL_PARENT_BLOCK,
+  HCL_PARENT_DOCUMENT
+} HclParentKind;
+
+#define HCL_HASH_SEED G_GUINT64_CONSTANT (0x9E3779B97F4A7C15)
+
+/* The splitmix64 finalizer */
+static inline guint64
+hcl_hash_mix (guint64 hash)
+{
+  hash ^= hash >> 30;
+  hash *= G_GUINT64_CONSTANT (0xBF58476D1CE4E5B9);
+  hash ^= hash >> 27;
+  hash *= G_GUINT64_CONSTANT (0x94D049BB133111EB);
+  hash ^= hash >> 31;
+
+  return hash;
+}
+
+/* Folds @value into @hash, so that the order values come in counts */
+static inline guint64
+hcl_hash_combine (guint64 hash, guint64 value)
+{
+  return hcl_hash_mix (hash ^ (value + HCL_HASH_SEED + (hash << 6) + (hash >> 2)));
+}
+
+guint64         hcl_hash_string                 (const gchar *string);
+guint64         hcl_hash_number                 (HclNumberType number_type,
+                                                 gint64 int_value,
+                                                 gdouble double_value);
+guint64         hcl_hash_attributes             (HclMap *attributes);
+guint           hcl_hash_get_epoch              (void);
+void            hcl_hash_invalidate             (gpointer node,
+                                                 HclParentKind kind);
+
+/* hcl-block-list.c */
+typedef struct {
+  GPtrArray *blocks;       /* Array of HclBlock*, owned */
+  GHashTable *by_type;     /* Interned type -> bucket, built on demand */
+  gboolean sealed;         /* Indexed in full and no longer changing */
+  gpointer owner;          /* The HclBlock or HclDocument holding the list */
+  HclParentKind owner_kind;
+} HclBlockList;
+
+void            hcl_block_list_init             (HclBlockList *list,
+                                                 gpointer owner,
+                                                 HclParentKind owner_kind);
+void            hcl_block_list_clear            (HclBlockList *list);
+void            hcl_block_list_add              (HclBlockList *list,
+                                                 HclBlock *block);
+GList          *hcl_block_list_get_all          (HclBlockList *list);
+GList          *hcl_block_list_get_by_type      (HclBlockList *list,
+                                                 const gchar *type);
+HclBlock       *hcl_block_list_get_by_label     (HclBlockList *list,
+                                                 const gchar *type,
+                                                 const gchar *label);
+void            hcl_block_list_iter_init        (HclBlockList *list,
+                                                 HclBlockIter *iter,
+                                                 const gchar *type);
+void            hcl_block_list_seal             (HclBlockList *list);
+void            hcl_block_list_forget_labels    (HclBlockList *list,
+                                                 const gchar *type);
+void            hcl_block_list_add_bucket       (HclBlockList *list,
+                                                 const gchar *type,
+                                                 const guint32 *positions,
+                                                 guint n_positions);
+
+/* hcl-block.c */
+HclBlock       *hcl_block_new_interned          (const gchar *type,
+                                                 gchar *label);
+guint           hcl_block_get_label_epoch       (void);
+HclValue       *hcl_block_get_attribute_interned (HclBlock *block,
+                                                  const gchar *name);
+HclBlockList   *hcl_block_get_block_list        (HclBlock *block);
+gboolean        hcl_block_seal                  (HclBlock *block);
+void            hcl_block_set_parent            (HclBlock *block,
+                                                 gpointer parent,
+                                                 HclParentKind kind);
+void            hcl_block_unset_parent          (HclBlock *block,
+                                                 gpointer parent);
+gboolean        hcl_block_forget_hash           (HclBlock *block,
+                                                 gpointer *parent,
+                                                 HclParentKind *kind);
+void            hcl_block_attribute_iter_init   (HclBlock *block,
+                                                 HclMapIter *iter);
+void            hcl_block_set_attribute_interned (HclBlock *block,
+                                                  const gchar *name,
+                                                  HclValue *value);
+
+/* hcl-document.c */
+typedef struct {
+  gsize offset;            /* Of the first token, in the parsed text */
+  const gchar *name;       /* Interned attribute name, NULL for a block */
+  gpointer node;           /* HclValue* or HclBlock*, owned */
+} HclStatement;
+
+void            hcl_document_set_attribute_interned (HclDocument *document,
+                                                     const gchar *name,
+                                                     HclValue *value);
+HclValue       *hcl_document_get_attribute_interned (HclDocument *document,
+                                                     const gchar *name);
+HclBlockList   *hcl_document_get_block_list     (HclDocument *document);
+void            hcl_document_attribute_iter_init (HclDocument *document,
+                                                  HclMapIter *iter);
+void            hcl_document_add_statement      (HclDocument *document,
+                                                 gsize offset,
+                                                 const gchar *name,
+                                                 gpointer node);
+GArray         *hcl_document_get_statements     (HclDocument *document);
+void            hcl_document_forget_hash        (HclDocument *document);
+
+/* hcl-lexer.c */
+void            hcl_lexer_reset                 (HclLexer *lexer,
+                                                 const gchar *input,
+                                                 gsize length,
+                                                 gsize line,
+                                                 gsize column);
+void            hcl_lexer_span_copy_value       (HclLexer *lexer,
+                                                 const HclSpanToken *token,
+                                                 GString *buffer);
+const gchar    *hcl_lexer_span_intern           (HclLexer *lexer,
+                                                 const HclSpanToken *token);
+gboolean        hcl_lexer_recover               (HclLexer *lexer,
+                                                 HclSpanToken *span);
+
+/* hcl-value.c */
+void            hcl_value_object_set_member_interned (HclValue *value,
+                                                      const gchar *key,
+                                                      HclValue *member);
+HclValue       *hcl_value_object_get_member_interned (HclValue *value,
+                                                      const gchar *key);
+guint           hcl_value_object_get_size       (HclValue *value);
+gboolean        hcl_value_list_add_number       (HclValue *value,
+                                                 HclNumberType number_type,
+                                                 gint64 int_value,
+                                                 gdouble double_value);
+void            hcl_value_object_iter_init      (HclValue *value,
+                                                 HclMapIter *iter);
+void            hcl_value_set_parent            (HclValue *value,
+                                                 gpointer parent,
+                                                 HclParentKind kind);
+void            hcl_value_unset_parent          (HclValue *value,
+                                                 gpointer parent);
+gboolean        hcl_value_forget_hash           (HclValue *value,
+                                                 gpointer *parent,
+                                                 HclParentKind *kind);
+void            hcl_value_map_insert            (HclMap *map,
+                                                 const gchar *key,
+                                                 HclValue *value,
+                                                 gpointer parent,
+                                                 HclParentKind kind);
+
+/* hcl-parser.c */
+GBytes         *hcl_file_load                   (const gchar *filename,
+                                                 GError **error);
+HclDocument    *hcl_parser_parse_text           (HclParser *parser,
+                                                 const gchar *input,
+                                                 gsize length,
+                                                 gsize line,
+                                                 gsize column,
+                                                 GError **error);
+gboolean        hcl_parser_parse_block_text     (HclParser *parser,
+                                                 const gchar *input,
+                                                 gsize length,
+                                                 gsize line,
+                                                 gsize column,
+                                                 HclBlock *block,
+                                                 GError **error);
+
+G_END_DECLS
+
+#endif /* __HCL_PRIVATE_H__ */
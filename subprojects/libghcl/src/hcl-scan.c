@@ -0,0 +1,448 @@
+/* hcl-scan.c - Bulk character class scanners for the HCL lexer
+ *
+ * Copyright 2024 Geoff Johnson <geoff.jay@gmail.com>
+ */
+
+#include "hcl-scan.h"
+#include <string.h>
+
+/*
+ * The lexer spends most of its time in a handful of loops: skipping
+ * blanks between tokens, reading identifiers, reading string bodies and
+ * reading comments up to the end of the line. The scanners below
+ * replace those byte-at-a-time loops.
+ *
+ * SSE2 is part of the x86-64 baseline so it is selected at compile time.
+ * AVX2 is not, so it is compiled with a target attribute and selected at
+ * run time when the CPU supports it. Every other platform uses the
+ * scalar loops.
+ */
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define HCL_SCAN_HAVE_SSE2 1
+#endif
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#define HCL_SCAN_HAVE_AVX2 1
+#define HCL_SCAN_AVX2_FUNC __attribute__((target ("avx2")))
+#endif
+
+static inline gboolean
+hcl_scan_is_whitespace (guchar c)
+{
+  return c == ' ' || c == '\t' || c == '\r';
+}
+
+static inline gboolean
+hcl_scan_is_identifier (guchar c)
+{
+  return g_ascii_isalnum (c) || c == '_' || c == '-';
+}
+
+gsize
+hcl_scan_whitespace_scalar (const gchar *data, gsize length)
+{
+  gsize i = 0;
+
+  while (i < length && hcl_scan_is_whitespace ((guchar) data[i]))
+    i++;
+
+  return i;
+}
+
+gsize
+hcl_scan_identifier_scalar (const gchar *data, gsize length)
+{
+  gsize i = 0;
+
+  while (i < length && hcl_scan_is_identifier ((guchar) data[i]))
+    i++;
+
+  return i;
+}
+
+gsize
+hcl_scan_line_scalar (const gchar *data, gsize length)
+{
+  gsize i = 0;
+
+  while (i < length && data[i] != '\n')
+    i++;
+
+  return i;
+}
+
+gsize
+hcl_scan_string_scalar (const gchar *data, gsize length, gchar quote)
+{
+  gsize i = 0;
+
+  while (i < length && data[i] != quote && data[i] != '\\')
+    i++;
+
+  return i;
+}
+
+gsize
+hcl_scan_count_newlines_scalar (const gchar *data, gsize length, gsize *last_newline)
+{
+  gsize count = 0;
+  gsize i;
+
+  for (i = 0; i < length; i++) {
+    if (data[i] == '\n') {
+      count++;
+      if (last_newline)
+        *last_newline = i;
+    }
+  }
+
+  return count;
+}
+
+#ifdef HCL_SCAN_HAVE_SSE2
+/* Bit i of the result is set when byte i of @v belongs to the class */
+static inline guint
+hcl_scan_sse2_whitespace_mask (__m128i v)
+{
+  __m128i m = _mm_or_si128 (_mm_or_si128 (_mm_cmpeq_epi8 (v, _mm_set1_epi8 (' ')),
+                                          _mm_cmpeq_epi8 (v, _mm_set1_epi8 ('\t'))),
+                            _mm_cmpeq_epi8 (v, _mm_set1_epi8 ('\r')));
+
+  return (guint) _mm_movemask_epi8 (m);
+}
+
+static inline __m128i
+hcl_scan_sse2_in_range (__m128i v, gchar lo, gchar hi)
+{
+  /* Signed compares; bytes >= 0x80 are negative and never match */
+  return _mm_and_si128 (_mm_cmpgt_epi8 (v, _mm_set1_epi8 ((gchar) (lo - 1))),
+                        _mm_cmplt_epi8 (v, _mm_set1_epi8 ((gchar) (hi + 1))));
+}
+
+static inline guint
+hcl_scan_sse2_identifier_mask (__m128i v)
+{
+  __m128i lower = _mm_or_si128 (v, _mm_set1_epi8 (0x20));
+  __m128i m = _mm_or_si128 (hcl_scan_sse2_in_range (lower, 'a', 'z'),
+                            hcl_scan_sse2_in_range (v, '0', '9'));
+
+  m = _mm_or_si128 (m, _mm_cmpeq_epi8 (v, _mm_set1_epi8 ('_')));
+  m = _mm_or_si128 (m, _mm_cmpeq_epi8 (v, _mm_set1_epi8 ('-')));
+
+  return (guint) _mm_movemask_epi8 (m);
+}
+
+static inline guint
+hcl_scan_sse2_newline_mask (__m128i v)
+{
+  return (guint) _mm_movemask_epi8 (_mm_cmpeq_epi8 (v, _mm_set1_epi8 ('\n')));
+}
+
+#define HCL_SCAN_DEFINE_SSE2_RUN(name, mask_func, scalar_func)              \
+  static gsize                                                              \
+  name (const gchar *data, gsize length)                                    \
+  {                                                                         \
+    gsize i;                                                                \
+                                                                            \
+    for (i = 0; i + 16 <= length; i += 16) {                                \
+      __m128i v = _mm_loadu_si128 ((const __m128i *) (const void *) (data + i)); \
+      guint outside = mask_func (v) ^ 0xFFFFu;                              \
+      if (outside != 0)                                                     \
+        return i + (gsize) __builtin_ctz (outside);                         \
+    }                                                                       \
+                                                                            \
+    return i + scalar_func (data + i, length - i);                          \
+  }
+
+HCL_SCAN_DEFINE_SSE2_RUN (hcl_scan_whitespace_sse2,
+                          hcl_scan_sse2_whitespace_mask,
+                          hcl_scan_whitespace_scalar)
+HCL_SCAN_DEFINE_SSE2_RUN (hcl_scan_identifier_sse2,
+                          hcl_scan_sse2_identifier_mask,
+                          hcl_scan_identifier_scalar)
+
+static gsize
+hcl_scan_string_sse2 (const gchar *data, gsize length, gchar quote)
+{
+  __m128i q = _mm_set1_epi8 (quote);
+  __m128i backslash = _mm_set1_epi8 ('\\');
+  gsize i;
+
+  for (i = 0; i + 16 <= length; i += 16) {
+    __m128i v = _mm_loadu_si128 ((const __m128i *) (const void *) (data + i));
+    guint stop = (guint) _mm_movemask_epi8 (_mm_or_si128 (_mm_cmpeq_epi8 (v, q),
+                                                          _mm_cmpeq_epi8 (v, backslash)));
+    if (stop != 0)
+      return i + (gsize) __builtin_ctz (stop);
+  }
+
+  return i + hcl_scan_string_scalar (data + i, length - i, quote);
+}
+
+static gsize
+hcl_scan_count_newlines_sse2 (const gchar *data, gsize length, gsize *last_newline)
+{
+  gsize count = 0;
+  gsize i;
+
+  for (i = 0; i + 16 <= length; i += 16) {
+    __m128i v = _mm_loadu_si128 ((const __m128i *) (const void *) (data + i));
+    guint mask = hcl_scan_sse2_newline_mask (v);
+
+    if (mask != 0) {
+      count += (gsize) __builtin_popcount (mask);
+      if (last_newline)
+        *last_newline = i + 31 - (gsize) __builtin_clz (mask);
+    }
+  }
+
+  if (i < length) {
+    gsize tail_last;
+    gsize tail = hcl_scan_count_newlines_scalar (data + i, length - i, &tail_last);
+
+    if (tail > 0) {
+      count += tail;
+      if (last_newline)
+        *last_newline = i + tail_last;
+    }
+  }
+
+  return count;
+}
+#endif /* HCL_SCAN_HAVE_SSE2 */
+
+#ifdef HCL_SCAN_HAVE_AVX2
+static inline HCL_SCAN_AVX2_FUNC __m256i
+hcl_scan_avx2_in_range (__m256i v, gchar lo, gchar hi)
+{
+  return _mm256_and_si256 (_mm256_cmpgt_epi8 (v, _mm256_set1_epi8 ((gchar) (lo - 1))),
+                           _mm256_cmpgt_epi8 (_mm256_set1_epi8 ((gchar) (hi + 1)), v));
+}
+
+static inline HCL_SCAN_AVX2_FUNC guint
+hcl_scan_avx2_whitespace_mask (__m256i v)
+{
+  __m256i m = _mm256_or_si256 (_mm256_or_si256 (_mm256_cmpeq_epi8 (v, _mm256_set1_epi8 (' ')),
+                                                _mm256_cmpeq_epi8 (v, _mm256_set1_epi8 ('\t'))),
+                               _mm256_cmpeq_epi8 (v, _mm256_set1_epi8 ('\r')));
+
+  return (guint) _mm256_movemask_epi8 (m);
+}
+
+static inline HCL_SCAN_AVX2_FUNC guint
+hcl_scan_avx2_identifier_mask (__m256i v)
+{
+  __m256i lower = _mm256_or_si256 (v, _mm256_set1_epi8 (0x20));
+  __m256i m = _mm256_or_si256 (hcl_scan_avx2_in_range (lower, 'a', 'z'),
+                               hcl_scan_avx2_in_range (v, '0', '9'));
+
+  m = _mm256_or_si256 (m, _mm256_cmpeq_epi8 (v, _mm256_set1_epi8 ('_')));
+  m = _mm256_or_si256 (m, _mm256_cmpeq_epi8 (v, _mm256_set1_epi8 ('-')));
+
+  return (guint) _mm256_movemask_epi8 (m);
+}
+
+#define HCL_SCAN_DEFINE_AVX2_RUN(name, mask_func, tail_func)                \
+  static HCL_SCAN_AVX2_FUNC gsize                                           \
+  name (const gchar *data, gsize length)                                    \
+  {                                                                         \
+    gsize i;                                                                \
+                                                                            \
+    for (i = 0; i + 32 <= length; i += 32) {                                \
+      __m256i v = _mm256_loadu_si256 ((const __m256i *) (const void *) (data + i)); \
+      guint outside = ~mask_func (v);                                       \
+      if (outside != 0)                                                     \
+        return i + (gsize) __builtin_ctz (outside);                         \
+    }                                                                       \
+                                                                            \
+    return i + tail_func (data + i, length - i);                            \
+  }
+
+HCL_SCAN_DEFINE_AVX2_RUN (hcl_scan_whitespace_avx2,
+                          hcl_scan_avx2_whitespace_mask,
+                          hcl_scan_whitespace_sse2)
+HCL_SCAN_DEFINE_AVX2_RUN (hcl_scan_identifier_avx2,
+                          hcl_scan_avx2_identifier_mask,
+                          hcl_scan_identifier_sse2)
+
+static HCL_SCAN_AVX2_FUNC gsize
+hcl_scan_string_avx2 (const gchar *data, gsize length, gchar quote)
+{
+  __m256i q = _mm256_set1_epi8 (quote);
+  __m256i backslash = _mm256_set1_epi8 ('\\');
+  gsize i;
+
+  for (i = 0; i + 32 <= length; i += 32) {
+    __m256i v = _mm256_loadu_si256 ((const __m256i *) (const void *) (data + i));
+    guint stop = (guint) _mm256_movemask_epi8 (_mm256_or_si256 (_mm256_cmpeq_epi8 (v, q),
+                                                                _mm256_cmpeq_epi8 (v, backslash)));
+    if (stop != 0)
+      return i + (gsize) __builtin_ctz (stop);
+  }
+
+  return i + hcl_scan_string_sse2 (data + i, length - i, quote);
+}
+
+static HCL_SCAN_AVX2_FUNC gsize
+hcl_scan_count_newlines_avx2 (const gchar *data, gsize length, gsize *last_newline)
+{
+  __m256i newline = _mm256_set1_epi8 ('\n');
+  gsize count = 0;
+  gsize i;
+
+  for (i = 0; i + 32 <= length; i += 32) {
+    __m256i v = _mm256_loadu_si256 ((const __m256i *) (const void *) (data + i));
+    guint mask = (guint) _mm256_movemask_epi8 (_mm256_cmpeq_epi8 (v, newline));
+
+    if (mask != 0) {
+      count += (gsize) __builtin_popcount (mask);
+      if (last_newline)
+        *last_newline = i + 31 - (gsize) __builtin_clz (mask);
+    }
+  }
+
+  if (i < length) {
+    gsize tail_last;
+    gsize tail = hcl_scan_count_newlines_sse2 (data + i, length - i, &tail_last);
+
+    if (tail > 0) {
+      count += tail;
+      if (last_newline)
+        *last_newline = i + tail_last;
+    }
+  }
+
+  return count;
+}
+
+static gboolean
+hcl_scan_have_avx2 (void)
+{
+  static gsize initialized = 0;
+  static gboolean have_avx2 = FALSE;
+
+  if (g_once_init_enter (&initialized)) {
+    __builtin_cpu_init ();
+    have_avx2 = __builtin_cpu_supports ("avx2") != 0;
+    g_once_init_leave (&initialized, 1);
+  }
+
+  return have_avx2;
+}
+#endif /* HCL_SCAN_HAVE_AVX2 */
+
+/**
+ * hcl_scan_whitespace:
+ * @data: bytes to scan
+ * @length: number of bytes available at @data
+ *
+ * Returns: the length of the leading run of blanks
+ */
+gsize
+hcl_scan_whitespace (const gchar *data, gsize length)
+{
+  /* Most runs are a single space; don't bother with vectors for those */
+  if (length < 16 || !hcl_scan_is_whitespace ((guchar) data[1]))
+    return hcl_scan_whitespace_scalar (data, length);
+
+#if defined(HCL_SCAN_HAVE_AVX2)
+  if (length >= 32 && hcl_scan_have_avx2 ())
+    return hcl_scan_whitespace_avx2 (data, length);
+#endif
+#if defined(HCL_SCAN_HAVE_SSE2)
+  return hcl_scan_whitespace_sse2 (data, length);
+#else
+  return hcl_scan_whitespace_scalar (data, length);
+#endif
+}
+
+/**
+ * hcl_scan_identifier:
+ * @data: bytes to scan
+ * @length: number of bytes available at @data
+ *
+ * Returns: the length of the leading run of identifier characters
+ */
+gsize
+hcl_scan_identifier (const gchar *data, gsize length)
+{
+  if (length < 16)
+    return hcl_scan_identifier_scalar (data, length);
+
+#if defined(HCL_SCAN_HAVE_AVX2)
+  if (length >= 32 && hcl_scan_have_avx2 ())
+    return hcl_scan_identifier_avx2 (data, length);
+#endif
+#if defined(HCL_SCAN_HAVE_SSE2)
+  return hcl_scan_identifier_sse2 (data, length);
+#else
+  return hcl_scan_identifier_scalar (data, length);
+#endif
+}
+
+/**
+ * hcl_scan_line:
+ * @data: bytes to scan
+ * @length: number of bytes available at @data
+ *
+ * Returns: the offset of the first newline, or @length
+ */
+gsize
+hcl_scan_line (const gchar *data, gsize length)
+{
+  /* The C library already ships a vectorized byte search */
+  const gchar *newline = memchr (data, '\n', length);
+
+  return newline ? (gsize) (newline - data) : length;
+}
+
+/**
+ * hcl_scan_string:
+ * @data: bytes to scan
+ * @length: number of bytes available at @data
+ * @quote: the quote character that opened the literal
+ *
+ * Returns: the offset of the first @quote or backslash, or @length
+ */
+gsize
+hcl_scan_string (const gchar *data, gsize length, gchar quote)
+{
+  if (length < 16)
+    return hcl_scan_string_scalar (data, length, quote);
+
+#if defined(HCL_SCAN_HAVE_AVX2)
+  if (length >= 32 && hcl_scan_have_avx2 ())
+    return hcl_scan_string_avx2 (data, length, quote);
+#endif
+#if defined(HCL_SCAN_HAVE_SSE2)
+  return hcl_scan_string_sse2 (data, length, quote);
+#else
+  return hcl_scan_string_scalar (data, length, quote);
+#endif
+}
+
+/**
+ * hcl_scan_count_newlines:
+ * @data: bytes to scan
+ * @length: number of bytes available at @data
+ * @last_newline: (out) (optional): offset of the last newline, left
+ *   untouched if there is none
+ *
+ * Returns: the number of newlines in @data
+ */
+gsize
+hcl_scan_count_newlines (const gchar *data, gsize length, gsize *last_newline)
+{
+#if defined(HCL_SCAN_HAVE_AVX2)
+  if (length >= 32 && hcl_scan_have_avx2 ())
+    return hcl_scan_count_newlines_avx2 (data, length, last_newline);
+#endif
+#if defined(HCL_SCAN_HAVE_SSE2)
+  return hcl_scan_count_newlines_sse2 (data, length, last_newline);
+#else
+  return hcl_scan_count_newlines_scalar (data, length, last_newline);
+#endif
+}
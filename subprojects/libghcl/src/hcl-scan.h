@@ -0,0 +1,59 @@
+/* hcl-scan.h - Bulk character class scanners for the HCL lexer
+ *
+ * Copyright 2024 Geoff Johnson <geoff.jay@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ */
+
+#ifndef __HCL_SCAN_H__
+#define __HCL_SCAN_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/*
+ * Private to libghcl. Each scanner looks at @data[0..@length) and returns
+ * the length of the leading run of its character class, classifying 16 or
+ * 32 bytes at a time where the CPU allows it. None of them reads past
+ * @data + @length.
+ */
+
+/* Leading run of ' ', '\t' and '\r' */
+gsize           hcl_scan_whitespace             (const gchar *data,
+                                                 gsize length);
+/* Leading run of [A-Za-z0-9_-] */
+gsize           hcl_scan_identifier             (const gchar *data,
+                                                 gsize length);
+/* Offset of the first '\n', or @length if there is none */
+gsize           hcl_scan_line                   (const gchar *data,
+                                                 gsize length);
+/* Offset of the first @quote or '\\', or @length if there is none */
+gsize           hcl_scan_string                 (const gchar *data,
+                                                 gsize length,
+                                                 gchar quote);
+/* Number of '\n' bytes; @last_newline gets the offset of the last one */
+gsize           hcl_scan_count_newlines         (const gchar *data,
+                                                 gsize length,
+                                                 gsize *last_newline);
+
+/* Byte-at-a-time reference implementations, for tests and benchmarks */
+gsize           hcl_scan_whitespace_scalar      (const gchar *data,
+                                                 gsize length);
+gsize           hcl_scan_identifier_scalar      (const gchar *data,
+                                                 gsize length);
+gsize           hcl_scan_line_scalar            (const gchar *data,
+                                                 gsize length);
+gsize           hcl_scan_string_scalar          (const gchar *data,
+                                                 gsize length,
+                                                 gchar quote);
+gsize           hcl_scan_count_newlines_scalar  (const gchar *data,
+                                                 gsize length,
+                                                 gsize *last_newline);
+
+G_END_DECLS
+
+#endif /* __HCL_SCAN_H__ */
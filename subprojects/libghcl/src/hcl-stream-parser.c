@@ -0,0 +1,804 @@
+/* hcl-stream-parser.c - Incremental HCL parser implementation
+ *
+ * Copyright 2024 Geoff Johnson <geoff.jay@gmail.com>
+ */
+
+#include "hcl-stream-parser.h"
+#include "hcl-lexer.h"
+#include "hcl-parser.h"
+#include "hcl-private.h"
+#include "hcl-scan.h"
+#include <string.h>
+
+/**
+ * SECTION:hcl-stream-parser
+ * @short_description: Incremental HCL parser
+ * @title: HclStreamParser
+ *
+ * #HclStreamParser parses HCL text that arrives in pieces, either pushed
+ * with hcl_stream_parser_feed() or pulled from a #GInputStream. Only the
+ * latest chunk and the statement left incomplete at its end are buffered,
+ * so memory use is bounded by the largest attribute rather than by the
+ * size of the input.
+ *
+ * Blocks are handed out through #HclStreamParser::block-parsed as soon as
+ * their closing brace has been read, innermost blocks first, so callers
+ * can act on the start of a large configuration before the rest of it
+ * has been read.
+ */
+
+typedef enum {
+  HCL_STREAM_STATE_CODE,
+  HCL_STREAM_STATE_STRING,
+  HCL_STREAM_STATE_COMMENT
+} HclStreamState;
+
+struct _HclStreamParser
+{
+  GObject parent_instance;
+
+  HclParser *parser;
+  HclLexer *lexer;         /* For block headers */
+  HclDocument *document;   /* Optional sink for completed statements */
+  gsize chunk_size;
+
+  GString *buffer;         /* Input not yet handed to the parser */
+  gsize statement_start;   /* Start of the pending statements in @buffer */
+  gsize statement_end;     /* End of the last complete one of them */
+  gsize scanned;           /* Bytes of @buffer the scanner has looked at */
+  gsize line;              /* Input position of @statement_start */
+  gsize column;
+
+  HclStreamState state;
+  gchar quote;
+  guint depth;             /* Open brackets and object braces */
+  gboolean has_assign;     /* Current statement has an '=' at depth 0 */
+  GPtrArray *open_blocks;  /* Stack of HclBlock* still waiting for '}' */
+};
+
+G_DEFINE_FINAL_TYPE (HclStreamParser, hcl_stream_parser, G_TYPE_OBJECT)
+
+#define HCL_STREAM_PARSER_DEFAULT_CHUNK_SIZE (64 * 1024)
+
+enum {
+  BLOCK_PARSED,
+  ATTRIBUTE_PARSED,
+  N_SIGNALS
+};
+
+static guint signals [N_SIGNALS];
+
+static void
+hcl_stream_parser_reset (HclStreamParser *self)
+{
+  g_string_truncate (self->buffer, 0);
+  self->statement_start = 0;
+  self->statement_end = 0;
+  self->scanned = 0;
+  self->line = 1;
+  self->column = 1;
+  self->state = HCL_STREAM_STATE_CODE;
+  self->quote = '\0';
+  self->depth = 0;
+  self->has_assign = FALSE;
+  g_ptr_array_set_size (self->open_blocks, 0);
+}
+
+static void
+hcl_stream_parser_finalize (GObject *object)
+{
+  HclStreamParser *self = HCL_STREAM_PARSER (object);
+
+  g_clear_object (&self->parser);
+  g_clear_object (&self->lexer);
+  g_clear_object (&self->document);
+  g_string_free (self->buffer, TRUE);
+  g_ptr_array_unref (self->open_blocks);
+
+  G_OBJECT_CLASS (hcl_stream_parser_parent_class)->finalize (object);
+}
+
+static void
+hcl_stream_parser_class_init (HclStreamParserClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = hcl_stream_parser_finalize;
+
+  /**
+   * HclStreamParser::block-parsed:
+   * @parser: the stream parser
+   * @block: the block that was completed
+   * @parent: (nullable): the block @block was added to, or %NULL for a
+   *   top-level block
+   *
+   * Emitted when the closing brace of a block has been read. Nested
+   * blocks are emitted before the blocks that contain them, and are
+   * already attached to @parent when the signal is emitted.
+   */
+  signals [BLOCK_PARSED] =
+    g_signal_new ("block-parsed",
+                  G_TYPE_FROM_CLASS (klass),
+                  G_SIGNAL_RUN_LAST,
+                  0,
+                  NULL, NULL,
+                  NULL,
+                  G_TYPE_NONE, 2,
+                  HCL_TYPE_BLOCK,
+                  HCL_TYPE_BLOCK);
+
+  /**
+   * HclStreamParser::attribute-parsed:
+   * @parser: the stream parser
+   * @name: the attribute name
+   * @value: the attribute value
+   *
+   * Emitted when a top-level attribute has been parsed. Attributes inside
+   * blocks are reported as part of their block.
+   */
+  signals [ATTRIBUTE_PARSED] =
+    g_signal_new ("attribute-parsed",
+                  G_TYPE_FROM_CLASS (klass),
+                  G_SIGNAL_RUN_LAST,
+                  0,
+                  NULL, NULL,
+                  NULL,
+                  G_TYPE_NONE, 2,
+                  G_TYPE_STRING,
+                  HCL_TYPE_VALUE);
+}
+
+static void
+hcl_stream_parser_init (HclStreamParser *self)
+{
+  self->parser = hcl_parser_new ();
+  self->lexer = hcl_lexer_new_with_length (NULL, 0);
+  self->chunk_size = HCL_STREAM_PARSER_DEFAULT_CHUNK_SIZE;
+  self->buffer = g_string_new (NULL);
+  self->open_blocks = g_ptr_array_new_with_free_func (g_object_unref);
+  hcl_stream_parser_reset (self);
+}
+
+/**
+ * hcl_stream_parser_new:
+ *
+ * Creates a new streaming HCL parser.
+ *
+ * Returns: (transfer full): a new #HclStreamParser
+ */
+HclStreamParser *
+hcl_stream_parser_new (void)
+{
+  return g_object_new (HCL_TYPE_STREAM_PARSER, NULL);
+}
+
+/**
+ * hcl_stream_parser_set_document:
+ * @parser: an #HclStreamParser
+ * @document: (nullable): document to collect the parsed statements in
+ *
+ * Sets a document that completed top-level blocks and attributes are
+ * added to, in addition to being emitted. Without a document the parser
+ * keeps nothing once a top-level statement has been emitted.
+ */
+void
+hcl_stream_parser_set_document (HclStreamParser *parser, HclDocument *document)
+{
+  g_return_if_fail (HCL_IS_STREAM_PARSER (parser));
+  g_return_if_fail (document == NULL || HCL_IS_DOCUMENT (document));
+
+  if (document)
+    g_object_ref (document);
+  g_clear_object (&parser->document);
+  parser->document = document;
+}
+
+/**
+ * hcl_stream_parser_get_document:
+ * @parser: an #HclStreamParser
+ *
+ * Gets the document set with hcl_stream_parser_set_document().
+ *
+ * Returns: (transfer none) (nullable): the document
+ */
+HclDocument *
+hcl_stream_parser_get_document (HclStreamParser *parser)
+{
+  g_return_val_if_fail (HCL_IS_STREAM_PARSER (parser), NULL);
+
+  return parser->document;
+}
+
+/**
+ * hcl_stream_parser_set_chunk_size:
+ * @parser: an #HclStreamParser
+ * @chunk_size: number of bytes to read from a stream at a time
+ *
+ * Sets how much hcl_stream_parser_parse() and
+ * hcl_stream_parser_parse_async() read from the stream at a time.
+ */
+void
+hcl_stream_parser_set_chunk_size (HclStreamParser *parser, gsize chunk_size)
+{
+  g_return_if_fail (HCL_IS_STREAM_PARSER (parser));
+  g_return_if_fail (chunk_size > 0);
+
+  parser->chunk_size = chunk_size;
+}
+
+/**
+ * hcl_stream_parser_get_chunk_size:
+ * @parser: an #HclStreamParser
+ *
+ * Gets the number of bytes read from a stream at a time.
+ *
+ * Returns: the chunk size
+ */
+gsize
+hcl_stream_parser_get_chunk_size (HclStreamParser *parser)
+{
+  g_return_val_if_fail (HCL_IS_STREAM_PARSER (parser), 0);
+
+  return parser->chunk_size;
+}
+
+/* Moves the start of the pending statements to @end */
+static void
+hcl_stream_parser_consume (HclStreamParser *self, gsize end)
+{
+  const gchar *text = self->buffer->str + self->statement_start;
+  gsize length = end - self->statement_start;
+  gsize last_newline = 0;
+  gsize newlines = hcl_scan_count_newlines (text, length, &last_newline);
+
+  if (newlines > 0) {
+    self->line += newlines;
+    self->column = length - last_newline;
+  } else {
+    self->column += length;
+  }
+
+  self->statement_start = end;
+  self->statement_end = MAX (self->statement_end, end);
+}
+
+/* Blank lines and comments need no parser */
+static gboolean
+hcl_stream_parser_is_trivia (const gchar *text, gsize length)
+{
+  gsize i = 0;
+
+  while (i < length) {
+    gchar c = text[i];
+
+    if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+      i++;
+    } else if (c == '#' || (c == '/' && i + 1 < length && text[i + 1] == '/')) {
+      i += hcl_scan_line (text + i, length - i);
+    } else {
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
+static HclBlock *
+hcl_stream_parser_current_block (HclStreamParser *self)
+{
+  if (self->open_blocks->len == 0)
+    return NULL;
+
+  return g_ptr_array_index (self->open_blocks, self->open_blocks->len - 1);
+}
+
+/* Attaches a finished block to its parent and announces it */
+static void
+hcl_stream_parser_complete_block (HclStreamParser *self, HclBlock *block)
+{
+  HclBlock *parent = hcl_stream_parser_current_block (self);
+
+  if (parent)
+    hcl_block_add_block (parent, g_object_ref (block));
+  else if (self->document)
+    hcl_document_add_block (self->document, g_object_ref (block));
+
+  g_signal_emit (self, signals[BLOCK_PARSED], 0, block, parent);
+}
+
+/* Parses the pending statements up to @end into the innermost open block */
+static gboolean
+hcl_stream_parser_flush (HclStreamParser *self, gsize end, GError **error)
+{
+  const gchar *text = self->buffer->str + self->statement_start;
+  gsize length = end - self->statement_start;
+  HclBlock *parent = hcl_stream_parser_current_block (self);
+
+  if (hcl_stream_parser_is_trivia (text, length)) {
+    /* Nothing to parse */
+  } else if (parent) {
+    if (!hcl_parser_parse_block_text (self->parser, text, length,
+                                      self->line, self->column, parent, error))
+      return FALSE;
+  } else {
+    g_autoptr(HclDocument) statements = NULL;
+    GList *names;
+    GList *blocks;
+    GList *l;
+
+    statements = hcl_parser_parse_text (self->parser, text, length,
+                                        self->line, self->column, error);
+    if (!statements)
+      return FALSE;
+
+    names = hcl_document_get_attribute_names (statements);
+    for (l = names; l != NULL; l = l->next) {
+      const gchar *name = l->data;
+      HclValue *value = hcl_document_get_attribute (statements, name);
+
+      if (self->document)
+        hcl_document_set_attribute_interned (self->document, name, g_object_ref (value));
+      g_signal_emit (self, signals[ATTRIBUTE_PARSED], 0, name, value);
+    }
+    g_list_free (names);
+
+    blocks = hcl_document_get_blocks (statements);
+    for (l = blocks; l != NULL; l = l->next)
+      hcl_stream_parser_complete_block (self, l->data);
+    g_list_free (blocks);
+  }
+
+  hcl_stream_parser_consume (self, end);
+  return TRUE;
+}
+
+/* Reports a malformed block header the same way the parser would */
+static gboolean
+hcl_stream_parser_header_error (HclStreamParser *self,
+                                const gchar *text,
+                                gsize length,
+                                GError **error)
+{
+  g_autoptr(HclDocument) document = NULL;
+
+  document = hcl_parser_parse_text (self->parser, text, length,
+                                    self->line, self->column, error);
+  if (document)
+    g_set_error (error, HCL_PARSER_ERROR, HCL_PARSER_ERROR_SYNTAX,
+                 "Expected block header at line %zu, column %zu",
+                 self->line, self->column);
+
+  return FALSE;
+}
+
+/* Starts a block whose opening brace is at @brace */
+static gboolean
+hcl_stream_parser_open_block (HclStreamParser *self, gsize brace, GError **error)
+{
+  const gchar *text = self->buffer->str + self->statement_start;
+  gsize length = brace + 1 - self->statement_start;
+  HclLexer *lexer = self->lexer;
+  g_autofree gchar *label = NULL;
+  const gchar *type;
+  HclSpanToken token;
+
+  hcl_lexer_reset (lexer, text, length, self->line, self->column);
+
+  do {
+    if (!hcl_lexer_next_span (lexer, &token, error))
+      return FALSE;
+  } while (token.type == HCL_TOKEN_TYPE_NEWLINE ||
+           token.type == HCL_TOKEN_TYPE_COMMENT);
+
+  if (token.type != HCL_TOKEN_TYPE_IDENTIFIER)
+    return hcl_stream_parser_header_error (self, text, length, error);
+
+  type = hcl_lexer_span_intern (lexer, &token);
+  if (!hcl_lexer_next_span (lexer, &token, error))
+    return FALSE;
+
+  if (token.type == HCL_TOKEN_TYPE_STRING ||
+      token.type == HCL_TOKEN_TYPE_IDENTIFIER) {
+    label = hcl_lexer_span_dup_value (lexer, &token);
+    if (!hcl_lexer_next_span (lexer, &token, error))
+      return FALSE;
+  }
+
+  if (token.type != HCL_TOKEN_TYPE_LBRACE)
+    return hcl_stream_parser_header_error (self, text, length, error);
+
+  g_ptr_array_add (self->open_blocks,
+                   hcl_block_new_interned (type, g_steal_pointer (&label)));
+  hcl_stream_parser_consume (self, brace + 1);
+  self->has_assign = FALSE;
+  return TRUE;
+}
+
+/* Finishes the innermost block, whose closing brace is at @brace */
+static gboolean
+hcl_stream_parser_close_block (HclStreamParser *self, gsize brace, GError **error)
+{
+  HclBlock *block;
+
+  if (!hcl_stream_parser_flush (self, brace, error))
+    return FALSE;
+
+  block = g_ptr_array_steal_index (self->open_blocks, self->open_blocks->len - 1);
+  hcl_stream_parser_complete_block (self, block);
+  g_object_unref (block);
+
+  hcl_stream_parser_consume (self, brace + 1);
+  self->has_assign = FALSE;
+  return TRUE;
+}
+
+static inline gboolean
+hcl_stream_parser_is_special (gchar c)
+{
+  switch (c) {
+    case '"': case '\'': case '#': case '/': case '=':
+    case '[': case ']': case '(': case ')': case '{': case '}':
+    case '\n':
+      return TRUE;
+    default:
+      return FALSE;
+  }
+}
+
+/*
+ * Finds statement boundaries in the unscanned part of the buffer. Only
+ * what is needed for that is tracked: whether we are inside a string or
+ * a comment, how deep inside brackets or object literals, and which
+ * braces open and close blocks. Everything else is left to the parser.
+ */
+static gboolean
+hcl_stream_parser_scan (HclStreamParser *self, gboolean at_end, GError **error)
+{
+  while (self->scanned < self->buffer->len) {
+    const gchar *data = self->buffer->str;
+    gsize length = self->buffer->len;
+    gsize i = self->scanned;
+
+    switch (self->state) {
+      case HCL_STREAM_STATE_STRING:
+        i += hcl_scan_string (data + i, length - i, self->quote);
+        if (i >= length) {
+          self->scanned = length;
+        } else if (data[i] == self->quote) {
+          self->state = HCL_STREAM_STATE_CODE;
+          self->scanned = i + 1;
+        } else if (i + 1 < length) {
+          self->scanned = i + 2; /* Skip the escaped character */
+        } else {
+          self->scanned = i; /* Wait for the escaped character */
+          return TRUE;
+        }
+        break;
+
+      case HCL_STREAM_STATE_COMMENT:
+        i += hcl_scan_line (data + i, length - i);
+        self->scanned = i;
+        if (i < length)
+          self->state = HCL_STREAM_STATE_CODE; /* The newline ends a statement */
+        break;
+
+      case HCL_STREAM_STATE_CODE:
+        while (i < length && !hcl_stream_parser_is_special (data[i]))
+          i++;
+
+        if (i >= length) {
+          self->scanned = length;
+          break;
+        }
+
+        self->scanned = i + 1;
+
+        switch (data[i]) {
+          case '"':
+          case '\'':
+            self->state = HCL_STREAM_STATE_STRING;
+            self->quote = data[i];
+            break;
+
+          case '#':
+            self->state = HCL_STREAM_STATE_COMMENT;
+            break;
+
+          case '/':
+            if (i + 1 >= length && !at_end) {
+              self->scanned = i; /* Could be the start of "//" */
+              return TRUE;
+            }
+            if (i + 1 < length && data[i + 1] == '/') {
+              self->state = HCL_STREAM_STATE_COMMENT;
+              self->scanned = i + 2;
+            }
+            break;
+
+          case '=':
+            if (self->depth == 0)
+              self->has_assign = TRUE;
+            break;
+
+          case '[':
+          case '(':
+            self->depth++;
+            break;
+
+          case ']':
+          case ')':
+            if (self->depth > 0)
+              self->depth--;
+            break;
+
+          case '{':
+            if (self->depth > 0 || self->has_assign)
+              self->depth++; /* Object literal */
+            else if (!hcl_stream_parser_flush (self, self->statement_end, error) ||
+                     !hcl_stream_parser_open_block (self, i, error))
+              return FALSE;
+            break;
+
+          case '}':
+            if (self->depth > 0)
+              self->depth--;
+            else if (self->open_blocks->len > 0 &&
+                     !hcl_stream_parser_close_block (self, i, error))
+              return FALSE;
+            break;
+
+          case '\n':
+            /* Complete statements are parsed in batches, see below */
+            if (self->depth == 0) {
+              self->statement_end = i + 1;
+              self->has_assign = FALSE;
+            }
+            break;
+
+          default:
+            g_assert_not_reached ();
+        }
+        break;
+
+      default:
+        g_assert_not_reached ();
+    }
+  }
+
+  /* Statements are handed to the parser together, one batch per brace
+   * or per call, which keeps the per-parse overhead off short lines */
+  return hcl_stream_parser_flush (self, self->statement_end, error);
+}
+
+/**
+ * hcl_stream_parser_feed:
+ * @parser: an #HclStreamParser
+ * @data: (array length=length): the next piece of HCL text
+ * @length: length of @data in bytes, or -1 if it is nul-terminated
+ * @error: return location for error
+ *
+ * Feeds the next piece of input to the parser. Pieces may be split
+ * anywhere, including inside tokens. Every statement completed by @data
+ * is parsed and emitted before this function returns.
+ *
+ * On error the parser is reset and can be used for a new input.
+ *
+ * Returns: %TRUE on success, %FALSE on error
+ */
+gboolean
+hcl_stream_parser_feed (HclStreamParser *parser,
+                        const gchar *data,
+                        gssize length,
+                        GError **error)
+{
+  g_return_val_if_fail (HCL_IS_STREAM_PARSER (parser), FALSE);
+  g_return_val_if_fail (data != NULL || length == 0, FALSE);
+
+  if (length < 0)
+    length = (gssize) strlen (data);
+
+  g_string_append_len (parser->buffer, data, length);
+
+  if (!hcl_stream_parser_scan (parser, FALSE, error)) {
+    hcl_stream_parser_reset (parser);
+    return FALSE;
+  }
+
+  /* Drop everything the parser is done with */
+  if (parser->statement_start > 0) {
+    g_string_erase (parser->buffer, 0, (gssize) parser->statement_start);
+    parser->scanned -= parser->statement_start;
+    parser->statement_end -= parser->statement_start;
+    parser->statement_start = 0;
+  }
+
+  return TRUE;
+}
+
+/**
+ * hcl_stream_parser_finish:
+ * @parser: an #HclStreamParser
+ * @error: return location for error
+ *
+ * Tells the parser that the end of the input has been reached, parsing
+ * whatever is still pending. The parser is reset afterwards and can be
+ * used for a new input.
+ *
+ * Returns: %TRUE if the whole input was valid, %FALSE on error
+ */
+gboolean
+hcl_stream_parser_finish (HclStreamParser *parser, GError **error)
+{
+  gboolean ret = FALSE;
+
+  g_return_val_if_fail (HCL_IS_STREAM_PARSER (parser), FALSE);
+
+  if (!hcl_stream_parser_scan (parser, TRUE, error) ||
+      !hcl_stream_parser_flush (parser, parser->buffer->len, error))
+    goto out;
+
+  if (parser->open_blocks->len > 0) {
+    HclBlock *block = hcl_stream_parser_current_block (parser);
+
+    g_set_error (error, HCL_PARSER_ERROR, HCL_PARSER_ERROR_UNEXPECTED_TOKEN,
+                 "Unterminated block '%s' at end of input, line %zu",
+                 hcl_block_get_block_type (block), parser->line);
+    goto out;
+  }
+
+  ret = TRUE;
+
+out:
+  hcl_stream_parser_reset (parser);
+  return ret;
+}
+
+/**
+ * hcl_stream_parser_parse:
+ * @parser: an #HclStreamParser
+ * @stream: a #GInputStream to read HCL text from
+ * @cancellable: (nullable): a #GCancellable
+ * @error: return location for error
+ *
+ * Reads @stream to the end in chunks of the configured size, feeding
+ * each chunk to the parser, and then finishes the parse.
+ *
+ * Returns: %TRUE on success, %FALSE on error
+ */
+gboolean
+hcl_stream_parser_parse (HclStreamParser *parser,
+                         GInputStream *stream,
+                         GCancellable *cancellable,
+                         GError **error)
+{
+  g_autofree gchar *chunk = NULL;
+
+  g_return_val_if_fail (HCL_IS_STREAM_PARSER (parser), FALSE);
+  g_return_val_if_fail (G_IS_INPUT_STREAM (stream), FALSE);
+
+  chunk = g_malloc (parser->chunk_size);
+
+  for (;;) {
+    gssize n_read = g_input_stream_read (stream, chunk, parser->chunk_size,
+                                         cancellable, error);
+
+    if (n_read < 0) {
+      hcl_stream_parser_reset (parser);
+      return FALSE;
+    }
+
+    if (n_read == 0)
+      break;
+
+    if (!hcl_stream_parser_feed (parser, chunk, n_read, error))
+      return FALSE;
+  }
+
+  return hcl_stream_parser_finish (parser, error);
+}
+
+static void hcl_stream_parser_read_next (GTask *task);
+
+static void
+hcl_stream_parser_read_cb (GObject *source, GAsyncResult *result, gpointer user_data)
+{
+  g_autoptr(GTask) task = user_data;
+  HclStreamParser *self = g_task_get_source_object (task);
+  g_autoptr(GBytes) bytes = NULL;
+  g_autoptr(GError) error = NULL;
+  gconstpointer data;
+  gsize size;
+
+  bytes = g_input_stream_read_bytes_finish (G_INPUT_STREAM (source), result, &error);
+  if (!bytes) {
+    hcl_stream_parser_reset (self);
+    g_task_return_error (task, g_steal_pointer (&error));
+    return;
+  }
+
+  data = g_bytes_get_data (bytes, &size);
+
+  if (size == 0) {
+    if (hcl_stream_parser_finish (self, &error))
+      g_task_return_boolean (task, TRUE);
+    else
+      g_task_return_error (task, g_steal_pointer (&error));
+    return;
+  }
+
+  if (!hcl_stream_parser_feed (self, data, (gssize) size, &error)) {
+    g_task_return_error (task, g_steal_pointer (&error));
+    return;
+  }
+
+  hcl_stream_parser_read_next (g_steal_pointer (&task));
+}
+
+static void
+hcl_stream_parser_read_next (GTask *task)
+{
+  HclStreamParser *self = g_task_get_source_object (task);
+  GInputStream *stream = g_task_get_task_data (task);
+
+  g_input_stream_read_bytes_async (stream,
+                                   self->chunk_size,
+                                   g_task_get_priority (task),
+                                   g_task_get_cancellable (task),
+                                   hcl_stream_parser_read_cb,
+                                   task);
+}
+
+/**
+ * hcl_stream_parser_parse_async:
+ * @parser: an #HclStreamParser
+ * @stream: a #GInputStream to read HCL text from
+ * @io_priority: the I/O priority of the reads
+ * @cancellable: (nullable): a #GCancellable
+ * @callback: callback to call when the parse is complete
+ * @user_data: data to pass to @callback
+ *
+ * Asynchronously reads @stream to the end and parses it. Signals are
+ * emitted from the thread-default main context as the chunks arrive, so
+ * a UI can be built up while the rest of the input is still being read.
+ */
+void
+hcl_stream_parser_parse_async (HclStreamParser *parser,
+                               GInputStream *stream,
+                               int io_priority,
+                               GCancellable *cancellable,
+                               GAsyncReadyCallback callback,
+                               gpointer user_data)
+{
+  GTask *task;
+
+  g_return_if_fail (HCL_IS_STREAM_PARSER (parser));
+  g_return_if_fail (G_IS_INPUT_STREAM (stream));
+
+  task = g_task_new (parser, cancellable, callback, user_data);
+  g_task_set_source_tag (task, hcl_stream_parser_parse_async);
+  g_task_set_priority (task, io_priority);
+  g_task_set_task_data (task, g_object_ref (stream), g_object_unref);
+
+  hcl_stream_parser_read_next (task);
+}
+
+/**
+ * hcl_stream_parser_parse_finish:
+ * @parser: an #HclStreamParser
+ * @result: a #GAsyncResult
+ * @error: return location for error
+ *
+ * Finishes an operation started with hcl_stream_parser_parse_async().
+ *
+ * Returns: %TRUE on success, %FALSE on error
+ */
+gboolean
+hcl_stream_parser_parse_finish (HclStreamParser *parser,
+                                GAsyncResult *result,
+                                GError **error)
+{
+  g_return_val_if_fail (HCL_IS_STREAM_PARSER (parser), FALSE);
+  g_return_val_if_fail (g_task_is_valid (result, parser), FALSE);
+
+  return g_task_propagate_boolean (G_TASK (result), error);
+}
@@ -0,0 +1,59 @@
+/* hcl-stream-parser.h - Incremental HCL parser
+ *
+ * Copyright 2024 Geoff Johnson <geoff.jay@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ */
+
+#ifndef __HCL_STREAM_PARSER_H__
+#define __HCL_STREAM_PARSER_H__
+
+#include <gio/gio.h>
+#include "hcl-document.h"
+#include "hcl-enums.h"
+
+G_BEGIN_DECLS
+
+#define HCL_TYPE_STREAM_PARSER (hcl_stream_parser_get_type())
+G_DECLARE_FINAL_TYPE (HclStreamParser, hcl_stream_parser, HCL, STREAM_PARSER, GObject)
+
+/* Constructor */
+HclStreamParser *hcl_stream_parser_new              (void);
+
+/* Configuration */
+void             hcl_stream_parser_set_document     (HclStreamParser *parser,
+                                                     HclDocument *document);
+HclDocument     *hcl_stream_parser_get_document     (HclStreamParser *parser);
+void             hcl_stream_parser_set_chunk_size   (HclStreamParser *parser,
+                                                     gsize chunk_size);
+gsize            hcl_stream_parser_get_chunk_size   (HclStreamParser *parser);
+
+/* Push API */
+gboolean         hcl_stream_parser_feed             (HclStreamParser *parser,
+                                                     const gchar *data,
+                                                     gssize length,
+                                                     GError **error);
+gboolean         hcl_stream_parser_finish           (HclStreamParser *parser,
+                                                     GError **error);
+
+/* Pull API */
+gboolean         hcl_stream_parser_parse            (HclStreamParser *parser,
+                                                     GInputStream *stream,
+                                                     GCancellable *cancellable,
+                                                     GError **error);
+void             hcl_stream_parser_parse_async      (HclStreamParser *parser,
+                                                     GInputStream *stream,
+                                                     int io_priority,
+                                                     GCancellable *cancellable,
+                                                     GAsyncReadyCallback callback,
+                                                     gpointer user_data);
+gboolean         hcl_stream_parser_parse_finish     (HclStreamParser *parser,
+                                                     GAsyncResult *result,
+                                                     GError **error);
+
+G_END_DECLS
+
+#endif /* __HCL_STREAM_PARSER_H__ */
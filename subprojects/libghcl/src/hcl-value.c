@@ -4,6 +4,8 @@
  */
 
 #include "hcl-value.h"
+#include "hcl-private.h"
+#include "hcl-writer.h"
 #include <math.h>
 
 /**
@@ -12,13 +14,32 @@
  * @title: HclValue
  *
  * #HclValue represents a value in HCL configuration.
+ *
+ * A value can be frozen with hcl_value_freeze(), after which neither it
+ * nor anything inside it changes. Frozen lists and objects are copied
+ * in constant time: the copy shares their items until it is first
+ * changed, and only then copies the one level it changes.
+ *
+ * A list whose items are all integers, or all floats, can be stored
+ * packed, as one array of #gint64 or #gdouble rather than one #HclValue
+ * per item. The parser packs such lists, and hcl_value_new_int_array()
+ * and hcl_value_new_double_array() make them. A packed list is a list
+ * like any other, and hcl_value_get_int_array() and
+ * hcl_value_get_double_array() read its numbers without copying them.
  */
 
 struct _HclValue
 {
   GObject parent_instance;
 
-  HclValueType type;
+  guint type : 3;           /* HclValueType */
+  guint frozen : 1;         /* Neither this nor anything inside changes */
+  guint borrowed : 1;       /* LIST, OBJECT: the items are a frozen value's */
+  guint packed : 1;         /* LIST: the items are numbers in @array */
+  guint hashed : 1;         /* STRING, LIST, OBJECT: @hash is set */
+  guint shared : 1;         /* Added to more than one container unfrozen */
+  guint parent_kind : 2;    /* HclParentKind of @parent */
+  guint hash_epoch;         /* When @hash was set, unless frozen */
 
   union {
     gboolean bool_value;
@@ -31,8 +52,16 @@ struct _HclValue
     } number;
     gchar *string_value;
     GPtrArray *list_value;    /* Array of HclValue* */
-    GHashTable *object_value; /* String -> HclValue* */
+    struct {
+      HclNumberType number_type;
+      GArray *numbers;        /* gint64 or gdouble, one per item */
+      GPtrArray *items;       /* The same as HclValue*, made when asked for */
+    } array;
+    HclMap *object_value;     /* Interned key -> HclValue*, in order set */
   } data;
+
+  guint64 hash;
+  gpointer parent;          /* LIST, OBJECT: the container last added to */
 };
 
 G_DEFINE_FINAL_TYPE (HclValue, hcl_value, G_TYPE_OBJECT)
@@ -48,13 +77,26 @@ hcl_value_finalize (GObject *object)
       break;
 
     case HCL_VALUE_TYPE_LIST:
-      if (self->data.list_value)
+      if (self->packed) {
+        g_array_unref (self->data.array.numbers);
+        g_clear_pointer (&self->data.array.items, g_ptr_array_unref);
+      } else if (self->data.list_value) {
+        for (guint i = 0; !self->frozen && !self->borrowed && i < self->data.list_value->len; i++)
+          hcl_value_unset_parent (g_ptr_array_index (self->data.list_value, i), self);
         g_ptr_array_unref (self->data.list_value);
+      }
       break;
 
     case HCL_VALUE_TYPE_OBJECT:
-      if (self->data.object_value)
-        g_hash_table_unref (self->data.object_value);
+      if (self->data.object_value) {
+        HclMapIter iter;
+        gpointer member;
+
+        hcl_map_iter_init (&iter, self->data.object_value);
+        while (!self->frozen && !self->borrowed && hcl_map_iter_next (&iter, NULL, &member))
+          hcl_value_unset_parent (member, self);
+        hcl_map_unref (self->data.object_value);
+      }
       break;
 
     default:
@@ -161,6 +203,48 @@ hcl_value_new_string (const gchar *value)
   return self;
 }
 
+/**
+ * hcl_value_new_string_len:
+ * @value: string value
+ * @length: length of @value in bytes, or -1 if it is nul-terminated
+ *
+ * Creates a new string HCL value from the first @length bytes of @value,
+ * which does not need to be nul-terminated.
+ *
+ * Returns: (transfer full): a new #HclValue
+ */
+HclValue *
+hcl_value_new_string_len (const gchar *value, gssize length)
+{
+  HclValue *self;
+
+  if (length < 0)
+    return hcl_value_new_string (value);
+
+  self = g_object_new (HCL_TYPE_VALUE, NULL);
+  self->type = HCL_VALUE_TYPE_STRING;
+  self->data.string_value = g_strndup (value, (gsize) length);
+  return self;
+}
+
+/**
+ * hcl_value_new_take_string:
+ * @value: (transfer full): string value
+ *
+ * Creates a new string HCL value that takes ownership of @value instead
+ * of copying it.
+ *
+ * Returns: (transfer full): a new #HclValue
+ */
+HclValue *
+hcl_value_new_take_string (gchar *value)
+{
+  HclValue *self = g_object_new (HCL_TYPE_VALUE, NULL);
+  self->type = HCL_VALUE_TYPE_STRING;
+  self->data.string_value = value;
+  return self;
+}
+
 /**
  * hcl_value_new_list:
  *
@@ -177,6 +261,55 @@ hcl_value_new_list (void)
   return self;
 }
 
+static HclValue *
+hcl_value_new_array (HclNumberType number_type, gconstpointer values, guint length)
+{
+  HclValue *self = g_object_new (HCL_TYPE_VALUE, NULL);
+
+  self->type = HCL_VALUE_TYPE_LIST;
+  self->packed = TRUE;
+  self->data.array.number_type = number_type;
+  self->data.array.numbers = g_array_sized_new (FALSE, FALSE, sizeof (gint64), length);
+  if (length > 0)
+    g_array_append_vals (self->data.array.numbers, values, length);
+
+  return self;
+}
+
+/**
+ * hcl_value_new_int_array:
+ * @values: (array length=length) (nullable): the integers
+ * @length: how many integers @values holds
+ *
+ * Creates a list of integers stored packed, copying @values in one go.
+ *
+ * Returns: (transfer full): a new #HclValue
+ */
+HclValue *
+hcl_value_new_int_array (const gint64 *values, guint length)
+{
+  g_return_val_if_fail (values != NULL || length == 0, NULL);
+
+  return hcl_value_new_array (HCL_NUMBER_TYPE_INTEGER, values, length);
+}
+
+/**
+ * hcl_value_new_double_array:
+ * @values: (array length=length) (nullable): the floats
+ * @length: how many floats @values holds
+ *
+ * Creates a list of floats stored packed, copying @values in one go.
+ *
+ * Returns: (transfer full): a new #HclValue
+ */
+HclValue *
+hcl_value_new_double_array (const gdouble *values, guint length)
+{
+  g_return_val_if_fail (values != NULL || length == 0, NULL);
+
+  return hcl_value_new_array (HCL_NUMBER_TYPE_FLOAT, values, length);
+}
+
 /**
  * hcl_value_new_object:
  *
@@ -189,8 +322,7 @@ hcl_value_new_object (void)
 {
   HclValue *self = g_object_new (HCL_TYPE_VALUE, NULL);
   self->type = HCL_VALUE_TYPE_OBJECT;
-  self->data.object_value = g_hash_table_new_full (g_str_hash, g_str_equal,
-                                                   g_free, g_object_unref);
+  self->data.object_value = hcl_map_new ();
   return self;
 }
 
@@ -210,6 +342,28 @@ hcl_value_get_value_type (HclValue *value)
   return value->type;
 }
 
+/**
+ * hcl_value_get_number_type:
+ * @value: an #HclValue holding a number, or a packed list
+ *
+ * Gets whether a number value was written as an integer or as a float,
+ * or which of the two the items of a packed list are.
+ *
+ * Returns: the #HclNumberType
+ */
+HclNumberType
+hcl_value_get_number_type (HclValue *value)
+{
+  g_return_val_if_fail (HCL_IS_VALUE (value), HCL_NUMBER_TYPE_INTEGER);
+
+  if (value->packed)
+    return value->data.array.number_type;
+
+  g_return_val_if_fail (value->type == HCL_VALUE_TYPE_NUMBER, HCL_NUMBER_TYPE_INTEGER);
+
+  return value->data.number.number_type;
+}
+
 /**
  * hcl_value_is_null:
  * @value: an #HclValue
@@ -380,6 +534,191 @@ hcl_value_get_string (HclValue *value)
   return value->data.string_value;
 }
 
+/**
+ * hcl_value_is_array:
+ * @value: an #HclValue
+ *
+ * Checks if the value is a list stored packed, whose numbers
+ * hcl_value_get_int_array() or hcl_value_get_double_array() return.
+ *
+ * Returns: %TRUE if the value is a packed list
+ */
+gboolean
+hcl_value_is_array (HclValue *value)
+{
+  g_return_val_if_fail (HCL_IS_VALUE (value), FALSE);
+
+  return value->packed;
+}
+
+static gconstpointer
+hcl_value_get_array (HclValue *value, HclNumberType number_type, guint *length)
+{
+  if (!value->packed || value->data.array.number_type != number_type) {
+    if (length)
+      *length = 0;
+    return NULL;
+  }
+
+  if (length)
+    *length = value->data.array.numbers->len;
+
+  return value->data.array.numbers->data;
+}
+
+/**
+ * hcl_value_get_int_array:
+ * @value: a list #HclValue
+ * @length: (out) (optional): return location for the number of items
+ *
+ * Gets the items of a packed list of integers, without copying them.
+ * The array is valid as long as @value is and is not added to. Lists
+ * that are not packed, or hold floats, give %NULL; read those with
+ * hcl_value_list_get_item().
+ *
+ * Returns: (array length=length) (transfer none) (nullable): the integers
+ */
+const gint64 *
+hcl_value_get_int_array (HclValue *value, guint *length)
+{
+  g_return_val_if_fail (HCL_IS_VALUE (value), NULL);
+  g_return_val_if_fail (value->type == HCL_VALUE_TYPE_LIST, NULL);
+
+  return hcl_value_get_array (value, HCL_NUMBER_TYPE_INTEGER, length);
+}
+
+/**
+ * hcl_value_get_double_array:
+ * @value: a list #HclValue
+ * @length: (out) (optional): return location for the number of items
+ *
+ * Gets the items of a packed list of floats, without copying them.
+ * The array is valid as long as @value is and is not added to. Lists
+ * that are not packed, or hold integers, give %NULL; read those with
+ * hcl_value_list_get_item().
+ *
+ * Returns: (array length=length) (transfer none) (nullable): the floats
+ */
+const gdouble *
+hcl_value_get_double_array (HclValue *value, guint *length)
+{
+  g_return_val_if_fail (HCL_IS_VALUE (value), NULL);
+  g_return_val_if_fail (value->type == HCL_VALUE_TYPE_LIST, NULL);
+
+  return hcl_value_get_array (value, HCL_NUMBER_TYPE_FLOAT, length);
+}
+
+/*
+ * The items of a packed list as values, made the first time somebody
+ * asks for one. Frozen lists are read from several threads, so the
+ * first array to be published wins.
+ */
+static GPtrArray *
+hcl_value_array_get_items (HclValue *value)
+{
+  GArray *numbers = value->data.array.numbers;
+  GPtrArray *items = g_atomic_pointer_get (&value->data.array.items);
+
+  if (G_LIKELY (items))
+    return items;
+
+  items = g_ptr_array_new_full (numbers->len, g_object_unref);
+  for (guint i = 0; i < numbers->len; i++) {
+    HclValue *item = value->data.array.number_type == HCL_NUMBER_TYPE_INTEGER
+                     ? hcl_value_new_int (g_array_index (numbers, gint64, i))
+                     : hcl_value_new_double (g_array_index (numbers, gdouble, i));
+
+    item->frozen = value->frozen;
+    g_ptr_array_add (items, item);
+  }
+
+  if (!g_atomic_pointer_compare_and_exchange (&value->data.array.items, NULL, items)) {
+    g_ptr_array_unref (items);
+    items = g_atomic_pointer_get (&value->data.array.items);
+  }
+
+  return items;
+}
+
+/* Stores a packed list as values, before something else is added to it */
+static void
+hcl_value_unpack (HclValue *value)
+{
+  GPtrArray *items;
+
+  if (G_LIKELY (!value->packed))
+    return;
+
+  items = g_ptr_array_ref (hcl_value_array_get_items (value));
+  g_array_unref (value->data.array.numbers);
+  g_ptr_array_unref (value->data.array.items);
+
+  value->packed = FALSE;
+  value->data.list_value = items;
+}
+
+/*
+ * hcl_value_list_add_number:
+ *
+ * Adds a number to a list the parser is filling, packed if the list is
+ * empty or packed with numbers of the same type. Returns %FALSE, having
+ * added nothing, when the number has to be added as an #HclValue.
+ */
+gboolean
+hcl_value_list_add_number (HclValue *value,
+                           HclNumberType number_type,
+                           gint64 int_value,
+                           gdouble double_value)
+{
+  if (!value->packed) {
+    if (value->data.list_value->len > 0 || value->borrowed)
+      return FALSE;
+
+    g_ptr_array_unref (value->data.list_value);
+    value->packed = TRUE;
+    value->data.array.number_type = number_type;
+    value->data.array.numbers = g_array_new (FALSE, FALSE, sizeof (gint64));
+    value->data.array.items = NULL;
+  } else if (value->data.array.number_type != number_type || value->data.array.items) {
+    return FALSE;
+  }
+
+  if (number_type == HCL_NUMBER_TYPE_INTEGER)
+    g_array_append_val (value->data.array.numbers, int_value);
+  else
+    g_array_append_val (value->data.array.numbers, double_value);
+
+  hcl_hash_invalidate (value, HCL_PARENT_VALUE);
+
+  return TRUE;
+}
+
+/* Gives a copy of a frozen value items of its own, before it changes them */
+static void
+hcl_value_unshare (HclValue *value)
+{
+  if (G_LIKELY (!value->borrowed))
+    return;
+
+  if (value->type == HCL_VALUE_TYPE_LIST) {
+    GPtrArray *items = value->data.list_value;
+    GPtrArray *copy = g_ptr_array_new_full (items->len + 1, g_object_unref);
+
+    for (guint i = 0; i < items->len; i++)
+      g_ptr_array_add (copy, g_object_ref (g_ptr_array_index (items, i)));
+
+    g_ptr_array_unref (items);
+    value->data.list_value = copy;
+  } else {
+    HclMap *members = value->data.object_value;
+
+    value->data.object_value = hcl_map_copy (members);
+    hcl_map_unref (members);
+  }
+
+  value->borrowed = FALSE;
+}
+
 /**
  * hcl_value_list_get_length:
  * @value: an #HclValue
@@ -394,6 +733,9 @@ hcl_value_list_get_length (HclValue *value)
   g_return_val_if_fail (HCL_IS_VALUE (value), 0);
   g_return_val_if_fail (value->type == HCL_VALUE_TYPE_LIST, 0);
 
+  if (value->packed)
+    return value->data.array.numbers->len;
+
   return value->data.list_value->len;
 }
 
@@ -402,20 +744,25 @@ hcl_value_list_get_length (HclValue *value)
  * @value: an #HclValue
  * @index: item index
  *
- * Gets an item from a list value.
+ * Gets an item from a list value. The first item asked of a packed list
+ * makes values for all of its numbers, which it then keeps.
  *
  * Returns: (transfer none): the list item or %NULL
  */
 HclValue *
 hcl_value_list_get_item (HclValue *value, guint index)
 {
+  GPtrArray *items;
+
   g_return_val_if_fail (HCL_IS_VALUE (value), NULL);
   g_return_val_if_fail (value->type == HCL_VALUE_TYPE_LIST, NULL);
 
-  if (index >= value->data.list_value->len)
+  if (index >= hcl_value_list_get_length (value))
     return NULL;
 
-  return g_ptr_array_index (value->data.list_value, index);
+  items = value->packed ? hcl_value_array_get_items (value) : value->data.list_value;
+
+  return g_ptr_array_index (items, index);
 }
 
 /**
@@ -423,23 +770,29 @@ hcl_value_list_get_item (HclValue *value, guint index)
  * @value: an #HclValue
  * @item: (transfer full): item to add
  *
- * Adds an item to a list value.
+ * Adds an item to a list value, which must not be frozen. A packed list
+ * stops being packed.
  */
 void
 hcl_value_list_add_item (HclValue *value, HclValue *item)
 {
   g_return_if_fail (HCL_IS_VALUE (value));
   g_return_if_fail (value->type == HCL_VALUE_TYPE_LIST);
+  g_return_if_fail (!value->frozen);
   g_return_if_fail (HCL_IS_VALUE (item));
 
+  hcl_value_unpack (value);
+  hcl_value_unshare (value);
   g_ptr_array_add (value->data.list_value, item);
+  hcl_value_set_parent (item, value, HCL_PARENT_VALUE);
+  hcl_hash_invalidate (value, HCL_PARENT_VALUE);
 }
 
 /**
  * hcl_value_object_get_keys:
  * @value: an #HclValue
  *
- * Gets all keys from an object value.
+ * Gets all keys from an object value, in the order they were first set.
  *
  * Returns: (transfer container) (element-type utf8): list of keys
  */
@@ -449,7 +802,7 @@ hcl_value_object_get_keys (HclValue *value)
   g_return_val_if_fail (HCL_IS_VALUE (value), NULL);
   g_return_val_if_fail (value->type == HCL_VALUE_TYPE_OBJECT, NULL);
 
-  return g_hash_table_get_keys (value->data.object_value);
+  return hcl_map_get_keys (value->data.object_value);
 }
 
 /**
@@ -468,7 +821,39 @@ hcl_value_object_get_member (HclValue *value, const gchar *key)
   g_return_val_if_fail (value->type == HCL_VALUE_TYPE_OBJECT, NULL);
   g_return_val_if_fail (key != NULL, NULL);
 
-  return g_hash_table_lookup (value->data.object_value, key);
+  return hcl_map_lookup_string (value->data.object_value, key);
+}
+
+/*
+ * hcl_value_object_get_member_interned:
+ * @key: an interned key
+ *
+ * Like hcl_value_object_get_member(), for callers that interned @key
+ * already.
+ */
+HclValue *
+hcl_value_object_get_member_interned (HclValue *value, const gchar *key)
+{
+  return hcl_map_lookup (value->data.object_value, key);
+}
+
+/* Number of members of an object value */
+guint
+hcl_value_object_get_size (HclValue *value)
+{
+  return hcl_map_get_size (value->data.object_value);
+}
+
+/*
+ * hcl_value_object_iter_init:
+ *
+ * Walks the members of an object value without copying the keys, in the
+ * order they were set.
+ */
+void
+hcl_value_object_iter_init (HclValue *value, HclMapIter *iter)
+{
+  hcl_map_iter_init (iter, value->data.object_value);
 }
 
 /**
@@ -477,17 +862,34 @@ hcl_value_object_get_member (HclValue *value, const gchar *key)
  * @key: member key
  * @member: (transfer full): member value
  *
- * Sets a member in an object value.
+ * Sets a member in an object value, which must not be frozen.
  */
 void
 hcl_value_object_set_member (HclValue *value, const gchar *key, HclValue *member)
 {
   g_return_if_fail (HCL_IS_VALUE (value));
   g_return_if_fail (value->type == HCL_VALUE_TYPE_OBJECT);
+  g_return_if_fail (!value->frozen);
   g_return_if_fail (key != NULL);
   g_return_if_fail (HCL_IS_VALUE (member));
 
-  g_hash_table_insert (value->data.object_value, g_strdup (key), member);
+  hcl_value_unshare (value);
+  hcl_value_map_insert (value->data.object_value, g_intern_string (key), member,
+                        value, HCL_PARENT_VALUE);
+}
+
+/*
+ * hcl_value_object_set_member_interned:
+ * @key: an interned key
+ *
+ * Like hcl_value_object_set_member(), for callers that interned @key
+ * already.
+ */
+void
+hcl_value_object_set_member_interned (HclValue *value, const gchar *key, HclValue *member)
+{
+  hcl_value_unshare (value);
+  hcl_value_map_insert (value->data.object_value, key, member, value, HCL_PARENT_VALUE);
 }
 
 /**
@@ -506,5 +908,474 @@ hcl_value_object_has_member (HclValue *value, const gchar *key)
   g_return_val_if_fail (value->type == HCL_VALUE_TYPE_OBJECT, FALSE);
   g_return_val_if_fail (key != NULL, FALSE);
 
-  return g_hash_table_contains (value->data.object_value, key);
+  return hcl_map_lookup_string (value->data.object_value, key) != NULL;
+}
+
+static inline gboolean
+hcl_value_is_container (HclValue *value)
+{
+  return value->type == HCL_VALUE_TYPE_LIST || value->type == HCL_VALUE_TYPE_OBJECT;
+}
+
+/* Strings never change, and frozen values no longer do */
+static inline gboolean
+hcl_value_hash_is_current (HclValue *value)
+{
+  return value->hashed &&
+         (value->frozen || !hcl_value_is_container (value) ||
+          value->hash_epoch == hcl_hash_get_epoch ());
+}
+
+/**
+ * hcl_value_freeze:
+ * @value: an #HclValue
+ *
+ * Makes @value and everything inside it immutable, so that copies can
+ * share it instead of copying it. Adding to a frozen list or setting a
+ * member of a frozen object is an error; change a copy instead.
+ *
+ * Parts of @value that are frozen already are not visited again.
+ */
+void
+hcl_value_freeze (HclValue *value)
+{
+  g_autoptr(GPtrArray) pending = NULL;
+
+  g_return_if_fail (HCL_IS_VALUE (value));
+
+  pending = g_ptr_array_new ();
+  g_ptr_array_add (pending, value);
+
+  while (pending->len > 0) {
+    HclValue *next = g_ptr_array_steal_index_fast (pending, pending->len - 1);
+    HclMapIter iter;
+    gpointer member;
+
+    if (next->frozen)
+      continue;
+
+    /* A frozen value keeps its hash for good, and needs no parent */
+    if (!hcl_value_hash_is_current (next))
+      next->hashed = FALSE;
+    next->frozen = TRUE;
+    next->parent = NULL;
+    next->parent_kind = HCL_PARENT_NONE;
+
+    if (next->packed) {
+      GPtrArray *items = g_atomic_pointer_get (&next->data.array.items);
+
+      for (guint i = 0; items && i < items->len; i++)
+        g_ptr_array_add (pending, g_ptr_array_index (items, i));
+      continue;
+    }
+
+    /* Borrowed items belong to a frozen value, so they are frozen too */
+    if (!hcl_value_is_container (next) || next->borrowed)
+      continue;
+
+    if (next->type == HCL_VALUE_TYPE_LIST) {
+      for (guint i = 0; i < next->data.list_value->len; i++)
+        g_ptr_array_add (pending, g_ptr_array_index (next->data.list_value, i));
+    } else {
+      hcl_map_iter_init (&iter, next->data.object_value);
+      while (hcl_map_iter_next (&iter, NULL, &member))
+        g_ptr_array_add (pending, member);
+    }
+  }
+}
+
+/**
+ * hcl_value_is_frozen:
+ * @value: an #HclValue
+ *
+ * Checks whether @value was frozen with hcl_value_freeze(), directly or
+ * as part of a value that contains it.
+ *
+ * Returns: %TRUE if the value is frozen
+ */
+gboolean
+hcl_value_is_frozen (HclValue *value)
+{
+  g_return_val_if_fail (HCL_IS_VALUE (value), FALSE);
+
+  return value->frozen;
+}
+
+/* A list or object that shares the items of @source until it changes */
+static HclValue *
+hcl_value_new_borrowed (HclValue *source)
+{
+  HclValue *self = g_object_new (HCL_TYPE_VALUE, NULL);
+
+  self->type = source->type;
+  self->borrowed = TRUE;
+
+  if (source->packed) {
+    /* The items, if asked for, are made again */
+    self->packed = TRUE;
+    self->data.array.number_type = source->data.array.number_type;
+    self->data.array.numbers = g_array_ref (source->data.array.numbers);
+  } else if (source->type == HCL_VALUE_TYPE_LIST) {
+    self->data.list_value = g_ptr_array_ref (source->data.list_value);
+  } else {
+    self->data.object_value = hcl_map_ref (source->data.object_value);
+  }
+
+  if (hcl_value_hash_is_current (source)) {
+    self->hash = source->hash;
+    self->hash_epoch = hcl_hash_get_epoch ();
+    self->hashed = TRUE;
+  }
+
+  return self;
+}
+
+/*
+ * What goes into a copy in place of @child. Scalars never change and
+ * frozen values no longer do, so they are shared; other lists and
+ * objects get an empty copy that is queued on @pending, after their
+ * source, to be filled in.
+ */
+static HclValue *
+hcl_value_copy_child (HclValue *child, GPtrArray *pending)
+{
+  HclValue *copy;
+
+  if (!hcl_value_is_container (child) || child->frozen)
+    return g_object_ref (child);
+
+  if (child->borrowed)
+    return hcl_value_new_borrowed (child);
+
+  if (child->packed)
+    return hcl_value_new_array (child->data.array.number_type,
+                                child->data.array.numbers->data,
+                                child->data.array.numbers->len);
+
+  copy = child->type == HCL_VALUE_TYPE_LIST ? hcl_value_new_list () : hcl_value_new_object ();
+  g_ptr_array_add (pending, child);
+  g_ptr_array_add (pending, copy);
+
+  return copy;
+}
+
+/**
+ * hcl_value_copy:
+ * @value: an #HclValue
+ *
+ * Copies @value, so that the copy can be changed without changing
+ * @value and the other way around.
+ *
+ * Copying a frozen list or object takes constant time whatever its size:
+ * the copy shares the items and copies them only when it is first
+ * changed, and then only the level that changes. Items it shares are
+ * frozen, so to change one, copy it and set the copy in its place. Of an
+ * unfrozen value, only the lists and objects that are not frozen are
+ * copied.
+ *
+ * Returns: (transfer full): the copy
+ */
+HclValue *
+hcl_value_copy (HclValue *value)
+{
+  g_autoptr(GPtrArray) pending = NULL;
+  HclValue *copy;
+
+  g_return_val_if_fail (HCL_IS_VALUE (value), NULL);
+
+  if (!hcl_value_is_container (value))
+    return g_object_ref (value);
+
+  if (value->frozen || value->borrowed)
+    return hcl_value_new_borrowed (value);
+
+  pending = g_ptr_array_new ();
+  copy = hcl_value_copy_child (value, pending);
+
+  /* Fill in one list or object at a time, without recursing */
+  while (pending->len > 0) {
+    HclValue *target = g_ptr_array_steal_index_fast (pending, pending->len - 1);
+    HclValue *source = g_ptr_array_steal_index_fast (pending, pending->len - 1);
+    HclMapIter iter;
+    const gchar *key;
+    gpointer member;
+
+    if (source->type == HCL_VALUE_TYPE_LIST) {
+      for (guint i = 0; i < source->data.list_value->len; i++) {
+        HclValue *item = hcl_value_copy_child (g_ptr_array_index (source->data.list_value, i),
+                                               pending);
+
+        hcl_value_set_parent (item, target, HCL_PARENT_VALUE);
+        g_ptr_array_add (target->data.list_value, item);
+      }
+    } else {
+      hcl_map_iter_init (&iter, source->data.object_value);
+      while (hcl_map_iter_next (&iter, &key, &member)) {
+        HclValue *copy_member = hcl_value_copy_child (member, pending);
+
+        hcl_value_set_parent (copy_member, target, HCL_PARENT_VALUE);
+        hcl_map_insert (target->data.object_value, key, copy_member);
+      }
+    }
+  }
+
+  return copy;
+}
+
+/*
+ * hcl_value_set_parent:
+ *
+ * Records that @value was added to @parent, so that changing it clears
+ * the cached hash of @parent. A list or object added to a second
+ * container is marked shared for good.
+ */
+void
+hcl_value_set_parent (HclValue *value, gpointer parent, HclParentKind kind)
+{
+  if (value->frozen || !hcl_value_is_container (value))
+    return;
+
+  if (value->parent && value->parent != parent)
+    value->shared = TRUE;
+
+  value->parent = parent;
+  value->parent_kind = kind;
+}
+
+/* Forgets @parent, which no longer holds @value */
+void
+hcl_value_unset_parent (HclValue *value, gpointer parent)
+{
+  if (value->frozen || value->parent != parent)
+    return;
+
+  value->parent = NULL;
+  value->parent_kind = HCL_PARENT_NONE;
+}
+
+/*
+ * hcl_value_forget_hash:
+ *
+ * Clears the cached hash of @value, for hcl_hash_invalidate(), and gives
+ * the container to clear next: none if @value had no hash to clear.
+ * Returns %TRUE if @value is shared.
+ */
+gboolean
+hcl_value_forget_hash (HclValue *value, gpointer *parent, HclParentKind *kind)
+{
+  *parent = value->hashed ? value->parent : NULL;
+  *kind = value->parent_kind;
+  value->hashed = FALSE;
+
+  return value->shared;
+}
+
+/*
+ * hcl_value_map_insert:
+ *
+ * Sets @key of @map, the attributes or members of @parent, to @value,
+ * and clears the cached hashes @value changes.
+ */
+void
+hcl_value_map_insert (HclMap *map,
+                      const gchar *key,
+                      HclValue *value,
+                      gpointer parent,
+                      HclParentKind kind)
+{
+  HclValue *old;
+
+  hcl_value_set_parent (value, parent, kind);
+  old = hcl_map_replace (map, key, value);
+
+  if (old) {
+    if (old != value)
+      hcl_value_unset_parent (old, parent);
+    g_object_unref (old);
+  }
+
+  hcl_hash_invalidate (parent, kind);
+}
+
+/* Numbers and booleans are cheaper to hash than to cache */
+static guint64
+hcl_value_hash_scalar (HclValue *value)
+{
+  switch (value->type) {
+    case HCL_VALUE_TYPE_BOOL:
+      return hcl_hash_combine (HCL_VALUE_TYPE_BOOL, value->data.bool_value != FALSE);
+
+    case HCL_VALUE_TYPE_NUMBER:
+      return hcl_hash_number (value->data.number.number_type,
+                              value->data.number.int_value,
+                              value->data.number.double_value);
+
+    case HCL_VALUE_TYPE_STRING:
+      if (!value->hashed) {
+        value->hash = hcl_hash_combine (HCL_VALUE_TYPE_STRING,
+                                        hcl_hash_string (value->data.string_value));
+        value->hashed = TRUE;
+      }
+      return value->hash;
+
+    default:
+      return hcl_hash_mix (HCL_VALUE_TYPE_NULL);
+  }
+}
+
+typedef struct {
+  HclValue *value;
+  guint index;              /* LIST: the next item */
+  HclMapIter members;       /* OBJECT: the next member */
+  const gchar *name;        /* OBJECT: the member being hashed */
+  guint64 hash;             /* LIST: so far; OBJECT: the sum of the members */
+} HclValueHashFrame;
+
+static void
+hcl_value_hash_frame_init (HclValueHashFrame *frame, HclValue *value)
+{
+  frame->value = value;
+  frame->index = 0;
+  frame->name = NULL;
+
+  if (value->type == HCL_VALUE_TYPE_OBJECT) {
+    hcl_map_iter_init (&frame->members, value->data.object_value);
+    frame->hash = 0;
+  } else {
+    frame->hash = hcl_hash_combine (HCL_VALUE_TYPE_LIST, hcl_value_list_get_length (value));
+  }
+}
+
+/* Adds the hash of an item or member to @frame */
+static void
+hcl_value_hash_frame_add (HclValueHashFrame *frame, guint64 hash)
+{
+  if (frame->value->type == HCL_VALUE_TYPE_OBJECT)
+    frame->hash += hcl_hash_combine (hcl_hash_string (frame->name), hash);
+  else
+    frame->hash = hcl_hash_combine (frame->hash, hash);
+}
+
+/* The next item or member of @frame to hash, or %NULL when done */
+static HclValue *
+hcl_value_hash_frame_next (HclValueHashFrame *frame)
+{
+  HclValue *value = frame->value;
+  gpointer member;
+
+  if (value->type == HCL_VALUE_TYPE_OBJECT)
+    return hcl_map_iter_next (&frame->members, &frame->name, &member) ? member : NULL;
+
+  if (value->packed) {
+    GArray *numbers = value->data.array.numbers;
+
+    for (; frame->index < numbers->len; frame->index++) {
+      gboolean integer = value->data.array.number_type == HCL_NUMBER_TYPE_INTEGER;
+
+      frame->hash = hcl_hash_combine (frame->hash,
+                                      hcl_hash_number (value->data.array.number_type,
+                                                       integer ? g_array_index (numbers, gint64, frame->index) : 0,
+                                                       integer ? 0 : g_array_index (numbers, gdouble, frame->index)));
+    }
+    return NULL;
+  }
+
+  if (frame->index < value->data.list_value->len)
+    return g_ptr_array_index (value->data.list_value, frame->index++);
+
+  return NULL;
+}
+
+/**
+ * hcl_value_hash:
+ * @value: an #HclValue
+ *
+ * Gets a 64-bit hash of the contents of @value. Equal values hash alike,
+ * whatever order the members of an object were set in, and a packed
+ * list hashes like the same numbers stored as values. Values that differ
+ * hash alike only by chance.
+ *
+ * The hashes of strings, lists and objects are cached. Changing a list
+ * or object clears the cached hashes of it and of whatever holds it, up
+ * to the document, and nothing else, so asking again hashes only what
+ * changed.
+ *
+ * Returns: the hash
+ */
+guint64
+hcl_value_hash (HclValue *value)
+{
+  g_autoptr(GArray) stack = NULL;
+  guint epoch;
+
+  g_return_val_if_fail (HCL_IS_VALUE (value), 0);
+
+  if (!hcl_value_is_container (value))
+    return hcl_value_hash_scalar (value);
+
+  if (hcl_value_hash_is_current (value))
+    return value->hash;
+
+  /* Hash one list or object at a time, without recursing */
+  epoch = hcl_hash_get_epoch ();
+  stack = g_array_sized_new (FALSE, FALSE, sizeof (HclValueHashFrame), 8);
+  g_array_set_size (stack, 1);
+  hcl_value_hash_frame_init (&g_array_index (stack, HclValueHashFrame, 0), value);
+
+  for (;;) {
+    HclValueHashFrame *frame = &g_array_index (stack, HclValueHashFrame, stack->len - 1);
+    HclValue *next = hcl_value_hash_frame_next (frame);
+    guint64 hash;
+
+    if (next) {
+      if (!hcl_value_is_container (next)) {
+        hcl_value_hash_frame_add (frame, hcl_value_hash_scalar (next));
+      } else if (hcl_value_hash_is_current (next)) {
+        hcl_value_hash_frame_add (frame, next->hash);
+      } else {
+        g_array_set_size (stack, stack->len + 1);
+        hcl_value_hash_frame_init (&g_array_index (stack, HclValueHashFrame, stack->len - 1),
+                                   next);
+      }
+      continue;
+    }
+
+    hash = frame->hash;
+    if (frame->value->type == HCL_VALUE_TYPE_OBJECT)
+      hash = hcl_hash_combine (HCL_VALUE_TYPE_OBJECT, hash);
+
+    frame->value->hash = hash;
+    frame->value->hash_epoch = epoch;
+    frame->value->hashed = TRUE;
+
+    g_array_set_size (stack, stack->len - 1);
+    if (stack->len == 0)
+      return hash;
+
+    hcl_value_hash_frame_add (&g_array_index (stack, HclValueHashFrame, stack->len - 1), hash);
+  }
+}
+
+/**
+ * hcl_value_to_string:
+ * @value: an #HclValue
+ *
+ * Formats @value as an HCL expression, the way an #HclWriter in the
+ * %HCL_WRITER_STYLE_PRETTY style writes it.
+ *
+ * Returns: (transfer full): a newly allocated string
+ */
+gchar *
+hcl_value_to_string (HclValue *value)
+{
+  g_autoptr(HclWriter) writer = NULL;
+  GString *buffer;
+
+  g_return_val_if_fail (HCL_IS_VALUE (value), NULL);
+
+  writer = hcl_writer_new ();
+  buffer = g_string_new (NULL);
+  hcl_writer_write_value (writer, value, buffer);
+
+  return g_string_free (buffer, FALSE);
 }
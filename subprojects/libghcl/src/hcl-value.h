@@ -25,17 +25,26 @@ HclValue *hcl_value_new_bool          (gboolean value);
 HclValue *hcl_value_new_int           (gint64 value);
 HclValue *hcl_value_new_double        (gdouble value);
 HclValue *hcl_value_new_string        (const gchar *value);
+HclValue *hcl_value_new_string_len    (const gchar *value,
+                                       gssize length);
+HclValue *hcl_value_new_take_string   (gchar *value);
 HclValue *hcl_value_new_list          (void);
 HclValue *hcl_value_new_object        (void);
+HclValue *hcl_value_new_int_array     (const gint64 *values,
+                                       guint length);
+HclValue *hcl_value_new_double_array  (const gdouble *values,
+                                       guint length);
 
 /* Type checking */
 HclValueType    hcl_value_get_value_type    (HclValue *value);
+HclNumberType   hcl_value_get_number_type   (HclValue *value);
 gboolean        hcl_value_is_null           (HclValue *value);
 gboolean        hcl_value_is_bool           (HclValue *value);
 gboolean        hcl_value_is_number         (HclValue *value);
 gboolean        hcl_value_is_string         (HclValue *value);
 gboolean        hcl_value_is_list           (HclValue *value);
 gboolean        hcl_value_is_object         (HclValue *value);
+gboolean        hcl_value_is_array          (HclValue *value);
 
 /* Value getters */
 gboolean        hcl_value_get_bool          (HclValue *value);
@@ -47,6 +56,8 @@ const gchar    *hcl_value_get_string        (HclValue *value);
 guint           hcl_value_list_get_length   (HclValue *value);
 HclValue       *hcl_value_list_get_item     (HclValue *value, guint index);
 void            hcl_value_list_add_item     (HclValue *value, HclValue *item);
+const gint64   *hcl_value_get_int_array     (HclValue *value, guint *length);
+const gdouble  *hcl_value_get_double_array  (HclValue *value, guint *length);
 
 /* Object operations */
 GList          *hcl_value_object_get_keys   (HclValue *value);
@@ -54,9 +65,14 @@ HclValue       *hcl_value_object_get_member (HclValue *value, const gchar *key);
 void            hcl_value_object_set_member (HclValue *value, const gchar *key, HclValue *member);
 gboolean        hcl_value_object_has_member (HclValue *value, const gchar *key);
 
+/* Freezing */
+void            hcl_value_freeze            (HclValue *value);
+gboolean        hcl_value_is_frozen         (HclValue *value);
+
 /* Utility */
 gchar          *hcl_value_to_string         (HclValue *value);
 HclValue       *hcl_value_copy              (HclValue *value);
+guint64         hcl_value_hash              (HclValue *value);
 
 G_END_DECLS
 
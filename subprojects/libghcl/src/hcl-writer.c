@@ -0,0 +1,791 @@
+/* hcl-writer.c - Serializing HCL documents
+ *
+ * Copyright 2024 Geoff Johnson <geoff.jay@gmail.com>
+ */
+
+#include "hcl-writer.h"
+#include "hcl-private.h"
+#include "hcl-scan.h"
+#include <math.h>
+#include <string.h>
+
+/**
+ * SECTION:hcl-writer
+ * @short_description: HCL serializer
+ * @title: HclWriter
+ *
+ * #HclWriter turns documents, blocks and values back into HCL text,
+ * appending to one #GString or streaming to a #GOutputStream. The text
+ * parses back to the same tree, and writing that tree again gives the
+ * same bytes. Attributes, object members and blocks are written in the
+ * order they were added.
+ *
+ * Attribute names and block types are written as they are, so they
+ * must be identifiers for the text to parse. Object keys that are not
+ * are quoted. Numbers that are not finite have no HCL form, so they
+ * cannot be written.
+ */
+
+/*
+ * Like the parser, the writer walks the tree with an explicit stack of
+ * frames, one for each block body, list and object that is open, and
+ * appends every token to a single buffer as it goes; nothing is
+ * formatted into a string of its own for its parent to copy. Writing to
+ * a stream hands the buffer over whenever it fills up, so the memory
+ * used depends on how deeply the document nests, not on its size.
+ */
+
+#define HCL_WRITER_CHUNK_SIZE 8192
+
+typedef enum {
+  HCL_WRITE_FRAME_BODY,
+  HCL_WRITE_FRAME_LIST,
+  HCL_WRITE_FRAME_OBJECT
+} HclWriteFrameKind;
+
+typedef struct {
+  HclWriteFrameKind kind;
+  gpointer node;            /* The HclDocument, HclBlock or HclValue */
+  HclMapIter names;         /* BODY, OBJECT: attributes or members */
+  GPtrArray *blocks;        /* BODY: the child blocks */
+  guint index;              /* Next block, item or member */
+  guint level;              /* Indentation of the lines inside */
+  gboolean multiline;       /* LIST, OBJECT: one item or member per line */
+  gboolean is_block;        /* BODY: a block body rather than a document */
+} HclWriteFrame;
+
+struct _HclWriter
+{
+  GObject parent_instance;
+
+  HclWriterStyle style;
+  guint indent;
+
+  GArray *frames;  /* HclWriteFrame, reused from one write to the next */
+};
+
+/* State of one write */
+typedef struct {
+  HclWriter *writer;
+  GString *buffer;
+  GOutputStream *stream;    /* Takes the buffer when it fills, or NULL */
+  GCancellable *cancellable;
+  GError *error;
+} HclWriteContext;
+
+G_DEFINE_FINAL_TYPE (HclWriter, hcl_writer, G_TYPE_OBJECT)
+
+static void
+hcl_writer_finalize (GObject *object)
+{
+  HclWriter *self = HCL_WRITER (object);
+
+  g_array_unref (self->frames);
+
+  G_OBJECT_CLASS (hcl_writer_parent_class)->finalize (object);
+}
+
+static void
+hcl_writer_class_init (HclWriterClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = hcl_writer_finalize;
+}
+
+static void
+hcl_writer_init (HclWriter *self)
+{
+  self->style = HCL_WRITER_STYLE_PRETTY;
+  self->indent = HCL_WRITER_DEFAULT_INDENT;
+  self->frames = g_array_new (FALSE, FALSE, sizeof (HclWriteFrame));
+}
+
+/**
+ * hcl_writer_new:
+ *
+ * Creates a new HCL writer using the %HCL_WRITER_STYLE_PRETTY style.
+ *
+ * Returns: (transfer full): a new #HclWriter
+ */
+HclWriter *
+hcl_writer_new (void)
+{
+  return g_object_new (HCL_TYPE_WRITER, NULL);
+}
+
+/**
+ * hcl_writer_get_style:
+ * @writer: an #HclWriter
+ *
+ * Gets how the writer lays out its text.
+ *
+ * Returns: the #HclWriterStyle
+ */
+HclWriterStyle
+hcl_writer_get_style (HclWriter *writer)
+{
+  g_return_val_if_fail (HCL_IS_WRITER (writer), HCL_WRITER_STYLE_PRETTY);
+
+  return writer->style;
+}
+
+/**
+ * hcl_writer_set_style:
+ * @writer: an #HclWriter
+ * @style: an #HclWriterStyle
+ *
+ * Sets how the writer lays out its text.
+ */
+void
+hcl_writer_set_style (HclWriter *writer, HclWriterStyle style)
+{
+  g_return_if_fail (HCL_IS_WRITER (writer));
+
+  writer->style = style;
+}
+
+/**
+ * hcl_writer_get_indent:
+ * @writer: an #HclWriter
+ *
+ * Gets how many spaces each level is indented by in the
+ * %HCL_WRITER_STYLE_PRETTY style.
+ *
+ * Returns: the number of spaces
+ */
+guint
+hcl_writer_get_indent (HclWriter *writer)
+{
+  g_return_val_if_fail (HCL_IS_WRITER (writer), 0);
+
+  return writer->indent;
+}
+
+/**
+ * hcl_writer_set_indent:
+ * @writer: an #HclWriter
+ * @indent: number of spaces
+ *
+ * Sets how many spaces each level is indented by in the
+ * %HCL_WRITER_STYLE_PRETTY style. The default is
+ * %HCL_WRITER_DEFAULT_INDENT.
+ */
+void
+hcl_writer_set_indent (HclWriter *writer, guint indent)
+{
+  g_return_if_fail (HCL_IS_WRITER (writer));
+
+  writer->indent = indent;
+}
+
+static inline gboolean
+hcl_writer_is_pretty (HclWriteContext *context)
+{
+  return context->writer->style == HCL_WRITER_STYLE_PRETTY;
+}
+
+static HclWriteFrame *
+hcl_writer_top_frame (HclWriteContext *context)
+{
+  GArray *frames = context->writer->frames;
+
+  return frames->len ? &g_array_index (frames, HclWriteFrame, frames->len - 1) : NULL;
+}
+
+static HclWriteFrame *
+hcl_writer_push_frame (HclWriteContext *context, HclWriteFrameKind kind, guint level)
+{
+  GArray *frames = context->writer->frames;
+  HclWriteFrame *frame;
+
+  g_array_set_size (frames, frames->len + 1);
+  frame = &g_array_index (frames, HclWriteFrame, frames->len - 1);
+  memset (frame, 0, sizeof *frame);
+  frame->kind = kind;
+  frame->level = level;
+
+  return frame;
+}
+
+static void
+hcl_writer_pop_frame (HclWriteContext *context)
+{
+  g_array_set_size (context->writer->frames, context->writer->frames->len - 1);
+}
+
+static void
+hcl_writer_append_indent (HclWriteContext *context, guint level)
+{
+  static const gchar spaces[] = "                                ";
+  gsize count = (gsize) level * context->writer->indent;
+
+  if (!hcl_writer_is_pretty (context))
+    return;
+
+  for (; count > sizeof spaces - 1; count -= sizeof spaces - 1)
+    g_string_append_len (context->buffer, spaces, sizeof spaces - 1);
+  g_string_append_len (context->buffer, spaces, (gssize) count);
+}
+
+/* Writes @string as a quoted literal, escaping what the lexer unescapes */
+static void
+hcl_writer_append_quoted (GString *buffer, const gchar *string)
+{
+  g_string_append_c (buffer, '"');
+
+  for (;;) {
+    gsize run = strcspn (string, "\"\\\n\r\t");
+
+    /* Copy everything up to the next character to escape in one go */
+    g_string_append_len (buffer, string, (gssize) run);
+    string += run;
+
+    if (*string == '\0')
+      break;
+
+    g_string_append_c (buffer, '\\');
+    switch (*string) {
+      case '\n':
+        g_string_append_c (buffer, 'n');
+        break;
+      case '\r':
+        g_string_append_c (buffer, 'r');
+        break;
+      case '\t':
+        g_string_append_c (buffer, 't');
+        break;
+      default:
+        g_string_append_c (buffer, *string);
+        break;
+    }
+    string++;
+  }
+
+  g_string_append_c (buffer, '"');
+}
+
+/* Writes an object key bare if it reads back as an identifier */
+static void
+hcl_writer_append_key (GString *buffer, const gchar *key)
+{
+  gsize length = strlen (key);
+
+  if ((g_ascii_isalpha (key[0]) || key[0] == '_') &&
+      hcl_scan_identifier (key, length) == length &&
+      !g_str_equal (key, "true") &&
+      !g_str_equal (key, "false") &&
+      !g_str_equal (key, "null"))
+    g_string_append_len (buffer, key, (gssize) length);
+  else
+    hcl_writer_append_quoted (buffer, key);
+}
+
+/* Formats @value by hand, which costs a fraction of going through printf */
+static void
+hcl_writer_append_int (GString *buffer, gint64 value)
+{
+  gchar text[24];
+  gchar *end = text + sizeof text;
+  gchar *start = end;
+  guint64 magnitude = value < 0 ? 0 - (guint64) value : (guint64) value;
+
+  do {
+    *--start = (gchar) ('0' + magnitude % 10);
+    magnitude /= 10;
+  } while (magnitude > 0);
+
+  if (value < 0)
+    *--start = '-';
+
+  g_string_append_len (buffer, start, end - start);
+}
+
+/*
+ * Writes the shortest decimal form that reads back as @value, keeping a
+ * fraction or an exponent so that it reads back as a float. Infinities
+ * and NaN have no such form, so they fail the write instead.
+ */
+static gboolean
+hcl_writer_append_double (HclWriteContext *context, gdouble value)
+{
+  static const gchar * const formats[] = { "%.15g", "%.16g", "%.17g" };
+  gchar text[G_ASCII_DTOSTR_BUF_SIZE];
+
+  if (!isfinite (value)) {
+    g_set_error (&context->error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+                 "Cannot write %s, HCL has no literal for it",
+                 isnan (value) ? "NaN" : "an infinite number");
+    return FALSE;
+  }
+
+  for (guint i = 0; i < G_N_ELEMENTS (formats); i++) {
+    g_ascii_formatd (text, sizeof text, formats[i], value);
+    if (g_ascii_strtod (text, NULL) == value)
+      break;
+  }
+
+  g_string_append (context->buffer, text);
+  if (strpbrk (text, ".eE") == NULL)
+    g_string_append (context->buffer, ".0");
+
+  return TRUE;
+}
+
+static inline void
+hcl_writer_append_assign (HclWriteContext *context)
+{
+  if (hcl_writer_is_pretty (context))
+    g_string_append_len (context->buffer, " = ", 3);
+  else
+    g_string_append_c (context->buffer, '=');
+}
+
+/* Finishes a value: an attribute ends its line, items and members don't */
+static void
+hcl_writer_end_value (HclWriteContext *context)
+{
+  HclWriteFrame *parent = hcl_writer_top_frame (context);
+
+  if (parent && parent->kind == HCL_WRITE_FRAME_BODY)
+    g_string_append_c (context->buffer, '\n');
+}
+
+/* Writes a packed list in one go, without making values of its numbers */
+static void
+hcl_writer_append_array (HclWriteContext *context, HclValue *list)
+{
+  GString *buffer = context->buffer;
+  gboolean pretty = hcl_writer_is_pretty (context);
+  guint length;
+  const gint64 *ints = hcl_value_get_int_array (list, &length);
+  const gdouble *doubles = ints ? NULL : hcl_value_get_double_array (list, &length);
+
+  g_string_append_c (buffer, '[');
+  for (guint i = 0; i < length; i++) {
+    if (i > 0)
+      g_string_append_len (buffer, ", ", pretty ? 2 : 1);
+
+    if (ints)
+      hcl_writer_append_int (buffer, ints[i]);
+    else if (!hcl_writer_append_double (context, doubles[i]))
+      return;
+  }
+  g_string_append_c (buffer, ']');
+}
+
+/* Whether a list needs a line per item to stay readable */
+static gboolean
+hcl_writer_list_is_multiline (HclWriteContext *context, HclValue *list)
+{
+  guint length = hcl_value_list_get_length (list);
+
+  if (!hcl_writer_is_pretty (context))
+    return FALSE;
+
+  for (guint i = 0; i < length; i++) {
+    HclValue *item = hcl_value_list_get_item (list, i);
+
+    if ((hcl_value_is_list (item) && hcl_value_list_get_length (item) > 0) ||
+        (hcl_value_is_object (item) && hcl_value_object_get_size (item) > 0))
+      return TRUE;
+  }
+
+  return FALSE;
+}
+
+/*
+ * Writes the value at the end of a line indented by @level. Scalars and
+ * empty containers are written straight away; other lists and objects
+ * push a frame that writes their contents.
+ */
+static void
+hcl_writer_begin_value (HclWriteContext *context, HclValue *value, guint level)
+{
+  GString *buffer = context->buffer;
+  HclWriteFrame *frame;
+
+  switch (hcl_value_get_value_type (value)) {
+    case HCL_VALUE_TYPE_NULL:
+      g_string_append_len (buffer, "null", 4);
+      break;
+
+    case HCL_VALUE_TYPE_BOOL:
+      g_string_append (buffer, hcl_value_get_bool (value) ? "true" : "false");
+      break;
+
+    case HCL_VALUE_TYPE_NUMBER:
+      if (hcl_value_get_number_type (value) == HCL_NUMBER_TYPE_INTEGER)
+        hcl_writer_append_int (buffer, hcl_value_get_int (value));
+      else if (!hcl_writer_append_double (context, hcl_value_get_double (value)))
+        return;
+      break;
+
+    case HCL_VALUE_TYPE_STRING:
+      hcl_writer_append_quoted (buffer, hcl_value_get_string (value));
+      break;
+
+    case HCL_VALUE_TYPE_LIST:
+      if (hcl_value_is_array (value)) {
+        hcl_writer_append_array (context, value);
+        break;
+      }
+
+      g_string_append_c (buffer, '[');
+      if (hcl_value_list_get_length (value) == 0) {
+        g_string_append_c (buffer, ']');
+        break;
+      }
+
+      frame = hcl_writer_push_frame (context, HCL_WRITE_FRAME_LIST, level);
+      frame->node = value;
+      frame->multiline = hcl_writer_list_is_multiline (context, value);
+      if (frame->multiline)
+        frame->level++;
+      return;
+
+    case HCL_VALUE_TYPE_OBJECT:
+      g_string_append_c (buffer, '{');
+      if (hcl_value_object_get_size (value) == 0) {
+        g_string_append_c (buffer, '}');
+        break;
+      }
+
+      frame = hcl_writer_push_frame (context, HCL_WRITE_FRAME_OBJECT, level + 1);
+      frame->node = value;
+      frame->multiline = hcl_writer_is_pretty (context);
+      hcl_value_object_iter_init (value, &frame->names);
+      return;
+
+    default:
+      g_assert_not_reached ();
+  }
+
+  hcl_writer_end_value (context);
+}
+
+/* Writes the header of @block on a line indented by @level and opens it */
+static void
+hcl_writer_begin_block (HclWriteContext *context, HclBlock *block, guint level)
+{
+  const gchar *label = hcl_block_get_label (block);
+  HclWriteFrame *frame;
+
+  hcl_writer_append_indent (context, level);
+  g_string_append (context->buffer, hcl_block_get_block_type (block));
+  if (label) {
+    g_string_append_c (context->buffer, ' ');
+    hcl_writer_append_quoted (context->buffer, label);
+  }
+  g_string_append_len (context->buffer, " {\n", 3);
+
+  frame = hcl_writer_push_frame (context, HCL_WRITE_FRAME_BODY, level + 1);
+  frame->node = block;
+  frame->is_block = TRUE;
+  frame->blocks = hcl_block_get_block_list (block)->blocks;
+  hcl_block_attribute_iter_init (block, &frame->names);
+}
+
+/* Writes the next attribute or block of a body, or closes it */
+static void
+hcl_writer_step_body (HclWriteContext *context, HclWriteFrame *frame)
+{
+  gboolean is_block = frame->is_block;
+  guint level = frame->level;
+  const gchar *name;
+  gpointer value;
+
+  if (hcl_map_iter_next (&frame->names, &name, &value)) {
+    hcl_writer_append_indent (context, level);
+    g_string_append (context->buffer, name);
+    hcl_writer_append_assign (context);
+    hcl_writer_begin_value (context, value, level);
+    return;
+  }
+
+  if (frame->index < frame->blocks->len) {
+    HclBlock *block = g_ptr_array_index (frame->blocks, frame->index++);
+
+    hcl_writer_begin_block (context, block, level);
+    return;
+  }
+
+  if (is_block) {
+    hcl_writer_append_indent (context, level - 1);
+    g_string_append_len (context->buffer, "}\n", 2);
+  }
+
+  hcl_writer_pop_frame (context);
+}
+
+/* Writes the next item of a list, or closes it */
+static void
+hcl_writer_step_list (HclWriteContext *context, HclWriteFrame *frame)
+{
+  GString *buffer = context->buffer;
+  gboolean multiline = frame->multiline;
+  guint level = frame->level;
+
+  if (frame->index < hcl_value_list_get_length (frame->node)) {
+    HclValue *item = hcl_value_list_get_item (frame->node, frame->index);
+
+    if (frame->index++ > 0)
+      g_string_append_c (buffer, ',');
+    if (multiline) {
+      g_string_append_c (buffer, '\n');
+      hcl_writer_append_indent (context, level);
+    } else if (frame->index > 1 && hcl_writer_is_pretty (context)) {
+      g_string_append_c (buffer, ' ');
+    }
+
+    hcl_writer_begin_value (context, item, level);
+    return;
+  }
+
+  hcl_writer_pop_frame (context);
+
+  if (multiline) {
+    g_string_append_c (buffer, '\n');
+    hcl_writer_append_indent (context, level - 1);
+  }
+  g_string_append_c (buffer, ']');
+  hcl_writer_end_value (context);
+}
+
+/* Writes the next member of an object, or closes it */
+static void
+hcl_writer_step_object (HclWriteContext *context, HclWriteFrame *frame)
+{
+  GString *buffer = context->buffer;
+  gboolean multiline = frame->multiline;
+  guint level = frame->level;
+  const gchar *key;
+  gpointer member;
+
+  if (hcl_map_iter_next (&frame->names, &key, &member)) {
+    if (multiline) {
+      g_string_append_c (buffer, '\n');
+      hcl_writer_append_indent (context, level);
+    } else if (frame->index > 0) {
+      g_string_append_c (buffer, ',');
+    }
+    frame->index++;
+
+    hcl_writer_append_key (buffer, key);
+    hcl_writer_append_assign (context);
+    hcl_writer_begin_value (context, member, level);
+    return;
+  }
+
+  hcl_writer_pop_frame (context);
+
+  if (multiline) {
+    g_string_append_c (buffer, '\n');
+    hcl_writer_append_indent (context, level - 1);
+  }
+  g_string_append_c (buffer, '}');
+  hcl_writer_end_value (context);
+}
+
+/* Hands what has been written so far to the stream */
+static gboolean
+hcl_writer_flush (HclWriteContext *context)
+{
+  if (!g_output_stream_write_all (context->stream,
+                                  context->buffer->str,
+                                  context->buffer->len,
+                                  NULL,
+                                  context->cancellable,
+                                  &context->error))
+    return FALSE;
+
+  g_string_truncate (context->buffer, 0);
+  return TRUE;
+}
+
+/* Writes whatever the frames on the stack still have to write */
+static gboolean
+hcl_writer_run (HclWriteContext *context)
+{
+  HclWriteFrame *frame;
+
+  while ((frame = hcl_writer_top_frame (context)) != NULL) {
+    if (context->error != NULL ||
+        (context->stream &&
+         context->buffer->len >= HCL_WRITER_CHUNK_SIZE &&
+         !hcl_writer_flush (context))) {
+      while (hcl_writer_top_frame (context))
+        hcl_writer_pop_frame (context);
+      return FALSE;
+    }
+
+    switch (frame->kind) {
+      case HCL_WRITE_FRAME_BODY:
+        hcl_writer_step_body (context, frame);
+        break;
+
+      case HCL_WRITE_FRAME_LIST:
+        hcl_writer_step_list (context, frame);
+        break;
+
+      case HCL_WRITE_FRAME_OBJECT:
+        hcl_writer_step_object (context, frame);
+        break;
+
+      default:
+        g_assert_not_reached ();
+    }
+  }
+
+  if (context->error != NULL)
+    return FALSE;
+
+  return context->stream == NULL || hcl_writer_flush (context);
+}
+
+/*
+ * Runs a write to a buffer. The functions doing these have no way to
+ * report an error, so a value that cannot be written is a programming
+ * error, and the text written for the call is taken back off @buffer.
+ */
+static void
+hcl_writer_finish (HclWriteContext *context, gsize start)
+{
+  if (hcl_writer_run (context))
+    return;
+
+  g_critical ("%s", context->error->message);
+  g_clear_error (&context->error);
+  g_string_truncate (context->buffer, start);
+}
+
+static void
+hcl_writer_begin_document (HclWriteContext *context, HclDocument *document)
+{
+  HclWriteFrame *frame = hcl_writer_push_frame (context, HCL_WRITE_FRAME_BODY, 0);
+
+  frame->node = document;
+  frame->blocks = hcl_document_get_block_list (document)->blocks;
+  hcl_document_attribute_iter_init (document, &frame->names);
+}
+
+/**
+ * hcl_writer_write_document:
+ * @writer: an #HclWriter
+ * @document: an #HclDocument
+ * @buffer: the #GString to append to
+ *
+ * Appends @document to @buffer as HCL text: its attributes, then its
+ * blocks, each on a line of its own. @document must not hold numbers
+ * that are not finite; if it does, nothing is appended.
+ */
+void
+hcl_writer_write_document (HclWriter *writer, HclDocument *document, GString *buffer)
+{
+  HclWriteContext context = { writer, buffer, NULL, NULL, NULL };
+  gsize start;
+
+  g_return_if_fail (HCL_IS_WRITER (writer));
+  g_return_if_fail (HCL_IS_DOCUMENT (document));
+  g_return_if_fail (buffer != NULL);
+
+  start = buffer->len;
+  hcl_writer_begin_document (&context, document);
+  hcl_writer_finish (&context, start);
+}
+
+/**
+ * hcl_writer_write_block:
+ * @writer: an #HclWriter
+ * @block: an #HclBlock
+ * @buffer: the #GString to append to
+ *
+ * Appends @block to @buffer as HCL text, ending with a newline. Like
+ * hcl_writer_write_document(), nothing is appended if @block holds a
+ * number that is not finite.
+ */
+void
+hcl_writer_write_block (HclWriter *writer, HclBlock *block, GString *buffer)
+{
+  HclWriteContext context = { writer, buffer, NULL, NULL, NULL };
+  gsize start;
+
+  g_return_if_fail (HCL_IS_WRITER (writer));
+  g_return_if_fail (HCL_IS_BLOCK (block));
+  g_return_if_fail (buffer != NULL);
+
+  start = buffer->len;
+  hcl_writer_begin_block (&context, block, 0);
+  hcl_writer_finish (&context, start);
+}
+
+/**
+ * hcl_writer_write_value:
+ * @writer: an #HclWriter
+ * @value: an #HclValue
+ * @buffer: the #GString to append to
+ *
+ * Appends @value to @buffer as an HCL expression, such as the right-hand
+ * side of an attribute. No newline is added after it. Nothing is
+ * appended if @value is or holds a number that is not finite.
+ */
+void
+hcl_writer_write_value (HclWriter *writer, HclValue *value, GString *buffer)
+{
+  HclWriteContext context = { writer, buffer, NULL, NULL, NULL };
+  gsize start;
+
+  g_return_if_fail (HCL_IS_WRITER (writer));
+  g_return_if_fail (HCL_IS_VALUE (value));
+  g_return_if_fail (buffer != NULL);
+
+  start = buffer->len;
+  hcl_writer_begin_value (&context, value, 0);
+  hcl_writer_finish (&context, start);
+}
+
+/**
+ * hcl_writer_write_document_to_stream:
+ * @writer: an #HclWriter
+ * @document: an #HclDocument
+ * @stream: a #GOutputStream
+ * @cancellable: (nullable): a #GCancellable, or %NULL
+ * @error: return location for error
+ *
+ * Writes @document to @stream, like hcl_writer_write_document(). The
+ * text is handed to @stream in chunks of a fixed size as it is written,
+ * so the whole document is never held in memory. @stream is not closed.
+ *
+ * A number in @document that is not finite fails the write with
+ * %G_IO_ERROR_INVALID_DATA, after what came before it has been written.
+ *
+ * Returns: %TRUE on success, %FALSE if writing to @stream failed
+ */
+gboolean
+hcl_writer_write_document_to_stream (HclWriter *writer,
+                                     HclDocument *document,
+                                     GOutputStream *stream,
+                                     GCancellable *cancellable,
+                                     GError **error)
+{
+  g_autoptr(GString) buffer = NULL;
+  HclWriteContext context = { writer, NULL, stream, cancellable, NULL };
+
+  g_return_val_if_fail (HCL_IS_WRITER (writer), FALSE);
+  g_return_val_if_fail (HCL_IS_DOCUMENT (document), FALSE);
+  g_return_val_if_fail (G_IS_OUTPUT_STREAM (stream), FALSE);
+  g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), FALSE);
+  g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  /* Flushed whenever it holds a chunk, so it seldom has to grow */
+  buffer = g_string_sized_new (HCL_WRITER_CHUNK_SIZE * 2);
+  context.buffer = buffer;
+
+  hcl_writer_begin_document (&context, document);
+  if (!hcl_writer_run (&context)) {
+    g_propagate_error (error, context.error);
+    return FALSE;
+  }
+
+  return TRUE;
+}
@@ -0,0 +1,60 @@
+/* hcl-writer.h - Serializing HCL documents
+ *
+ * Copyright 2024 Geoff Johnson <geoff.jay@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ */
+
+#ifndef __HCL_WRITER_H__
+#define __HCL_WRITER_H__
+
+#include <gio/gio.h>
+#include "hcl-document.h"
+#include "hcl-enums.h"
+
+G_BEGIN_DECLS
+
+#define HCL_TYPE_WRITER (hcl_writer_get_type())
+G_DECLARE_FINAL_TYPE (HclWriter, hcl_writer, HCL, WRITER, GObject)
+
+/**
+ * HCL_WRITER_DEFAULT_INDENT:
+ *
+ * How many spaces a new #HclWriter indents each level by in the
+ * %HCL_WRITER_STYLE_PRETTY style.
+ */
+#define HCL_WRITER_DEFAULT_INDENT 2
+
+/* Constructor */
+HclWriter      *hcl_writer_new                  (void);
+
+/* Configuration */
+HclWriterStyle  hcl_writer_get_style            (HclWriter *writer);
+void            hcl_writer_set_style            (HclWriter *writer,
+                                                 HclWriterStyle style);
+guint           hcl_writer_get_indent           (HclWriter *writer);
+void            hcl_writer_set_indent           (HclWriter *writer,
+                                                 guint indent);
+
+/* Writing */
+void            hcl_writer_write_document       (HclWriter *writer,
+                                                 HclDocument *document,
+                                                 GString *buffer);
+void            hcl_writer_write_block          (HclWriter *writer,
+                                                 HclBlock *block,
+                                                 GString *buffer);
+void            hcl_writer_write_value          (HclWriter *writer,
+                                                 HclValue *value,
+                                                 GString *buffer);
+gboolean        hcl_writer_write_document_to_stream (HclWriter *writer,
+                                                     HclDocument *document,
+                                                     GOutputStream *stream,
+                                                     GCancellable *cancellable,
+                                                     GError **error);
+
+G_END_DECLS
+
+#endif /* __HCL_WRITER_H__ */
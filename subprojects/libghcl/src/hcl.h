@@ -23,9 +23,15 @@ G_BEGIN_DECLS
 #include "hcl-enums.h"
 #include "hcl-value.h"
 #include "hcl-block.h"
+#include "hcl-diagnostic.h"
+#include "hcl-diff.h"
 #include "hcl-document.h"
+#include "hcl-frozen-document.h"
 #include "hcl-lexer.h"
 #include "hcl-parser.h"
+#include "hcl-path.h"
+#include "hcl-stream-parser.h"
+#include "hcl-writer.h"
 
 G_END_DECLS
 
@@ -62,6 +62,99 @@ test_block_nested_blocks (void)
   g_list_free (other_blocks);
 }
 
+static void
+test_block_interned_keys (void)
+{
+  g_autofree gchar *type = g_strdup ("service");
+  g_autofree gchar *name = g_strdup ("interned_port");
+  g_autoptr(HclBlock) first = hcl_block_new ("service", NULL);
+  g_autoptr(HclBlock) second = hcl_block_new (type, NULL);
+
+  hcl_block_set_attribute (first, name, hcl_value_new_int (1));
+  hcl_block_set_attribute (second, "interned_port", hcl_value_new_int (2));
+
+  /* Equal keys and types from different objects share one copy */
+  g_autoptr(GList) first_names = hcl_block_get_attribute_names (first);
+  g_autoptr(GList) second_names = hcl_block_get_attribute_names (second);
+  g_assert_true (first_names->data == second_names->data);
+  g_assert_true (first_names->data != (gpointer) name);
+  g_assert_true (hcl_block_get_block_type (first) == hcl_block_get_block_type (second));
+
+  /* Lookups work with any copy of the key and don't intern unknown ones */
+  g_assert_cmpint (hcl_value_get_int (hcl_block_get_attribute (first, name)), ==, 1);
+  g_assert_null (hcl_block_get_attribute (first, "never-used-as-a-key"));
+  g_assert_false (hcl_block_has_attribute (first, "never-used-as-a-key"));
+  g_assert_null (hcl_block_get_blocks_by_type (first, "never-used-as-a-type"));
+  g_assert_cmpuint (g_quark_try_string ("never-used-as-a-key"), ==, 0);
+  g_assert_cmpuint (g_quark_try_string ("never-used-as-a-type"), ==, 0);
+}
+
+static void
+test_block_indexed_lookup (void)
+{
+  g_autoptr(HclBlock) dashboard = hcl_block_new ("dashboard", NULL);
+  HclBlock *header = hcl_block_new ("box", "header");
+  HclBlock *content = hcl_block_new ("box", "content");
+  HclBlockIter iter;
+  HclBlock *child;
+
+  hcl_block_add_block (dashboard, header);
+  hcl_block_add_block (dashboard, hcl_block_new ("grid", NULL));
+  hcl_block_add_block (dashboard, content);
+
+  g_assert_true (hcl_block_get_block_by_label (dashboard, "box", "content") == content);
+  g_assert_null (hcl_block_get_block_by_label (dashboard, "grid", "content"));
+
+  hcl_block_iter_init (&iter, dashboard, "box");
+  g_assert_true (hcl_block_iter_next (&iter, &child));
+  g_assert_true (child == header);
+
+  /* Matching blocks added mid-iteration are visited */
+  hcl_block_add_block (dashboard, hcl_block_new ("box", "footer"));
+  g_assert_true (hcl_block_iter_next (&iter, &child));
+  g_assert_true (child == content);
+  g_assert_true (hcl_block_iter_next (&iter, &child));
+  g_assert_cmpstr (hcl_block_get_label (child), ==, "footer");
+  g_assert_false (hcl_block_iter_next (&iter, &child));
+}
+
+static void
+test_block_attribute_order (void)
+{
+  g_autoptr(HclBlock) block = hcl_block_new ("box", NULL);
+  GList *names;
+  GList *l;
+  guint i;
+
+  /* Enough attributes to be looked up by hash as well as by scanning */
+  for (i = 0; i < 40; i++) {
+    g_autofree gchar *name = g_strdup_printf ("attr_%u", 39 - i);
+
+    hcl_block_set_attribute (block, name, hcl_value_new_int (i));
+
+    if (i == 3 || i == 39) {
+      g_assert_cmpint (hcl_value_get_int (hcl_block_get_attribute (block, "attr_38")), ==, 1);
+      g_assert_false (hcl_block_has_attribute (block, "attr_40"));
+    }
+  }
+
+  /* Setting an attribute again keeps its place */
+  hcl_block_set_attribute (block, "attr_37", hcl_value_new_string ("again"));
+
+  names = hcl_block_get_attribute_names (block);
+  g_assert_cmpuint (g_list_length (names), ==, 40);
+  for (l = names, i = 0; l != NULL; l = l->next, i++) {
+    g_autofree gchar *expected = g_strdup_printf ("attr_%u", 39 - i);
+
+    g_assert_cmpstr (l->data, ==, expected);
+    if (i != 2)
+      g_assert_cmpint (hcl_value_get_int (hcl_block_get_attribute (block, expected)), ==, i);
+  }
+  g_list_free (names);
+
+  g_assert_cmpstr (hcl_value_get_string (hcl_block_get_attribute (block, "attr_37")), ==, "again");
+}
+
 int
 main (int argc, char **argv)
 {
@@ -70,6 +163,9 @@ main (int argc, char **argv)
   g_test_add_func ("/hcl/block/basic", test_block_basic);
   g_test_add_func ("/hcl/block/attributes", test_block_attributes);
   g_test_add_func ("/hcl/block/nested_blocks", test_block_nested_blocks);
+  g_test_add_func ("/hcl/block/interned_keys", test_block_interned_keys);
+  g_test_add_func ("/hcl/block/indexed_lookup", test_block_indexed_lookup);
+  g_test_add_func ("/hcl/block/attribute_order", test_block_attribute_order);
 
   return g_test_run ();
 }
@@ -0,0 +1,267 @@
+/* test-cache.c - Tests for the binary document cache
+ *
+ * Copyright 2024 Geoff Johnson <geoff.jay@gmail.com>
+ */
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <hcl.h>
+#include <utime.h>
+
+#include "test-utils.h"
+
+static const gchar *config =
+  "name = \"slate\"\n"
+  "version = 2\n"
+  "application \"app\" {\n"
+  "  title = \"Monitor \\\"main\\\"\"\n"
+  "  ratio = 0.75\n"
+  "  debug = false\n"
+  "  tags = [\"a\", [1, 2.5], { nested = true }, []]\n"
+  "  series = [[1, 2, 3], [0.5, -1e10]]\n"
+  "  limits = { cpu = 2, \"mem\" = \"1G\", z = {} }\n"
+  "  dashboard {\n"
+  "    box \"header\" {\n"
+  "      height = \"auto\"\n"
+  "    }\n"
+  "    grid {\n"
+  "      columns = 3\n"
+  "    }\n"
+  "    box \"content\" {\n"
+  "      height = \"expand\"\n"
+  "    }\n"
+  "  }\n"
+  "}\n"
+  "footer {\n"
+  "}\n";
+
+/* A source file in a temporary directory, and where to cache it */
+typedef struct {
+  gchar *dir;
+  gchar *source;
+  gchar *cache;
+} CacheFiles;
+
+static void
+cache_files_init (CacheFiles *files)
+{
+  g_autoptr(GError) error = NULL;
+
+  files->dir = g_dir_make_tmp ("hcl-cache-XXXXXX", &error);
+  g_assert_no_error (error);
+  files->source = g_build_filename (files->dir, "config.hcl", NULL);
+  files->cache = g_build_filename (files->dir, "config.hclc", NULL);
+
+  g_file_set_contents (files->source, config, -1, &error);
+  g_assert_no_error (error);
+}
+
+static void
+cache_files_clear (CacheFiles *files)
+{
+  g_remove (files->source);
+  g_remove (files->cache);
+  g_rmdir (files->dir);
+  g_free (files->source);
+  g_free (files->cache);
+  g_free (files->dir);
+}
+
+static void
+test_cache_round_trip (void)
+{
+  CacheFiles files;
+  g_autoptr(GError) error = NULL;
+  g_autoptr(HclDocument) expected = NULL;
+  g_autoptr(HclDocument) document = NULL;
+  g_autoptr(GList) boxes = NULL;
+  HclBlock *application;
+  HclBlock *dashboard;
+
+  cache_files_init (&files);
+
+  expected = hcl_parse_file (files.source, &error);
+  g_assert_no_error (error);
+
+  g_assert_true (hcl_document_save_cached (expected, files.cache, files.source, &error));
+  g_assert_no_error (error);
+
+  document = hcl_document_load_cached (files.cache, files.source, &error);
+  g_assert_no_error (error);
+  g_assert_nonnull (document);
+
+  hcl_test_assert_document_equal (expected, document);
+
+  /* The stored block index answers typed lookups */
+  application = hcl_document_get_block_by_label (document, "application", "app");
+  g_assert_nonnull (application);
+  dashboard = hcl_block_get_blocks (application)->data;
+  boxes = hcl_block_get_blocks_by_type (dashboard, "box");
+  g_assert_cmpuint (g_list_length (boxes), ==, 2);
+  g_assert_cmpstr (hcl_block_get_label (boxes->data), ==, "header");
+  g_assert_cmpstr (hcl_block_get_label (boxes->next->data), ==, "content");
+  g_assert_nonnull (hcl_block_get_block_by_label (dashboard, "box", "content"));
+  g_assert_null (hcl_block_get_blocks_by_type (dashboard, "missing"));
+
+  /* Blocks added after loading are indexed as usual */
+  hcl_block_add_block (dashboard, hcl_block_new ("box", "footer"));
+  g_assert_nonnull (hcl_block_get_block_by_label (dashboard, "box", "footer"));
+
+  cache_files_clear (&files);
+}
+
+static void
+test_cache_stale (void)
+{
+  CacheFiles files;
+  g_autoptr(GError) error = NULL;
+  g_autoptr(HclDocument) expected = NULL;
+  g_autoptr(HclDocument) document = NULL;
+  g_autofree gchar *same_size = g_strdup (config);
+
+  cache_files_init (&files);
+
+  expected = hcl_parse_file (files.source, &error);
+  g_assert_no_error (error);
+  g_assert_true (hcl_document_save_cached (expected, files.cache, files.source, &error));
+
+  /* Only the time moved: the contents are compared and still match */
+  g_assert_cmpint (g_utime (files.source, &(struct utimbuf) { 1000, 1000 }), ==, 0);
+  document = hcl_document_load_cached (files.cache, files.source, &error);
+  g_assert_no_error (error);
+  g_assert_nonnull (document);
+  g_clear_object (&document);
+
+  /* Same size, different contents */
+  same_size[7] = 'S';
+  g_file_set_contents (files.source, same_size, -1, &error);
+  g_assert_no_error (error);
+  document = hcl_document_load_cached (files.cache, files.source, &error);
+  g_assert_error (error, HCL_CACHE_ERROR, HCL_CACHE_ERROR_STALE);
+  g_assert_null (document);
+  g_clear_error (&error);
+
+  /* Different size */
+  g_file_set_contents (files.source, "name = \"other\"\n", -1, &error);
+  g_assert_no_error (error);
+  document = hcl_document_load_cached (files.cache, files.source, &error);
+  g_assert_error (error, HCL_CACHE_ERROR, HCL_CACHE_ERROR_STALE);
+  g_assert_null (document);
+
+  cache_files_clear (&files);
+}
+
+static void
+test_cache_parse_cached (void)
+{
+  CacheFiles files;
+  g_autoptr(GError) error = NULL;
+  g_autoptr(HclDocument) expected = NULL;
+  g_autoptr(HclDocument) document = NULL;
+  g_autofree gchar *cache_dir = NULL;
+  g_autofree gchar *cache = NULL;
+  g_autofree gchar *same_size = g_strdup (config);
+  GStatBuf buf;
+
+  cache_files_init (&files);
+  cache_dir = g_build_filename (files.dir, "cache", NULL);
+  cache = g_build_filename (cache_dir, "config.hclc", NULL);
+
+  /* Parses, and writes the cache in a directory of its own making */
+  expected = hcl_parse_file (files.source, &error);
+  g_assert_no_error (error);
+  document = hcl_document_parse_cached (cache, files.source, &error);
+  g_assert_no_error (error);
+  hcl_test_assert_document_equal (expected, document);
+  g_clear_object (&document);
+
+  document = hcl_document_load_cached (cache, files.source, &error);
+  g_assert_no_error (error);
+  hcl_test_assert_document_equal (expected, document);
+  g_clear_object (&document);
+
+  /* A current cache is used as it is */
+  g_assert_cmpint (g_utime (cache, &(struct utimbuf) { 1000, 1000 }), ==, 0);
+  document = hcl_document_parse_cached (cache, files.source, &error);
+  g_assert_no_error (error);
+  hcl_test_assert_document_equal (expected, document);
+  g_clear_object (&document);
+  g_assert_cmpint (g_stat (cache, &buf), ==, 0);
+  g_assert_cmpint (buf.st_mtime, ==, 1000);
+
+  /* A rewrite within the same second is caught by the hash */
+  same_size[8] = 'S';
+  g_file_set_contents (files.source, same_size, -1, &error);
+  g_assert_no_error (error);
+  document = hcl_document_parse_cached (cache, files.source, &error);
+  g_assert_no_error (error);
+  g_assert_cmpstr (hcl_value_get_string (hcl_document_get_attribute (document, "name")),
+                   ==, "Slate");
+  g_clear_object (&document);
+
+  /* A source that does not parse is an error, and leaves no cache behind */
+  g_remove (cache);
+  g_file_set_contents (files.source, "name = \"unterminated\n", -1, &error);
+  g_assert_no_error (error);
+  document = hcl_document_parse_cached (cache, files.source, &error);
+  g_assert_null (document);
+  g_assert_error (error, HCL_PARSER_ERROR, HCL_PARSER_ERROR_UNTERMINATED_STRING);
+  g_assert_false (g_file_test (cache, G_FILE_TEST_EXISTS));
+
+  g_rmdir (cache_dir);
+  cache_files_clear (&files);
+}
+
+static void
+test_cache_invalid (void)
+{
+  CacheFiles files;
+  g_autoptr(GError) error = NULL;
+  g_autoptr(HclDocument) expected = NULL;
+  g_autoptr(HclDocument) document = NULL;
+  g_autofree gchar *contents = NULL;
+  gsize length;
+
+  cache_files_init (&files);
+
+  /* No cache yet */
+  document = hcl_document_load_cached (files.cache, files.source, &error);
+  g_assert_error (error, G_FILE_ERROR, G_FILE_ERROR_NOENT);
+  g_clear_error (&error);
+
+  /* Not a cache at all */
+  g_file_set_contents (files.cache, config, -1, &error);
+  g_assert_no_error (error);
+  document = hcl_document_load_cached (files.cache, files.source, &error);
+  g_assert_error (error, HCL_CACHE_ERROR, HCL_CACHE_ERROR_INVALID);
+  g_assert_null (document);
+  g_clear_error (&error);
+
+  /* A cache cut short */
+  expected = hcl_parse_file (files.source, &error);
+  g_assert_no_error (error);
+  g_assert_true (hcl_document_save_cached (expected, files.cache, files.source, &error));
+  g_file_get_contents (files.cache, &contents, &length, &error);
+  g_assert_no_error (error);
+
+  g_file_set_contents (files.cache, contents, (gssize) length / 2, &error);
+  g_assert_no_error (error);
+  document = hcl_document_load_cached (files.cache, files.source, &error);
+  g_assert_error (error, HCL_CACHE_ERROR, HCL_CACHE_ERROR_INVALID);
+  g_assert_null (document);
+
+  cache_files_clear (&files);
+}
+
+int
+main (int argc, char **argv)
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/hcl/cache/round_trip", test_cache_round_trip);
+  g_test_add_func ("/hcl/cache/stale", test_cache_stale);
+  g_test_add_func ("/hcl/cache/parse_cached", test_cache_parse_cached);
+  g_test_add_func ("/hcl/cache/invalid", test_cache_invalid);
+
+  return g_test_run ();
+}
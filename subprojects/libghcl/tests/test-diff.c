@@ -0,0 +1,216 @@
+/* test-diff.c - Tests for hcl_document_diff()
+ *
+ * Copyright 2024 Geoff Johnson <geoff.jay@gmail.com>
+ */
+
+#include <glib.h>
+#include <hcl.h>
+
+static const gchar *config =
+  "name = \"slate\"\n"
+  "version = 2\n"
+  "dashboard \"main\" {\n"
+  "  title = \"Main\"\n"
+  "  series = [1, 2, 3]\n"
+  "  box \"header\" {\n"
+  "    height = 40\n"
+  "  }\n"
+  "  box \"content\" {\n"
+  "    height = \"expand\"\n"
+  "    chart {\n"
+  "      limits = { min = 0, max = 10 }\n"
+  "    }\n"
+  "  }\n"
+  "}\n"
+  "plugin \"logger\" {\n"
+  "}\n";
+
+static HclDocument *
+parse (const gchar *text)
+{
+  g_autoptr(GError) error = NULL;
+  HclDocument *document = hcl_parse_string (text, &error);
+
+  g_assert_no_error (error);
+
+  return document;
+}
+
+static void
+assert_change (GPtrArray *changes,
+               guint index,
+               HclChangeType change_type,
+               const gchar *name,
+               const gchar *label)
+{
+  HclChange *change;
+  HclBlock *block;
+
+  g_assert_cmpuint (index, <, changes->len);
+  change = g_ptr_array_index (changes, index);
+
+  g_assert_cmpint (hcl_change_get_change_type (change), ==, change_type);
+  g_assert_cmpstr (hcl_change_get_name (change), ==, name);
+
+  block = hcl_change_get_new_block (change) ? hcl_change_get_new_block (change)
+                                            : hcl_change_get_old_block (change);
+  g_assert_cmpstr (block ? hcl_block_get_label (block) : NULL, ==, label);
+}
+
+static void
+test_diff_identical (void)
+{
+  g_autoptr(HclDocument) old_document = parse (config);
+  g_autoptr(HclDocument) new_document = parse (config);
+  g_autoptr(HclDocument) reordered = NULL;
+  g_autoptr(GPtrArray) changes = NULL;
+
+  changes = hcl_document_diff (old_document, new_document);
+  g_assert_cmpuint (changes->len, ==, 0);
+  g_clear_pointer (&changes, g_ptr_array_unref);
+
+  changes = hcl_document_diff (old_document, old_document);
+  g_assert_cmpuint (changes->len, ==, 0);
+  g_clear_pointer (&changes, g_ptr_array_unref);
+
+  /* The order attributes and members are written in does not count */
+  reordered = parse ("a = { x = 1, y = [true, null] }\n"
+                     "b = \"b\"\n");
+  g_clear_object (&new_document);
+  new_document = parse ("b = \"b\"\n"
+                        "a = { y = [true, null], x = 1 }\n");
+  changes = hcl_document_diff (reordered, new_document);
+  g_assert_cmpuint (changes->len, ==, 0);
+}
+
+static void
+test_diff_attributes (void)
+{
+  g_autoptr(HclDocument) old_document = parse ("name = \"slate\"\n"
+                                               "version = 2\n"
+                                               "ratio = 0.5\n"
+                                               "flags = [1, 2]\n");
+  g_autoptr(HclDocument) new_document = parse ("name = \"slate\"\n"
+                                               "version = 3\n"
+                                               "flags = [1, 2]\n"
+                                               "debug = true\n");
+  g_autoptr(GPtrArray) changes = hcl_document_diff (old_document, new_document);
+  HclChange *change;
+
+  g_assert_cmpuint (changes->len, ==, 3);
+  assert_change (changes, 0, HCL_CHANGE_TYPE_MODIFIED, "version", NULL);
+  assert_change (changes, 1, HCL_CHANGE_TYPE_ADDED, "debug", NULL);
+  assert_change (changes, 2, HCL_CHANGE_TYPE_REMOVED, "ratio", NULL);
+
+  change = g_ptr_array_index (changes, 0);
+  g_assert_cmpint (hcl_value_get_int (hcl_change_get_old_value (change)), ==, 2);
+  g_assert_cmpint (hcl_value_get_int (hcl_change_get_new_value (change)), ==, 3);
+
+  change = g_ptr_array_index (changes, 1);
+  g_assert_null (hcl_change_get_old_value (change));
+  g_assert_true (hcl_value_get_bool (hcl_change_get_new_value (change)));
+}
+
+static void
+test_diff_blocks (void)
+{
+  g_autoptr(HclDocument) old_document = parse (config);
+  g_autoptr(HclDocument) new_document = NULL;
+  g_autoptr(GPtrArray) changes = NULL;
+  HclChange *change;
+
+  new_document = parse ("name = \"slate\"\n"
+                        "version = 2\n"
+                        "dashboard \"main\" {\n"
+                        "  title = \"Main\"\n"
+                        "  series = [1, 2, 3]\n"
+                        "  box \"header\" {\n"
+                        "    height = 40\n"
+                        "  }\n"
+                        "  box \"content\" {\n"
+                        "    height = \"expand\"\n"
+                        "    chart {\n"
+                        "      limits = { min = 0, max = 20 }\n"
+                        "    }\n"
+                        "  }\n"
+                        "  box \"footer\" {\n"
+                        "  }\n"
+                        "}\n"
+                        "plugin \"recorder\" {\n"
+                        "}\n");
+
+  changes = hcl_document_diff (old_document, new_document);
+
+  /* Unchanged blocks such as box "header" are not listed */
+  g_assert_cmpuint (changes->len, ==, 7);
+  assert_change (changes, 0, HCL_CHANGE_TYPE_MODIFIED, NULL, "main");
+  assert_change (changes, 1, HCL_CHANGE_TYPE_ADDED, NULL, "recorder");
+  assert_change (changes, 2, HCL_CHANGE_TYPE_REMOVED, NULL, "logger");
+  assert_change (changes, 3, HCL_CHANGE_TYPE_MODIFIED, NULL, "content");
+  assert_change (changes, 4, HCL_CHANGE_TYPE_ADDED, NULL, "footer");
+  assert_change (changes, 5, HCL_CHANGE_TYPE_MODIFIED, NULL, NULL);
+  assert_change (changes, 6, HCL_CHANGE_TYPE_MODIFIED, "limits", NULL);
+
+  /* Both sides of a modified block are given, and an attribute change
+   * gives the blocks holding it */
+  change = g_ptr_array_index (changes, 3);
+  g_assert_nonnull (hcl_change_get_old_block (change));
+  g_assert_true (hcl_change_get_old_block (change) != hcl_change_get_new_block (change));
+  g_assert_null (hcl_change_get_name (change));
+
+  change = g_ptr_array_index (changes, 6);
+  g_assert_cmpstr (hcl_block_get_block_type (hcl_change_get_new_block (change)), ==, "chart");
+  g_assert_cmpstr (hcl_block_get_block_type (hcl_change_get_old_block (change)), ==, "chart");
+
+  change = g_ptr_array_index (changes, 2);
+  g_assert_null (hcl_change_get_new_block (change));
+}
+
+static void
+test_diff_matching (void)
+{
+  g_autoptr(HclDocument) old_document = parse ("row { cells = 1 }\n"
+                                               "row { cells = 2 }\n"
+                                               "panel \"a\" {}\n");
+  g_autoptr(HclDocument) new_document = parse ("row { cells = 1 }\n"
+                                               "row { cells = 3 }\n"
+                                               "row { cells = 4 }\n"
+                                               "panel \"b\" {}\n");
+  g_autoptr(HclDocument) packed = hcl_document_new ();
+  g_autoptr(HclDocument) boxed = hcl_document_new ();
+  g_autoptr(GPtrArray) changes = hcl_document_diff (old_document, new_document);
+  static const gint64 numbers[] = { 1, 2, 3 };
+  HclValue *list;
+
+  /* Unlabelled blocks pair up in order, and a new label is a new block */
+  g_assert_cmpuint (changes->len, ==, 5);
+  assert_change (changes, 0, HCL_CHANGE_TYPE_MODIFIED, NULL, NULL);
+  assert_change (changes, 1, HCL_CHANGE_TYPE_ADDED, NULL, NULL);
+  assert_change (changes, 2, HCL_CHANGE_TYPE_ADDED, NULL, "b");
+  assert_change (changes, 3, HCL_CHANGE_TYPE_REMOVED, NULL, "a");
+  assert_change (changes, 4, HCL_CHANGE_TYPE_MODIFIED, "cells", NULL);
+  g_clear_pointer (&changes, g_ptr_array_unref);
+
+  /* A packed list is equal to the same numbers stored as values */
+  hcl_document_set_attribute (packed, "series", hcl_value_new_int_array (numbers, 3));
+  list = hcl_value_new_list ();
+  for (guint i = 0; i < G_N_ELEMENTS (numbers); i++)
+    hcl_value_list_add_item (list, hcl_value_new_int (numbers[i]));
+  hcl_document_set_attribute (boxed, "series", list);
+
+  changes = hcl_document_diff (packed, boxed);
+  g_assert_cmpuint (changes->len, ==, 0);
+}
+
+int
+main (int argc, char **argv)
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/hcl/diff/identical", test_diff_identical);
+  g_test_add_func ("/hcl/diff/attributes", test_diff_attributes);
+  g_test_add_func ("/hcl/diff/blocks", test_diff_blocks);
+  g_test_add_func ("/hcl/diff/matching", test_diff_matching);
+
+  return g_test_run ();
+}
@@ -57,6 +57,308 @@ test_document_blocks (void)
   g_list_free (db_blocks);
 }
 
+static void
+test_document_indexed_lookup (void)
+{
+  g_autoptr(HclDocument) document = hcl_document_new ();
+  g_autoptr(GList) apps = NULL;
+  HclBlock *app1 = hcl_block_new ("application", "app1");
+  HclBlock *app2 = hcl_block_new ("application", "app2");
+  HclBlock *duplicate = hcl_block_new ("application", "app1");
+  HclBlock *db = hcl_block_new ("database", "app1");
+  HclBlock *late;
+
+  hcl_document_add_block (document, app1);
+  hcl_document_add_block (document, db);
+  hcl_document_add_block (document, app2);
+  hcl_document_add_block (document, duplicate);
+
+  /* The first block with a type and label wins */
+  g_assert_true (hcl_document_get_block_by_label (document, "application", "app1") == app1);
+  g_assert_true (hcl_document_get_block_by_label (document, "database", "app1") == db);
+  g_assert_null (hcl_document_get_block_by_label (document, "application", "app3"));
+  g_assert_null (hcl_document_get_block_by_label (document, "unknown-block-type", "app1"));
+
+  /* Blocks added after the index was built are found */
+  late = hcl_block_new ("application", "app3");
+  hcl_document_add_block (document, late);
+  g_assert_true (hcl_document_get_block_by_label (document, "application", "app3") == late);
+
+  apps = hcl_document_get_blocks_by_type (document, "application");
+  g_assert_cmpuint (g_list_length (apps), ==, 4);
+  g_assert_true (apps->data == app1);
+  g_assert_true (g_list_last (apps)->data == late);
+
+  /* Relabelling a block is picked up by the next lookup */
+  hcl_block_set_label (app1, "renamed");
+  g_assert_true (hcl_document_get_block_by_label (document, "application", "app1") == duplicate);
+  g_assert_true (hcl_document_get_block_by_label (document, "application", "renamed") == app1);
+
+  /* A block added between a relabel and the next lookup is found too */
+  hcl_block_set_label (duplicate, "moved");
+  late = hcl_block_new ("application", "app1");
+  hcl_document_add_block (document, late);
+  g_assert_true (hcl_document_get_block_by_label (document, "application", "app1") == late);
+  g_assert_true (hcl_document_get_block_by_label (document, "application", "moved") == duplicate);
+}
+
+static void
+test_document_relabel_shared (void)
+{
+  g_autoptr(HclDocument) first = hcl_document_new ();
+  g_autoptr(HclDocument) second = hcl_document_new ();
+  HclBlock *shared = hcl_block_new ("application", "old");
+  HclBlock *outer = hcl_block_new ("group", "outer");
+  HclBlock *inner = hcl_block_new ("application", "inner");
+
+  hcl_document_add_block (first, shared);
+  hcl_document_add_block (second, g_object_ref (shared));
+  hcl_block_add_block (outer, inner);
+  hcl_document_add_block (first, outer);
+
+  g_assert_true (hcl_document_get_block_by_label (first, "application", "old") == shared);
+  g_assert_true (hcl_document_get_block_by_label (second, "application", "old") == shared);
+  g_assert_true (hcl_block_get_block_by_label (outer, "application", "inner") == inner);
+
+  /* Both documents see the new label, though the block only knows one */
+  hcl_block_set_label (shared, "new");
+  hcl_document_add_block (second, hcl_block_new ("application", "added"));
+  g_assert_null (hcl_document_get_block_by_label (first, "application", "old"));
+  g_assert_true (hcl_document_get_block_by_label (first, "application", "new") == shared);
+  g_assert_null (hcl_document_get_block_by_label (second, "application", "old"));
+  g_assert_true (hcl_document_get_block_by_label (second, "application", "new") == shared);
+  g_assert_nonnull (hcl_document_get_block_by_label (second, "application", "added"));
+
+  /* A nested block tells the block holding it */
+  hcl_block_set_label (inner, "renamed");
+  g_assert_null (hcl_block_get_block_by_label (outer, "application", "inner"));
+  g_assert_true (hcl_block_get_block_by_label (outer, "application", "renamed") == inner);
+}
+
+static void
+test_document_iter (void)
+{
+  g_autoptr(HclDocument) document = hcl_document_new ();
+  HclBlockIter iter;
+  HclBlock *block;
+  guint count = 0;
+
+  hcl_document_add_block (document, hcl_block_new ("application", "app1"));
+  hcl_document_add_block (document, hcl_block_new ("database", "db1"));
+  hcl_document_add_block (document, hcl_block_new ("application", "app2"));
+
+  hcl_document_iter_init (&iter, document, NULL);
+  while (hcl_block_iter_next (&iter, &block))
+    count++;
+  g_assert_cmpuint (count, ==, 3);
+
+  hcl_document_iter_init (&iter, document, "application");
+  g_assert_true (hcl_block_iter_next (&iter, &block));
+  g_assert_cmpstr (hcl_block_get_label (block), ==, "app1");
+  g_assert_true (hcl_block_iter_next (&iter, &block));
+  g_assert_cmpstr (hcl_block_get_label (block), ==, "app2");
+  g_assert_false (hcl_block_iter_next (&iter, &block));
+
+  hcl_document_iter_init (&iter, document, "unknown-block-type");
+  g_assert_false (hcl_block_iter_next (&iter, NULL));
+}
+
+static void
+test_document_merge (void)
+{
+  g_autoptr(HclDocument) document = hcl_document_new ();
+  g_autoptr(HclDocument) other = hcl_document_new ();
+  g_autoptr(GList) blocks = NULL;
+  HclBlock *late = hcl_block_new ("application", "late");
+
+  hcl_document_set_attribute (document, "name", hcl_value_new_string ("first"));
+  hcl_document_set_attribute (document, "kept", hcl_value_new_bool (TRUE));
+  hcl_document_add_block (document, hcl_block_new ("application", "early"));
+
+  hcl_document_set_attribute (other, "name", hcl_value_new_string ("second"));
+  hcl_document_add_block (other, late);
+
+  /* Index the first document before merging */
+  g_assert_null (hcl_document_get_block_by_label (document, "application", "late"));
+
+  hcl_document_merge (document, other);
+
+  g_assert_cmpstr (hcl_value_get_string (hcl_document_get_attribute (document, "name")), ==, "second");
+  g_assert_true (hcl_document_has_attribute (document, "kept"));
+  g_assert_true (hcl_document_get_block_by_label (document, "application", "late") == late);
+
+  blocks = hcl_document_get_blocks (document);
+  g_assert_cmpuint (g_list_length (blocks), ==, 2);
+  g_assert_cmpstr (hcl_block_get_label (blocks->next->data), ==, "late");
+
+  /* Both documents share the block */
+  g_clear_object (&other);
+  g_assert_cmpstr (hcl_block_get_label (late), ==, "late");
+}
+
+static gpointer
+read_sealed (gpointer data)
+{
+  HclDocument *document = data;
+
+  for (guint i = 0; i < 1000; i++) {
+    g_autofree gchar *key = g_strdup_printf ("k%02u", i % 20);
+    HclBlock *app = hcl_document_get_block_by_label (document, "application", "app1");
+    HclBlock *db = hcl_block_get_block_by_label (app, "database", "main");
+    HclValue *ports = hcl_block_get_attribute (db, "ports");
+    HclValue *wide = hcl_document_get_attribute (document, "wide");
+
+    g_assert_nonnull (db);
+    g_assert_cmpint (hcl_value_get_int (hcl_value_object_get_member (wide, key)), ==, i % 20);
+    g_assert_cmpint (hcl_value_get_int (hcl_value_list_get_item (ports, i % 3)), ==, 5432 + i % 3);
+    g_assert_cmpstr (hcl_value_get_string (hcl_document_get_attribute (document, "name")), ==, "sealed");
+    g_assert_cmpuint (hcl_block_hash (app), !=, hcl_block_hash (db));
+  }
+
+  g_object_unref (document);
+
+  return NULL;
+}
+
+static void
+test_document_seal (void)
+{
+  g_autoptr(GError) error = NULL;
+  g_autoptr(HclDocument) document = NULL;
+  g_autoptr(HclBlock) unrelated = hcl_block_new ("application", "elsewhere");
+  GThread *threads[4];
+  HclBlock *app;
+
+  document = hcl_parse_string ("name = \"sealed\"\n"
+                               "wide = { k00 = 0, k01 = 1, k02 = 2, k03 = 3, k04 = 4,\n"
+                               "         k05 = 5, k06 = 6, k07 = 7, k08 = 8, k09 = 9,\n"
+                               "         k10 = 10, k11 = 11, k12 = 12, k13 = 13, k14 = 14,\n"
+                               "         k15 = 15, k16 = 16, k17 = 17, k18 = 18, k19 = 19 }\n"
+                               "application \"app1\" {\n"
+                               "  database \"main\" {\n"
+                               "    ports = [5432, 5433, 5434]\n"
+                               "    owner = { user = \"admin\" }\n"
+                               "  }\n"
+                               "}\n", &error);
+  g_assert_no_error (error);
+  g_assert_false (hcl_document_is_sealed (document));
+
+  hcl_document_seal (document);
+  hcl_document_seal (document);
+  g_assert_true (hcl_document_is_sealed (document));
+
+  app = hcl_document_get_block_by_label (document, "application", "app1");
+  g_assert_nonnull (app);
+  g_assert_true (hcl_value_is_frozen (hcl_document_get_attribute (document, "name")));
+  g_assert_true (hcl_value_is_frozen (hcl_block_get_attribute (hcl_block_get_block_by_label (app, "database", "main"),
+                                                              "owner")));
+
+  /* Lookups match names on their contents and never ask the intern table */
+  g_assert_null (hcl_document_get_attribute (document, "seal-test-unknown-name"));
+  g_assert_null (hcl_block_get_attribute (app, "seal-test-unknown-name"));
+  g_assert_null (hcl_document_get_blocks_by_type (document, "seal-test-unknown-type"));
+  g_assert_null (hcl_value_object_get_member (hcl_document_get_attribute (document, "wide"),
+                                              "seal-test-unknown-key"));
+  g_assert_cmpuint (g_quark_try_string ("seal-test-unknown-name"), ==, 0);
+  g_assert_cmpuint (g_quark_try_string ("seal-test-unknown-type"), ==, 0);
+  g_assert_cmpuint (g_quark_try_string ("seal-test-unknown-key"), ==, 0);
+
+  /* Relabelling a block elsewhere leaves the sealed indexes alone */
+  hcl_block_set_label (unrelated, "moved");
+  g_assert_true (hcl_document_get_block_by_label (document, "application", "app1") == app);
+
+  for (guint i = 0; i < G_N_ELEMENTS (threads); i++)
+    threads[i] = g_thread_new ("reader", read_sealed, g_object_ref (document));
+  for (guint i = 0; i < G_N_ELEMENTS (threads); i++)
+    g_thread_join (threads[i]);
+}
+
+static void
+test_document_hash (void)
+{
+  g_autoptr(GError) error = NULL;
+  g_autoptr(HclDocument) document = NULL;
+  g_autoptr(HclDocument) reordered = NULL;
+  g_autoptr(HclDocument) other = hcl_document_new ();
+  g_autoptr(HclBlock) orphan = NULL;
+  GList *caches;
+  HclBlock *app;
+  HclBlock *copy;
+  HclBlock *db;
+  HclBlock *cache;
+  HclValue *owner;
+  guint64 hash;
+  guint64 cache_hash;
+
+  document = hcl_parse_string ("name = \"hashed\"\n"
+                               "application \"app1\" {\n"
+                               "  database \"main\" {\n"
+                               "    owner = { user = \"admin\" }\n"
+                               "  }\n"
+                               "  cache {\n"
+                               "    size = 64\n"
+                               "  }\n"
+                               "}\n", &error);
+  g_assert_no_error (error);
+  reordered = hcl_parse_string ("application \"app1\" {\n"
+                                "  database \"main\" {\n"
+                                "    owner = { user = \"admin\" }\n"
+                                "  }\n"
+                                "  cache {\n"
+                                "    size = 64\n"
+                                "  }\n"
+                                "}\n"
+                                "name = \"hashed\"\n", &error);
+  g_assert_no_error (error);
+
+  hash = hcl_document_hash (document);
+  g_assert_cmpuint (hcl_document_hash (reordered), ==, hash);
+
+  app = hcl_document_get_block_by_label (document, "application", "app1");
+  db = hcl_block_get_block_by_label (app, "database", "main");
+  caches = hcl_block_get_blocks_by_type (app, "cache");
+  cache = caches->data;
+  g_list_free (caches);
+  copy = hcl_document_get_block_by_label (reordered, "application", "app1");
+  owner = hcl_block_get_attribute (db, "owner");
+  cache_hash = hcl_block_hash (cache);
+
+  /* A change deep down reaches the document, and leaves siblings alone */
+  hcl_value_object_set_member (owner, "user", hcl_value_new_string ("root"));
+  g_assert_cmpuint (hcl_document_hash (document), !=, hash);
+  g_assert_cmpuint (hcl_block_hash (app), !=, hcl_block_hash (copy));
+  g_assert_cmpuint (hcl_block_hash (cache), ==, cache_hash);
+
+  hcl_value_object_set_member (owner, "user", hcl_value_new_string ("admin"));
+  g_assert_cmpuint (hcl_document_hash (document), ==, hash);
+
+  hcl_block_set_label (db, "replica");
+  g_assert_cmpuint (hcl_document_hash (document), !=, hash);
+  hcl_block_set_label (db, "main");
+  hcl_block_add_block (app, hcl_block_new ("log", NULL));
+  g_assert_cmpuint (hcl_document_hash (document), !=, hash);
+
+  /* A block in two documents is changed through either */
+  hcl_document_merge (other, document);
+  hash = hcl_document_hash (document);
+  g_assert_cmpuint (hcl_document_hash (other), ==, hash);
+  hcl_block_set_attribute (cache, "size", hcl_value_new_int (128));
+  g_assert_cmpuint (hcl_document_hash (document), !=, hash);
+  g_assert_cmpuint (hcl_document_hash (other), ==, hcl_document_hash (document));
+
+  /* A block outlives the document it was in */
+  orphan = g_object_ref (app);
+  g_clear_object (&document);
+  g_clear_object (&other);
+  hcl_block_set_label (orphan, "app2");
+  g_assert_cmpuint (hcl_block_hash (orphan), !=, hcl_block_hash (copy));
+
+  /* Sealing keeps the hash */
+  hash = hcl_document_hash (reordered);
+  hcl_document_seal (reordered);
+  g_assert_cmpuint (hcl_document_hash (reordered), ==, hash);
+}
+
 int
 main (int argc, char **argv)
 {
@@ -65,6 +367,12 @@ main (int argc, char **argv)
   g_test_add_func ("/hcl/document/basic", test_document_basic);
   g_test_add_func ("/hcl/document/attributes", test_document_attributes);
   g_test_add_func ("/hcl/document/blocks", test_document_blocks);
+  g_test_add_func ("/hcl/document/indexed_lookup", test_document_indexed_lookup);
+  g_test_add_func ("/hcl/document/relabel_shared", test_document_relabel_shared);
+  g_test_add_func ("/hcl/document/iter", test_document_iter);
+  g_test_add_func ("/hcl/document/merge", test_document_merge);
+  g_test_add_func ("/hcl/document/seal", test_document_seal);
+  g_test_add_func ("/hcl/document/hash", test_document_hash);
 
   return g_test_run ();
 }
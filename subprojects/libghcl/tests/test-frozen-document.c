@@ -0,0 +1,337 @@
+/* test-frozen-document.c - Tests for HclFrozenDocument
+ *
+ * Copyright 2024 Geoff Johnson <geoff.jay@gmail.com>
+ */
+
+#include <glib.h>
+#include <hcl.h>
+
+static const gchar *config =
+  "name = \"slate\"\n"
+  "version = 2\n"
+  "application \"app\" {\n"
+  "  title = \"Monitor \\\"main\\\"\"\n"
+  "  ratio = 0.75\n"
+  "  debug = false\n"
+  "  tags = [\"a\", [1, 2.5], { nested = true }, []]\n"
+  "  limits = { cpu = 2, \"mem\" = \"1G\", z = {} }\n"
+  "  dashboard {\n"
+  "    box \"header\" {\n"
+  "      height = \"auto\"\n"
+  "    }\n"
+  "    box \"content\" {\n"
+  "      height = \"expand\"\n"
+  "    }\n"
+  "    grid {\n"
+  "      columns = 3\n"
+  "    }\n"
+  "  }\n"
+  "}\n"
+  "footer {\n"
+  "}\n";
+
+static void assert_value_equal (HclValue *expected, const HclFrozenValue *value);
+
+/* Frozen keys come in the order the tree has them, which is the order set */
+static void
+assert_keys_equal (GList *expected, GList *keys)
+{
+  g_assert_cmpuint (g_list_length (keys), ==, g_list_length (expected));
+
+  for (; expected; expected = expected->next, keys = keys->next)
+    g_assert_cmpstr (keys->data, ==, expected->data);
+}
+
+static void
+assert_value_equal (HclValue *expected, const HclFrozenValue *value)
+{
+  g_assert_nonnull (value);
+  g_assert_cmpint (hcl_frozen_value_get_value_type (value), ==,
+                   hcl_value_get_value_type (expected));
+
+  switch (hcl_value_get_value_type (expected)) {
+    case HCL_VALUE_TYPE_BOOL:
+      g_assert_cmpint (hcl_frozen_value_get_bool (value), ==, hcl_value_get_bool (expected));
+      break;
+
+    case HCL_VALUE_TYPE_NUMBER:
+      g_assert_cmpint (hcl_frozen_value_get_number_type (value), ==,
+                       hcl_value_get_number_type (expected));
+      g_assert_cmpint (hcl_frozen_value_get_int (value), ==, hcl_value_get_int (expected));
+      g_assert_cmpfloat (hcl_frozen_value_get_double (value), ==,
+                         hcl_value_get_double (expected));
+      break;
+
+    case HCL_VALUE_TYPE_STRING:
+      g_assert_cmpstr (hcl_frozen_value_get_string (value), ==,
+                       hcl_value_get_string (expected));
+      break;
+
+    case HCL_VALUE_TYPE_LIST:
+      g_assert_cmpuint (hcl_frozen_value_list_get_length (value), ==,
+                        hcl_value_list_get_length (expected));
+      for (guint i = 0; i < hcl_value_list_get_length (expected); i++)
+        assert_value_equal (hcl_value_list_get_item (expected, i),
+                            hcl_frozen_value_list_get_item (value, i));
+      g_assert_null (hcl_frozen_value_list_get_item (value,
+                                                     hcl_value_list_get_length (expected)));
+      break;
+
+    case HCL_VALUE_TYPE_OBJECT: {
+      g_autoptr(GList) keys = hcl_value_object_get_keys (expected);
+      g_autoptr(GList) frozen_keys = hcl_frozen_value_object_get_keys (value);
+
+      assert_keys_equal (keys, frozen_keys);
+
+      for (GList *l = keys; l; l = l->next)
+        assert_value_equal (hcl_value_object_get_member (expected, l->data),
+                            hcl_frozen_value_object_get_member (value, l->data));
+
+      g_assert_false (hcl_frozen_value_object_has_member (value, "missing"));
+      break;
+    }
+
+    default:
+      break;
+  }
+}
+
+static void
+assert_block_equal (HclBlock *expected, const HclFrozenBlock *block)
+{
+  g_autoptr(GList) names = hcl_block_get_attribute_names (expected);
+  g_autoptr(GList) frozen_names = hcl_frozen_block_get_attribute_names (block);
+  g_autoptr(GList) blocks = hcl_block_get_blocks (expected);
+  g_autoptr(GList) frozen_blocks = hcl_frozen_block_get_blocks (block);
+  GList *l, *f;
+  guint i;
+
+  g_assert_cmpstr (hcl_frozen_block_get_block_type (block), ==,
+                   hcl_block_get_block_type (expected));
+  g_assert_cmpstr (hcl_frozen_block_get_label (block), ==,
+                   hcl_block_get_label (expected));
+
+  assert_keys_equal (names, frozen_names);
+
+  for (l = names; l; l = l->next) {
+    g_assert_true (hcl_frozen_block_has_attribute (block, l->data));
+    assert_value_equal (hcl_block_get_attribute (expected, l->data),
+                        hcl_frozen_block_get_attribute (block, l->data));
+  }
+
+  g_assert_cmpuint (hcl_frozen_block_get_n_blocks (block), ==, g_list_length (blocks));
+  g_assert_cmpuint (g_list_length (frozen_blocks), ==, g_list_length (blocks));
+
+  for (l = blocks, f = frozen_blocks, i = 0; l; l = l->next, f = f->next, i++) {
+    g_assert_true (f->data == hcl_frozen_block_get_block (block, i));
+    assert_block_equal (l->data, f->data);
+  }
+}
+
+static void
+assert_document_equal (HclDocument *expected, HclFrozenDocument *document)
+{
+  g_autoptr(GList) names = hcl_document_get_attribute_names (expected);
+  g_autoptr(GList) blocks = hcl_document_get_blocks (expected);
+  g_autoptr(GList) frozen_blocks = hcl_frozen_document_get_blocks (document);
+  g_autoptr(GList) frozen_names = hcl_frozen_document_get_attribute_names (document);
+  GList *l, *f;
+
+  assert_keys_equal (names, frozen_names);
+
+  for (l = names; l; l = l->next)
+    assert_value_equal (hcl_document_get_attribute (expected, l->data),
+                        hcl_frozen_document_get_attribute (document, l->data));
+
+  g_assert_cmpuint (hcl_frozen_document_get_n_blocks (document), ==, g_list_length (blocks));
+
+  for (l = blocks, f = frozen_blocks; l; l = l->next, f = f->next)
+    assert_block_equal (l->data, f->data);
+}
+
+static void
+test_frozen_from_string (void)
+{
+  g_autoptr(GError) error = NULL;
+  g_autoptr(HclDocument) expected = hcl_parse_string (config, &error);
+  g_autoptr(HclFrozenDocument) document = NULL;
+
+  g_assert_no_error (error);
+
+  document = hcl_frozen_document_new_from_string (config, -1, &error);
+  g_assert_no_error (error);
+  g_assert_nonnull (document);
+
+  assert_document_equal (expected, document);
+}
+
+static void
+test_frozen_from_document (void)
+{
+  g_autoptr(GError) error = NULL;
+  g_autoptr(HclDocument) expected = hcl_parse_string (config, &error);
+  g_autoptr(HclFrozenDocument) document = NULL;
+
+  g_assert_no_error (error);
+
+  document = hcl_frozen_document_new_from_document (expected);
+  assert_document_equal (expected, document);
+
+  /* The frozen copy does not follow later changes */
+  hcl_document_set_attribute (expected, "name", hcl_value_new_string ("changed"));
+  g_assert_cmpstr (hcl_frozen_value_get_string (hcl_frozen_document_get_attribute (document, "name")),
+                   ==, "slate");
+}
+
+static void
+test_frozen_lookups (void)
+{
+  g_autoptr(GError) error = NULL;
+  g_autoptr(HclFrozenDocument) document = hcl_frozen_document_new_from_string (config, -1, &error);
+  g_autoptr(GList) names = NULL;
+  g_autoptr(GList) footers = NULL;
+  g_autoptr(GList) boxes = NULL;
+  const HclFrozenBlock *application;
+  const HclFrozenBlock *dashboard;
+  const HclFrozenValue *limits;
+
+  g_assert_no_error (error);
+
+  names = hcl_frozen_document_get_attribute_names (document);
+  g_assert_cmpuint (g_list_length (names), ==, 2);
+  g_assert_cmpstr (names->data, ==, "name");
+  g_assert_cmpstr (names->next->data, ==, "version");
+  g_assert_false (hcl_frozen_document_has_attribute (document, "title"));
+  g_assert_null (hcl_frozen_document_get_attribute (document, "title"));
+
+  footers = hcl_frozen_document_get_blocks_by_type (document, "footer");
+  g_assert_cmpuint (g_list_length (footers), ==, 1);
+  g_assert_null (hcl_frozen_block_get_label (footers->data));
+  g_assert_cmpuint (hcl_frozen_block_get_n_blocks (footers->data), ==, 0);
+  g_assert_null (hcl_frozen_block_get_attribute_names (footers->data));
+
+  application = hcl_frozen_document_get_block (document, 0);
+  g_assert_cmpstr (hcl_frozen_block_get_label (application), ==, "app");
+  g_assert_null (hcl_frozen_document_get_block (document, 2));
+
+  limits = hcl_frozen_block_get_attribute (application, "limits");
+  g_assert_true (hcl_frozen_value_is_object (limits));
+  g_assert_cmpstr (hcl_frozen_value_get_string (hcl_frozen_value_object_get_member (limits, "mem")),
+                   ==, "1G");
+  g_assert_null (hcl_frozen_value_object_get_keys (hcl_frozen_value_object_get_member (limits, "z")));
+
+  dashboard = hcl_frozen_block_get_block (application, 0);
+  boxes = hcl_frozen_block_get_blocks_by_type (dashboard, "box");
+  g_assert_cmpuint (g_list_length (boxes), ==, 2);
+  g_assert_cmpstr (hcl_frozen_block_get_label (boxes->data), ==, "header");
+  g_assert_cmpstr (hcl_frozen_block_get_label (boxes->next->data), ==, "content");
+
+  /* Keys and types are interned, so equal strings share storage */
+  g_assert_true (hcl_frozen_block_get_block_type (boxes->data) ==
+                 hcl_frozen_block_get_block_type (boxes->next->data));
+}
+
+static void
+test_frozen_duplicates (void)
+{
+  const gchar *input =
+    "port = 1\n"
+    "port = 2\n"
+    "app {\n"
+    "  b = 1\n"
+    "  a = 1\n"
+    "  b = 2\n"
+    "  obj = { k = 1, k = \"last\" }\n"
+    "}\n";
+  g_autoptr(GError) error = NULL;
+  g_autoptr(HclDocument) expected = hcl_parse_string (input, &error);
+  g_autoptr(HclFrozenDocument) document = NULL;
+  g_autoptr(GList) names = NULL;
+  const HclFrozenBlock *app;
+
+  g_assert_no_error (error);
+
+  /* Like the tree, the last assignment wins */
+  document = hcl_frozen_document_new_from_string (input, -1, &error);
+  g_assert_no_error (error);
+  assert_document_equal (expected, document);
+
+  /* A key set again keeps the place it was first set in */
+  app = hcl_frozen_document_get_block (document, 0);
+  names = hcl_frozen_block_get_attribute_names (app);
+  g_assert_cmpuint (g_list_length (names), ==, 3);
+  g_assert_cmpstr (names->data, ==, "b");
+  g_assert_cmpstr (names->next->data, ==, "a");
+  g_assert_cmpstr (names->next->next->data, ==, "obj");
+  g_assert_cmpint (hcl_frozen_value_get_int (hcl_frozen_block_get_attribute (app, "b")), ==, 2);
+  g_assert_cmpint (hcl_frozen_value_get_int (hcl_frozen_document_get_attribute (document, "port")),
+                   ==, 2);
+}
+
+static void
+test_frozen_order (void)
+{
+  g_autoptr(GString) input = g_string_new ("object = {\n");
+  g_autoptr(GError) error = NULL;
+  g_autoptr(HclFrozenDocument) document = NULL;
+  g_autoptr(GList) keys = NULL;
+  const HclFrozenValue *object;
+  GList *l;
+  guint i;
+
+  /* Set in descending order, so nothing is where sorting would put it */
+  for (i = 40; i > 0; i--)
+    g_string_append_printf (input, "  key_%02u = %u\n", i, i);
+  g_string_append (input, "}\n");
+
+  document = hcl_frozen_document_new_from_string (input->str, -1, &error);
+  g_assert_no_error (error);
+
+  object = hcl_frozen_document_get_attribute (document, "object");
+  keys = hcl_frozen_value_object_get_keys (object);
+  g_assert_cmpuint (g_list_length (keys), ==, 40);
+
+  for (l = keys, i = 40; l; l = l->next, i--) {
+    g_autofree gchar *key = g_strdup_printf ("key_%02u", i);
+
+    g_assert_cmpstr (l->data, ==, key);
+    g_assert_cmpint (hcl_frozen_value_get_int (hcl_frozen_value_object_get_member (object, key)),
+                     ==, i);
+  }
+
+  g_assert_null (hcl_frozen_value_object_get_member (object, "key_00"));
+  g_assert_null (hcl_frozen_value_object_get_member (object, "key_41"));
+  g_assert_null (hcl_frozen_value_object_get_member (object, "key_205"));
+}
+
+static void
+test_frozen_empty_and_errors (void)
+{
+  g_autoptr(GError) error = NULL;
+  g_autoptr(HclFrozenDocument) empty = hcl_frozen_document_new_from_string ("", 0, &error);
+  g_autoptr(HclFrozenDocument) invalid = NULL;
+
+  g_assert_no_error (error);
+  g_assert_nonnull (empty);
+  g_assert_cmpuint (hcl_frozen_document_get_n_blocks (empty), ==, 0);
+  g_assert_null (hcl_frozen_document_get_attribute_names (empty));
+
+  invalid = hcl_frozen_document_new_from_string ("app {\n  port = [1, 2\n}\n", -1, &error);
+  g_assert_null (invalid);
+  g_assert_error (error, HCL_PARSER_ERROR, HCL_PARSER_ERROR_SYNTAX);
+}
+
+int
+main (int argc, char **argv)
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/hcl/frozen-document/from_string", test_frozen_from_string);
+  g_test_add_func ("/hcl/frozen-document/from_document", test_frozen_from_document);
+  g_test_add_func ("/hcl/frozen-document/lookups", test_frozen_lookups);
+  g_test_add_func ("/hcl/frozen-document/duplicates", test_frozen_duplicates);
+  g_test_add_func ("/hcl/frozen-document/order", test_frozen_order);
+  g_test_add_func ("/hcl/frozen-document/empty_and_errors", test_frozen_empty_and_errors);
+
+  return g_test_run ();
+}
@@ -5,6 +5,7 @@
 
 #include <glib.h>
 #include <hcl.h>
+#include <string.h>
 
 static void
 test_lexer_basic_tokens (void)
@@ -81,6 +82,97 @@ test_lexer_numbers (void)
   g_assert_cmpstr (hcl_token_get_value (token4), ==, "1.5e10");
 }
 
+static void
+test_lexer_number_values (void)
+{
+  const gchar *input = "42 -10 0xFF -0x1e 0b101 9223372036854775807 -9223372036854775808 "
+                       "99999999999999999999 -0 1.5e10 3.14e-2 2.";
+  const struct {
+    gboolean is_float;
+    gint64 int_value;
+    gdouble double_value;
+  } expected[] = {
+    { FALSE, 42, 0 },
+    { FALSE, -10, 0 },
+    { FALSE, 255, 0 },
+    { FALSE, -30, 0 },
+    { FALSE, 5, 0 },
+    { FALSE, G_MAXINT64, 0 },
+    { FALSE, G_MININT64, 0 },
+    { FALSE, G_MAXINT64, 0 },
+    { FALSE, 0, 0 },
+    { TRUE, 0, 1.5e10 },
+    { TRUE, 0, 3.14e-2 },
+    { TRUE, 0, 2.0 },
+  };
+  g_autoptr(HclLexer) lexer = hcl_lexer_new (input);
+  g_autoptr(GError) error = NULL;
+  HclSpanToken token;
+
+  for (gsize i = 0; i < G_N_ELEMENTS (expected); i++) {
+    g_assert_true (hcl_lexer_next_span (lexer, &token, &error));
+    g_assert_no_error (error);
+    g_assert_cmpint (token.type, ==, HCL_TOKEN_TYPE_NUMBER);
+    g_assert_cmpint (!!(token.flags & HCL_SPAN_FLAG_FLOAT), ==, expected[i].is_float);
+
+    if (expected[i].is_float)
+      g_assert_cmpfloat (token.number.double_value, ==, expected[i].double_value);
+    else
+      g_assert_cmpint (token.number.int_value, ==, expected[i].int_value);
+  }
+}
+
+static void
+test_lexer_float_rounding (void)
+{
+  g_autoptr(GRand) rand = g_rand_new_with_seed (7);
+  g_autoptr(GString) input = g_string_new (NULL);
+  g_autoptr(GError) error = NULL;
+  g_autoptr(HclLexer) lexer = NULL;
+  HclSpanToken token;
+  guint out_of_range = 0;
+
+  /* Mix lexemes the fast path takes with ones it hands to strtod */
+  for (guint i = 0; i < 2000; i++) {
+    g_string_append_printf (input, "%s%u.%0*u", g_rand_int_range (rand, 0, 2) ? "-" : "",
+                            g_rand_int (rand), g_rand_int_range (rand, 1, 10),
+                            g_rand_int_range (rand, 0, 1000000000));
+    if (i % 3 == 0)
+      g_string_append_printf (input, "e%d", g_rand_int_range (rand, -330, 310));
+    g_string_append_c (input, ' ');
+  }
+  g_string_append (input, "0.1 17976931348623157e292 4.9e-324 123456789012345678901234.5 1e400");
+
+  lexer = hcl_lexer_new (input->str);
+
+  for (;;) {
+    const gchar *start;
+    gchar *end;
+    gdouble reference;
+
+    /* Lexemes past the largest double are errors, and scanning goes on */
+    if (!hcl_lexer_next_span (lexer, &token, &error)) {
+      g_assert_error (error, HCL_PARSER_ERROR, HCL_PARSER_ERROR_INVALID_NUMBER);
+      g_clear_error (&error);
+      out_of_range++;
+      continue;
+    }
+
+    if (token.type == HCL_TOKEN_TYPE_EOF)
+      break;
+
+    start = input->str + token.offset;
+    reference = g_ascii_strtod (start, &end);
+
+    g_assert_true (token.flags & HCL_SPAN_FLAG_FLOAT);
+    g_assert_cmpuint (token.length, ==, (gsize) (end - start));
+    g_assert_true (memcmp (&token.number.double_value, &reference, sizeof reference) == 0);
+  }
+
+  /* At least the 1e400 at the end */
+  g_assert_cmpuint (out_of_range, >=, 1);
+}
+
 static void
 test_lexer_identifiers_and_bools (void)
 {
@@ -133,6 +225,238 @@ test_lexer_comments (void)
   g_assert_cmpstr (hcl_token_get_value (token5), ==, "identifier");
 }
 
+static void
+test_lexer_spans (void)
+{
+  const gchar *input = "name = \"a\\tb\"\n  # note\nflag = true";
+  g_autoptr(HclLexer) lexer = hcl_lexer_new (input);
+  g_autoptr(GError) error = NULL;
+  HclSpanToken token;
+  const gchar *text;
+  gsize length;
+
+  g_assert_true (hcl_lexer_next_span (lexer, &token, &error));
+  g_assert_no_error (error);
+  g_assert_cmpint (token.type, ==, HCL_TOKEN_TYPE_IDENTIFIER);
+  g_assert_cmpuint (token.offset, ==, 0);
+  g_assert_cmpuint (token.length, ==, 4);
+  g_assert_true (hcl_lexer_span_equal (lexer, &token, "name"));
+  g_assert_false (hcl_lexer_span_equal (lexer, &token, "nam"));
+
+  g_assert_true (hcl_lexer_next_span (lexer, &token, &error));
+  g_assert_cmpint (token.type, ==, HCL_TOKEN_TYPE_ASSIGN);
+  g_assert_cmpuint (token.column, ==, 6);
+
+  /* Peeking does not consume */
+  g_assert_true (hcl_lexer_peek_span (lexer, &token, &error));
+  g_assert_cmpint (token.type, ==, HCL_TOKEN_TYPE_STRING);
+  g_assert_true (hcl_lexer_next_span (lexer, &token, &error));
+  g_assert_cmpint (token.type, ==, HCL_TOKEN_TYPE_STRING);
+  g_assert_cmpuint (token.offset, ==, 7);
+  g_assert_cmpuint (token.length, ==, 6);
+
+  text = hcl_lexer_span_get_text (lexer, &token, &length);
+  g_assert_cmpuint (length, ==, 4);
+  g_assert_true (strncmp (text, "a\\tb", length) == 0);
+
+  g_autofree gchar *value = hcl_lexer_span_dup_value (lexer, &token);
+  g_assert_cmpstr (value, ==, "a\tb");
+
+  g_assert_true (hcl_lexer_next_span (lexer, &token, &error));
+  g_assert_cmpint (token.type, ==, HCL_TOKEN_TYPE_NEWLINE);
+
+  g_assert_true (hcl_lexer_next_span (lexer, &token, &error));
+  g_assert_cmpint (token.type, ==, HCL_TOKEN_TYPE_COMMENT);
+  g_assert_cmpuint (token.line, ==, 2);
+  g_assert_cmpuint (token.column, ==, 3);
+  g_autofree gchar *comment = hcl_lexer_span_dup_value (lexer, &token);
+  g_assert_cmpstr (comment, ==, " note");
+
+  g_assert_true (hcl_lexer_next_span (lexer, &token, &error));
+  g_assert_cmpint (token.type, ==, HCL_TOKEN_TYPE_NEWLINE);
+  g_assert_true (hcl_lexer_next_span (lexer, &token, &error));
+  g_assert_true (hcl_lexer_next_span (lexer, &token, &error));
+  g_assert_true (hcl_lexer_next_span (lexer, &token, &error));
+  g_assert_cmpint (token.type, ==, HCL_TOKEN_TYPE_BOOL);
+  g_assert_cmpuint (token.line, ==, 3);
+  g_assert_true (hcl_lexer_span_equal (lexer, &token, "true"));
+
+  g_assert_true (hcl_lexer_next_span (lexer, &token, &error));
+  g_assert_cmpint (token.type, ==, HCL_TOKEN_TYPE_EOF);
+}
+
+static void
+test_lexer_string_fast_path (void)
+{
+  /* Long enough that the quote and backslashes land in vector blocks */
+  const gchar *input =
+    "\"plain text that is comfortably longer than thirty-two bytes\" "
+    "\"escapes \\\"late\\\" in a long literal, past the first block\\n\"\n"
+    "'multi\nline' x";
+  g_autoptr(HclLexer) lexer = hcl_lexer_new (input);
+  g_autoptr(GError) error = NULL;
+  HclSpanToken token;
+
+  g_assert_true (hcl_lexer_next_span (lexer, &token, &error));
+  g_assert_no_error (error);
+  g_assert_cmpint (token.type, ==, HCL_TOKEN_TYPE_STRING);
+  g_assert_cmpint (token.flags & HCL_SPAN_FLAG_ESCAPED, ==, 0);
+  g_autofree gchar *plain = hcl_lexer_span_dup_value (lexer, &token);
+  g_assert_cmpstr (plain, ==, "plain text that is comfortably longer than thirty-two bytes");
+
+  g_assert_true (hcl_lexer_next_span (lexer, &token, &error));
+  g_assert_cmpint (token.flags & HCL_SPAN_FLAG_ESCAPED, !=, 0);
+  g_assert_cmpuint (token.column, ==, 63);
+  g_autofree gchar *escaped = hcl_lexer_span_dup_value (lexer, &token);
+  g_assert_cmpstr (escaped, ==, "escapes \"late\" in a long literal, past the first block\n");
+
+  g_assert_true (hcl_lexer_next_span (lexer, &token, &error));
+  g_assert_cmpint (token.type, ==, HCL_TOKEN_TYPE_NEWLINE);
+
+  /* Raw newlines inside a literal still move the line counter */
+  g_assert_true (hcl_lexer_next_span (lexer, &token, &error));
+  g_assert_cmpint (token.type, ==, HCL_TOKEN_TYPE_STRING);
+  g_assert_cmpuint (token.line, ==, 2);
+  g_assert_true (hcl_lexer_next_span (lexer, &token, &error));
+  g_assert_cmpint (token.type, ==, HCL_TOKEN_TYPE_IDENTIFIER);
+  g_assert_cmpuint (token.line, ==, 3);
+  g_assert_cmpuint (token.column, ==, 7);
+}
+
+static void
+test_lexer_string_errors (void)
+{
+  g_autoptr(GError) error = NULL;
+  HclSpanToken token;
+
+  g_autoptr(HclLexer) bad_escape = hcl_lexer_new ("x = \"abc\\q\"");
+  g_assert_true (hcl_lexer_next_span (bad_escape, &token, &error));
+  g_assert_true (hcl_lexer_next_span (bad_escape, &token, &error));
+  g_assert_false (hcl_lexer_next_span (bad_escape, &token, &error));
+  g_assert_error (error, HCL_PARSER_ERROR, HCL_PARSER_ERROR_INVALID_ESCAPE);
+  g_assert_nonnull (strstr (error->message, "column 10"));
+  g_clear_error (&error);
+
+  /* Scanning carries on behind the string */
+  g_assert_true (hcl_lexer_next_span (bad_escape, &token, &error));
+  g_assert_cmpint (token.type, ==, HCL_TOKEN_TYPE_EOF);
+
+  g_autoptr(HclLexer) unterminated = hcl_lexer_new ("\"abc\\\"");
+  g_assert_false (hcl_lexer_next_span (unterminated, &token, &error));
+  g_assert_error (error, HCL_PARSER_ERROR, HCL_PARSER_ERROR_UNTERMINATED_STRING);
+}
+
+static void
+test_lexer_punctuation_positions (void)
+{
+  const gchar *input = "a={\n [1,2].x\n}(),";
+  const struct {
+    HclTokenType type;
+    gsize line;
+    gsize column;
+  } expected[] = {
+    { HCL_TOKEN_TYPE_IDENTIFIER, 1, 1 },
+    { HCL_TOKEN_TYPE_ASSIGN, 1, 2 },
+    { HCL_TOKEN_TYPE_LBRACE, 1, 3 },
+    { HCL_TOKEN_TYPE_NEWLINE, 1, 4 },
+    { HCL_TOKEN_TYPE_LBRACKET, 2, 2 },
+    { HCL_TOKEN_TYPE_NUMBER, 2, 3 },
+    { HCL_TOKEN_TYPE_COMMA, 2, 4 },
+    { HCL_TOKEN_TYPE_NUMBER, 2, 5 },
+    { HCL_TOKEN_TYPE_RBRACKET, 2, 6 },
+    { HCL_TOKEN_TYPE_DOT, 2, 7 },
+    { HCL_TOKEN_TYPE_IDENTIFIER, 2, 8 },
+    { HCL_TOKEN_TYPE_NEWLINE, 2, 9 },
+    { HCL_TOKEN_TYPE_RBRACE, 3, 1 },
+    { HCL_TOKEN_TYPE_LPAREN, 3, 2 },
+    { HCL_TOKEN_TYPE_RPAREN, 3, 3 },
+    { HCL_TOKEN_TYPE_COMMA, 3, 4 },
+    { HCL_TOKEN_TYPE_EOF, 3, 5 },
+  };
+  g_autoptr(HclLexer) lexer = hcl_lexer_new (input);
+  g_autoptr(HclLexer) other = hcl_lexer_new ("{");
+  g_autoptr(GError) error = NULL;
+  g_autoptr(HclToken) first_brace = NULL;
+  g_autoptr(HclToken) second_brace = NULL;
+
+  for (gsize i = 0; i < G_N_ELEMENTS (expected); i++) {
+    g_autoptr(HclToken) token = hcl_lexer_next_token (lexer, &error);
+
+    g_assert_no_error (error);
+    g_assert_cmpint (hcl_token_get_token_type (token), ==, expected[i].type);
+    g_assert_cmpuint (hcl_token_get_line (token), ==, expected[i].line);
+    g_assert_cmpuint (hcl_token_get_column (token), ==, expected[i].column);
+
+    if (expected[i].type == HCL_TOKEN_TYPE_LBRACE)
+      first_brace = g_steal_pointer (&token);
+  }
+
+  /* Punctuation tokens share one static copy of their text */
+  second_brace = hcl_lexer_next_token (other, &error);
+  g_assert_no_error (error);
+  g_assert_cmpstr (hcl_token_get_value (first_brace), ==, "{");
+  g_assert_true (hcl_token_get_value (first_brace) == hcl_token_get_value (second_brace));
+}
+
+static void
+test_lexer_invalid_characters (void)
+{
+  const gchar *inputs[] = { "a = @", "a = -x", "a = / 2", "a = \xc3\xa9" };
+
+  for (gsize i = 0; i < G_N_ELEMENTS (inputs); i++) {
+    g_autoptr(HclLexer) lexer = hcl_lexer_new (inputs[i]);
+    g_autoptr(GError) error = NULL;
+    HclSpanToken token;
+
+    while (hcl_lexer_next_span (lexer, &token, &error) && token.type != HCL_TOKEN_TYPE_EOF)
+      ;
+
+    g_assert_error (error, HCL_PARSER_ERROR, HCL_PARSER_ERROR_SYNTAX);
+    g_assert_nonnull (strstr (error->message, "column 5"));
+  }
+}
+
+static void
+test_lexer_lookahead (void)
+{
+  const gchar *input = "a b c d e f g h";
+  g_autoptr(HclLexer) lexer = hcl_lexer_new (input);
+  g_autoptr(GError) error = NULL;
+  g_autoptr(HclToken) next = NULL;
+  HclSpanToken token;
+  HclToken *peeked;
+
+  /* Fill the ring, then keep it full while consuming so it wraps */
+  for (guint i = 0; i < 4; i++) {
+    g_assert_true (hcl_lexer_peek_span_nth (lexer, HCL_LEXER_LOOKAHEAD - 1, &token, &error));
+    g_assert_no_error (error);
+    g_assert_cmpuint (token.offset, ==, 2 * (i + HCL_LEXER_LOOKAHEAD - 1));
+
+    g_assert_true (hcl_lexer_peek_span_nth (lexer, 1, &token, &error));
+    g_assert_cmpuint (token.offset, ==, 2 * (i + 1));
+
+    g_assert_true (hcl_lexer_next_span (lexer, &token, &error));
+    g_assert_cmpuint (token.offset, ==, 2 * i);
+  }
+
+  /* Token peeks and span peeks see the same lookahead */
+  peeked = hcl_lexer_peek_token (lexer, &error);
+  g_assert_cmpstr (hcl_token_get_value (peeked), ==, "e");
+  g_assert_true (hcl_lexer_peek_span_nth (lexer, 2, &token, &error));
+  g_assert_true (hcl_lexer_span_equal (lexer, &token, "g"));
+
+  next = hcl_lexer_next_token (lexer, &error);
+  g_assert_true (next == peeked);
+  g_assert_true (hcl_lexer_next_span (lexer, &token, &error));
+  g_assert_true (hcl_lexer_span_equal (lexer, &token, "f"));
+
+  /* Peeking past the end keeps returning the end */
+  g_assert_true (hcl_lexer_peek_span_nth (lexer, 3, &token, &error));
+  g_assert_cmpint (token.type, ==, HCL_TOKEN_TYPE_EOF);
+  g_assert_true (hcl_lexer_peek_span_nth (lexer, 2, &token, &error));
+  g_assert_cmpint (token.type, ==, HCL_TOKEN_TYPE_EOF);
+}
+
 int
 main (int argc, char **argv)
 {
@@ -141,8 +465,16 @@ main (int argc, char **argv)
   g_test_add_func ("/hcl/lexer/basic_tokens", test_lexer_basic_tokens);
   g_test_add_func ("/hcl/lexer/strings", test_lexer_strings);
   g_test_add_func ("/hcl/lexer/numbers", test_lexer_numbers);
+  g_test_add_func ("/hcl/lexer/number_values", test_lexer_number_values);
+  g_test_add_func ("/hcl/lexer/float_rounding", test_lexer_float_rounding);
   g_test_add_func ("/hcl/lexer/identifiers_and_bools", test_lexer_identifiers_and_bools);
   g_test_add_func ("/hcl/lexer/comments", test_lexer_comments);
+  g_test_add_func ("/hcl/lexer/spans", test_lexer_spans);
+  g_test_add_func ("/hcl/lexer/string_fast_path", test_lexer_string_fast_path);
+  g_test_add_func ("/hcl/lexer/string_errors", test_lexer_string_errors);
+  g_test_add_func ("/hcl/lexer/punctuation_positions", test_lexer_punctuation_positions);
+  g_test_add_func ("/hcl/lexer/invalid_characters", test_lexer_invalid_characters);
+  g_test_add_func ("/hcl/lexer/lookahead", test_lexer_lookahead);
 
   return g_test_run ();
 }
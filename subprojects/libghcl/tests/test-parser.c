@@ -4,7 +4,9 @@
  */
 
 #include <glib.h>
+#include <glib/gstdio.h>
 #include <hcl.h>
+#include <string.h>
 
 static void
 test_parse_simple_attribute (void)
@@ -176,6 +178,92 @@ test_parse_list_values (void)
   g_assert_cmpint (hcl_value_get_int (third), ==, 42);
 }
 
+static void
+test_parse_packed_lists (void)
+{
+  const gchar *input =
+    "ints = [1, -2, 3]\n"
+    "floats = [0.5, 1e3]\n"
+    "mixed = [1, 2.5, 3]\n"
+    "tail = [1, \"two\"]\n"
+    "rows = [[1, 2], [3.5]]\n";
+
+  g_autoptr(GError) error = NULL;
+  g_autoptr(HclDocument) document = hcl_parse_string (input, &error);
+  HclValue *value;
+  const gint64 *ints;
+  const gdouble *doubles;
+  guint length;
+
+  g_assert_no_error (error);
+
+  /* Lists of integers or of floats are packed */
+  value = hcl_document_get_attribute (document, "ints");
+  g_assert_true (hcl_value_is_list (value));
+  g_assert_true (hcl_value_is_array (value));
+  ints = hcl_value_get_int_array (value, &length);
+  g_assert_nonnull (ints);
+  g_assert_cmpuint (length, ==, 3);
+  g_assert_cmpint (ints[1], ==, -2);
+  g_assert_null (hcl_value_get_double_array (value, NULL));
+
+  value = hcl_document_get_attribute (document, "floats");
+  doubles = hcl_value_get_double_array (value, &length);
+  g_assert_nonnull (doubles);
+  g_assert_cmpuint (length, ==, 2);
+  g_assert_cmpfloat (doubles[1], ==, 1000.0);
+
+  /* Anything else is not, but reads the same */
+  value = hcl_document_get_attribute (document, "mixed");
+  g_assert_false (hcl_value_is_array (value));
+  g_assert_cmpuint (hcl_value_list_get_length (value), ==, 3);
+  g_assert_cmpint (hcl_value_get_int (hcl_value_list_get_item (value, 0)), ==, 1);
+  g_assert_cmpfloat (hcl_value_get_double (hcl_value_list_get_item (value, 1)), ==, 2.5);
+  g_assert_cmpint (hcl_value_get_number_type (hcl_value_list_get_item (value, 2)), ==,
+                   HCL_NUMBER_TYPE_INTEGER);
+
+  value = hcl_document_get_attribute (document, "tail");
+  g_assert_false (hcl_value_is_array (value));
+  g_assert_cmpint (hcl_value_get_int (hcl_value_list_get_item (value, 0)), ==, 1);
+  g_assert_cmpstr (hcl_value_get_string (hcl_value_list_get_item (value, 1)), ==, "two");
+
+  value = hcl_document_get_attribute (document, "rows");
+  g_assert_false (hcl_value_is_array (value));
+  g_assert_true (hcl_value_is_array (hcl_value_list_get_item (value, 0)));
+  g_assert_cmpint (hcl_value_get_number_type (hcl_value_list_get_item (value, 1)), ==,
+                   HCL_NUMBER_TYPE_FLOAT);
+}
+
+static void
+test_parse_number_values (void)
+{
+  const gchar *input =
+    "mask = 0x1e\n"
+    "bits = -0b101\n"
+    "curve = [0.5, 1e3, -2.25e-1, 7]\n";
+
+  g_autoptr(GError) error = NULL;
+  g_autoptr(HclDocument) document = hcl_parse_string (input, &error);
+
+  g_assert_no_error (error);
+
+  HclValue *mask = hcl_document_get_attribute (document, "mask");
+  g_assert_cmpint (hcl_value_get_number_type (mask), ==, HCL_NUMBER_TYPE_INTEGER);
+  g_assert_cmpint (hcl_value_get_int (mask), ==, 30);
+
+  HclValue *bits = hcl_document_get_attribute (document, "bits");
+  g_assert_cmpint (hcl_value_get_int (bits), ==, -5);
+
+  HclValue *curve = hcl_document_get_attribute (document, "curve");
+  g_assert_cmpint (hcl_value_get_number_type (hcl_value_list_get_item (curve, 0)), ==,
+                   HCL_NUMBER_TYPE_FLOAT);
+  g_assert_cmpfloat (hcl_value_get_double (hcl_value_list_get_item (curve, 0)), ==, 0.5);
+  g_assert_cmpfloat (hcl_value_get_double (hcl_value_list_get_item (curve, 1)), ==, 1000.0);
+  g_assert_cmpfloat (hcl_value_get_double (hcl_value_list_get_item (curve, 2)), ==, -0.225);
+  g_assert_cmpint (hcl_value_get_number_type (hcl_value_list_get_item (curve, 3)), ==,
+                   HCL_NUMBER_TYPE_INTEGER);
+}
+
 static void
 test_parse_object_values (void)
 {
@@ -220,7 +308,11 @@ test_parse_with_comments (void)
     "# This is a comment\n"
     "name = \"test\" # inline comment\n"
     "// Another comment style\n"
-    "count = 42\n";
+    "count = 42\n"
+    "app {\n"
+    "  # Comments are allowed in block bodies too\n"
+    "  port = 8080 // trailing\n"
+    "}\n";
 
   g_autoptr(GError) error = NULL;
   g_autoptr(HclDocument) document = hcl_parse_string (input, &error);
@@ -236,6 +328,44 @@ test_parse_with_comments (void)
 
   HclValue *count = hcl_document_get_attribute (document, "count");
   g_assert_cmpint (hcl_value_get_int (count), ==, 42);
+
+  g_autoptr(GList) blocks = hcl_document_get_blocks (document);
+  g_assert_cmpuint (g_list_length (blocks), ==, 1);
+  HclValue *port = hcl_block_get_attribute (blocks->data, "port");
+  g_assert_cmpint (hcl_value_get_int (port), ==, 8080);
+}
+
+static void
+test_parse_interned_keys (void)
+{
+  const gchar *input =
+    "box \"a\" {\n"
+    "  width = 1\n"
+    "  style = { \"width\" = 2, depth = 3 }\n"
+    "}\n"
+    "box \"b\" {\n"
+    "  width = 4\n"
+    "}\n";
+  g_autoptr(GError) error = NULL;
+  g_autoptr(HclDocument) document = hcl_parse_string (input, &error);
+  g_autoptr(GList) boxes = NULL;
+
+  g_assert_no_error (error);
+
+  /* Keys from different blocks and objects are the same string */
+  boxes = hcl_document_get_blocks_by_type (document, "box");
+  g_assert_cmpuint (g_list_length (boxes), ==, 2);
+
+  g_autoptr(GList) a_names = hcl_block_get_attribute_names (boxes->data);
+  g_autoptr(GList) b_names = hcl_block_get_attribute_names (boxes->next->data);
+  const gchar *a_width = g_list_find_custom (a_names, "width", (GCompareFunc) g_strcmp0)->data;
+  g_assert_true (a_width == b_names->data);
+  g_assert_true (hcl_block_get_block_type (boxes->data) ==
+                 hcl_block_get_block_type (boxes->next->data));
+
+  HclValue *style = hcl_block_get_attribute (boxes->data, "style");
+  g_autoptr(GList) style_keys = hcl_value_object_get_keys (style);
+  g_assert_true (g_list_find (style_keys, a_width) != NULL);
 }
 
 static void
@@ -249,6 +379,741 @@ test_parse_error_handling (void)
   g_assert_null (document);
 }
 
+/* Records events as text, skipping or stopping at a given name */
+typedef struct {
+  GString *log;
+  const gchar *skip;
+  const gchar *stop;
+  gboolean skip_lists;
+  gboolean fail;
+} EventTrace;
+
+static HclEventResult
+trace_name (EventTrace *trace, const gchar *name)
+{
+  if (g_strcmp0 (name, trace->stop) == 0)
+    return HCL_EVENT_RESULT_STOP;
+
+  return g_strcmp0 (name, trace->skip) == 0 ? HCL_EVENT_RESULT_SKIP
+                                            : HCL_EVENT_RESULT_CONTINUE;
+}
+
+static HclEventResult
+trace_block_begin (const gchar *type, const gchar *label, gpointer user_data, GError **error)
+{
+  EventTrace *trace = user_data;
+
+  (void) error;
+  g_string_append_printf (trace->log, "block(%s,%s) ", type, label ? label : "-");
+  return trace_name (trace, type);
+}
+
+static HclEventResult
+trace_block_end (gpointer user_data, GError **error)
+{
+  EventTrace *trace = user_data;
+
+  (void) error;
+  g_string_append (trace->log, "end ");
+  return HCL_EVENT_RESULT_CONTINUE;
+}
+
+static HclEventResult
+trace_attribute (const gchar *name, gpointer user_data, GError **error)
+{
+  EventTrace *trace = user_data;
+
+  g_string_append_printf (trace->log, "%s= ", name);
+
+  if (trace->fail && g_strcmp0 (name, trace->stop) == 0) {
+    g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA, "bad %s", name);
+    return HCL_EVENT_RESULT_STOP;
+  }
+
+  return trace_name (trace, name);
+}
+
+static HclEventResult
+trace_value (const HclEventValue *value, gpointer user_data, GError **error)
+{
+  EventTrace *trace = user_data;
+
+  (void) error;
+
+  switch (value->type) {
+    case HCL_VALUE_TYPE_STRING:
+      g_assert_cmpuint (strlen (value->string), ==, value->length);
+      g_string_append_printf (trace->log, "'%s' ", value->string);
+      break;
+
+    case HCL_VALUE_TYPE_NUMBER:
+      if (value->number_type == HCL_NUMBER_TYPE_INTEGER)
+        g_string_append_printf (trace->log, "%" G_GINT64_FORMAT " ", value->int_value);
+      else
+        g_string_append_printf (trace->log, "%g ", value->double_value);
+      break;
+
+    case HCL_VALUE_TYPE_BOOL:
+      g_string_append (trace->log, value->bool_value ? "true " : "false ");
+      break;
+
+    default:
+      g_assert_not_reached ();
+  }
+
+  return HCL_EVENT_RESULT_CONTINUE;
+}
+
+static HclEventResult
+trace_list_begin (gpointer user_data, GError **error)
+{
+  EventTrace *trace = user_data;
+
+  (void) error;
+  g_string_append (trace->log, "[ ");
+  return trace->skip_lists ? HCL_EVENT_RESULT_SKIP : HCL_EVENT_RESULT_CONTINUE;
+}
+
+static HclEventResult
+trace_list_end (gpointer user_data, GError **error)
+{
+  EventTrace *trace = user_data;
+
+  (void) error;
+  g_string_append (trace->log, "] ");
+  return HCL_EVENT_RESULT_CONTINUE;
+}
+
+static HclEventResult
+trace_object_begin (gpointer user_data, GError **error)
+{
+  EventTrace *trace = user_data;
+
+  (void) error;
+  g_string_append (trace->log, "{ ");
+  return HCL_EVENT_RESULT_CONTINUE;
+}
+
+static HclEventResult
+trace_object_key (const gchar *key, gpointer user_data, GError **error)
+{
+  EventTrace *trace = user_data;
+
+  (void) error;
+  g_string_append_printf (trace->log, "%s: ", key);
+  return trace_name (trace, key);
+}
+
+static HclEventResult
+trace_object_end (gpointer user_data, GError **error)
+{
+  EventTrace *trace = user_data;
+
+  (void) error;
+  g_string_append (trace->log, "} ");
+  return HCL_EVENT_RESULT_CONTINUE;
+}
+
+static const HclParserEvents trace_events = {
+  trace_block_begin,
+  trace_block_end,
+  trace_attribute,
+  trace_value,
+  trace_list_begin,
+  trace_list_end,
+  trace_object_begin,
+  trace_object_key,
+  trace_object_end,
+};
+
+static const gchar *events_input =
+  "# Top level\n"
+  "name = \"demo\"\n"
+  "application \"app\" {\n"
+  "  port = 8080\n"
+  "  ratio = 0.5\n"
+  "  debug = false\n"
+  "  tags = [\"a\", \"b\\tc\"]\n"
+  "  limits = { cpu = 2, \"mem\" = [1, 2] }\n"
+  "  database {\n"
+  "    host = \"localhost\" // trailing\n"
+  "  }\n"
+  "}\n"
+  "footer = true\n";
+
+static gchar *
+trace_parse (EventTrace *trace, const gchar *input, GError **error)
+{
+  g_autoptr(HclParser) parser = hcl_parser_new ();
+
+  trace->log = g_string_new (NULL);
+
+  if (!hcl_parser_parse_events (parser, input, -1, &trace_events, trace, error)) {
+    g_string_free (trace->log, TRUE);
+    return NULL;
+  }
+
+  return g_string_free (trace->log, FALSE);
+}
+
+static void
+test_parse_events (void)
+{
+  EventTrace trace = { 0, };
+  g_autoptr(GError) error = NULL;
+  g_autofree gchar *log = trace_parse (&trace, events_input, &error);
+
+  g_assert_no_error (error);
+  g_assert_cmpstr (log, ==,
+                   "name= 'demo' "
+                   "block(application,app) "
+                   "port= 8080 ratio= 0.5 debug= false "
+                   "tags= [ 'a' 'b\tc' ] "
+                   "limits= { cpu: 2 mem: [ 1 2 ] } "
+                   "block(database,-) host= 'localhost' end "
+                   "end "
+                   "footer= true ");
+}
+
+static void
+test_parse_events_skip (void)
+{
+  EventTrace trace = { 0, };
+  g_autoptr(GError) error = NULL;
+  g_autofree gchar *blocks = NULL;
+  g_autofree gchar *attributes = NULL;
+  g_autofree gchar *members = NULL;
+  g_autofree gchar *lists = NULL;
+
+  /* Skipped blocks report neither their contents nor their end */
+  trace.skip = "application";
+  blocks = trace_parse (&trace, events_input, &error);
+  g_assert_no_error (error);
+  g_assert_cmpstr (blocks, ==, "name= 'demo' block(application,app) footer= true ");
+
+  trace.skip = "limits";
+  attributes = trace_parse (&trace, events_input, &error);
+  g_assert_no_error (error);
+  g_assert_nonnull (strstr (attributes, "limits= block(database,-)"));
+
+  trace.skip = "mem";
+  members = trace_parse (&trace, events_input, &error);
+  g_assert_no_error (error);
+  g_assert_nonnull (strstr (members, "{ cpu: 2 mem: } "));
+
+  trace.skip = NULL;
+  trace.skip_lists = TRUE;
+  lists = trace_parse (&trace, events_input, &error);
+  g_assert_no_error (error);
+  g_assert_nonnull (strstr (lists, "tags= [ limits= { cpu: 2 mem: [ } "));
+}
+
+static void
+test_parse_events_stop (void)
+{
+  EventTrace trace = { 0, };
+  g_autoptr(GError) error = NULL;
+  g_autofree gchar *log = NULL;
+  g_autofree gchar *failed = NULL;
+
+  /* Input after the stop is not looked at, even if it is invalid */
+  trace.stop = "port";
+  log = trace_parse (&trace, "block {\n  port = 1\n  junk junk junk\n", &error);
+  g_assert_no_error (error);
+  g_assert_cmpstr (log, ==, "block(block,-) port= ");
+
+  /* Errors raised by callbacks are passed on */
+  trace.fail = TRUE;
+  failed = trace_parse (&trace, events_input, &error);
+  g_assert_null (failed);
+  g_assert_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA);
+  g_assert_cmpstr (error->message, ==, "bad port");
+}
+
+static void
+test_parse_events_errors (void)
+{
+  const gchar *invalid[] = {
+    "name = ",
+    "name = }",
+    "app {\n  port = 1\n",
+    "app {\n  = 1\n}\n",
+    "list = [1, 2\n",
+    "obj = { 1 = 2 }\n",
+    "\"quoted\" = 1\n",
+    "app \"label\" = 1\n",
+  };
+
+  for (gsize i = 0; i < G_N_ELEMENTS (invalid); i++) {
+    EventTrace trace = { 0, };
+    g_autoptr(GError) tree_error = NULL;
+    g_autoptr(GError) error = NULL;
+    g_autoptr(HclDocument) document = hcl_parse_string (invalid[i], &tree_error);
+    g_autofree gchar *log = trace_parse (&trace, invalid[i], &error);
+
+    /* Both modes reject the same input with the same error */
+    g_assert_null (document);
+    g_assert_null (log);
+    g_assert_nonnull (error);
+    g_assert_error (error, tree_error->domain, tree_error->code);
+    g_assert_cmpstr (error->message, ==, tree_error->message);
+  }
+}
+
+static void
+test_parse_events_skip_unterminated (void)
+{
+  EventTrace trace = { 0, };
+  g_autoptr(GError) error = NULL;
+  g_autofree gchar *log = NULL;
+
+  trace.skip = "app";
+  log = trace_parse (&trace, "app {\n  list = [1, 2\n}\n", &error);
+  g_assert_null (log);
+  g_assert_error (error, HCL_PARSER_ERROR, HCL_PARSER_ERROR_SYNTAX);
+}
+
+static void
+test_parse_files (void)
+{
+  g_autoptr(GError) error = NULL;
+  g_autofree gchar *dir = g_dir_make_tmp ("hcl-parse-files-XXXXXX", &error);
+  g_autoptr(GPtrArray) filenames = g_ptr_array_new_with_free_func (g_free);
+  g_autoptr(HclDocument) document = NULL;
+  g_autoptr(HclDocument) failed = NULL;
+  g_autoptr(GList) panels = NULL;
+  guint i;
+
+  g_assert_no_error (error);
+
+  for (i = 0; i < 16; i++) {
+    g_autofree gchar *name = g_strdup_printf ("%02u.hcl", i);
+    g_autofree gchar *text = g_strdup_printf ("last = %u\n"
+                                              "file_%u = true\n"
+                                              "panel \"p%u\" {\n  index = %u\n}\n",
+                                              i, i, i, i);
+    gchar *filename = g_build_filename (dir, name, NULL);
+
+    g_file_set_contents (filename, text, -1, &error);
+    g_assert_no_error (error);
+    g_ptr_array_add (filenames, filename);
+  }
+  g_ptr_array_add (filenames, NULL);
+
+  document = hcl_parse_files ((const gchar * const *) filenames->pdata, &error);
+  g_assert_no_error (error);
+  g_assert_nonnull (document);
+
+  /* Files merge in the order given, whichever finished first */
+  g_assert_cmpint (hcl_value_get_int (hcl_document_get_attribute (document, "last")), ==, 15);
+  g_assert_true (hcl_document_has_attribute (document, "file_0"));
+  g_assert_true (hcl_document_has_attribute (document, "file_15"));
+
+  panels = hcl_document_get_blocks_by_type (document, "panel");
+  g_assert_cmpuint (g_list_length (panels), ==, 16);
+  i = 0;
+  for (GList *l = panels; l; l = l->next, i++)
+    g_assert_cmpint (hcl_value_get_int (hcl_block_get_attribute (l->data, "index")), ==, i);
+
+  /* The first broken file in the list is reported */
+  g_file_set_contents (filenames->pdata[3], "broken = [1,\n", -1, &error);
+  g_assert_no_error (error);
+  g_file_set_contents (filenames->pdata[9], "also broken {\n", -1, &error);
+  g_assert_no_error (error);
+
+  failed = hcl_parse_files ((const gchar * const *) filenames->pdata, &error);
+  g_assert_null (failed);
+  g_assert_nonnull (error);
+  g_assert_true (g_str_has_prefix (error->message, filenames->pdata[3]));
+  g_clear_error (&error);
+
+  for (i = 0; i < 16; i++)
+    g_remove (filenames->pdata[i]);
+  g_rmdir (dir);
+}
+
+static void
+test_parse_mapped_file (void)
+{
+  /* Each file ends exactly on a page boundary, with no newline to stop
+   * the lexer before the end of the mapping */
+  const gchar *endings[] = { "n = 12345", "s = abc", "s = \"abc\"", "# end", "x = \"open" };
+  g_autoptr(GError) error = NULL;
+  g_autofree gchar *dir = g_dir_make_tmp ("hcl-parse-mapped-XXXXXX", &error);
+  g_autofree gchar *filename = NULL;
+  g_autofree gchar *missing = NULL;
+  g_autoptr(HclDocument) empty = NULL;
+  HclDocument *document;
+  gsize i;
+
+  g_assert_no_error (error);
+  filename = g_build_filename (dir, "page.hcl", NULL);
+  missing = g_build_filename (dir, "missing.hcl", NULL);
+
+  for (i = 0; i < G_N_ELEMENTS (endings); i++) {
+    g_autoptr(GString) text = g_string_new ("first = 1\n#");
+    gsize ending_length = strlen (endings[i]);
+
+    while (text->len < 4096 - ending_length - 1)
+      g_string_append_c (text, '-');
+    g_string_append_c (text, '\n');
+    g_string_append (text, endings[i]);
+    g_assert_cmpuint (text->len, ==, 4096);
+
+    g_file_set_contents (filename, text->str, (gssize) text->len, &error);
+    g_assert_no_error (error);
+
+    document = hcl_parse_file (filename, &error);
+    if (i == G_N_ELEMENTS (endings) - 1) {
+      g_assert_error (error, HCL_PARSER_ERROR, HCL_PARSER_ERROR_UNTERMINATED_STRING);
+      g_assert_null (document);
+      g_clear_error (&error);
+      continue;
+    }
+
+    g_assert_no_error (error);
+    g_assert_true (hcl_document_has_attribute (document, "first"));
+    g_object_unref (document);
+  }
+
+  g_file_set_contents (filename, "", 0, &error);
+  g_assert_no_error (error);
+  empty = hcl_parse_file (filename, &error);
+  g_assert_no_error (error);
+  g_assert_nonnull (empty);
+
+  g_assert_null (hcl_parse_file (missing, &error));
+  g_assert_error (error, G_FILE_ERROR, G_FILE_ERROR_NOENT);
+
+  g_remove (filename);
+  g_rmdir (dir);
+}
+
+/* Builds "@depth nested blocks, around a list nested @list_depth deep" */
+static gchar *
+nested_input (guint depth, guint list_depth)
+{
+  GString *input = g_string_new (NULL);
+  guint i;
+
+  for (i = 0; i < depth; i++)
+    g_string_append (input, "box {\n");
+  g_string_append (input, "value = ");
+  for (i = 0; i < list_depth; i++)
+    g_string_append_c (input, '[');
+  g_string_append_c (input, '1');
+  for (i = 0; i < list_depth; i++)
+    g_string_append_c (input, ']');
+  g_string_append_c (input, '\n');
+  for (i = 0; i < depth; i++)
+    g_string_append (input, "}\n");
+
+  return g_string_free (input, FALSE);
+}
+
+/* Checks the events reported for nested_input (@depth, @list_depth) */
+static void
+assert_deep_events (HclParser *parser, guint depth, guint list_depth)
+{
+  g_autofree gchar *input = nested_input (depth, list_depth);
+  g_autoptr(GString) expected = g_string_new (NULL);
+  EventTrace trace = { NULL, };
+  GError *error = NULL;
+  guint i;
+
+  for (i = 0; i < depth; i++)
+    g_string_append (expected, "block(box,-) ");
+  g_string_append (expected, "value= ");
+  for (i = 0; i < list_depth; i++)
+    g_string_append (expected, "[ ");
+  g_string_append (expected, "1 ");
+  for (i = 0; i < list_depth; i++)
+    g_string_append (expected, "] ");
+  for (i = 0; i < depth; i++)
+    g_string_append (expected, "end ");
+
+  trace.log = g_string_new (NULL);
+  g_assert_true (hcl_parser_parse_events (parser, input, -1, &trace_events, &trace, &error));
+  g_assert_no_error (error);
+  g_assert_cmpstr (trace.log->str, ==, expected->str);
+  g_string_free (trace.log, TRUE);
+}
+
+static void
+test_parse_depth_limit (void)
+{
+  g_autoptr(HclParser) parser = hcl_parser_new ();
+  g_autofree gchar *deep = nested_input (2000, 2000);
+  g_autofree gchar *shallow = nested_input (2, 1);
+  g_autoptr(HclDocument) document = NULL;
+  HclParserEvents events = { 0, };
+  GError *error = NULL;
+  HclBlockIter iter;
+  HclBlock *block;
+  HclBlock *child;
+  HclValue *value;
+  guint depth = 0;
+
+  g_assert_cmpuint (hcl_parser_get_max_depth (parser), ==, HCL_PARSER_DEFAULT_MAX_DEPTH);
+
+  g_assert_null (hcl_parser_parse_string (parser, deep, &error));
+  g_assert_error (error, HCL_PARSER_ERROR, HCL_PARSER_ERROR_TOO_DEEP);
+  g_clear_error (&error);
+
+  g_assert_false (hcl_parser_parse_events (parser, deep, -1, &events, NULL, &error));
+  g_assert_error (error, HCL_PARSER_ERROR, HCL_PARSER_ERROR_TOO_DEEP);
+  g_clear_error (&error);
+
+  /* Without a limit the tree parser takes any depth */
+  hcl_parser_set_max_depth (parser, 0);
+  document = hcl_parser_parse_string (parser, deep, &error);
+  g_assert_no_error (error);
+
+  hcl_document_iter_init (&iter, document, "box");
+  g_assert_true (hcl_block_iter_next (&iter, &block));
+  for (;;) {
+    hcl_block_iter_init (&iter, block, "box");
+    if (!hcl_block_iter_next (&iter, &child))
+      break;
+    block = child;
+    depth++;
+  }
+  g_assert_cmpuint (depth, ==, 1999);
+
+  value = hcl_block_get_attribute (block, "value");
+  for (depth = 0; hcl_value_is_list (value); depth++)
+    value = hcl_value_list_get_item (value, 0);
+  g_assert_cmpuint (depth, ==, 2000);
+  g_assert_cmpint (hcl_value_get_int (value), ==, 1);
+  g_clear_object (&document);
+
+  /* And so does the event parser, well past what the C stack would hold */
+  assert_deep_events (parser, 2000, 2000);
+  assert_deep_events (parser, 10, 1000000);
+
+  /* Two blocks and a list open three levels */
+  hcl_parser_set_max_depth (parser, 3);
+  document = hcl_parser_parse_string (parser, shallow, &error);
+  g_assert_no_error (error);
+  g_assert_true (hcl_parser_parse_events (parser, shallow, -1, &events, NULL, &error));
+  g_assert_no_error (error);
+  g_clear_object (&document);
+
+  hcl_parser_set_max_depth (parser, 2);
+  g_assert_null (hcl_parser_parse_string (parser, shallow, &error));
+  g_assert_error (error, HCL_PARSER_ERROR, HCL_PARSER_ERROR_TOO_DEEP);
+  g_clear_error (&error);
+  g_assert_false (hcl_parser_parse_events (parser, shallow, -1, &events, NULL, &error));
+  g_assert_error (error, HCL_PARSER_ERROR, HCL_PARSER_ERROR_TOO_DEEP);
+  g_clear_error (&error);
+
+  /* The parser is left clean for the next input */
+  document = hcl_parser_parse_string (parser, "a = { b = [1, 2] }\n", &error);
+  g_assert_no_error (error);
+  g_assert_true (hcl_document_has_attribute (document, "a"));
+}
+
+static void
+test_parse_recover (void)
+{
+  const gchar *input =
+    "name = \"ok\"\n"
+    "broken = \n"
+    "count = 5\n"
+    "box \"a\" {\n"
+    "  width = [1, 2\n"
+    "  height = 3\n"
+    "}\n"
+    "tags = [1, @, 3]\n"
+    "after = true\n"
+    "bad $ here\n"
+    "}\n"
+    "last = \"end\"\n"
+    "open {\n"
+    "  inner = { a = 1 }\n";
+  static const struct {
+    HclParserError code;
+    gsize line;
+    gsize column;
+    gsize length;
+  } expected[] = {
+    { HCL_PARSER_ERROR_SYNTAX, 2, 10, 1 },
+    { HCL_PARSER_ERROR_SYNTAX, 6, 10, 1 },
+    { HCL_PARSER_ERROR_SYNTAX, 8, 12, 1 },
+    { HCL_PARSER_ERROR_SYNTAX, 10, 5, 1 },
+    { HCL_PARSER_ERROR_SYNTAX, 11, 1, 1 },
+    { HCL_PARSER_ERROR_UNEXPECTED_TOKEN, 15, 1, 0 },
+  };
+  g_autoptr(HclParser) parser = hcl_parser_new ();
+  g_autoptr(GPtrArray) diagnostics = NULL;
+  g_autoptr(HclDocument) document = NULL;
+  g_autoptr(GError) error = NULL;
+  HclBlockIter iter;
+  HclBlock *box;
+  HclBlock *unclosed;
+  guint i;
+
+  document = hcl_parser_parse_string_recover (parser, input, &diagnostics);
+  g_assert_nonnull (document);
+  g_assert_cmpuint (diagnostics->len, ==, G_N_ELEMENTS (expected));
+
+  for (i = 0; i < G_N_ELEMENTS (expected); i++) {
+    HclDiagnostic *diagnostic = g_ptr_array_index (diagnostics, i);
+
+    g_assert_cmpint (hcl_diagnostic_get_code (diagnostic), ==, expected[i].code);
+    g_assert_cmpuint (hcl_diagnostic_get_line (diagnostic), ==, expected[i].line);
+    g_assert_cmpuint (hcl_diagnostic_get_column (diagnostic), ==, expected[i].column);
+    g_assert_cmpuint (hcl_diagnostic_get_length (diagnostic), ==, expected[i].length);
+    g_assert_nonnull (hcl_diagnostic_get_message (diagnostic));
+  }
+
+  /* The offset points at the text, here the stray character */
+  g_assert_cmpint (input[hcl_diagnostic_get_offset (g_ptr_array_index (diagnostics, 2))], ==, '@');
+
+  g_assert_cmpstr (hcl_value_get_string (hcl_document_get_attribute (document, "name")), ==, "ok");
+  g_assert_cmpint (hcl_value_get_int (hcl_document_get_attribute (document, "count")), ==, 5);
+  g_assert_true (hcl_value_get_bool (hcl_document_get_attribute (document, "after")));
+  g_assert_cmpstr (hcl_value_get_string (hcl_document_get_attribute (document, "last")), ==, "end");
+  g_assert_false (hcl_document_has_attribute (document, "broken"));
+  g_assert_false (hcl_document_has_attribute (document, "tags"));
+  g_assert_false (hcl_document_has_attribute (document, "bad"));
+
+  box = hcl_document_get_block_by_label (document, "box", "a");
+  g_assert_nonnull (box);
+  g_assert_false (hcl_block_has_attribute (box, "width"));
+  g_assert_false (hcl_block_has_attribute (box, "height"));
+
+  /* A block left open at the end keeps what it holds */
+  hcl_document_iter_init (&iter, document, "open");
+  g_assert_true (hcl_block_iter_next (&iter, &unclosed));
+  g_assert_true (hcl_value_is_object (hcl_block_get_attribute (unclosed, "inner")));
+
+  /* Valid input gives the same document and no diagnostics */
+  g_clear_pointer (&diagnostics, g_ptr_array_unref);
+  g_clear_object (&document);
+  document = hcl_parser_parse_string_recover (parser, "a = [1, { b = 2 }]\n", &diagnostics);
+  g_assert_cmpuint (diagnostics->len, ==, 0);
+  g_assert_cmpuint (hcl_value_list_get_length (hcl_document_get_attribute (document, "a")), ==, 2);
+
+  /* The parser still stops at the first error otherwise */
+  g_clear_object (&document);
+  document = hcl_parser_parse_string (parser, input, &error);
+  g_assert_error (error, HCL_PARSER_ERROR, HCL_PARSER_ERROR_SYNTAX);
+  g_assert_null (document);
+}
+
+/* Applies an edit to @text, like hcl_parser_reparse() does */
+static gchar *
+apply_edit (const gchar *text, gsize offset, gsize removed, const gchar *inserted)
+{
+  return g_strdup_printf ("%.*s%s%s", (int) offset, text, inserted, text + offset + removed);
+}
+
+static void
+test_parse_reparse (void)
+{
+  const gchar *input =
+    "title = \"Monitor\"\n"
+    "\n"
+    "box \"a\" {\n"
+    "  width = 10\n"
+    "}\n"
+    "box \"b\" {\n"
+    "  width = 20\n"
+    "}\n"
+    "# trailing\n"
+    "box \"c\" {\n"
+    "  width = 30\n"
+    "}\n";
+  g_autoptr(HclParser) parser = hcl_parser_new ();
+  g_autoptr(HclDocument) document = NULL;
+  g_autoptr(HclDocument) edited = NULL;
+  g_autoptr(HclDocument) again = NULL;
+  g_autoptr(GPtrArray) changed = NULL;
+  g_autoptr(GPtrArray) replaced = NULL;
+  g_autoptr(GError) error = NULL;
+  g_autofree gchar *edited_text = NULL;
+  HclBlock *a, *b, *c;
+  HclBlock *new_b;
+  gsize offset;
+
+  document = hcl_parser_parse_string (parser, input, &error);
+  g_assert_no_error (error);
+  a = hcl_document_get_block_by_label (document, "box", "a");
+  b = hcl_document_get_block_by_label (document, "box", "b");
+  c = hcl_document_get_block_by_label (document, "box", "c");
+
+  /* Widening box "b" only parses box "b" again */
+  offset = strstr (input, "20") - input;
+  edited = hcl_parser_reparse (parser, document, input, offset, 2, "200",
+                               &changed, &replaced, &error);
+  g_assert_no_error (error);
+  edited_text = apply_edit (input, offset, 2, "200");
+
+  g_assert_cmpuint (changed->len, ==, 1);
+  g_assert_cmpuint (replaced->len, ==, 1);
+  g_assert_true (g_ptr_array_index (replaced, 0) == b);
+
+  new_b = g_ptr_array_index (changed, 0);
+  g_assert_true (new_b != b);
+  g_assert_true (hcl_document_get_block_by_label (edited, "box", "b") == new_b);
+  g_assert_cmpint (hcl_value_get_int (hcl_block_get_attribute (new_b, "width")), ==, 200);
+  g_assert_cmpint (hcl_value_get_int (hcl_block_get_attribute (b, "width")), ==, 20);
+
+  g_assert_true (hcl_document_get_block_by_label (edited, "box", "a") == a);
+  g_assert_true (hcl_document_get_block_by_label (edited, "box", "c") == c);
+  g_assert_true (hcl_document_get_attribute (edited, "title") ==
+                 hcl_document_get_attribute (document, "title"));
+  g_assert_cmpuint (g_list_length (hcl_document_get_blocks (edited)), ==, 3);
+
+  /* The edited document can be edited again, after the shifted text */
+  g_clear_pointer (&changed, g_ptr_array_unref);
+  g_clear_pointer (&replaced, g_ptr_array_unref);
+  offset = strstr (edited_text, "30") - edited_text;
+  again = hcl_parser_reparse (parser, edited, edited_text, offset, 2, "31",
+                              &changed, &replaced, &error);
+  g_assert_no_error (error);
+  g_assert_cmpuint (changed->len, ==, 1);
+  g_assert_true (g_ptr_array_index (replaced, 0) == c);
+  g_assert_true (hcl_document_get_block_by_label (again, "box", "b") == new_b);
+  g_assert_cmpint (hcl_value_get_int (hcl_block_get_attribute (g_ptr_array_index (changed, 0),
+                                                               "width")), ==, 31);
+  g_clear_object (&again);
+
+  /* Text inserted between statements is parsed with its neighbour */
+  g_clear_pointer (&changed, g_ptr_array_unref);
+  g_clear_pointer (&replaced, g_ptr_array_unref);
+  offset = strstr (input, "box \"b\"") - input;
+  again = hcl_parser_reparse (parser, document, input, offset, 0, "box \"new\" {}\n",
+                              &changed, &replaced, &error);
+  g_assert_no_error (error);
+  g_assert_cmpuint (changed->len, ==, 2);
+  g_assert_cmpuint (replaced->len, ==, 1);
+  g_assert_nonnull (hcl_document_get_block_by_label (again, "box", "new"));
+  g_assert_true (hcl_document_get_block_by_label (again, "box", "a") == a);
+  g_assert_cmpuint (g_list_length (hcl_document_get_blocks (again)), ==, 4);
+  g_clear_object (&again);
+
+  /* Edits that break the text fail like a full parse */
+  offset = strstr (input, "}\nbox \"b\"") - input;
+  again = hcl_parser_reparse (parser, document, input, offset, 1, "", NULL, NULL, &error);
+  g_assert_error (error, HCL_PARSER_ERROR, HCL_PARSER_ERROR_UNEXPECTED_TOKEN);
+  g_assert_null (again);
+  g_clear_error (&error);
+
+  /* A document changed since it was parsed is parsed again in full */
+  g_clear_pointer (&changed, g_ptr_array_unref);
+  g_clear_pointer (&replaced, g_ptr_array_unref);
+  hcl_document_set_attribute (document, "extra", hcl_value_new_bool (TRUE));
+  offset = strstr (input, "10") - input;
+  again = hcl_parser_reparse (parser, document, input, offset, 2, "11",
+                              &changed, &replaced, &error);
+  g_assert_no_error (error);
+  g_assert_cmpuint (changed->len, ==, 3);
+  g_assert_cmpuint (replaced->len, ==, 3);
+  g_assert_false (hcl_document_has_attribute (again, "extra"));
+}
+
 int
 main (int argc, char **argv)
 {
@@ -259,9 +1124,22 @@ main (int argc, char **argv)
   g_test_add_func ("/hcl/parser/simple_block", test_parse_simple_block);
   g_test_add_func ("/hcl/parser/nested_blocks", test_parse_nested_blocks);
   g_test_add_func ("/hcl/parser/list_values", test_parse_list_values);
+  g_test_add_func ("/hcl/parser/packed_lists", test_parse_packed_lists);
+  g_test_add_func ("/hcl/parser/number_values", test_parse_number_values);
   g_test_add_func ("/hcl/parser/object_values", test_parse_object_values);
   g_test_add_func ("/hcl/parser/with_comments", test_parse_with_comments);
+  g_test_add_func ("/hcl/parser/interned_keys", test_parse_interned_keys);
   g_test_add_func ("/hcl/parser/error_handling", test_parse_error_handling);
+  g_test_add_func ("/hcl/parser/events", test_parse_events);
+  g_test_add_func ("/hcl/parser/events_skip", test_parse_events_skip);
+  g_test_add_func ("/hcl/parser/events_stop", test_parse_events_stop);
+  g_test_add_func ("/hcl/parser/events_errors", test_parse_events_errors);
+  g_test_add_func ("/hcl/parser/events_skip_unterminated", test_parse_events_skip_unterminated);
+  g_test_add_func ("/hcl/parser/depth_limit", test_parse_depth_limit);
+  g_test_add_func ("/hcl/parser/recover", test_parse_recover);
+  g_test_add_func ("/hcl/parser/reparse", test_parse_reparse);
+  g_test_add_func ("/hcl/parser/files", test_parse_files);
+  g_test_add_func ("/hcl/parser/mapped_file", test_parse_mapped_file);
 
   return g_test_run ();
 }
@@ -0,0 +1,223 @@
+/* test-path.c - Tests for HclPath
+ *
+ * Copyright 2024 Geoff Johnson <geoff.jay@gmail.com>
+ */
+
+#include <glib.h>
+#include <hcl.h>
+
+static const gchar *config =
+  "title = \"Slate\"\n"
+  "sizes = [[1, 2], [3, 4]]\n"
+  "limits = { cpu = 2, mem = \"1G\" }\n"
+  "dashboard \"main\" {\n"
+  "  card \"cpu\" {\n"
+  "    chart {\n"
+  "      title = \"CPU\"\n"
+  "    }\n"
+  "  }\n"
+  "  card \"memory\" {\n"
+  "    chart {\n"
+  "      title = \"Memory\"\n"
+  "    }\n"
+  "  }\n"
+  "  card \"empty\" {\n"
+  "  }\n"
+  "}\n"
+  "dashboard \"other\" {\n"
+  "  card \"disk\" {\n"
+  "    chart {\n"
+  "      title = \"Disk\"\n"
+  "    }\n"
+  "  }\n"
+  "}\n";
+
+static HclDocument *
+load_config (void)
+{
+  g_autoptr(GError) error = NULL;
+  HclDocument *document = hcl_parse_string (config, &error);
+
+  g_assert_no_error (error);
+
+  return document;
+}
+
+/* Evaluates @expression and joins string matches and block labels with ',' */
+static gchar *
+collect (HclDocument *document, const gchar *expression)
+{
+  g_autoptr(GError) error = NULL;
+  g_autoptr(HclPath) path = hcl_path_new (expression, &error);
+  g_autoptr(GString) result = g_string_new (NULL);
+  HclPathIter iter;
+  HclBlock *block;
+  HclValue *value;
+
+  g_assert_no_error (error);
+
+  hcl_path_iter_init (&iter, path, document);
+  while (hcl_path_iter_next (&iter, &block, &value)) {
+    if (result->len > 0)
+      g_string_append_c (result, ',');
+
+    if (block)
+      g_string_append (result, hcl_block_get_label (block));
+    else if (hcl_value_is_string (value))
+      g_string_append (result, hcl_value_get_string (value));
+    else if (hcl_value_is_number (value))
+      g_string_append_printf (result, "%" G_GINT64_FORMAT, hcl_value_get_int (value));
+    else
+      g_string_append (result, "?");
+  }
+
+  return g_string_free (g_steal_pointer (&result), FALSE);
+}
+
+static void
+assert_path (HclDocument *document, const gchar *expression, const gchar *expected)
+{
+  g_autofree gchar *result = collect (document, expression);
+
+  g_assert_cmpstr (result, ==, expected);
+}
+
+static void
+test_path_blocks (void)
+{
+  g_autoptr(HclDocument) document = load_config ();
+
+  assert_path (document, "dashboard[\"main\"].card[*].chart.title", "CPU,Memory");
+  assert_path (document, "dashboard.card.chart.title", "CPU,Memory,Disk");
+  assert_path (document, "dashboard", "main,other");
+  assert_path (document, "dashboard[1].card", "disk");
+  assert_path (document, "dashboard[\"main\"].card[2]", "empty");
+  assert_path (document, "dashboard[\"main\"].card[3]", "");
+  assert_path (document, "dashboard[\"missing\"].card", "");
+  assert_path (document, "nothing.card", "");
+}
+
+static void
+test_path_values (void)
+{
+  g_autoptr(HclDocument) document = load_config ();
+  g_autofree gchar *members = NULL;
+
+  assert_path (document, "title", "Slate");
+  assert_path (document, "sizes[1][0]", "3");
+  assert_path (document, "sizes[*][1]", "2,4");
+  assert_path (document, "sizes[2]", "");
+  assert_path (document, "limits.mem", "1G");
+  assert_path (document, "limits[\"cpu\"]", "2");
+  assert_path (document, "title[0]", "");
+  assert_path (document, "title.length", "");
+
+  /* Object members come in no particular order */
+  members = collect (document, "limits[*]");
+  g_assert_true (g_str_equal (members, "2,1G") || g_str_equal (members, "1G,2"));
+
+  /* Selectors after a block pick nothing */
+  assert_path (document, "dashboard[0][0]", "");
+}
+
+static void
+test_path_iter (void)
+{
+  g_autoptr(HclDocument) document = load_config ();
+  g_autoptr(HclPath) path = hcl_path_new ("dashboard.card", NULL);
+  g_autoptr(HclPath) title = hcl_path_new ("chart.title", NULL);
+  HclBlock *card = hcl_document_get_block_by_label (document, "dashboard", "other");
+  HclPathIter outer;
+  HclPathIter inner;
+  HclBlock *block;
+  HclValue *value;
+  guint count = 0;
+
+  /* Only the requested kind of match is returned */
+  hcl_path_iter_init (&outer, path, document);
+  while (hcl_path_iter_next (&outer, NULL, &value))
+    count++;
+  g_assert_cmpuint (count, ==, 0);
+
+  /* Two iterators can walk the same path at once */
+  hcl_path_iter_init (&outer, path, document);
+  g_assert_true (hcl_path_iter_next (&outer, &block, NULL));
+  hcl_path_iter_init (&inner, path, document);
+  g_assert_true (hcl_path_iter_next (&inner, &block, NULL));
+  g_assert_cmpstr (hcl_block_get_label (block), ==, "cpu");
+  hcl_path_iter_clear (&inner);
+  hcl_path_iter_clear (&inner);
+  g_assert_true (hcl_path_iter_next (&outer, &block, NULL));
+  g_assert_cmpstr (hcl_block_get_label (block), ==, "memory");
+  hcl_path_iter_clear (&outer);
+
+  /* Evaluation can start from a block */
+  card = hcl_block_get_block_by_label (card, "card", "disk");
+  hcl_path_iter_init_block (&inner, title, card);
+  g_assert_true (hcl_path_iter_next (&inner, &block, &value));
+  g_assert_null (block);
+  g_assert_cmpstr (hcl_value_get_string (value), ==, "Disk");
+  g_assert_false (hcl_path_iter_next (&inner, &block, &value));
+
+  g_assert_cmpstr (hcl_path_get_expression (path), ==, "dashboard.card");
+  g_assert_cmpstr (hcl_block_get_label (hcl_path_get_block (path, document)), ==, "cpu");
+  g_assert_null (hcl_path_get_value (path, document));
+  g_assert_null (hcl_path_get_value (title, document));
+}
+
+static void
+test_path_errors (void)
+{
+  const struct {
+    const gchar *expression;
+    gint code;
+  } cases[] = {
+    { "", HCL_PATH_ERROR_SYNTAX },
+    { ".title", HCL_PATH_ERROR_SYNTAX },
+    { "title.", HCL_PATH_ERROR_SYNTAX },
+    { "a..b", HCL_PATH_ERROR_SYNTAX },
+    { "a[", HCL_PATH_ERROR_SYNTAX },
+    { "a[]", HCL_PATH_ERROR_SYNTAX },
+    { "a[1", HCL_PATH_ERROR_SYNTAX },
+    { "a[\"x]", HCL_PATH_ERROR_SYNTAX },
+    { "a[\"\\n\"]", HCL_PATH_ERROR_SYNTAX },
+    { "a[x]", HCL_PATH_ERROR_SYNTAX },
+    { "a b", HCL_PATH_ERROR_SYNTAX },
+    { "[0]", HCL_PATH_ERROR_SYNTAX },
+    { "a[-1]", HCL_PATH_ERROR_INVALID_INDEX },
+    { "a[99999999999]", HCL_PATH_ERROR_INVALID_INDEX },
+  };
+
+  for (gsize i = 0; i < G_N_ELEMENTS (cases); i++) {
+    g_autoptr(GError) error = NULL;
+    g_autoptr(HclPath) path = hcl_path_new (cases[i].expression, &error);
+
+    g_assert_null (path);
+    g_assert_error (error, HCL_PATH_ERROR, cases[i].code);
+  }
+}
+
+static void
+test_path_quoted_keys (void)
+{
+  g_autoptr(GError) error = NULL;
+  g_autoptr(HclDocument) document =
+    hcl_parse_string ("box \"a \\\"b\\\" \\\\ c\" {\n  x = 1\n}\n", &error);
+
+  g_assert_no_error (error);
+  assert_path (document, "box[\"a \\\"b\\\" \\\\ c\"].x", "1");
+}
+
+int
+main (int argc, char **argv)
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/hcl/path/blocks", test_path_blocks);
+  g_test_add_func ("/hcl/path/values", test_path_values);
+  g_test_add_func ("/hcl/path/iter", test_path_iter);
+  g_test_add_func ("/hcl/path/errors", test_path_errors);
+  g_test_add_func ("/hcl/path/quoted_keys", test_path_quoted_keys);
+
+  return g_test_run ();
+}
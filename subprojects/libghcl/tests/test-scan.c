@@ -0,0 +1,97 @@
+/* test-scan.c - Tests for the lexer bulk scanners
+ *
+ * Copyright 2024 Geoff Johnson <geoff.jay@gmail.com>
+ */
+
+#include <glib.h>
+#include <hcl.h>
+#include "hcl-scan.h"
+
+/* Compares the vector scanners with the scalar ones on every suffix of a
+ * random buffer, so that runs end inside, at and past vector boundaries */
+static void
+test_scan_matches_scalar (void)
+{
+  static const gchar alphabet[] = "  \t\r\nab_-Z09#\"'\\={}.\x80\xff";
+  g_autoptr(GRand) rand = g_rand_new_with_seed (1234);
+  gchar buffer[300];
+  guint round;
+
+  for (round = 0; round < 200; round++) {
+    gsize i;
+
+    /* Long runs of one class make the vector paths do real work */
+    for (i = 0; i < sizeof buffer; i++) {
+      if (g_rand_int_range (rand, 0, 8) == 0 || i == 0)
+        buffer[i] = alphabet[g_rand_int_range (rand, 0, sizeof alphabet - 1)];
+      else
+        buffer[i] = buffer[i - 1];
+    }
+
+    for (i = 0; i < sizeof buffer; i++) {
+      const gchar *data = buffer + i;
+      gsize length = sizeof buffer - i;
+      gsize scalar_last = G_MAXSIZE;
+      gsize vector_last = G_MAXSIZE;
+
+      g_assert_cmpuint (hcl_scan_whitespace (data, length), ==,
+                        hcl_scan_whitespace_scalar (data, length));
+      g_assert_cmpuint (hcl_scan_identifier (data, length), ==,
+                        hcl_scan_identifier_scalar (data, length));
+      g_assert_cmpuint (hcl_scan_line (data, length), ==,
+                        hcl_scan_line_scalar (data, length));
+      g_assert_cmpuint (hcl_scan_string (data, length, '"'), ==,
+                        hcl_scan_string_scalar (data, length, '"'));
+      g_assert_cmpuint (hcl_scan_string (data, length, '\''), ==,
+                        hcl_scan_string_scalar (data, length, '\''));
+      g_assert_cmpuint (hcl_scan_count_newlines (data, length, &vector_last), ==,
+                        hcl_scan_count_newlines_scalar (data, length, &scalar_last));
+      g_assert_cmpuint (vector_last, ==, scalar_last);
+    }
+  }
+}
+
+static void
+test_scan_lexer_positions (void)
+{
+  /* Long blank and identifier runs still yield exact line/column */
+  const gchar *input =
+    "                                        a_very_long_identifier_name_exceeding_32_bytes\n"
+    "\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t# a comment that is longer than thirty-two bytes\n"
+    "x";
+  g_autoptr(HclLexer) lexer = hcl_lexer_new (input);
+  g_autoptr(GError) error = NULL;
+  HclSpanToken token;
+
+  g_assert_true (hcl_lexer_next_span (lexer, &token, &error));
+  g_assert_no_error (error);
+  g_assert_cmpint (token.type, ==, HCL_TOKEN_TYPE_IDENTIFIER);
+  g_assert_cmpuint (token.column, ==, 41);
+  g_assert_cmpuint (token.length, ==, 46);
+
+  g_assert_true (hcl_lexer_next_span (lexer, &token, &error));
+  g_assert_cmpint (token.type, ==, HCL_TOKEN_TYPE_NEWLINE);
+  g_assert_cmpuint (token.column, ==, 87);
+
+  g_assert_true (hcl_lexer_next_span (lexer, &token, &error));
+  g_assert_cmpint (token.type, ==, HCL_TOKEN_TYPE_COMMENT);
+  g_assert_cmpuint (token.line, ==, 2);
+  g_assert_cmpuint (token.column, ==, 21);
+
+  g_assert_true (hcl_lexer_next_span (lexer, &token, &error));
+  g_assert_true (hcl_lexer_next_span (lexer, &token, &error));
+  g_assert_cmpint (token.type, ==, HCL_TOKEN_TYPE_IDENTIFIER);
+  g_assert_cmpuint (token.line, ==, 3);
+  g_assert_cmpuint (token.column, ==, 1);
+}
+
+int
+main (int argc, char **argv)
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/hcl/scan/matches_scalar", test_scan_matches_scalar);
+  g_test_add_func ("/hcl/scan/lexer_positions", test_scan_lexer_positions);
+
+  return g_test_run ();
+}
@@ -0,0 +1,229 @@
+/* test-stream-parser.c - Tests for HclStreamParser
+ *
+ * Copyright 2024 Geoff Johnson <geoff.jay@gmail.com>
+ */
+
+#include <glib.h>
+#include <hcl.h>
+#include <string.h>
+
+#include "test-utils.h"
+
+static const gchar *config =
+  "# Dashboard configuration\n"
+  "title = \"Main \\\"dashboard\\\"\"\n"
+  "version = 2\n"
+  "application \"slate\" {\n"
+  "  debug = true // trailing comment\n"
+  "  tags = [\"a\", \"b{\",\n"
+  "          \"c}\"]\n"
+  "  options = {\n"
+  "    depth = 1\n"
+  "    path = \"/var/lib\"\n"
+  "  }\n"
+  "  dashboard {\n"
+  "    box \"main\" { orientation = \"vertical\" }\n"
+  "    box 'side' {\n"
+  "      width = 1.5\n"
+  "    }\n"
+  "  }\n"
+  "}\n"
+  "footer = 'end'";
+
+static void
+test_stream_parser_chunk_boundaries (void)
+{
+  g_autoptr(GError) error = NULL;
+  g_autoptr(HclDocument) expected = hcl_parse_string (config, &error);
+  gsize length = strlen (config);
+  gsize chunk_size;
+
+  g_assert_no_error (error);
+
+  /* Every split point gets exercised with the one-byte chunks */
+  for (chunk_size = 1; chunk_size <= 17; chunk_size += 4) {
+    g_autoptr(HclStreamParser) parser = hcl_stream_parser_new ();
+    g_autoptr(HclDocument) document = hcl_document_new ();
+    gsize offset;
+
+    hcl_stream_parser_set_document (parser, document);
+
+    for (offset = 0; offset < length; offset += chunk_size) {
+      g_assert_true (hcl_stream_parser_feed (parser, config + offset,
+                                             (gssize) MIN (chunk_size, length - offset),
+                                             &error));
+      g_assert_no_error (error);
+    }
+
+    g_assert_true (hcl_stream_parser_finish (parser, &error));
+    g_assert_no_error (error);
+
+    hcl_test_assert_document_equal (expected, document);
+  }
+}
+
+static void
+on_block_parsed (HclStreamParser *parser, HclBlock *block, HclBlock *parent, GString *log)
+{
+  (void) parser;
+
+  g_string_append_printf (log, "%s:%s<%s ",
+                          hcl_block_get_block_type (block),
+                          hcl_block_get_label (block) ? hcl_block_get_label (block) : "",
+                          parent ? hcl_block_get_block_type (parent) : "");
+}
+
+static void
+on_attribute_parsed (HclStreamParser *parser, const gchar *name, HclValue *value, GString *log)
+{
+  (void) parser;
+  (void) value;
+
+  g_string_append_printf (log, "%s= ", name);
+}
+
+static void
+test_stream_parser_emits_early (void)
+{
+  g_autoptr(HclStreamParser) parser = hcl_stream_parser_new ();
+  g_autoptr(GString) log = g_string_new (NULL);
+  g_autoptr(GError) error = NULL;
+  const gchar *split = strstr (config, "  }\n}\n");
+
+  g_signal_connect (parser, "block-parsed", G_CALLBACK (on_block_parsed), log);
+  g_signal_connect (parser, "attribute-parsed", G_CALLBACK (on_attribute_parsed), log);
+
+  /* Everything before the end of "dashboard" is known before it arrives */
+  g_assert_true (hcl_stream_parser_feed (parser, config, split - config, &error));
+  g_assert_no_error (error);
+  g_assert_nonnull (strstr (log->str, "title= "));
+  g_assert_nonnull (strstr (log->str, "version= "));
+  g_assert_true (g_str_has_suffix (log->str, "box:main<dashboard box:side<dashboard "));
+  g_string_truncate (log, 0);
+
+  g_assert_true (hcl_stream_parser_feed (parser, split, -1, &error));
+  g_assert_cmpstr (log->str, ==, "dashboard:<application application:slate< ");
+
+  /* The last line has no newline; only the end of input completes it */
+  g_assert_true (hcl_stream_parser_finish (parser, &error));
+  g_assert_no_error (error);
+  g_assert_true (g_str_has_suffix (log->str, "footer= "));
+}
+
+static void
+test_stream_parser_errors (void)
+{
+  static const gchar *inputs[] = {
+    "a = 1\nb = \n",
+    "x {\n  y = [1, 2\n",
+    "block \"label\" {\n  good = 1\n  bad = \"unterminated\n}\n",
+    "outer {\n  inner {\n    v = 1\n  }\n",
+    "x = 1\n  3 {\n}\n",
+  };
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (inputs); i++) {
+    g_autoptr(HclStreamParser) parser = hcl_stream_parser_new ();
+    g_autoptr(GError) error = NULL;
+    gsize length = strlen (inputs[i]);
+    gsize offset;
+    gboolean ok = TRUE;
+
+    for (offset = 0; ok && offset < length; offset += 3)
+      ok = hcl_stream_parser_feed (parser, inputs[i] + offset,
+                                   (gssize) MIN (3, length - offset), &error);
+    if (ok)
+      ok = hcl_stream_parser_finish (parser, &error);
+
+    g_assert_false (ok);
+    g_assert_nonnull (error);
+    g_assert_true (error->domain == HCL_PARSER_ERROR);
+  }
+
+  /* Positions are those of the whole input, not of the current chunk */
+  {
+    const gchar *input = "a = 1\nb {\n  c = 2\n  d = \"x\\q\"\n}\n";
+    g_autoptr(HclStreamParser) parser = hcl_stream_parser_new ();
+    g_autoptr(GError) expected = NULL;
+    g_autoptr(GError) error = NULL;
+    g_autoptr(HclDocument) document = hcl_parse_string (input, &expected);
+
+    g_assert_null (document);
+    g_assert_false (hcl_stream_parser_feed (parser, input, -1, &error));
+    g_assert_error (error, HCL_PARSER_ERROR, HCL_PARSER_ERROR_INVALID_ESCAPE);
+    g_assert_cmpstr (error->message, ==, expected->message);
+
+    /* The parser is reset after an error and can be reused */
+    g_clear_error (&error);
+    g_assert_true (hcl_stream_parser_feed (parser, "ok = 1\n", -1, &error));
+    g_assert_true (hcl_stream_parser_finish (parser, &error));
+    g_assert_no_error (error);
+  }
+}
+
+static void
+test_stream_parser_input_stream (void)
+{
+  g_autoptr(HclParser) parser = hcl_parser_new ();
+  g_autoptr(GInputStream) stream = NULL;
+  g_autoptr(GError) error = NULL;
+  g_autoptr(HclDocument) expected = hcl_parse_string (config, &error);
+  g_autoptr(HclDocument) document = NULL;
+
+  stream = g_memory_input_stream_new_from_data (config, -1, NULL);
+  document = hcl_parser_parse_stream (parser, stream, NULL, &error);
+  g_assert_no_error (error);
+  g_assert_nonnull (document);
+
+  hcl_test_assert_document_equal (expected, document);
+}
+
+static void
+on_parse_ready (GObject *source, GAsyncResult *result, gpointer user_data)
+{
+  GMainLoop *loop = user_data;
+  g_autoptr(GError) error = NULL;
+
+  g_assert_true (hcl_stream_parser_parse_finish (HCL_STREAM_PARSER (source), result, &error));
+  g_assert_no_error (error);
+  g_main_loop_quit (loop);
+}
+
+static void
+test_stream_parser_async (void)
+{
+  g_autoptr(HclStreamParser) parser = hcl_stream_parser_new ();
+  g_autoptr(HclDocument) document = hcl_document_new ();
+  g_autoptr(GMainLoop) loop = g_main_loop_new (NULL, FALSE);
+  g_autoptr(GInputStream) stream = NULL;
+  g_autoptr(GString) log = g_string_new (NULL);
+  g_autoptr(GError) error = NULL;
+  g_autoptr(HclDocument) expected = hcl_parse_string (config, &error);
+
+  stream = g_memory_input_stream_new_from_data (config, -1, NULL);
+  hcl_stream_parser_set_document (parser, document);
+  hcl_stream_parser_set_chunk_size (parser, 16);
+  g_assert_cmpuint (hcl_stream_parser_get_chunk_size (parser), ==, 16);
+  g_signal_connect (parser, "block-parsed", G_CALLBACK (on_block_parsed), log);
+
+  hcl_stream_parser_parse_async (parser, stream, G_PRIORITY_DEFAULT, NULL,
+                                 on_parse_ready, loop);
+  g_main_loop_run (loop);
+
+  g_assert_true (g_str_has_suffix (log->str, "application:slate< "));
+  hcl_test_assert_document_equal (expected, document);
+}
+
+int
+main (int argc, char **argv)
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/hcl/stream-parser/chunk_boundaries", test_stream_parser_chunk_boundaries);
+  g_test_add_func ("/hcl/stream-parser/emits_early", test_stream_parser_emits_early);
+  g_test_add_func ("/hcl/stream-parser/errors", test_stream_parser_errors);
+  g_test_add_func ("/hcl/stream-parser/input_stream", test_stream_parser_input_stream);
+  g_test_add_func ("/hcl/stream-parser/async", test_stream_parser_async);
+
+  return g_test_run ();
+}
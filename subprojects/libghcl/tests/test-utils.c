@@ -0,0 +1,100 @@
+/* test-utils.c - Helpers shared by the libghcl tests
+ *
+ * Copyright 2024 Geoff Johnson <geoff.jay@gmail.com>
+ */
+
+#include "test-utils.h"
+
+/*
+ * Deep comparisons of documents built in different ways, such as parsed,
+ * streamed or loaded from a cache. Attributes and members are matched by
+ * name; blocks and list items must come in the same order.
+ */
+
+void
+hcl_test_assert_value_equal (HclValue *expected, HclValue *value)
+                             {
+  g_assert_nonnull (value);
+  g_assert_cmpint (hcl_value_get_value_type (value), ==, hcl_value_get_value_type (expected));
+
+  switch (hcl_value_get_value_type (expected)) {
+    case HCL_VALUE_TYPE_BOOL:
+      g_assert_cmpint (hcl_value_get_bool (value), ==, hcl_value_get_bool (expected));
+      break;
+
+    case HCL_VALUE_TYPE_NUMBER:
+      g_assert_cmpint (hcl_value_get_number_type (value), ==,
+                       hcl_value_get_number_type (expected));
+      g_assert_cmpint (hcl_value_get_int (value), ==, hcl_value_get_int (expected));
+      g_assert_cmpfloat (hcl_value_get_double (value), ==, hcl_value_get_double (expected));
+      break;
+
+    case HCL_VALUE_TYPE_STRING:
+      g_assert_cmpstr (hcl_value_get_string (value), ==, hcl_value_get_string (expected));
+      break;
+
+    case HCL_VALUE_TYPE_LIST:
+      g_assert_cmpint (hcl_value_is_array (value), ==, hcl_value_is_array (expected));
+      g_assert_cmpuint (hcl_value_list_get_length (value), ==,
+                        hcl_value_list_get_length (expected));
+      for (guint i = 0; i < hcl_value_list_get_length (expected); i++)
+        hcl_test_assert_value_equal (hcl_value_list_get_item (expected, i),
+                                     hcl_value_list_get_item (value, i));
+      break;
+
+    case HCL_VALUE_TYPE_OBJECT: {
+      g_autoptr(GList) keys = hcl_value_object_get_keys (expected);
+      g_autoptr(GList) other_keys = hcl_value_object_get_keys (value);
+
+      g_assert_cmpuint (g_list_length (other_keys), ==, g_list_length (keys));
+      for (GList *l = keys; l; l = l->next)
+        hcl_test_assert_value_equal (hcl_value_object_get_member (expected, l->data),
+                                     hcl_value_object_get_member (value, l->data));
+      break;
+    }
+
+    default:
+      break;
+  }
+}
+
+void
+hcl_test_assert_block_equal (HclBlock *expected, HclBlock *block)
+{
+  g_autoptr(GList) names = hcl_block_get_attribute_names (expected);
+  g_autoptr(GList) other_names = hcl_block_get_attribute_names (block);
+  g_autoptr(GList) blocks = hcl_block_get_blocks (expected);
+  g_autoptr(GList) other_blocks = hcl_block_get_blocks (block);
+  GList *l, *o;
+
+  g_assert_cmpstr (hcl_block_get_block_type (block), ==, hcl_block_get_block_type (expected));
+  g_assert_cmpstr (hcl_block_get_label (block), ==, hcl_block_get_label (expected));
+
+  g_assert_cmpuint (g_list_length (other_names), ==, g_list_length (names));
+  for (l = names; l; l = l->next)
+    hcl_test_assert_value_equal (hcl_block_get_attribute (expected, l->data),
+                                 hcl_block_get_attribute (block, l->data));
+
+  g_assert_cmpuint (g_list_length (other_blocks), ==, g_list_length (blocks));
+  for (l = blocks, o = other_blocks; l; l = l->next, o = o->next)
+    hcl_test_assert_block_equal (l->data, o->data);
+}
+
+void
+hcl_test_assert_document_equal (HclDocument *expected, HclDocument *document)
+{
+  g_autoptr(GList) names = hcl_document_get_attribute_names (expected);
+  g_autoptr(GList) other_names = hcl_document_get_attribute_names (document);
+  g_autoptr(GList) blocks = hcl_document_get_blocks (expected);
+  g_autoptr(GList) other_blocks = hcl_document_get_blocks (document);
+  GList *l, *o;
+
+  g_assert_cmpuint (g_list_length (other_names), ==, g_list_length (names));
+  for (l = names; l; l = l->next)
+    hcl_test_assert_value_equal (hcl_document_get_attribute (expected, l->data),
+                                 hcl_document_get_attribute (document, l->data));
+
+  g_assert_cmpuint (g_list_length (other_blocks), ==, g_list_length (blocks));
+  for (l = blocks, o = other_blocks; l; l = l->next, o = o->next)
+    hcl_test_assert_block_equal (l->data, o->data);
+}
@@ -0,0 +1,23 @@
+/* test-utils.h - Helpers shared by the libghcl tests
+ *
+ * Copyright 2024 Geoff Johnson <geoff.jay@gmail.com>
+ */
+
+#ifndef __TEST_UTILS_H__
+#define __TEST_UTILS_H__
+
+#include <glib.h>
+#include <hcl.h>
+
+G_BEGIN_DECLS
+
+void hcl_test_assert_value_equal    (HclValue *expected,
+                                     HclValue *value);
+void hcl_test_assert_block_equal    (HclBlock *expected,
+                                     HclBlock *block);
+void hcl_test_assert_document_equal (HclDocument *expected,
+                                     HclDocument *document);
+
+G_END_DECLS
+
+#endif /* __TEST_UTILS_H__ */
@@ -58,6 +58,12 @@ test_value_string (void)
 
   g_assert_true (hcl_value_is_string (value));
   g_assert_cmpstr (hcl_value_get_string (value), ==, "hello world");
+
+  g_autoptr(HclValue) slice = hcl_value_new_string_len ("hello world", 5);
+  g_assert_cmpstr (hcl_value_get_string (slice), ==, "hello");
+
+  g_autoptr(HclValue) taken = hcl_value_new_take_string (g_strdup ("owned"));
+  g_assert_cmpstr (hcl_value_get_string (taken), ==, "owned");
 }
 
 static void
@@ -119,6 +125,217 @@ test_value_object (void)
   g_list_free (keys);
 }
 
+/* { items = [1, { deep = "x" }], name = "n" } */
+static HclValue *
+build_nested (void)
+{
+  HclValue *object = hcl_value_new_object ();
+  HclValue *items = hcl_value_new_list ();
+  HclValue *inner = hcl_value_new_object ();
+
+  hcl_value_object_set_member (inner, "deep", hcl_value_new_string ("x"));
+  hcl_value_list_add_item (items, hcl_value_new_int (1));
+  hcl_value_list_add_item (items, inner);
+  hcl_value_object_set_member (object, "items", items);
+  hcl_value_object_set_member (object, "name", hcl_value_new_string ("n"));
+
+  return object;
+}
+
+static void
+test_value_copy (void)
+{
+  g_autoptr(HclValue) object = build_nested ();
+  g_autoptr(HclValue) copy = hcl_value_copy (object);
+  HclValue *items = hcl_value_object_get_member (object, "items");
+  HclValue *copied_items = hcl_value_object_get_member (copy, "items");
+  HclValue *inner;
+
+  g_assert_false (hcl_value_is_frozen (copy));
+  g_assert_true (copied_items != items);
+  g_assert_cmpuint (hcl_value_list_get_length (copied_items), ==, 2);
+
+  /* Scalars are shared, lists and objects are not */
+  g_assert_true (hcl_value_list_get_item (copied_items, 0) == hcl_value_list_get_item (items, 0));
+  inner = hcl_value_list_get_item (copied_items, 1);
+  g_assert_true (inner != hcl_value_list_get_item (items, 1));
+  g_assert_cmpstr (hcl_value_get_string (hcl_value_object_get_member (inner, "deep")), ==, "x");
+
+  hcl_value_object_set_member (inner, "deep", hcl_value_new_string ("y"));
+  hcl_value_list_add_item (copied_items, hcl_value_new_int (2));
+
+  g_assert_cmpuint (hcl_value_list_get_length (items), ==, 2);
+  g_assert_cmpstr (hcl_value_get_string (hcl_value_object_get_member (hcl_value_list_get_item (items, 1),
+                                                                      "deep")), ==, "x");
+}
+
+static void
+test_value_freeze (void)
+{
+  g_autoptr(HclValue) object = build_nested ();
+  HclValue *items = hcl_value_object_get_member (object, "items");
+
+  g_assert_false (hcl_value_is_frozen (object));
+
+  hcl_value_freeze (object);
+
+  g_assert_true (hcl_value_is_frozen (object));
+  g_assert_true (hcl_value_is_frozen (items));
+  g_assert_true (hcl_value_is_frozen (hcl_value_list_get_item (items, 1)));
+  g_assert_true (hcl_value_is_frozen (hcl_value_object_get_member (object, "name")));
+
+  /* Freezing again changes nothing */
+  hcl_value_freeze (object);
+  g_assert_true (hcl_value_is_frozen (object));
+}
+
+static void
+test_value_copy_frozen (void)
+{
+  g_autoptr(HclValue) object = build_nested ();
+  g_autoptr(HclValue) copy = NULL;
+  g_autoptr(HclValue) again = NULL;
+  g_autoptr(HclValue) items = NULL;
+  HclValue *frozen_items;
+  HclValue *inner;
+
+  hcl_value_freeze (object);
+  frozen_items = hcl_value_object_get_member (object, "items");
+  copy = hcl_value_copy (object);
+
+  /* The copy can be changed, and shares every member until it is */
+  g_assert_false (hcl_value_is_frozen (copy));
+  g_assert_true (hcl_value_object_get_member (copy, "items") == frozen_items);
+  g_assert_true (hcl_value_object_get_member (copy, "name") ==
+                 hcl_value_object_get_member (object, "name"));
+
+  /* A copy of a copy that was not changed shares the same members */
+  again = hcl_value_copy (copy);
+  g_assert_true (hcl_value_object_get_member (again, "items") == frozen_items);
+
+  /* Shared members stay frozen, so change a copy and set it back */
+  items = hcl_value_copy (frozen_items);
+  inner = hcl_value_list_get_item (items, 1);
+  g_assert_true (inner == hcl_value_list_get_item (frozen_items, 1));
+  hcl_value_list_add_item (items, hcl_value_new_int (3));
+  hcl_value_object_set_member (copy, "items", g_object_ref (items));
+  hcl_value_object_set_member (copy, "extra", hcl_value_new_bool (TRUE));
+
+  g_assert_cmpuint (hcl_value_list_get_length (hcl_value_object_get_member (copy, "items")), ==, 3);
+  g_assert_true (hcl_value_list_get_item (items, 1) == inner);
+  g_assert_true (hcl_value_object_has_member (copy, "extra"));
+
+  /* None of which shows through in the original or the other copy */
+  g_assert_cmpuint (hcl_value_list_get_length (frozen_items), ==, 2);
+  g_assert_true (hcl_value_object_get_member (object, "items") == frozen_items);
+  g_assert_false (hcl_value_object_has_member (object, "extra"));
+  g_assert_false (hcl_value_object_has_member (again, "extra"));
+  g_assert_true (hcl_value_object_get_member (again, "items") == frozen_items);
+}
+
+static void
+test_value_array (void)
+{
+  static const gint64 numbers[] = { 5, -1, 42 };
+  g_autoptr(HclValue) array = hcl_value_new_int_array (numbers, G_N_ELEMENTS (numbers));
+  g_autoptr(HclValue) copy = NULL;
+  g_autoptr(HclValue) shared = NULL;
+  const gint64 *ints;
+  HclValue *item;
+  guint length;
+
+  g_assert_true (hcl_value_is_list (array));
+  g_assert_true (hcl_value_is_array (array));
+  g_assert_cmpint (hcl_value_get_number_type (array), ==, HCL_NUMBER_TYPE_INTEGER);
+  g_assert_cmpuint (hcl_value_list_get_length (array), ==, 3);
+
+  ints = hcl_value_get_int_array (array, &length);
+  g_assert_true (ints != numbers);
+  g_assert_cmpmem (ints, length * sizeof (gint64), numbers, sizeof numbers);
+  g_assert_null (hcl_value_get_double_array (array, &length));
+  g_assert_cmpuint (length, ==, 0);
+
+  /* Items read as values, and stay the same values */
+  item = hcl_value_list_get_item (array, 2);
+  g_assert_cmpint (hcl_value_get_int (item), ==, 42);
+  g_assert_true (hcl_value_list_get_item (array, 2) == item);
+  g_assert_null (hcl_value_list_get_item (array, 3));
+
+  /* A copy of a frozen array shares the numbers */
+  copy = hcl_value_copy (array);
+  g_assert_true (hcl_value_get_int_array (copy, NULL) != ints);
+  hcl_value_freeze (array);
+  g_assert_true (hcl_value_is_frozen (item));
+  shared = hcl_value_copy (array);
+  g_assert_true (hcl_value_get_int_array (shared, NULL) == ints);
+
+  /* Adding any item stores the list as values */
+  hcl_value_list_add_item (shared, hcl_value_new_int (7));
+  g_assert_false (hcl_value_is_array (shared));
+  g_assert_null (hcl_value_get_int_array (shared, NULL));
+  g_assert_cmpuint (hcl_value_list_get_length (shared), ==, 4);
+  g_assert_cmpint (hcl_value_get_int (hcl_value_list_get_item (shared, 1)), ==, -1);
+  g_assert_cmpint (hcl_value_get_int (hcl_value_list_get_item (shared, 3)), ==, 7);
+  g_assert_true (hcl_value_is_array (array));
+  g_assert_cmpuint (hcl_value_list_get_length (array), ==, 3);
+
+  g_clear_object (&shared);
+  shared = hcl_value_new_double_array (NULL, 0);
+  g_assert_true (hcl_value_is_array (shared));
+  g_assert_cmpint (hcl_value_get_number_type (shared), ==, HCL_NUMBER_TYPE_FLOAT);
+  g_assert_cmpuint (hcl_value_list_get_length (shared), ==, 0);
+}
+
+static void
+test_value_hash (void)
+{
+  g_autoptr(HclValue) object = build_nested ();
+  g_autoptr(HclValue) reordered = hcl_value_new_object ();
+  g_autoptr(HclValue) copy = NULL;
+  g_autoptr(HclValue) boxed = hcl_value_new_list ();
+  g_autoptr(HclValue) packed = NULL;
+  g_autoptr(HclValue) negative_zero = hcl_value_new_double (-0.0);
+  g_autoptr(HclValue) zero = hcl_value_new_double (0.0);
+  g_autoptr(HclValue) one = hcl_value_new_int (1);
+  g_autoptr(HclValue) one_point_zero = hcl_value_new_double (1.0);
+  static const gint64 numbers[] = { 1, 2, 3 };
+  HclValue *items = hcl_value_object_get_member (object, "items");
+  HclValue *inner = hcl_value_list_get_item (items, 1);
+  HclValue *name = hcl_value_object_get_member (object, "name");
+  guint64 hash = hcl_value_hash (object);
+  guint64 name_hash = hcl_value_hash (name);
+
+  /* Equal values hash alike, whatever order members were set in */
+  hcl_value_object_set_member (reordered, "name", hcl_value_new_string ("n"));
+  hcl_value_object_set_member (reordered, "items", hcl_value_copy (items));
+  g_assert_cmpuint (hcl_value_hash (reordered), ==, hash);
+  g_assert_cmpuint (hcl_value_hash (negative_zero), ==, hcl_value_hash (zero));
+  g_assert_cmpuint (hcl_value_hash (one), !=, hcl_value_hash (one_point_zero));
+
+  /* A change deep down reaches every container above it */
+  hcl_value_object_set_member (inner, "deep", hcl_value_new_string ("y"));
+  g_assert_cmpuint (hcl_value_hash (object), !=, hash);
+  g_assert_cmpuint (hcl_value_hash (name), ==, name_hash);
+  hcl_value_object_set_member (inner, "deep", hcl_value_new_string ("x"));
+  g_assert_cmpuint (hcl_value_hash (object), ==, hash);
+
+  /* A copy hashes like its source until one of them changes */
+  hcl_value_freeze (object);
+  copy = hcl_value_copy (object);
+  g_assert_cmpuint (hcl_value_hash (copy), ==, hash);
+  hcl_value_object_set_member (copy, "name", hcl_value_new_string ("m"));
+  g_assert_cmpuint (hcl_value_hash (copy), !=, hash);
+  g_assert_cmpuint (hcl_value_hash (object), ==, hash);
+
+  /* A packed list hashes like the same numbers stored as values */
+  packed = hcl_value_new_int_array (numbers, G_N_ELEMENTS (numbers));
+  for (guint i = 0; i < G_N_ELEMENTS (numbers); i++)
+    hcl_value_list_add_item (boxed, hcl_value_new_int (numbers[i]));
+  g_assert_cmpuint (hcl_value_hash (packed), ==, hcl_value_hash (boxed));
+  hcl_value_list_add_item (boxed, hcl_value_new_int (4));
+  g_assert_cmpuint (hcl_value_hash (packed), !=, hcl_value_hash (boxed));
+}
+
 int
 main (int argc, char **argv)
 {
@@ -130,6 +347,11 @@ main (int argc, char **argv)
   g_test_add_func ("/hcl/value/string", test_value_string);
   g_test_add_func ("/hcl/value/list", test_value_list);
   g_test_add_func ("/hcl/value/object", test_value_object);
+  g_test_add_func ("/hcl/value/copy", test_value_copy);
+  g_test_add_func ("/hcl/value/freeze", test_value_freeze);
+  g_test_add_func ("/hcl/value/copy_frozen", test_value_copy_frozen);
+  g_test_add_func ("/hcl/value/array", test_value_array);
+  g_test_add_func ("/hcl/value/hash", test_value_hash);
 
   return g_test_run ();
 }
@@ -0,0 +1,382 @@
+/* test-writer.c - Tests for the HCL writer
+ *
+ * Copyright 2024 Geoff Johnson <geoff.jay@gmail.com>
+ */
+
+#include <glib.h>
+#include <gio/gio.h>
+#include <hcl.h>
+#include <math.h>
+
+static const gchar *config =
+  "name = \"slate \\\"main\\\"\\n\\tpath\\\\to\"\n"
+  "version = 2\n"
+  "nothing = null\n"
+  "application \"app\" {\n"
+  "  ratio = 0.1\n"
+  "  scale = -2.5e-300\n"
+  "  whole = 3.0\n"
+  "  huge = 1e300\n"
+  "  limits = [9223372036854775807, -9223372036854775808, 0.3333333333333333]\n"
+  "  series = [1, -2, 3]\n"
+  "  ratios = [0.5, 2.0, -1e-7]\n"
+  "  tags = [\"a\", [1, 2.5], { nested = true }, [], {}]\n"
+  "  keys = { plain = 1, \"with space\" = 2, \"true\" = 3, \"9lives\" = 4, dash-ed = 5 }\n"
+  "  dashboard {\n"
+  "    box \"header\" {\n"
+  "      height = \"auto\"\n"
+  "    }\n"
+  "    grid {\n"
+  "    }\n"
+  "  }\n"
+  "}\n"
+  "footer {\n"
+  "}\n";
+
+static HclDocument *
+build_document (void)
+{
+  HclDocument *document = hcl_document_new ();
+  HclBlock *application = hcl_block_new ("application", "my \"app\"");
+  HclBlock *dashboard = hcl_block_new ("dashboard", NULL);
+  HclValue *margin = hcl_value_new_object ();
+  HclValue *sizes = hcl_value_new_list ();
+  HclValue *rows = hcl_value_new_list ();
+  HclValue *row = hcl_value_new_list ();
+
+  hcl_value_list_add_item (sizes, hcl_value_new_int (1));
+  hcl_value_list_add_item (sizes, hcl_value_new_double (2.0));
+  hcl_value_list_add_item (sizes, hcl_value_new_string ("three"));
+  hcl_value_object_set_member (margin, "sizes", sizes);
+
+  hcl_value_list_add_item (row, hcl_value_new_bool (TRUE));
+  hcl_value_list_add_item (rows, row);
+  hcl_value_list_add_item (rows, hcl_value_new_list ());
+
+  hcl_document_set_attribute (document, "title", hcl_value_new_string ("Monitor"));
+  hcl_block_set_attribute (application, "margin", margin);
+  hcl_block_set_attribute (dashboard, "rows", rows);
+  hcl_block_add_block (application, dashboard);
+  hcl_document_add_block (document, application);
+
+  return document;
+}
+
+static gchar *
+write_document (HclDocument *document, HclWriterStyle style)
+{
+  g_autoptr(HclWriter) writer = hcl_writer_new ();
+  GString *buffer = g_string_new (NULL);
+
+  hcl_writer_set_style (writer, style);
+  hcl_writer_write_document (writer, document, buffer);
+
+  return g_string_free (buffer, FALSE);
+}
+
+static void
+test_writer_pretty (void)
+{
+  g_autoptr(HclDocument) document = build_document ();
+  g_autofree gchar *text = write_document (document, HCL_WRITER_STYLE_PRETTY);
+
+  g_assert_cmpstr (text, ==,
+                   "title = \"Monitor\"\n"
+                   "application \"my \\\"app\\\"\" {\n"
+                   "  margin = {\n"
+                   "    sizes = [1, 2.0, \"three\"]\n"
+                   "  }\n"
+                   "  dashboard {\n"
+                   "    rows = [\n"
+                   "      [true],\n"
+                   "      []\n"
+                   "    ]\n"
+                   "  }\n"
+                   "}\n");
+}
+
+static void
+test_writer_compact (void)
+{
+  g_autoptr(HclDocument) document = build_document ();
+  g_autofree gchar *text = write_document (document, HCL_WRITER_STYLE_COMPACT);
+
+  g_assert_cmpstr (text, ==,
+                   "title=\"Monitor\"\n"
+                   "application \"my \\\"app\\\"\" {\n"
+                   "margin={sizes=[1,2.0,\"three\"]}\n"
+                   "dashboard {\n"
+                   "rows=[[true],[]]\n"
+                   "}\n"
+                   "}\n");
+}
+
+static void
+test_writer_indent (void)
+{
+  g_autoptr(HclDocument) document = build_document ();
+  g_autoptr(HclWriter) writer = hcl_writer_new ();
+  g_autoptr(GString) buffer = g_string_new (NULL);
+  g_autoptr(GList) blocks = hcl_document_get_blocks (document);
+
+  g_assert_cmpuint (hcl_writer_get_indent (writer), ==, HCL_WRITER_DEFAULT_INDENT);
+  hcl_writer_set_indent (writer, 4);
+  hcl_writer_write_block (writer, blocks->data, buffer);
+
+  g_assert_true (g_str_has_prefix (buffer->str,
+                                   "application \"my \\\"app\\\"\" {\n"
+                                   "    margin = {\n"
+                                   "        sizes = [1, 2.0, \"three\"]\n"
+                                   "    }\n"));
+}
+
+static void
+test_writer_round_trip (void)
+{
+  static const HclWriterStyle styles[] = { HCL_WRITER_STYLE_PRETTY, HCL_WRITER_STYLE_COMPACT };
+  g_autoptr(GError) error = NULL;
+  g_autoptr(HclDocument) document = hcl_parse_string (config, &error);
+  HclBlock *application;
+  HclValue *keys;
+
+  g_assert_no_error (error);
+
+  for (guint i = 0; i < G_N_ELEMENTS (styles); i++) {
+    g_autofree gchar *text = write_document (document, styles[i]);
+    g_autoptr(HclDocument) reparsed = hcl_parse_string (text, &error);
+    g_autofree gchar *again = NULL;
+
+    g_assert_no_error (error);
+
+    /* Writing what was read back gives the same bytes */
+    again = write_document (reparsed, styles[i]);
+    g_assert_cmpstr (again, ==, text);
+
+    g_assert_cmpstr (hcl_value_get_string (hcl_document_get_attribute (reparsed, "name")), ==,
+                     "slate \"main\"\n\tpath\\to");
+    g_assert_true (hcl_value_is_null (hcl_document_get_attribute (reparsed, "nothing")));
+
+    application = hcl_document_get_block_by_label (reparsed, "application", "app");
+    g_assert_nonnull (application);
+    g_assert_cmpfloat (hcl_value_get_double (hcl_block_get_attribute (application, "ratio")), ==, 0.1);
+    g_assert_cmpfloat (hcl_value_get_double (hcl_block_get_attribute (application, "scale")), ==, -2.5e-300);
+    g_assert_cmpfloat (hcl_value_get_double (hcl_block_get_attribute (application, "huge")), ==, 1e300);
+    g_assert_true (hcl_value_is_array (hcl_block_get_attribute (application, "ratios")));
+    g_assert_cmpfloat (hcl_value_get_double_array (hcl_block_get_attribute (application, "ratios"),
+                                                   NULL)[2], ==, -1e-7);
+    g_assert_cmpint (hcl_value_get_number_type (hcl_block_get_attribute (application, "whole")), ==,
+                     HCL_NUMBER_TYPE_FLOAT);
+
+    keys = hcl_block_get_attribute (application, "keys");
+    g_assert_cmpint (hcl_value_get_int (hcl_value_object_get_member (keys, "with space")), ==, 2);
+    g_assert_cmpint (hcl_value_get_int (hcl_value_object_get_member (keys, "true")), ==, 3);
+    g_assert_cmpint (hcl_value_get_int (hcl_value_object_get_member (keys, "9lives")), ==, 4);
+    g_assert_cmpint (hcl_value_get_int (hcl_value_object_get_member (keys, "dash-ed")), ==, 5);
+  }
+}
+
+static void
+test_writer_order (void)
+{
+  g_autoptr(HclDocument) document = hcl_document_new ();
+  g_autoptr(HclDocument) reparsed = NULL;
+  g_autoptr(GError) error = NULL;
+  g_autofree gchar *text = NULL;
+  g_autofree gchar *again = NULL;
+  HclValue *object = hcl_value_new_object ();
+
+  hcl_value_object_set_member (object, "zoom", hcl_value_new_int (1));
+  hcl_value_object_set_member (object, "axis", hcl_value_new_int (2));
+  hcl_document_set_attribute (document, "title", hcl_value_new_string ("t"));
+  hcl_document_set_attribute (document, "layout", object);
+  hcl_document_set_attribute (document, "author", hcl_value_new_string ("a"));
+
+  /* Written in the order they were set, not sorted */
+  text = write_document (document, HCL_WRITER_STYLE_COMPACT);
+  g_assert_cmpstr (text, ==,
+                   "title=\"t\"\n"
+                   "layout={zoom=1,axis=2}\n"
+                   "author=\"a\"\n");
+
+  reparsed = hcl_parse_string (text, &error);
+  g_assert_no_error (error);
+  again = write_document (reparsed, HCL_WRITER_STYLE_COMPACT);
+  g_assert_cmpstr (again, ==, text);
+}
+
+static void
+test_writer_deep (void)
+{
+  g_autoptr(HclParser) parser = hcl_parser_new ();
+  g_autoptr(GError) error = NULL;
+  g_autoptr(HclDocument) document = NULL;
+  g_autoptr(HclDocument) reparsed = NULL;
+  g_autofree gchar *text = NULL;
+  g_autofree gchar *again = NULL;
+  GString *input = g_string_new ("value = ");
+  guint depth = 5000;
+
+  /* Deeper than the parser takes by default */
+  for (guint i = 0; i < depth; i++)
+    g_string_append_c (input, '[');
+  for (guint i = 0; i < depth; i++)
+    g_string_append_c (input, ']');
+  g_string_append_c (input, '\n');
+
+  hcl_parser_set_max_depth (parser, 0);
+  document = hcl_parser_parse_string (parser, input->str, &error);
+  g_assert_no_error (error);
+
+  text = write_document (document, HCL_WRITER_STYLE_COMPACT);
+  g_assert_cmpstr (text + strlen ("value="), ==, input->str + strlen ("value = "));
+
+  g_free (text);
+  text = write_document (document, HCL_WRITER_STYLE_PRETTY);
+  reparsed = hcl_parser_parse_string (parser, text, &error);
+  g_assert_no_error (error);
+  again = write_document (reparsed, HCL_WRITER_STYLE_PRETTY);
+  g_assert_cmpstr (again, ==, text);
+
+  g_string_free (input, TRUE);
+}
+
+static void
+test_writer_stream (void)
+{
+  g_autoptr(HclDocument) document = hcl_document_new ();
+  g_autoptr(HclWriter) writer = hcl_writer_new ();
+  g_autoptr(GOutputStream) stream = g_memory_output_stream_new_resizable ();
+  g_autoptr(GOutputStream) closed = g_memory_output_stream_new_resizable ();
+  g_autoptr(GError) error = NULL;
+  g_autofree gchar *expected = NULL;
+
+  /* Large enough to be handed over in many chunks */
+  for (guint i = 0; i < 2000; i++) {
+    g_autofree gchar *label = g_strdup_printf ("box_%u", i);
+    HclBlock *block = hcl_block_new ("box", label);
+
+    hcl_block_set_attribute (block, "spacing", hcl_value_new_int (i));
+    hcl_document_add_block (document, block);
+  }
+
+  expected = write_document (document, HCL_WRITER_STYLE_PRETTY);
+
+  g_assert_true (hcl_writer_write_document_to_stream (writer, document, stream, NULL, &error));
+  g_assert_no_error (error);
+  g_assert_cmpuint (g_memory_output_stream_get_data_size (G_MEMORY_OUTPUT_STREAM (stream)), ==,
+                    strlen (expected));
+  g_assert_cmpmem (g_memory_output_stream_get_data (G_MEMORY_OUTPUT_STREAM (stream)),
+                   g_memory_output_stream_get_data_size (G_MEMORY_OUTPUT_STREAM (stream)),
+                   expected, strlen (expected));
+
+  /* Errors from the stream are passed on, and the writer is usable after */
+  g_output_stream_close (closed, NULL, NULL);
+  g_assert_false (hcl_writer_write_document_to_stream (writer, document, closed, NULL, &error));
+  g_assert_error (error, G_IO_ERROR, G_IO_ERROR_CLOSED);
+  g_clear_error (&error);
+
+  g_clear_object (&stream);
+  stream = g_memory_output_stream_new_resizable ();
+  g_assert_true (hcl_writer_write_document_to_stream (writer, document, stream, NULL, &error));
+  g_assert_cmpuint (g_memory_output_stream_get_data_size (G_MEMORY_OUTPUT_STREAM (stream)), ==,
+                    strlen (expected));
+}
+
+static void
+test_writer_to_string (void)
+{
+  g_autoptr(HclDocument) document = build_document ();
+  g_autofree gchar *text = hcl_document_to_string (document);
+  g_autofree gchar *expected = write_document (document, HCL_WRITER_STYLE_PRETTY);
+  g_autoptr(GList) blocks = hcl_document_get_blocks (document);
+  g_autoptr(GList) children = hcl_block_get_blocks (blocks->data);
+  g_autofree gchar *block = NULL;
+  g_autofree gchar *value = NULL;
+
+  g_assert_cmpstr (text, ==, expected);
+
+  block = hcl_block_to_string (children->data);
+  g_assert_cmpstr (block, ==,
+                   "dashboard {\n"
+                   "  rows = [\n"
+                   "    [true],\n"
+                   "    []\n"
+                   "  ]\n"
+                   "}\n");
+
+  value = hcl_value_to_string (hcl_block_get_attribute (blocks->data, "margin"));
+  g_assert_cmpstr (value, ==,
+                   "{\n"
+                   "  sizes = [1, 2.0, \"three\"]\n"
+                   "}");
+}
+
+static void
+test_writer_non_finite (void)
+{
+  static const gchar *out_of_range[] = {
+    "x = 1e999\n",
+    "x = -1.5e400\n",
+    "x = [0.5, 1e309]\n",
+  };
+  static const gdouble doubles[] = { 0.5, NAN };
+  g_autoptr(HclWriter) writer = hcl_writer_new ();
+  g_autoptr(GOutputStream) stream = g_memory_output_stream_new_resizable ();
+  g_autoptr(HclDocument) document = hcl_document_new ();
+  g_autoptr(HclValue) infinite = hcl_value_new_double (INFINITY);
+  g_autoptr(GError) error = NULL;
+  g_autoptr(HclDocument) tiny = NULL;
+  GString *buffer = g_string_new ("kept");
+
+  /* A float literal too large for a double reads as nothing else */
+  for (guint i = 0; i < G_N_ELEMENTS (out_of_range); i++) {
+    g_autoptr(HclDocument) parsed = hcl_parse_string (out_of_range[i], &error);
+
+    g_assert_null (parsed);
+    g_assert_error (error, HCL_PARSER_ERROR, HCL_PARSER_ERROR_INVALID_NUMBER);
+    g_clear_error (&error);
+  }
+
+  /* Underflow is not an error, the value is just zero */
+  tiny = hcl_parse_string ("x = 1e-999\n", &error);
+  g_assert_no_error (error);
+  g_assert_cmpfloat (hcl_value_get_double (hcl_document_get_attribute (tiny, "x")), ==, 0.0);
+
+  /* Writing to a buffer refuses and leaves the buffer as it was */
+  g_test_expect_message (NULL, G_LOG_LEVEL_CRITICAL, "*no literal*");
+  hcl_writer_write_value (writer, infinite, buffer);
+  g_test_assert_expected_messages ();
+  g_assert_cmpstr (buffer->str, ==, "kept");
+
+  hcl_document_set_attribute (document, "ratio", hcl_value_new_double (0.25));
+  hcl_document_set_attribute (document, "ratios", hcl_value_new_double_array (doubles, 2));
+
+  g_test_expect_message (NULL, G_LOG_LEVEL_CRITICAL, "*no literal*");
+  hcl_writer_write_document (writer, document, buffer);
+  g_test_assert_expected_messages ();
+  g_assert_cmpstr (buffer->str, ==, "kept");
+
+  /* Writing to a stream fails with an error */
+  g_assert_false (hcl_writer_write_document_to_stream (writer, document, stream, NULL, &error));
+  g_assert_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA);
+
+  g_string_free (buffer, TRUE);
+}
+
+int
+main (int argc, char **argv)
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/hcl/writer/pretty", test_writer_pretty);
+  g_test_add_func ("/hcl/writer/compact", test_writer_compact);
+  g_test_add_func ("/hcl/writer/indent", test_writer_indent);
+  g_test_add_func ("/hcl/writer/round_trip", test_writer_round_trip);
+  g_test_add_func ("/hcl/writer/order", test_writer_order);
+  g_test_add_func ("/hcl/writer/deep", test_writer_deep);
+  g_test_add_func ("/hcl/writer/stream", test_writer_stream);
+  g_test_add_func ("/hcl/writer/to_string", test_writer_to_string);
+  g_test_add_func ("/hcl/writer/non_finite", test_writer_non_finite);
+
+  return g_test_run ();
+}
@@ -17,7 +17,9 @@
  */
 
 #include <glib.h>
+#include <glib/gstdio.h>
 #include <gtk/gtk.h>
+#include <utime.h>
 #include "../../src/libslate/core/slate-config.h"
 #include "../../src/libslate/ui/slate-box.h"
 
@@ -103,13 +105,161 @@ test_config_nested_objects (void)
   g_object_unref (config);
 }
 
+static void
+test_config_load_directory (void)
+{
+  SlateConfig *config;
+  GError *error = NULL;
+  char *dir;
+  char *base;
+  char *override;
+  char *ignored;
+
+  dir = g_dir_make_tmp ("slate-config-XXXXXX", &error);
+  g_assert_no_error (error);
+
+  base = g_build_filename (dir, "00-base.hcl", NULL);
+  override = g_build_filename (dir, "10-override.hcl", NULL);
+  ignored = g_build_filename (dir, "notes.txt", NULL);
+
+  g_assert_true (g_file_set_contents (base,
+                                      "app = \"Base\"\n"
+                                      "dark_theme = true\n"
+                                      "object \"box\" {\n  id = \"first\"\n}\n",
+                                      -1, &error));
+  g_assert_true (g_file_set_contents (override,
+                                      "app = \"Override\"\n"
+                                      "object \"box\" {\n  id = \"second\"\n}\n",
+                                      -1, &error));
+  g_assert_true (g_file_set_contents (ignored, "not = [hcl", -1, &error));
+  g_assert_no_error (error);
+
+  config = slate_config_new ();
+
+  /* Files are merged in name order, later files winning */
+  g_assert_true (slate_config_load_directory (config, dir, &error));
+  g_assert_no_error (error);
+  g_assert_cmpstr (slate_config_get_string_property (config, "app"), ==, "Override");
+  g_assert_true (slate_config_get_boolean_property (config, "dark_theme"));
+
+  GList *objects = slate_config_get_objects_by_type (config, "object");
+  g_assert_cmpint (g_list_length (objects), ==, 2);
+  g_assert_cmpstr (hcl_value_get_string (hcl_block_get_attribute (objects->data, "id")), ==, "first");
+  g_list_free (objects);
+
+  g_remove (base);
+  g_remove (override);
+  g_remove (ignored);
+  g_rmdir (dir);
+
+  g_free (base);
+  g_free (override);
+  g_free (ignored);
+  g_free (dir);
+  g_object_unref (config);
+}
+
+static void
+test_config_load_file_cached (void)
+{
+  SlateConfig *config;
+  GError *error = NULL;
+  GStatBuf buf;
+  char *dir;
+  char *source;
+  char *cache_dir;
+  char *cache;
+  char *absolute;
+  char *key;
+  char *basename;
+
+  dir = g_dir_make_tmp ("slate-config-XXXXXX", &error);
+  g_assert_no_error (error);
+
+  source = g_build_filename (dir, "slate.hcl", NULL);
+  g_assert_true (g_file_set_contents (source, "app = \"Cached\"\n", -1, &error));
+  g_assert_no_error (error);
+
+  /* The cache is keyed by the SHA-256 of the absolute source path */
+  absolute = g_canonicalize_filename (source, NULL);
+  key = g_compute_checksum_for_string (G_CHECKSUM_SHA256, absolute, -1);
+  basename = g_strconcat (key, ".hclc", NULL);
+  cache_dir = g_build_filename (g_get_user_cache_dir (), "slate", "config", NULL);
+  cache = g_build_filename (cache_dir, basename, NULL);
+  g_assert_false (g_file_test (cache, G_FILE_TEST_EXISTS));
+
+  config = slate_config_new ();
+
+  /* The first load parses the file and writes the cache */
+  g_assert_true (slate_config_load_file (config, source, &error));
+  g_assert_no_error (error);
+  g_assert_cmpstr (slate_config_get_string_property (config, "app"), ==, "Cached");
+  g_assert_true (g_file_test (cache, G_FILE_TEST_IS_REGULAR));
+
+  /* A hit reads the cache and leaves it alone */
+  g_assert_cmpint (g_utime (cache, &(struct utimbuf) { 1000, 1000 }), ==, 0);
+  g_assert_true (slate_config_load_file (config, source, &error));
+  g_assert_no_error (error);
+  g_assert_cmpstr (slate_config_get_string_property (config, "app"), ==, "Cached");
+  g_assert_cmpint (g_stat (cache, &buf), ==, 0);
+  g_assert_cmpint (buf.st_mtime, ==, 1000);
+
+  /* Once the source changes it is parsed again and the cache rewritten */
+  g_assert_true (g_file_set_contents (source, "app = \"Changed again\"\n", -1, &error));
+  g_assert_no_error (error);
+  g_assert_true (slate_config_load_file (config, source, &error));
+  g_assert_no_error (error);
+  g_assert_cmpstr (slate_config_get_string_property (config, "app"), ==, "Changed again");
+  g_assert_cmpint (g_stat (cache, &buf), ==, 0);
+  g_assert_cmpint (buf.st_mtime, !=, 1000);
+
+  g_remove (cache);
+  g_remove (source);
+  g_rmdir (dir);
+
+  g_free (basename);
+  g_free (key);
+  g_free (absolute);
+  g_free (cache);
+  g_free (cache_dir);
+  g_free (source);
+  g_free (dir);
+  g_object_unref (config);
+}
+
 int
 main (int argc, char *argv[])
 {
+  char *cache_home;
+  char *slate_dir;
+  char *cache_dir;
+  int status;
+
+  /* Keep the document cache out of the user's cache directory. This has
+   * to happen before anything asks GLib for the cache directory. */
+  cache_home = g_dir_make_tmp ("slate-cache-XXXXXX", NULL);
+  g_assert_nonnull (cache_home);
+  g_setenv ("XDG_CACHE_HOME", cache_home, TRUE);
+
   gtk_test_init (&argc, &argv, NULL);
 
   g_test_add_func ("/slate/config/basic", test_config_basic);
   g_test_add_func ("/slate/config/nested-objects", test_config_nested_objects);
+  g_test_add_func ("/slate/config/load-directory", test_config_load_directory);
+  g_test_add_func ("/slate/config/load-file-cached", test_config_load_file_cached);
+
+  status = g_test_run ();
+
+  /* Only load-file-cached writes to the cache, and it removes its file */
+  slate_dir = g_build_filename (cache_home, "slate", NULL);
+  cache_dir = g_build_filename (slate_dir, "config", NULL);
+  g_rmdir (cache_dir);
+  g_rmdir (slate_dir);
+  g_rmdir (cache_home);
+
+  g_free (cache_dir);
+  g_free (slate_dir);
+  g_free (cache_home);
 
-  return g_test_run ();
+  return status;
 }